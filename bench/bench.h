@@ -0,0 +1,104 @@
+/**
+ * @file bench.h
+ * @brief Helpers and the sample model shared by the benchmarks
+ * 
+ * @note Every benchmark is a target of the CMake build, or build one with the wrapper source and cJSON, for example:
+ *           cc -O2 -Iinclude bench/bench_s2j.c src/json_wrapper*.c -lcjson -lm -lpthread -o bench_s2j
+ */
+
+
+#include <stdio.h>
+#include <stdint.h>
+#include <time.h>
+#include <json_wrapper/json_wrapper.h>
+
+
+DEFINE_STRUCT(Son,
+    (OBJ(STRING), name)
+    (OBJ(INT), age)
+    (OBJ(STRING), birthday)
+    (OBJ(CHAR), sex)
+)
+
+DEFINE_STRUCT(Person,
+    (OBJ(STRING), name)
+    (OBJ(INT), age)
+    (OBJ(STRING), birthday)
+    (OBJ(CHAR), sex)
+    (OBJ(STRING), couple)
+    (OBJ(Son), son)
+    (ARRAY(Son, 2), sons)
+    (VA_ARRAY(Son), v_sons)
+)
+
+
+/**
+ * @brief Get the monotonic time in nanoseconds
+ */
+static inline uint64_t bench_now_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t) ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+/**
+ * @brief Print one result line
+ * 
+ * @param name The name of the case
+ * @param ns The total nanoseconds
+ * @param ops The number of operations
+ * @param bytes The number of bytes processed, @p 0 for not reporting throughput
+ */
+static inline void bench_report(const char * name, uint64_t ns, uint64_t ops, uint64_t bytes)
+{
+    double ns_op = (double) ns / ops;
+    if (bytes)
+    {
+        printf("%-40s %12.1f ns/op %10.1f MB/s\n", name, ns_op, bytes * 1000.0 / ns);
+    } else
+    {
+        printf("%-40s %12.1f ns/op\n", name, ns_op);
+    }
+}
+
+/**
+ * @brief Fill a @p Person with @p children entries in its VA_ARRAY, the strings are static
+ * 
+ * @param person The person, the VA_ARRAY buffer should be freed by json_wrapper_free
+ * @param children The number of children
+ */
+static inline void bench_fill_person(GET_STRUCT_NAME(Person) * person, size_t children)
+{
+    static const char * names[] = { "Alice", "Bob", "Carol", "Dave \"D\" Smith" };
+    memset(person, 0, sizeof(GET_STRUCT_NAME(Person)));
+    person->name = "John Appleseed";
+    person->age = 42;
+    person->birthday = "1980-01-01";
+    person->sex = 1;
+    person->couple = "Jane Appleseed";
+    person->son.name = "Junior";
+    person->son.age = 12;
+    person->son.birthday = "2010-06-30";
+    int i = 0;
+    for (; i < 2; ++i)
+    {
+        person->sons[i].name = (char *) names[i];
+        person->sons[i].age = 10 + i;
+        person->sons[i].birthday = "2012-02-29";
+    }
+    if (children)
+    {
+        person->v_sons.v_sons = json_wrapper_alloc(sizeof(GET_STRUCT_NAME(Son)) * children);
+        person->v_sons.size = children;
+        size_t j = 0;
+        for (; j < children; ++j)
+        {
+            GET_STRUCT_NAME(Son) * son = &person->v_sons.v_sons[j];
+            son->name = (char *) names[j % 4];
+            son->age = (int) j;
+            son->birthday = "2015-12-31";
+            son->sex = j & 1;
+        }
+    }
+}
@@ -0,0 +1,97 @@
+/**
+ * @file bench_arena.c
+ * @brief Compare J2S/COPY_ST plus RECYCLE_ST with the arena variants plus an arena reset
+ */
+
+
+#include "bench.h"
+
+
+static uint64_t g_allocs = 0;
+
+static void * counting_alloc(size_t size)
+{
+    ++g_allocs;
+    return malloc(size);
+}
+
+static void run(size_t children, int iterations)
+{
+    char name[64];
+    DECLARE_STRUCT(Person, person);
+    bench_fill_person(&person, children);
+    char * json = S2J(Person, &person);
+    json_wrapper_free(person.v_sons.v_sons);
+    if (NULL == json) return;
+    size_t bytes = strlen(json);
+    GET_STRUCT_NAME(Arena) arena;
+    json_wrapper_arena_init(&arena, 0);
+    DECLARE_STRUCT(Person, decoded);
+    DECLARE_STRUCT(Person, copied);
+    int i = 0;
+
+    g_allocs = 0;
+    uint64_t begin = bench_now_ns();
+    for (i = 0; i < iterations; ++i)
+    {
+        J2S(json, Person, &decoded);
+        RECYCLE_ST(Person, &decoded);
+    }
+    uint64_t ns = bench_now_ns() - begin;
+    snprintf(name, sizeof(name), "j2s+recycle        (%zu children)", children);
+    bench_report(name, ns, iterations, bytes * iterations);
+    printf("%-40s %12.1f allocs/op\n", "", (double) g_allocs / iterations);
+
+    g_allocs = 0;
+    begin = bench_now_ns();
+    for (i = 0; i < iterations; ++i)
+    {
+        memset(&decoded, 0, sizeof(decoded));
+        J2S_ARENA(json, Person, &decoded, &arena);
+        json_wrapper_arena_reset(&arena);
+    }
+    ns = bench_now_ns() - begin;
+    snprintf(name, sizeof(name), "j2s arena+reset    (%zu children)", children);
+    bench_report(name, ns, iterations, bytes * iterations);
+    printf("%-40s %12.1f allocs/op\n", "", (double) g_allocs / iterations);
+
+    memset(&decoded, 0, sizeof(decoded));
+    J2S(json, Person, &decoded);
+    g_allocs = 0;
+    begin = bench_now_ns();
+    for (i = 0; i < iterations; ++i)
+    {
+        COPY_ST(Person, &decoded, &copied);
+        RECYCLE_ST(Person, &copied);
+    }
+    ns = bench_now_ns() - begin;
+    snprintf(name, sizeof(name), "copy+recycle       (%zu children)", children);
+    bench_report(name, ns, iterations, 0);
+    printf("%-40s %12.1f allocs/op\n", "", (double) g_allocs / iterations);
+
+    g_allocs = 0;
+    begin = bench_now_ns();
+    for (i = 0; i < iterations; ++i)
+    {
+        memset(&copied, 0, sizeof(copied));
+        COPY_ST_ARENA(Person, &decoded, &copied, &arena);
+        json_wrapper_arena_reset(&arena);
+    }
+    ns = bench_now_ns() - begin;
+    snprintf(name, sizeof(name), "copy arena+reset   (%zu children)", children);
+    bench_report(name, ns, iterations, 0);
+    printf("%-40s %12.1f allocs/op\n", "", (double) g_allocs / iterations);
+
+    RECYCLE_ST(Person, &decoded);
+    json_wrapper_arena_release(&arena);
+    json_wrapper_free(json);
+}
+
+int main(int argc, char * argv[])
+{
+    json_wrapper_hook_alloc(counting_alloc);
+    run(0, 200000);
+    run(10, 50000);
+    run(1000, 500);
+    return 0;
+}
@@ -0,0 +1,87 @@
+/**
+ * @file bench_batch.c
+ * @brief Compare S2J_BATCH with a loop of S2J per record concatenated into one output, as an exporter would do
+ */
+
+
+#include "bench.h"
+
+
+/**
+ * @brief A write callback which only counts the bytes, standing for a file or a socket
+ */
+static int count_write(void * ctx, const char * data, size_t len)
+{
+    *(size_t *) ctx += len;
+    return 0;
+}
+
+static void run(size_t records, int iterations)
+{
+    char name[64];
+    GET_STRUCT_NAME(Person) * people = json_wrapper_alloc(sizeof(GET_STRUCT_NAME(Person)) * records);
+    if (NULL == people) return;
+    size_t i = 0;
+    for (i = 0; i < records; ++i)
+    {
+        bench_fill_person(&people[i], 0);
+        people[i].age = (int) i;
+    }
+    GET_STRUCT_NAME(Buffer) out;
+    memset(&out, 0, sizeof(GET_STRUCT_NAME(Buffer)));
+    GET_STRUCT_NAME(Sink) sink;
+    size_t bytes = 0;
+    int k = 0;
+    /* Grow the output once so neither case pays for it */
+    json_wrapper_sink_init_buffer(&sink, &out, BATCH_ARRAY);
+    S2J_BATCH(Person, people, records, &sink);
+
+    uint64_t begin = bench_now_ns();
+    for (k = 0; k < iterations; ++k)
+    {
+        out.len = 0;
+        json_wrapper_buffer_append(&out, "[", 1);
+        for (i = 0; i < records; ++i)
+        {
+            char * json = S2J(Person, &people[i]);
+            if (i > 0) json_wrapper_buffer_append(&out, ",", 1);
+            json_wrapper_buffer_append(&out, json, strlen(json));
+            json_wrapper_free(json);
+        }
+        json_wrapper_buffer_append(&out, "]", 1);
+    }
+    bytes = out.len;
+    snprintf(name, sizeof(name), "s2j loop, array (%zu records)", records);
+    bench_report(name, bench_now_ns() - begin, (uint64_t) iterations * records, (uint64_t) bytes * iterations);
+
+    begin = bench_now_ns();
+    for (k = 0; k < iterations; ++k)
+    {
+        out.len = 0;
+        S2J_BATCH(Person, people, records, &sink);
+    }
+    snprintf(name, sizeof(name), "s2j batch, array (%zu records)", records);
+    bench_report(name, bench_now_ns() - begin, (uint64_t) iterations * records, (uint64_t) out.len * iterations);
+
+    size_t written = 0;
+    json_wrapper_sink_init_write(&sink, count_write, &written, 0, BATCH_NDJSON);
+    begin = bench_now_ns();
+    for (k = 0; k < iterations; ++k)
+    {
+        S2J_BATCH(Person, people, records, &sink);
+    }
+    snprintf(name, sizeof(name), "s2j batch, ndjson write (%zu records)", records);
+    bench_report(name, bench_now_ns() - begin, (uint64_t) iterations * records, written);
+    json_wrapper_sink_release(&sink);
+
+    json_wrapper_buffer_release(&out);
+    json_wrapper_free(people);
+}
+
+int main(int argc, char * argv[])
+{
+    run(100, 2000);
+    run(10000, 20);
+    run(100000, 5);
+    return 0;
+}
@@ -0,0 +1,57 @@
+/**
+ * @file bench_cjson_pool.c
+ * @brief Compare the cJSON tree paths with the default allocator of cJSON, routed through the hooks and with the node pool
+ */
+
+
+#include "bench.h"
+
+
+static void run(const char * mode, GET_STRUCT_NAME(Person) * person, const char * json, int iterations)
+{
+    char name[64];
+    size_t bytes = strlen(json);
+    DECLARE_STRUCT(Person, decoded);
+    int i = 0;
+
+    uint64_t begin = bench_now_ns();
+    for (i = 0; i < iterations; ++i)
+    {
+        cJSON * tree = STRUCT_2_FUNCTION_NAME(Person)(person);
+        cJSON_free(cJSON_PrintUnformatted(tree));
+        cJSON_Delete(tree);
+    }
+    snprintf(name, sizeof(name), "tree build+print  (%s)", mode);
+    bench_report(name, bench_now_ns() - begin, iterations, bytes * iterations);
+
+    begin = bench_now_ns();
+    for (i = 0; i < iterations; ++i)
+    {
+        cJSON * tree = cJSON_Parse(json);
+        JSON_2_FUNCTION_NAME(Person)(tree, &decoded);
+        cJSON_Delete(tree);
+        RECYCLE_ST(Person, &decoded);
+    }
+    snprintf(name, sizeof(name), "tree parse+decode (%s)", mode);
+    bench_report(name, bench_now_ns() - begin, iterations, bytes * iterations);
+}
+
+int main(int argc, char * argv[])
+{
+    int iterations = argc > 1 ? atoi(argv[1]) : 50000;
+    DECLARE_STRUCT(Person, person);
+    bench_fill_person(&person, 8);
+    char * json = S2J(Person, &person);
+    if (NULL == json) return 1;
+
+    run("cjson malloc", &person, json, iterations);
+    json_wrapper_hook_cjson(false);
+    run("hooks", &person, json, iterations);
+    json_wrapper_hook_cjson(true);
+    run("hooks + pool", &person, json, iterations);
+    json_wrapper_cjson_pool_release();
+
+    json_wrapper_free(json);
+    json_wrapper_free(person.v_sons.v_sons);
+    return 0;
+}
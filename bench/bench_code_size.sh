@@ -0,0 +1,41 @@
+#!/bin/sh
+# Compare the object size of N generated types defined with DEFINE_STRUCT and with DEFINE_STRUCT_COMPACT
+#
+# usage: bench/bench_code_size.sh [N] [CC flags...]
+#        Run it from the root of the repository, the include path of cJSON can be passed in the flags
+
+N=${1:-20}
+[ $# -gt 0 ] && shift
+CC=${CC:-cc}
+TMP=${TMPDIR:-/tmp}/json_wrapper_code_size.$$
+mkdir -p "$TMP" || exit 1
+trap 'rm -rf "$TMP"' EXIT
+
+gen()
+{
+    macro=$1
+    echo "#include <json_wrapper/json_wrapper.h>"
+    i=0
+    while [ $i -lt "$N" ]; do
+        echo "$macro(Leaf$i, (OBJ(STRING), name)(OBJ(INT), age)(OBJ(BOOL), ok)(OBJ(CHAR), sex))"
+        echo "$macro(Node$i, (OBJ(STRING), name)(OBJ(INT), id)(OBJ(Leaf$i), leaf)(ARRAY(Leaf$i, 2), pair)(VA_ARRAY(Leaf$i), leaves)(ARRAY(INT, 4), xs))"
+        # Reference every entry so nothing is dropped as unused
+        echo "void * use$i[] = {"
+        for t in Leaf$i Node$i; do
+            for f in STRUCT_2_FUNCTION_NAME JSON_2_FUNCTION_NAME STRUCT_2_JSON_STR_FUNCTION_NAME JSON_STR_2_FUNCTION_NAME \
+                     STRUCT_2_MSGPACK_FUNCTION_NAME MSGPACK_2_FUNCTION_NAME COPY_FUNCTION_NAME RECYCLE_FUNCTION_NAME; do
+                echo "    (void *) $f($t),"
+            done
+        done
+        echo "};"
+        i=$((i + 1))
+    done
+}
+
+gen DEFINE_STRUCT > "$TMP/unrolled.c"
+gen DEFINE_STRUCT_COMPACT > "$TMP/compact.c"
+for v in unrolled compact; do
+    $CC -O2 -std=gnu11 -Iinclude "$@" -c "$TMP/$v.c" -o "$TMP/$v.o" || exit 1
+done
+echo "$((N * 2)) types, text/data/bss in bytes:"
+size "$TMP/unrolled.o" "$TMP/compact.o" | sed "s|$TMP/||"
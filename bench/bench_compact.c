@@ -0,0 +1,99 @@
+/**
+ * @file bench_compact.c
+ * @brief Compare the throughput of the unrolled functions (DEFINE_STRUCT) with the table-driven engine (DEFINE_STRUCT_COMPACT)
+ *
+ * @note The code size is compared by bench_code_size.sh
+ */
+
+
+#include "bench.h"
+
+
+DEFINE_STRUCT_COMPACT(CompactSon,
+    (OBJ(STRING), name)
+    (OBJ(INT), age)
+    (OBJ(STRING), birthday)
+    (OBJ(CHAR), sex)
+)
+
+DEFINE_STRUCT_COMPACT(CompactPerson,
+    (OBJ(STRING), name)
+    (OBJ(INT), age)
+    (OBJ(STRING), birthday)
+    (OBJ(CHAR), sex)
+    (OBJ(STRING), couple)
+    (OBJ(CompactSon), son)
+    (ARRAY(CompactSon, 2), sons)
+    (VA_ARRAY(CompactSon), v_sons)
+)
+
+
+/**
+ * @brief Run the same operation on both variants of the person
+ */
+#define BENCH_BOTH(label, children, iterations, bytes, body_person, body_compact) do { \
+    char name_[64]; \
+    int i_ = 0; \
+    uint64_t begin_ = bench_now_ns(); \
+    for (i_ = 0; i_ < (iterations); ++i_) { body_person; } \
+    snprintf(name_, sizeof(name_), "%s unrolled (%zu children)", label, (size_t) (children)); \
+    bench_report(name_, bench_now_ns() - begin_, (iterations), (bytes) * (iterations)); \
+    begin_ = bench_now_ns(); \
+    for (i_ = 0; i_ < (iterations); ++i_) { body_compact; } \
+    snprintf(name_, sizeof(name_), "%s compact  (%zu children)", label, (size_t) (children)); \
+    bench_report(name_, bench_now_ns() - begin_, (iterations), (bytes) * (iterations)); \
+} while (0)
+
+
+static void run(size_t children, int iterations)
+{
+    DECLARE_STRUCT(Person, person);
+    bench_fill_person(&person, children);
+    /* The layouts are the same, only the names differ */
+    GET_STRUCT_NAME(CompactPerson) compact;
+    memcpy(&compact, &person, sizeof(compact));
+
+    char * json = S2J(Person, &person);
+    char * compact_json = S2J(CompactPerson, &compact);
+    size_t len = 0;
+    char * msgpack = S2M(Person, &person, &len);
+    if (NULL == json || NULL == compact_json || NULL == msgpack || 0 != strcmp(json, compact_json))
+    {
+        printf("the outputs differ\n");
+        return;
+    }
+    size_t bytes = strlen(json);
+    DECLARE_STRUCT(Person, decoded);
+    DECLARE_STRUCT(CompactPerson, compact_decoded);
+    DECLARE_STRUCT(Person, copied);
+    DECLARE_STRUCT(CompactPerson, compact_copied);
+
+    BENCH_BOTH("s2j", children, iterations, bytes,
+        json_wrapper_free(S2J(Person, &person)),
+        json_wrapper_free(S2J(CompactPerson, &compact)));
+    BENCH_BOTH("j2s", children, iterations, bytes,
+        J2S(json, Person, &decoded); RECYCLE_ST(Person, &decoded),
+        J2S(json, CompactPerson, &compact_decoded); RECYCLE_ST(CompactPerson, &compact_decoded));
+    BENCH_BOTH("s2m", children, iterations, len,
+        size_t l = 0; json_wrapper_free(S2M(Person, &person, &l)),
+        size_t l = 0; json_wrapper_free(S2M(CompactPerson, &compact, &l)));
+    BENCH_BOTH("m2s", children, iterations, len,
+        M2S(msgpack, len, Person, &decoded); RECYCLE_ST(Person, &decoded),
+        M2S(msgpack, len, CompactPerson, &compact_decoded); RECYCLE_ST(CompactPerson, &compact_decoded));
+    BENCH_BOTH("copy", children, iterations, 0,
+        COPY_ST(Person, &person, &copied); RECYCLE_ST(Person, &copied),
+        COPY_ST(CompactPerson, &compact, &compact_copied); RECYCLE_ST(CompactPerson, &compact_copied));
+
+    json_wrapper_free(json);
+    json_wrapper_free(compact_json);
+    json_wrapper_free(msgpack);
+    json_wrapper_free(person.v_sons.v_sons);
+}
+
+int main(int argc, char * argv[])
+{
+    run(0, 200000);
+    run(10, 50000);
+    run(1000, 500);
+    return 0;
+}
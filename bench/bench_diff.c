@@ -0,0 +1,94 @@
+/**
+ * @file bench_diff.c
+ * @brief Compare sending the whole S2J of a Person on a change of its age with sending the DIFF_ST merge patch,
+ *        and applying the patch with PATCH_ST on the other side
+ */
+
+
+#include "bench.h"
+
+
+static uint64_t g_allocs = 0;
+
+static void * counting_alloc(size_t size)
+{
+    ++g_allocs;
+    return malloc(size);
+}
+
+static void report(const char * label, size_t children, uint64_t begin, int iterations, size_t bytes)
+{
+    char name[64];
+    snprintf(name, sizeof(name), "%-18s (%zu children)", label, children);
+    bench_report(name, bench_now_ns() - begin, iterations, (uint64_t) bytes * iterations);
+    printf("%-40s %12.1f allocs/op %8zu bytes/op\n", "", (double) g_allocs / iterations, bytes);
+}
+
+static void run(size_t children, int iterations)
+{
+    DECLARE_STRUCT(Person, person);
+    bench_fill_person(&person, children);
+    char * json = S2J(Person, &person);
+    json_wrapper_free(person.v_sons.v_sons);
+    if (NULL == json) return;
+    DECLARE_STRUCT(Person, sent);
+    DECLARE_STRUCT(Person, current);
+    DECLARE_STRUCT(Person, received);
+    J2S(json, Person, &sent);
+    COPY_ST(Person, &sent, &current);
+    COPY_ST(Person, &sent, &received);
+    size_t bytes = 0;
+    long sum = 0;
+    int i = 0;
+
+    g_allocs = 0;
+    uint64_t begin = bench_now_ns();
+    for (i = 0; i < iterations; ++i)
+    {
+        ++current.age;
+        char * text = S2J(Person, &current);
+        bytes = strlen(text);
+        sum += text[bytes - 1];
+        json_wrapper_free(text);
+    }
+    report("s2j", children, begin, iterations, bytes);
+
+    g_allocs = 0;
+    begin = bench_now_ns();
+    for (i = 0; i < iterations; ++i)
+    {
+        ++current.age;
+        char * patch = DIFF_ST(Person, &sent, &current);
+        bytes = strlen(patch);
+        sum += patch[bytes - 1];
+        json_wrapper_free(patch);
+        sent.age = current.age;
+    }
+    report("diff_st", children, begin, iterations, bytes);
+
+    g_allocs = 0;
+    begin = bench_now_ns();
+    for (i = 0; i < iterations; ++i)
+    {
+        char patch[32];
+        snprintf(patch, sizeof(patch), "{\"age\":%d}", i);
+        PATCH_ST(Person, patch, &received);
+        sum += received.age;
+    }
+    report("patch_st", children, begin, iterations, 0);
+
+    printf("  (sum %ld)\n", sum);
+    RECYCLE_ST(Person, &sent);
+    RECYCLE_ST(Person, &current);
+    RECYCLE_ST(Person, &received);
+    json_wrapper_free(json);
+}
+
+int main(int argc, char * argv[])
+{
+    json_wrapper_hook_alloc(counting_alloc);
+    run(0, 200000);
+    run(10, 50000);
+    run(1000, 500);
+    return 0;
+}
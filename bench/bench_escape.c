@@ -0,0 +1,100 @@
+/**
+ * @file bench_escape.c
+ * @brief Compare the throughput of writing json strings by cJSON_CreateString and cJSON_PrintUnformatted
+ *        with the string writer of S2J on each instruction set, over an ASCII-heavy and an escape-heavy corpus
+ */
+
+
+#include "bench.h"
+
+
+/**
+ * @brief The number of strings in a corpus
+ */
+#define STRINGS 256
+
+static const char * const g_simd_names[] = { "scalar", "sse2", "avx2" };
+
+/**
+ * @brief Fill @p count strings of @p len bytes, of words in plain ASCII or with a quote, a backslash, a newline
+ *        or a tab about every 8 bytes
+ */
+static char ** make_corpus(size_t len, bool escapes)
+{
+    static const char ascii[] = "lorem ipsum dolor sit amet consectetur adipiscing elit sed do eiusmod tempor ";
+    static const char special[] = "\"\\\n\t";
+    char ** corpus = json_wrapper_alloc(STRINGS * sizeof(char *));
+    size_t i = 0;
+    size_t j = 0;
+    for (i = 0; i < STRINGS; ++i)
+    {
+        corpus[i] = json_wrapper_alloc(len + 1);
+        for (j = 0; j < len; ++j)
+        {
+            corpus[i][j] = escapes && 0 == (i + j * 5) % 37 % 8 ? special[(i + j) % 4] : ascii[(i * 7 + j) % (sizeof(ascii) - 1)];
+        }
+        corpus[i][len] = '\0';
+    }
+    return corpus;
+}
+
+static void run(const char * corpus_name, size_t len, bool escapes, int iterations)
+{
+    char ** corpus = make_corpus(len, escapes);
+    char name[64];
+    long sum = 0;
+    int i = 0;
+    size_t k = 0;
+    uint64_t bytes = (uint64_t) len * STRINGS * iterations;
+
+    uint64_t begin = bench_now_ns();
+    for (i = 0; i < iterations; ++i)
+    {
+        for (k = 0; k < STRINGS; ++k)
+        {
+            cJSON * obj = cJSON_CreateString(corpus[k]);
+            char * text = cJSON_PrintUnformatted(obj);
+            sum += text[1];
+            cJSON_free(text);
+            cJSON_Delete(obj);
+        }
+    }
+    snprintf(name, sizeof(name), "%s %zu cjson", corpus_name, len);
+    bench_report(name, bench_now_ns() - begin, (uint64_t) iterations * STRINGS, bytes);
+
+    GET_STRUCT_NAME(Buffer) buf = { 0 };
+    int level = SIMD_SCALAR;
+    for (level = SIMD_SCALAR; level <= SIMD_AVX2; ++level)
+    {
+        if (json_wrapper_simd_limit(level) != level) continue;
+        begin = bench_now_ns();
+        for (i = 0; i < iterations; ++i)
+        {
+            for (k = 0; k < STRINGS; ++k)
+            {
+                buf.len = 0;
+                json_wrapper_buffer_append_string(&buf, corpus[k]);
+                sum += buf.data[1];
+            }
+        }
+        snprintf(name, sizeof(name), "%s %zu s2j %s", corpus_name, len, g_simd_names[level]);
+        bench_report(name, bench_now_ns() - begin, (uint64_t) iterations * STRINGS, bytes);
+    }
+    json_wrapper_simd_limit(SIMD_AVX2);
+
+    printf("  (sum %ld)\n", sum);
+    json_wrapper_buffer_release(&buf);
+    for (k = 0; k < STRINGS; ++k) json_wrapper_free(corpus[k]);
+    json_wrapper_free(corpus);
+}
+
+int main(int argc, char * argv[])
+{
+    run("ascii", 16, false, 2000);
+    run("ascii", 256, false, 500);
+    run("ascii", 4096, false, 50);
+    run("escapes", 16, true, 2000);
+    run("escapes", 256, true, 500);
+    run("escapes", 4096, true, 50);
+    return 0;
+}
@@ -0,0 +1,114 @@
+/**
+ * @file bench_fixed.c
+ * @brief Compare the sample model with STRING fields against the same model with FIXED_STRING fields
+ *        under J2S, COPY_ST and RECYCLE_ST
+ */
+
+
+#include "bench.h"
+
+
+DEFINE_STRUCT(FixedSon,
+    (FIXED_STRING(24), name)
+    (OBJ(INT), age)
+    (FIXED_STRING(11), birthday)
+    (OBJ(CHAR), sex)
+)
+
+DEFINE_STRUCT(FixedPerson,
+    (FIXED_STRING(24), name)
+    (OBJ(INT), age)
+    (FIXED_STRING(11), birthday)
+    (OBJ(CHAR), sex)
+    (FIXED_STRING(24), couple)
+    (OBJ(FixedSon), son)
+    (ARRAY(FixedSon, 2), sons)
+    (VA_ARRAY(FixedSon), v_sons)
+)
+
+
+static uint64_t g_allocs = 0;
+
+static void * counting_alloc(size_t size)
+{
+    ++g_allocs;
+    return malloc(size);
+}
+
+static void report(const char * label, size_t children, uint64_t begin, int iterations, size_t bytes)
+{
+    char name[64];
+    snprintf(name, sizeof(name), "%-18s (%zu children)", label, children);
+    bench_report(name, bench_now_ns() - begin, iterations, (uint64_t) bytes * iterations);
+    printf("%-40s %12.1f allocs/op\n", "", (double) g_allocs / iterations);
+}
+
+static void run(size_t children, int iterations)
+{
+    DECLARE_STRUCT(Person, person);
+    bench_fill_person(&person, children);
+    char * json = S2J(Person, &person);
+    json_wrapper_free(person.v_sons.v_sons);
+    if (NULL == json) return;
+    size_t bytes = strlen(json);
+    DECLARE_STRUCT(Person, decoded);
+    DECLARE_STRUCT(Person, copied);
+    DECLARE_STRUCT(FixedPerson, fixed);
+    DECLARE_STRUCT(FixedPerson, fixed_copied);
+    long sum = 0;
+    int i = 0;
+
+    g_allocs = 0;
+    uint64_t begin = bench_now_ns();
+    for (i = 0; i < iterations; ++i)
+    {
+        J2S(json, Person, &decoded);
+        sum += decoded.age;
+        RECYCLE_ST(Person, &decoded);
+    }
+    report("j2s string", children, begin, iterations, bytes);
+
+    g_allocs = 0;
+    begin = bench_now_ns();
+    for (i = 0; i < iterations; ++i)
+    {
+        J2S(json, FixedPerson, &fixed);
+        sum += fixed.age;
+        RECYCLE_ST(FixedPerson, &fixed);
+    }
+    report("j2s fixed", children, begin, iterations, bytes);
+
+    J2S(json, Person, &decoded);
+    g_allocs = 0;
+    begin = bench_now_ns();
+    for (i = 0; i < iterations; ++i)
+    {
+        COPY_ST(Person, &decoded, &copied);
+        RECYCLE_ST(Person, &copied);
+    }
+    report("copy string", children, begin, iterations, 0);
+
+    J2S(json, FixedPerson, &fixed);
+    g_allocs = 0;
+    begin = bench_now_ns();
+    for (i = 0; i < iterations; ++i)
+    {
+        COPY_ST(FixedPerson, &fixed, &fixed_copied);
+        RECYCLE_ST(FixedPerson, &fixed_copied);
+    }
+    report("copy fixed", children, begin, iterations, 0);
+
+    printf("  (sum %ld)\n", sum);
+    RECYCLE_ST(Person, &decoded);
+    RECYCLE_ST(FixedPerson, &fixed);
+    json_wrapper_free(json);
+}
+
+int main(int argc, char * argv[])
+{
+    json_wrapper_hook_alloc(counting_alloc);
+    run(0, 200000);
+    run(10, 50000);
+    run(1000, 500);
+    return 0;
+}
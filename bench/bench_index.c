@@ -0,0 +1,133 @@
+/**
+ * @file bench_index.c
+ * @brief Measure the throughput of building the structural index on each instruction set against cJSON_Parse,
+ *        and compare J2S and J2S_MASK of a large Person with J2S_INDEX over the index
+ */
+
+
+#include "bench.h"
+
+
+static const char * const g_simd_names[] = { "scalar", "sse2", "avx2" };
+
+static const GET_STRUCT_NAME(Mask) g_name_age = { GET_FIELD_BIT(Person, name) | GET_FIELD_BIT(Person, age), NULL };
+
+static const GET_STRUCT_NAME(Mask) g_son_age = { GET_FIELD_BIT(Son, age), NULL };
+static const GET_STRUCT_NAME(Mask) * const g_person_subs[GET_FIELD_COUNT(Person)] = {
+    [GET_FIELD_INDEX(Person, v_sons)] = &g_son_age,
+};
+static const GET_STRUCT_NAME(Mask) g_children_ages = { GET_FIELD_BIT(Person, v_sons), g_person_subs };
+
+static void report(const char * label, size_t children, uint64_t begin, int iterations, size_t bytes)
+{
+    char name[64];
+    uint64_t ns = bench_now_ns() - begin;
+    snprintf(name, sizeof(name), "%-18s (%zu children)", label, children);
+    bench_report(name, ns, iterations, 0);
+    printf("%-40s %12.2f GB/s\n", "", (double) bytes * iterations / ns);
+}
+
+static void run(size_t children, int iterations)
+{
+    DECLARE_STRUCT(Person, person);
+    bench_fill_person(&person, children);
+    char * json = S2J(Person, &person);
+    json_wrapper_free(person.v_sons.v_sons);
+    if (NULL == json) return;
+    size_t bytes = strlen(json);
+    GET_STRUCT_NAME(Index) index = { 0 };
+    DECLARE_STRUCT(Person, decoded);
+    char name[32];
+    long sum = 0;
+    int i = 0;
+
+    uint64_t begin = bench_now_ns();
+    for (i = 0; i < iterations; ++i)
+    {
+        cJSON * root = cJSON_Parse(json);
+        sum += cJSON_GetArraySize(cJSON_GetObjectItem(root, "v_sons"));
+        cJSON_Delete(root);
+    }
+    report("cjson parse", children, begin, iterations, bytes);
+
+    int level = SIMD_SCALAR;
+    for (level = SIMD_SCALAR; level <= SIMD_AVX2; ++level)
+    {
+        if (json_wrapper_simd_limit(level) != level) continue;
+        begin = bench_now_ns();
+        for (i = 0; i < iterations; ++i)
+        {
+            json_wrapper_index_build(&index, json, bytes);
+            sum += index.count;
+        }
+        snprintf(name, sizeof(name), "index %s", g_simd_names[level]);
+        report(name, children, begin, iterations, bytes);
+    }
+    json_wrapper_simd_limit(SIMD_AVX2);
+
+    begin = bench_now_ns();
+    for (i = 0; i < iterations; ++i)
+    {
+        J2S(json, Person, &decoded);
+        sum += decoded.v_sons.size;
+        RECYCLE_ST(Person, &decoded);
+    }
+    report("j2s", children, begin, iterations, bytes);
+
+    begin = bench_now_ns();
+    for (i = 0; i < iterations; ++i)
+    {
+        J2S_INDEX(json, bytes, Person, &decoded, NULL, &index);
+        sum += decoded.v_sons.size;
+        RECYCLE_ST(Person, &decoded);
+    }
+    report("j2s_index", children, begin, iterations, bytes);
+
+    begin = bench_now_ns();
+    for (i = 0; i < iterations; ++i)
+    {
+        J2S_MASK(json, Person, &decoded, &g_name_age);
+        sum += decoded.age;
+        RECYCLE_ST(Person, &decoded);
+    }
+    report("j2s_mask name+age", children, begin, iterations, bytes);
+
+    begin = bench_now_ns();
+    for (i = 0; i < iterations; ++i)
+    {
+        J2S_INDEX(json, bytes, Person, &decoded, &g_name_age, &index);
+        sum += decoded.age;
+        RECYCLE_ST(Person, &decoded);
+    }
+    report("j2s_index name+age", children, begin, iterations, bytes);
+
+    begin = bench_now_ns();
+    for (i = 0; i < iterations; ++i)
+    {
+        J2S_MASK(json, Person, &decoded, &g_children_ages);
+        sum += decoded.v_sons.size;
+        RECYCLE_ST(Person, &decoded);
+    }
+    report("j2s_mask son ages", children, begin, iterations, bytes);
+
+    begin = bench_now_ns();
+    for (i = 0; i < iterations; ++i)
+    {
+        J2S_INDEX(json, bytes, Person, &decoded, &g_children_ages, &index);
+        sum += decoded.v_sons.size;
+        RECYCLE_ST(Person, &decoded);
+    }
+    report("j2s_index son ages", children, begin, iterations, bytes);
+
+    printf("  (sum %ld)\n", sum);
+    json_wrapper_index_release(&index);
+    json_wrapper_free(json);
+}
+
+int main(int argc, char * argv[])
+{
+    run(1000, 500);
+    run(10000, 50);
+    run(100000, 5);
+    return 0;
+}
@@ -0,0 +1,88 @@
+/**
+ * @file bench_mask.c
+ * @brief Compare J2S of a whole Person with J2S_MASK of its name and age only, as the payload grows
+ */
+
+
+#include "bench.h"
+
+
+static uint64_t g_allocs = 0;
+
+static void * counting_alloc(size_t size)
+{
+    ++g_allocs;
+    return malloc(size);
+}
+
+static const GET_STRUCT_NAME(Mask) g_name_age = { GET_FIELD_BIT(Person, name) | GET_FIELD_BIT(Person, age), NULL };
+
+static const GET_STRUCT_NAME(Mask) g_son_age = { GET_FIELD_BIT(Son, age), NULL };
+static const GET_STRUCT_NAME(Mask) * const g_person_subs[GET_FIELD_COUNT(Person)] = {
+    [GET_FIELD_INDEX(Person, v_sons)] = &g_son_age,
+};
+static const GET_STRUCT_NAME(Mask) g_children_ages = { GET_FIELD_BIT(Person, v_sons), g_person_subs };
+
+static void report(const char * label, size_t children, uint64_t begin, int iterations, size_t bytes)
+{
+    char name[64];
+    snprintf(name, sizeof(name), "%-18s (%zu children)", label, children);
+    bench_report(name, bench_now_ns() - begin, iterations, (uint64_t) bytes * iterations);
+    printf("%-40s %12.1f allocs/op\n", "", (double) g_allocs / iterations);
+}
+
+static void run(size_t children, int iterations)
+{
+    DECLARE_STRUCT(Person, person);
+    bench_fill_person(&person, children);
+    char * json = S2J(Person, &person);
+    json_wrapper_free(person.v_sons.v_sons);
+    if (NULL == json) return;
+    size_t bytes = strlen(json);
+    DECLARE_STRUCT(Person, decoded);
+    long sum = 0;
+    int i = 0;
+
+    g_allocs = 0;
+    uint64_t begin = bench_now_ns();
+    for (i = 0; i < iterations; ++i)
+    {
+        J2S(json, Person, &decoded);
+        sum += decoded.age;
+        RECYCLE_ST(Person, &decoded);
+    }
+    report("j2s", children, begin, iterations, bytes);
+
+    g_allocs = 0;
+    begin = bench_now_ns();
+    for (i = 0; i < iterations; ++i)
+    {
+        J2S_MASK(json, Person, &decoded, &g_name_age);
+        sum += decoded.age;
+        RECYCLE_ST(Person, &decoded);
+    }
+    report("j2s_mask name+age", children, begin, iterations, bytes);
+
+    g_allocs = 0;
+    begin = bench_now_ns();
+    for (i = 0; i < iterations; ++i)
+    {
+        J2S_MASK(json, Person, &decoded, &g_children_ages);
+        sum += decoded.v_sons.size;
+        RECYCLE_ST(Person, &decoded);
+    }
+    report("j2s_mask son ages", children, begin, iterations, bytes);
+
+    printf("  (sum %ld)\n", sum);
+    json_wrapper_free(json);
+}
+
+int main(int argc, char * argv[])
+{
+    json_wrapper_hook_alloc(counting_alloc);
+    run(0, 200000);
+    run(10, 50000);
+    run(1000, 500);
+    run(10000, 50);
+    return 0;
+}
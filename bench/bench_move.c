@@ -0,0 +1,73 @@
+/**
+ * @file bench_move.c
+ * @brief Compare handing a decoded Person to the next stage by COPY_ST and RECYCLE_ST of the source with MOVE_ST
+ */
+
+
+#include "bench.h"
+
+
+static uint64_t g_allocs = 0;
+
+static void * counting_alloc(size_t size)
+{
+    ++g_allocs;
+    return malloc(size);
+}
+
+static void report(const char * label, size_t children, uint64_t begin, int iterations)
+{
+    char name[64];
+    snprintf(name, sizeof(name), "%-18s (%zu children)", label, children);
+    bench_report(name, bench_now_ns() - begin, iterations, 0);
+    printf("%-40s %12.1f allocs/op\n", "", (double) g_allocs / iterations);
+}
+
+static void run(size_t children, int iterations)
+{
+    DECLARE_STRUCT(Person, person);
+    bench_fill_person(&person, children);
+    char * json = S2J(Person, &person);
+    json_wrapper_free(person.v_sons.v_sons);
+    if (NULL == json) return;
+    DECLARE_STRUCT(Person, stage1);
+    DECLARE_STRUCT(Person, stage2);
+    long sum = 0;
+    int i = 0;
+
+    J2S(json, Person, &stage1);
+    g_allocs = 0;
+    uint64_t begin = bench_now_ns();
+    for (i = 0; i < iterations; ++i)
+    {
+        COPY_ST(Person, &stage1, &stage2);
+        RECYCLE_ST(Person, &stage1);
+        COPY_ST(Person, &stage2, &stage1);
+        RECYCLE_ST(Person, &stage2);
+        sum += stage1.age;
+    }
+    report("copy + recycle", children, begin, iterations * 2);
+
+    g_allocs = 0;
+    begin = bench_now_ns();
+    for (i = 0; i < iterations; ++i)
+    {
+        MOVE_ST(Person, &stage1, &stage2);
+        MOVE_ST(Person, &stage2, &stage1);
+        sum += stage1.age;
+    }
+    report("move", children, begin, iterations * 2);
+
+    printf("  (sum %ld)\n", sum);
+    RECYCLE_ST(Person, &stage1);
+    json_wrapper_free(json);
+}
+
+int main(int argc, char * argv[])
+{
+    json_wrapper_hook_alloc(counting_alloc);
+    run(0, 200000);
+    run(10, 50000);
+    run(1000, 500);
+    return 0;
+}
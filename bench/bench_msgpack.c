@@ -0,0 +1,71 @@
+/**
+ * @file bench_msgpack.c
+ * @brief Compare the size and throughput of MessagePack (S2M/M2S) with json (S2J/J2S) on the same structs
+ */
+
+
+#include "bench.h"
+
+
+static void run(size_t children, int iterations)
+{
+    char name[64];
+    DECLARE_STRUCT(Person, person);
+    bench_fill_person(&person, children);
+    char * json = S2J(Person, &person);
+    size_t msgpack_len = 0;
+    char * msgpack = S2M(Person, &person, &msgpack_len);
+    if (NULL == json || NULL == msgpack) return;
+    size_t json_len = strlen(json);
+    printf("%zu children: json %zu bytes, msgpack %zu bytes (%.1f%%)\n",
+        children, json_len, msgpack_len, 100.0 * msgpack_len / json_len);
+
+    DECLARE_STRUCT(Person, decoded);
+    int i = 0;
+    uint64_t begin = bench_now_ns();
+    for (i = 0; i < iterations; ++i)
+    {
+        json_wrapper_free(S2J(Person, &person));
+    }
+    snprintf(name, sizeof(name), "s2j (%zu children)", children);
+    bench_report(name, bench_now_ns() - begin, iterations, json_len * iterations);
+
+    begin = bench_now_ns();
+    for (i = 0; i < iterations; ++i)
+    {
+        size_t len = 0;
+        json_wrapper_free(S2M(Person, &person, &len));
+    }
+    snprintf(name, sizeof(name), "s2m (%zu children)", children);
+    bench_report(name, bench_now_ns() - begin, iterations, msgpack_len * iterations);
+
+    begin = bench_now_ns();
+    for (i = 0; i < iterations; ++i)
+    {
+        J2S(json, Person, &decoded);
+        RECYCLE_ST(Person, &decoded);
+    }
+    snprintf(name, sizeof(name), "j2s (%zu children)", children);
+    bench_report(name, bench_now_ns() - begin, iterations, json_len * iterations);
+
+    begin = bench_now_ns();
+    for (i = 0; i < iterations; ++i)
+    {
+        M2S(msgpack, msgpack_len, Person, &decoded);
+        RECYCLE_ST(Person, &decoded);
+    }
+    snprintf(name, sizeof(name), "m2s (%zu children)", children);
+    bench_report(name, bench_now_ns() - begin, iterations, msgpack_len * iterations);
+
+    json_wrapper_free(json);
+    json_wrapper_free(msgpack);
+    json_wrapper_free(person.v_sons.v_sons);
+}
+
+int main(int argc, char * argv[])
+{
+    run(0, 200000);
+    run(10, 50000);
+    run(1000, 500);
+    return 0;
+}
@@ -0,0 +1,115 @@
+/**
+ * @file bench_ndjson.c
+ * @brief Compare decoding an NDJSON file line by line with getline and J2S against J2S_NEXT over a descriptor and a mapping
+ */
+
+
+#define _GNU_SOURCE
+#include <fcntl.h>
+#include <unistd.h>
+#include "bench.h"
+
+
+/**
+ * @brief Write @p records persons into @p path as NDJSON
+ */
+static size_t write_file(const char * path, size_t records)
+{
+    DECLARE_STRUCT(Person, person);
+    bench_fill_person(&person, 2);
+    GET_STRUCT_NAME(Sink) sink;
+    FILE * file = fopen(path, "w");
+    if (NULL == file) return 0;
+    size_t bytes = 0;
+    size_t i = 0;
+    for (i = 0; i < records; ++i)
+    {
+        GET_STRUCT_NAME(Buffer) buf;
+        memset(&buf, 0, sizeof(GET_STRUCT_NAME(Buffer)));
+        person.age = (int) i;
+        json_wrapper_sink_init_buffer(&sink, &buf, BATCH_NDJSON);
+        S2J_BATCH(Person, &person, 1, &sink);
+        bytes += fwrite(buf.data, 1, buf.len, file);
+        json_wrapper_buffer_release(&buf);
+    }
+    fclose(file);
+    json_wrapper_free(person.v_sons.v_sons);
+    return bytes;
+}
+
+static void report(const char * name, uint64_t begin, size_t records, size_t bytes, long sum)
+{
+    char label[64];
+    snprintf(label, sizeof(label), "%s (sum %ld)", name, sum);
+    bench_report(label, bench_now_ns() - begin, records, bytes);
+}
+
+int main(int argc, char * argv[])
+{
+    const char * path = argc > 2 ? argv[2] : "/tmp/json_wrapper_bench.ndjson";
+    size_t records = argc > 1 ? strtoul(argv[1], NULL, 10) : 200000;
+    size_t bytes = write_file(path, records);
+    if (0 == bytes) return 1;
+    printf("%zu records, %zu bytes\n", records, bytes);
+    DECLARE_STRUCT(Person, person);
+    long sum = 0;
+
+    FILE * file = fopen(path, "r");
+    char * line = NULL;
+    size_t cap = 0;
+    uint64_t begin = bench_now_ns();
+    while (getline(&line, &cap, file) > 0)
+    {
+        if (0 == J2S(line, Person, &person)) sum += person.age;
+    }
+    report("getline + j2s", begin, records, bytes, sum);
+    free(line);
+    fclose(file);
+    RECYCLE_ST(Person, &person);
+
+    GET_STRUCT_NAME(Lines) lines;
+    int fd = open(path, O_RDONLY);
+    json_wrapper_lines_init_fd(&lines, fd, 0);
+    sum = 0;
+    begin = bench_now_ns();
+    int rc = 0;
+    while (0 != (rc = J2S_NEXT(&lines, Person, &person)))
+    {
+        if (1 == rc) sum += person.age;
+    }
+    report("j2s_next fd", begin, records, bytes, sum);
+    printf("  refill buffer %zu bytes\n", lines.cap);
+    json_wrapper_lines_release(&lines);
+    close(fd);
+
+    json_wrapper_lines_init_map(&lines, path);
+    sum = 0;
+    begin = bench_now_ns();
+    while (0 != (rc = J2S_NEXT(&lines, Person, &person)))
+    {
+        if (1 == rc) sum += person.age;
+    }
+    report("j2s_next map", begin, records, bytes, sum);
+    json_wrapper_lines_release(&lines);
+
+    RECYCLE_ST(Person, &person);
+    GET_STRUCT_NAME(Arena) arena;
+    json_wrapper_arena_init(&arena, 0);
+    fd = open(path, O_RDONLY);
+    json_wrapper_lines_init_fd(&lines, fd, 0);
+    lines.arena = &arena;
+    sum = 0;
+    begin = bench_now_ns();
+    while (0 != (rc = J2S_NEXT(&lines, Person, &person)))
+    {
+        if (1 == rc) sum += person.age;
+        json_wrapper_arena_reset(&arena);
+    }
+    report("j2s_next fd + arena", begin, records, bytes, sum);
+    json_wrapper_lines_release(&lines);
+    json_wrapper_arena_release(&arena);
+    close(fd);
+
+    unlink(path);
+    return 0;
+}
@@ -0,0 +1,184 @@
+/**
+ * @file bench_numbers.c
+ * @brief Compare writing and reading records of the INT64, UINT32, UINT64, FLOAT and DOUBLE fields by S2J and J2S
+ *        with the cJSON_CreateNumber path, and count the records changed by each round trip
+ */
+
+
+#include <math.h>
+#include "bench.h"
+
+
+DEFINE_STRUCT(Reading,
+    (OBJ(INT64), id)
+    (OBJ(UINT32), seq)
+    (OBJ(UINT64), ts)
+    (OBJ(FLOAT), temp)
+    (OBJ(DOUBLE), lat)
+    (OBJ(DOUBLE), lon)
+)
+
+DEFINE_STRUCT(Readings,
+    (VA_ARRAY(Reading), items)
+)
+
+
+static uint64_t g_allocs = 0;
+
+static void * counting_alloc(size_t size)
+{
+    ++g_allocs;
+    return malloc(size);
+}
+
+static void report(const char * label, size_t count, uint64_t begin, int iterations, size_t bytes)
+{
+    char name[64];
+    snprintf(name, sizeof(name), "%-18s (%zu readings)", label, count);
+    bench_report(name, bench_now_ns() - begin, iterations, (uint64_t) bytes * iterations);
+    printf("%-40s %12.1f allocs/op\n", "", (double) g_allocs / iterations);
+}
+
+static void fill(GET_STRUCT_NAME(Readings) * readings, size_t count)
+{
+    size_t i = 0;
+    readings->items.items = json_wrapper_alloc(count * sizeof(GET_STRUCT_NAME(Reading)));
+    readings->items.size = count;
+    for (i = 0; i < count; ++i)
+    {
+        GET_STRUCT_NAME(Reading) * r = &readings->items.items[i];
+        r->id = 0x1234567890ABCDLL * 31 + (int64_t) i * 7919;
+        r->seq = (uint32_t) i;
+        r->ts = 1700000000000000000ULL + i * 1000003;
+        r->temp = 20.5f + (float) (i % 100) / 10;
+        r->lat = 48.858370 + (double) i / 1e6;
+        r->lon = 2.294481 + sqrt((double) i) / 1e3;
+    }
+}
+
+static char * cjson_print(GET_STRUCT_NAME(Readings) * readings)
+{
+    cJSON * root = cJSON_CreateObject();
+    cJSON * items = cJSON_CreateArray();
+    size_t i = 0;
+    for (i = 0; i < readings->items.size; ++i)
+    {
+        GET_STRUCT_NAME(Reading) * r = &readings->items.items[i];
+        cJSON * obj = cJSON_CreateObject();
+        cJSON_AddItemToObject(obj, "id", cJSON_CreateNumber((double) r->id));
+        cJSON_AddItemToObject(obj, "seq", cJSON_CreateNumber(r->seq));
+        cJSON_AddItemToObject(obj, "ts", cJSON_CreateNumber((double) r->ts));
+        cJSON_AddItemToObject(obj, "temp", cJSON_CreateNumber(r->temp));
+        cJSON_AddItemToObject(obj, "lat", cJSON_CreateNumber(r->lat));
+        cJSON_AddItemToObject(obj, "lon", cJSON_CreateNumber(r->lon));
+        cJSON_AddItemToArray(items, obj);
+    }
+    cJSON_AddItemToObject(root, "items", items);
+    char * text = cJSON_PrintUnformatted(root);
+    cJSON_Delete(root);
+    return text;
+}
+
+static size_t cjson_parse(const char * text, GET_STRUCT_NAME(Reading) * out, size_t cap)
+{
+    cJSON * root = cJSON_Parse(text);
+    cJSON * obj = NULL;
+    size_t count = 0;
+    cJSON_ArrayForEach(obj, cJSON_GetObjectItem(root, "items"))
+    {
+        if (count == cap) break;
+        GET_STRUCT_NAME(Reading) * r = &out[count++];
+        r->id = (int64_t) cJSON_GetObjectItem(obj, "id")->valuedouble;
+        r->seq = (uint32_t) cJSON_GetObjectItem(obj, "seq")->valuedouble;
+        r->ts = (uint64_t) cJSON_GetObjectItem(obj, "ts")->valuedouble;
+        r->temp = (float) cJSON_GetObjectItem(obj, "temp")->valuedouble;
+        r->lat = cJSON_GetObjectItem(obj, "lat")->valuedouble;
+        r->lon = cJSON_GetObjectItem(obj, "lon")->valuedouble;
+    }
+    cJSON_Delete(root);
+    return count;
+}
+
+static size_t count_lost(GET_STRUCT_NAME(Reading) * a, GET_STRUCT_NAME(Reading) * b, size_t count)
+{
+    size_t lost = 0;
+    size_t i = 0;
+    for (i = 0; i < count; ++i)
+    {
+        lost += a[i].id != b[i].id || a[i].ts != b[i].ts || a[i].temp != b[i].temp
+            || a[i].lat != b[i].lat || a[i].lon != b[i].lon;
+    }
+    return lost;
+}
+
+static void run(size_t count, int iterations)
+{
+    DECLARE_STRUCT(Readings, readings);
+    fill(&readings, count);
+    char * json = S2J(Readings, &readings);
+    char * cjson = cjson_print(&readings);
+    if (NULL == json || NULL == cjson) return;
+    size_t bytes = strlen(json);
+    GET_STRUCT_NAME(Reading) * parsed = json_wrapper_alloc(count * sizeof(GET_STRUCT_NAME(Reading)));
+    DECLARE_STRUCT(Readings, decoded);
+    long sum = 0;
+    int i = 0;
+
+    g_allocs = 0;
+    uint64_t begin = bench_now_ns();
+    for (i = 0; i < iterations; ++i)
+    {
+        char * text = cjson_print(&readings);
+        sum += text[bytes / 2];
+        cJSON_free(text);
+    }
+    report("cjson create+print", count, begin, iterations, strlen(cjson));
+
+    g_allocs = 0;
+    begin = bench_now_ns();
+    for (i = 0; i < iterations; ++i)
+    {
+        char * text = S2J(Readings, &readings);
+        sum += text[bytes / 2];
+        json_wrapper_free(text);
+    }
+    report("s2j", count, begin, iterations, bytes);
+
+    g_allocs = 0;
+    begin = bench_now_ns();
+    for (i = 0; i < iterations; ++i)
+    {
+        sum += cjson_parse(cjson, parsed, count);
+    }
+    report("cjson parse", count, begin, iterations, strlen(cjson));
+
+    g_allocs = 0;
+    begin = bench_now_ns();
+    for (i = 0; i < iterations; ++i)
+    {
+        J2S(json, Readings, &decoded);
+        sum += decoded.items.size;
+        RECYCLE_ST(Readings, &decoded);
+    }
+    report("j2s", count, begin, iterations, bytes);
+
+    J2S(json, Readings, &decoded);
+    printf("  (sum %ld) records changed by the round trip: cjson %zu, j2s %zu of %zu\n", sum,
+        count_lost(readings.items.items, parsed, count),
+        count_lost(readings.items.items, decoded.items.items, decoded.items.size), count);
+    RECYCLE_ST(Readings, &decoded);
+    RECYCLE_ST(Readings, &readings);
+    json_wrapper_free(parsed);
+    cJSON_free(cjson);
+    json_wrapper_free(json);
+}
+
+int main(int argc, char * argv[])
+{
+    json_wrapper_hook_alloc(counting_alloc);
+    json_wrapper_hook_cjson(false);
+    run(1, 200000);
+    run(100, 5000);
+    run(10000, 50);
+    return 0;
+}
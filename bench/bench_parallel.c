@@ -0,0 +1,78 @@
+/**
+ * @file bench_parallel.c
+ * @brief Scaling of J2S_PARALLEL over NDJSON text from 1 to N workers, with even and skewed record sizes
+ *
+ * @note Build with -lpthread
+ */
+
+
+#include <unistd.h>
+#include "bench.h"
+
+
+/**
+ * @brief Encode @p records persons as NDJSON, every 64th one has @p skew children and the others have 2
+ */
+static char * make_text(size_t records, size_t skew, size_t * len)
+{
+    DECLARE_STRUCT(Person, even);
+    DECLARE_STRUCT(Person, heavy);
+    bench_fill_person(&even, 2);
+    bench_fill_person(&heavy, skew);
+    GET_STRUCT_NAME(Buffer) buf;
+    memset(&buf, 0, sizeof(GET_STRUCT_NAME(Buffer)));
+    GET_STRUCT_NAME(Sink) sink;
+    json_wrapper_sink_init_buffer(&sink, &buf, BATCH_NDJSON);
+    size_t i = 0;
+    for (i = 0; i < records; ++i)
+    {
+        GET_STRUCT_NAME(Person) * person = 0 == i % 64 && skew ? &heavy : &even;
+        person->age = (int) i;
+        S2J_BATCH(Person, person, 1, &sink);
+    }
+    json_wrapper_free(even.v_sons.v_sons);
+    json_wrapper_free(heavy.v_sons.v_sons);
+    *len = buf.len;
+    return json_wrapper_buffer_detach(&buf);
+}
+
+static void run(const char * label, size_t records, size_t skew, int max_threads, int rounds)
+{
+    size_t len = 0;
+    char * text = make_text(records, skew, &len);
+    GET_STRUCT_NAME(Person) * people = json_wrapper_alloc(sizeof(GET_STRUCT_NAME(Person)) * records);
+    if (NULL == text || NULL == people) return;
+    memset(people, 0, sizeof(GET_STRUCT_NAME(Person)) * records);
+    printf("%s: %zu records, %zu bytes\n", label, records, len);
+    int threads = 1;
+    for (threads = 1; threads <= max_threads; threads *= 2)
+    {
+        GET_STRUCT_NAME(Parallel) options;
+        memset(&options, 0, sizeof(GET_STRUCT_NAME(Parallel)));
+        options.threads = threads;
+        size_t decoded = 0;
+        uint64_t begin = bench_now_ns();
+        int i = 0;
+        for (i = 0; i < rounds; ++i)
+        {
+            J2S_PARALLEL(text, len, Person, people, records, &options, &decoded);
+        }
+        char name[64];
+        snprintf(name, sizeof(name), "  %d thread(s)", threads);
+        bench_report(name, bench_now_ns() - begin, (uint64_t) decoded * rounds, (uint64_t) len * rounds);
+        if (threads < max_threads && threads * 2 > max_threads) threads = max_threads / 2;
+    }
+    size_t i = 0;
+    for (i = 0; i < records; ++i) RECYCLE_ST(Person, &people[i]);
+    json_wrapper_free(people);
+    json_wrapper_free(text);
+}
+
+int main(int argc, char * argv[])
+{
+    int max_threads = argc > 1 ? atoi(argv[1]) : (int) sysconf(_SC_NPROCESSORS_ONLN);
+    if (max_threads <= 0) max_threads = 1;
+    run("even", 200000, 0, max_threads, 3);
+    run("skewed", 200000, 2000, max_threads, 3);
+    return 0;
+}
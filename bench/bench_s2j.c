@@ -0,0 +1,83 @@
+/**
+ * @file bench_s2j.c
+ * @brief Compare S2J through the streaming writer with printing the intermediate cJSON tree,
+ *        and S2J_INTO writing into a buffer of the caller
+ */
+
+
+#include "bench.h"
+
+
+/**
+ * @brief The old S2J path: build the cJSON tree, print it and delete it
+ */
+static char * s2j_tree(GET_STRUCT_NAME(Person) * person)
+{
+    cJSON * json = STRUCT_2_FUNCTION_NAME(Person)(person);
+    ASSERT_RETURN(json, NULL);
+    char * result = cJSON_PrintUnformatted(json);
+    cJSON_Delete(json);
+    return result;
+}
+
+static void run(size_t children, int iterations)
+{
+    char name[64];
+    DECLARE_STRUCT(Person, person);
+    bench_fill_person(&person, children);
+
+    char * tree = s2j_tree(&person);
+    char * stream = S2J(Person, &person);
+    if (NULL == tree || NULL == stream || 0 != strcmp(tree, stream))
+    {
+        printf("output mismatch with %zu children\n", children);
+    }
+    size_t bytes = strlen(stream);
+    cJSON_free(tree);
+    json_wrapper_free(stream);
+
+    uint64_t begin = bench_now_ns();
+    int i = 0;
+    for (; i < iterations; ++i)
+    {
+        cJSON_free(s2j_tree(&person));
+    }
+    snprintf(name, sizeof(name), "s2j tree   (%zu children)", children);
+    bench_report(name, bench_now_ns() - begin, iterations, bytes * iterations);
+
+    begin = bench_now_ns();
+    for (i = 0; i < iterations; ++i)
+    {
+        json_wrapper_free(S2J(Person, &person));
+    }
+    snprintf(name, sizeof(name), "s2j stream (%zu children)", children);
+    bench_report(name, bench_now_ns() - begin, iterations, bytes * iterations);
+
+    char * out = malloc(bytes + 1);
+    begin = bench_now_ns();
+    for (i = 0; i < iterations && NULL != out; ++i)
+    {
+        S2J_INTO(Person, &person, out, bytes + 1);
+    }
+    snprintf(name, sizeof(name), "s2j into   (%zu children)", children);
+    bench_report(name, bench_now_ns() - begin, iterations, bytes * iterations);
+
+    begin = bench_now_ns();
+    for (i = 0; i < iterations; ++i)
+    {
+        bytes = S2J_SIZE(Person, &person);
+    }
+    snprintf(name, sizeof(name), "s2j size   (%zu children)", children);
+    bench_report(name, bench_now_ns() - begin, iterations, bytes * iterations);
+    free(out);
+
+    json_wrapper_free(person.v_sons.v_sons);
+}
+
+int main(int argc, char * argv[])
+{
+    run(0, 200000);
+    run(10, 50000);
+    run(1000, 500);
+    return 0;
+}
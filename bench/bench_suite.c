@@ -0,0 +1,533 @@
+/**
+ * @file bench_suite.c
+ * @brief The codec benchmark suite built as the json_wrapper_bench target: S2J, J2S, COPY_ST and RECYCLE_ST
+ *        of small, medium, deep, wide and huge types against hand-written cJSON code,
+ *        reported in ns/op, bytes/s and allocs/op
+ *
+ * @note usage: json_wrapper_bench [--json] [--min-ms N] [type...]
+ *           --json      print one json object per result line for trend tracking
+ *           --min-ms N  run each case for at least N milliseconds, 200 by default
+ *           type...     run only the types of these names, e.g. small huge
+ */
+
+
+#include "bench.h"
+
+
+DEFINE_STRUCT(Deep0,
+    (OBJ(STRING), name)
+    (OBJ(INT64), id)
+    (ARRAY(INT, 4), xs)
+)
+DEFINE_STRUCT(Deep1, (OBJ(STRING), name)(OBJ(INT64), id)(ARRAY(INT, 4), xs)(OBJ(Deep0), child))
+DEFINE_STRUCT(Deep2, (OBJ(STRING), name)(OBJ(INT64), id)(ARRAY(INT, 4), xs)(OBJ(Deep1), child))
+DEFINE_STRUCT(Deep3, (OBJ(STRING), name)(OBJ(INT64), id)(ARRAY(INT, 4), xs)(OBJ(Deep2), child))
+DEFINE_STRUCT(Deep4, (OBJ(STRING), name)(OBJ(INT64), id)(ARRAY(INT, 4), xs)(OBJ(Deep3), child))
+DEFINE_STRUCT(Deep5, (OBJ(STRING), name)(OBJ(INT64), id)(ARRAY(INT, 4), xs)(OBJ(Deep4), child))
+DEFINE_STRUCT(Deep6, (OBJ(STRING), name)(OBJ(INT64), id)(ARRAY(INT, 4), xs)(OBJ(Deep5), child))
+DEFINE_STRUCT(Deep7, (OBJ(STRING), name)(OBJ(INT64), id)(ARRAY(INT, 4), xs)(OBJ(Deep6), child))
+
+#define WIDE_FIELDS(i) (OBJ(INT), a##i)(OBJ(STRING), s##i)(OBJ(DOUBLE), d##i)(OBJ(BOOL), b##i)
+
+DEFINE_STRUCT(Wide,
+    WIDE_FIELDS(0) WIDE_FIELDS(1) WIDE_FIELDS(2) WIDE_FIELDS(3) WIDE_FIELDS(4) WIDE_FIELDS(5)
+    WIDE_FIELDS(6) WIDE_FIELDS(7) WIDE_FIELDS(8) WIDE_FIELDS(9) WIDE_FIELDS(10) WIDE_FIELDS(11)
+)
+
+DEFINE_STRUCT(BenchResult,
+    (OBJ(STRING), type)
+    (OBJ(STRING), op)
+    (OBJ(UINT64), ops)
+    (OBJ(DOUBLE), ns_per_op)
+    (OBJ(DOUBLE), bytes_per_s)
+    (OBJ(DOUBLE), allocs_per_op)
+)
+
+
+/**************************************** RAW CJSON BEGIN ****************************************/
+/**
+ * The hand-written cJSON code a user would write without the wrapper: build a tree and print it,
+ * or parse a tree and copy its values out
+ */
+
+static cJSON * raw_create_string(const char * value)
+{
+    return value ? cJSON_CreateString(value) : cJSON_CreateNull();
+}
+
+static char * raw_read_string(cJSON * obj, const char * key)
+{
+    cJSON * item = cJSON_GetObjectItemCaseSensitive(obj, key);
+    ASSERT_RETURN(cJSON_IsString(item), NULL);
+    size_t len = strlen(item->valuestring);
+    char * value = json_wrapper_alloc(len + 1);
+    if (value) memcpy(value, item->valuestring, len + 1);
+    return value;
+}
+
+static double raw_read_number(cJSON * obj, const char * key)
+{
+    cJSON * item = cJSON_GetObjectItemCaseSensitive(obj, key);
+    return cJSON_IsNumber(item) ? item->valuedouble : 0;
+}
+
+static bool raw_read_bool(cJSON * obj, const char * key)
+{
+    cJSON * item = cJSON_GetObjectItemCaseSensitive(obj, key);
+    return NULL != item && (item->type & 0xFF) == cJSON_True;
+}
+
+static char * raw_print(cJSON * root)
+{
+    char * text = cJSON_PrintUnformatted(root);
+    cJSON_Delete(root);
+    return text;
+}
+
+static cJSON * raw_create_son(const GET_STRUCT_NAME(Son) * son)
+{
+    cJSON * obj = cJSON_CreateObject();
+    cJSON_AddItemToObject(obj, "name", raw_create_string(son->name));
+    cJSON_AddItemToObject(obj, "age", cJSON_CreateNumber(son->age));
+    cJSON_AddItemToObject(obj, "birthday", raw_create_string(son->birthday));
+    cJSON_AddItemToObject(obj, "sex", cJSON_CreateNumber(son->sex));
+    return obj;
+}
+
+static void raw_read_son(cJSON * obj, GET_STRUCT_NAME(Son) * son)
+{
+    son->name = raw_read_string(obj, "name");
+    son->age = (int) raw_read_number(obj, "age");
+    son->birthday = raw_read_string(obj, "birthday");
+    son->sex = (char) raw_read_number(obj, "sex");
+}
+
+static char * raw_print_son(void * st)
+{
+    return raw_print(raw_create_son(st));
+}
+
+static int raw_parse_son(const char * text, void * st)
+{
+    cJSON * root = cJSON_Parse(text);
+    ASSERT_RETURN(root, -1);
+    raw_read_son(root, st);
+    cJSON_Delete(root);
+    return 0;
+}
+
+static char * raw_print_person(void * st)
+{
+    GET_STRUCT_NAME(Person) * person = st;
+    cJSON * obj = cJSON_CreateObject();
+    cJSON_AddItemToObject(obj, "name", raw_create_string(person->name));
+    cJSON_AddItemToObject(obj, "age", cJSON_CreateNumber(person->age));
+    cJSON_AddItemToObject(obj, "birthday", raw_create_string(person->birthday));
+    cJSON_AddItemToObject(obj, "sex", cJSON_CreateNumber(person->sex));
+    cJSON_AddItemToObject(obj, "couple", raw_create_string(person->couple));
+    cJSON_AddItemToObject(obj, "son", raw_create_son(&person->son));
+    cJSON * sons = cJSON_CreateArray();
+    size_t i = 0;
+    for (i = 0; i < 2; ++i) cJSON_AddItemToArray(sons, raw_create_son(&person->sons[i]));
+    cJSON_AddItemToObject(obj, "sons", sons);
+    cJSON * v_sons = cJSON_CreateArray();
+    for (i = 0; i < person->v_sons.size; ++i) cJSON_AddItemToArray(v_sons, raw_create_son(&person->v_sons.v_sons[i]));
+    cJSON_AddItemToObject(obj, "v_sons", v_sons);
+    return raw_print(obj);
+}
+
+static int raw_parse_person(const char * text, void * st)
+{
+    GET_STRUCT_NAME(Person) * person = st;
+    cJSON * root = cJSON_Parse(text);
+    ASSERT_RETURN(root, -1);
+    person->name = raw_read_string(root, "name");
+    person->age = (int) raw_read_number(root, "age");
+    person->birthday = raw_read_string(root, "birthday");
+    person->sex = (char) raw_read_number(root, "sex");
+    person->couple = raw_read_string(root, "couple");
+    raw_read_son(cJSON_GetObjectItemCaseSensitive(root, "son"), &person->son);
+    cJSON * item = NULL;
+    size_t i = 0;
+    cJSON_ArrayForEach(item, cJSON_GetObjectItemCaseSensitive(root, "sons"))
+    {
+        if (i < 2) raw_read_son(item, &person->sons[i++]);
+    }
+    cJSON * v_sons = cJSON_GetObjectItemCaseSensitive(root, "v_sons");
+    size_t count = cJSON_GetArraySize(v_sons);
+    person->v_sons.v_sons = count ? json_wrapper_alloc(count * sizeof(GET_STRUCT_NAME(Son))) : NULL;
+    person->v_sons.size = count;
+    i = 0;
+    cJSON_ArrayForEach(item, v_sons)
+    {
+        raw_read_son(item, &person->v_sons.v_sons[i++]);
+    }
+    cJSON_Delete(root);
+    return 0;
+}
+
+static cJSON * raw_create_deep_head(const char * name, int64_t id, const int * xs)
+{
+    cJSON * obj = cJSON_CreateObject();
+    cJSON_AddItemToObject(obj, "name", raw_create_string(name));
+    cJSON_AddItemToObject(obj, "id", cJSON_CreateNumber((double) id));
+    cJSON * array = cJSON_CreateArray();
+    int i = 0;
+    for (i = 0; i < 4; ++i) cJSON_AddItemToArray(array, cJSON_CreateNumber(xs[i]));
+    cJSON_AddItemToObject(obj, "xs", array);
+    return obj;
+}
+
+static void raw_read_deep_head(cJSON * obj, char ** name, int64_t * id, int * xs)
+{
+    *name = raw_read_string(obj, "name");
+    *id = (int64_t) raw_read_number(obj, "id");
+    cJSON * item = NULL;
+    int i = 0;
+    cJSON_ArrayForEach(item, cJSON_GetObjectItemCaseSensitive(obj, "xs"))
+    {
+        if (i < 4) xs[i++] = item->valueint;
+    }
+}
+
+static cJSON * raw_create_Deep0(const GET_STRUCT_NAME(Deep0) * st)
+{
+    return raw_create_deep_head(st->name, st->id, st->xs);
+}
+
+static void raw_read_Deep0(cJSON * obj, GET_STRUCT_NAME(Deep0) * st)
+{
+    raw_read_deep_head(obj, &st->name, &st->id, st->xs);
+}
+
+/**
+ * @brief Define the cJSON code of a level of the deep types, which is the same for each level but its child
+ */
+#define DEFINE_RAW_DEEP(type, inner) \
+static cJSON * raw_create_##type(const GET_STRUCT_NAME(type) * st) \
+{ \
+    cJSON * obj = raw_create_deep_head(st->name, st->id, st->xs); \
+    cJSON_AddItemToObject(obj, "child", raw_create_##inner(&st->child)); \
+    return obj; \
+} \
+static void raw_read_##type(cJSON * obj, GET_STRUCT_NAME(type) * st) \
+{ \
+    raw_read_deep_head(obj, &st->name, &st->id, st->xs); \
+    raw_read_##inner(cJSON_GetObjectItemCaseSensitive(obj, "child"), &st->child); \
+}
+
+DEFINE_RAW_DEEP(Deep1, Deep0)
+DEFINE_RAW_DEEP(Deep2, Deep1)
+DEFINE_RAW_DEEP(Deep3, Deep2)
+DEFINE_RAW_DEEP(Deep4, Deep3)
+DEFINE_RAW_DEEP(Deep5, Deep4)
+DEFINE_RAW_DEEP(Deep6, Deep5)
+DEFINE_RAW_DEEP(Deep7, Deep6)
+
+static char * raw_print_deep(void * st)
+{
+    return raw_print(raw_create_Deep7(st));
+}
+
+static int raw_parse_deep(const char * text, void * st)
+{
+    cJSON * root = cJSON_Parse(text);
+    ASSERT_RETURN(root, -1);
+    raw_read_Deep7(root, st);
+    cJSON_Delete(root);
+    return 0;
+}
+
+#define RAW_WIDE_CREATE(obj, st, i) \
+    cJSON_AddItemToObject(obj, "a" #i, cJSON_CreateNumber((st)->a##i)); \
+    cJSON_AddItemToObject(obj, "s" #i, raw_create_string((st)->s##i)); \
+    cJSON_AddItemToObject(obj, "d" #i, cJSON_CreateNumber((st)->d##i)); \
+    cJSON_AddItemToObject(obj, "b" #i, cJSON_CreateBool((st)->b##i));
+
+#define RAW_WIDE_READ(obj, st, i) \
+    (st)->a##i = (int) raw_read_number(obj, "a" #i); \
+    (st)->s##i = raw_read_string(obj, "s" #i); \
+    (st)->d##i = raw_read_number(obj, "d" #i); \
+    (st)->b##i = raw_read_bool(obj, "b" #i);
+
+static char * raw_print_wide(void * st)
+{
+    GET_STRUCT_NAME(Wide) * wide = st;
+    cJSON * obj = cJSON_CreateObject();
+    RAW_WIDE_CREATE(obj, wide, 0) RAW_WIDE_CREATE(obj, wide, 1) RAW_WIDE_CREATE(obj, wide, 2)
+    RAW_WIDE_CREATE(obj, wide, 3) RAW_WIDE_CREATE(obj, wide, 4) RAW_WIDE_CREATE(obj, wide, 5)
+    RAW_WIDE_CREATE(obj, wide, 6) RAW_WIDE_CREATE(obj, wide, 7) RAW_WIDE_CREATE(obj, wide, 8)
+    RAW_WIDE_CREATE(obj, wide, 9) RAW_WIDE_CREATE(obj, wide, 10) RAW_WIDE_CREATE(obj, wide, 11)
+    return raw_print(obj);
+}
+
+static int raw_parse_wide(const char * text, void * st)
+{
+    GET_STRUCT_NAME(Wide) * wide = st;
+    cJSON * root = cJSON_Parse(text);
+    ASSERT_RETURN(root, -1);
+    RAW_WIDE_READ(root, wide, 0) RAW_WIDE_READ(root, wide, 1) RAW_WIDE_READ(root, wide, 2)
+    RAW_WIDE_READ(root, wide, 3) RAW_WIDE_READ(root, wide, 4) RAW_WIDE_READ(root, wide, 5)
+    RAW_WIDE_READ(root, wide, 6) RAW_WIDE_READ(root, wide, 7) RAW_WIDE_READ(root, wide, 8)
+    RAW_WIDE_READ(root, wide, 9) RAW_WIDE_READ(root, wide, 10) RAW_WIDE_READ(root, wide, 11)
+    cJSON_Delete(root);
+    return 0;
+}
+/**************************************** RAW CJSON  END  ****************************************/
+
+
+/**
+ * @brief The operations of a type, over structs passed as @p void *
+ */
+typedef struct BenchOps
+{
+    size_t size;
+    char * (* s2j)(void * st);
+    int (* j2s)(char * json, void * st);
+    void (* copy)(void * src, void * dst);
+    void (* recycle)(void * st);
+    char * (* raw_print)(void * st);
+    int (* raw_parse)(const char * json, void * st);
+} BenchOps;
+
+/**
+ * @brief Define the operations of a type by its wrapper macros and its hand-written cJSON code
+ */
+#define DEFINE_BENCH_OPS(type, print, parse) \
+static char * bench_s2j_##type(void * st) { return S2J(type, st); } \
+static int bench_j2s_##type(char * json, void * st) { return J2S(json, type, st); } \
+static void bench_copy_##type(void * src, void * dst) { COPY_ST(type, src, dst); } \
+static void bench_recycle_##type(void * st) { RECYCLE_ST(type, st); } \
+static const BenchOps g_##type##_ops = { sizeof(GET_STRUCT_NAME(type)), \
+    bench_s2j_##type, bench_j2s_##type, bench_copy_##type, bench_recycle_##type, print, parse };
+
+DEFINE_BENCH_OPS(Son, raw_print_son, raw_parse_son)
+DEFINE_BENCH_OPS(Person, raw_print_person, raw_parse_person)
+DEFINE_BENCH_OPS(Deep7, raw_print_deep, raw_parse_deep)
+DEFINE_BENCH_OPS(Wide, raw_print_wide, raw_parse_wide)
+
+typedef enum BenchOp
+{
+    OP_S2J,
+    OP_J2S,
+    OP_COPY,
+    OP_RECYCLE,
+    OP_RAW_PRINT,
+    OP_RAW_PARSE,
+    OP_COUNT,
+} BenchOp;
+
+static const char * const g_op_names[OP_COUNT] = {
+    "s2j", "j2s", "copy_st", "recycle_st", "cjson create+print", "cjson parse+read",
+};
+
+/**
+ * @brief The number of structs decoded or copied in a round before they're recycled out of the clock
+ */
+#define BENCH_BATCH 64
+
+static bool g_json = false;
+static uint64_t g_min_ns = 200000000ULL;
+static bool g_counting = false;
+static uint64_t g_allocs = 0;
+
+static void * counting_alloc(size_t size)
+{
+    g_allocs += g_counting;
+    return malloc(size);
+}
+
+/**
+ * @brief Run @p count operations @p op on @p objs, only the operations themselves are on the clock
+ *
+ * @return uint64_t The nanoseconds
+ */
+static uint64_t bench_round(const BenchOps * ops, BenchOp op, void * st, char * json, char * objs, size_t count)
+{
+    size_t i = 0;
+    uint64_t begin = 0;
+    uint64_t ns = 0;
+    if (OP_RECYCLE == op)
+    {
+        for (i = 0; i < count; ++i) ops->copy(st, objs + i * ops->size);
+    }
+    g_counting = true;
+    begin = bench_now_ns();
+    for (i = 0; i < count; ++i)
+    {
+        void * obj = objs + i * ops->size;
+        switch (op)
+        {
+            case OP_S2J: json_wrapper_free(ops->s2j(st)); break;
+            case OP_J2S: ops->j2s(json, obj); break;
+            case OP_COPY: ops->copy(st, obj); break;
+            case OP_RECYCLE: ops->recycle(obj); break;
+            case OP_RAW_PRINT: cJSON_free(ops->raw_print(st)); break;
+            case OP_RAW_PARSE: ops->raw_parse(json, obj); break;
+            default: break;
+        }
+    }
+    ns = bench_now_ns() - begin;
+    g_counting = false;
+    if (OP_J2S == op || OP_COPY == op || OP_RAW_PARSE == op)
+    {
+        for (i = 0; i < count; ++i) ops->recycle(objs + i * ops->size);
+    }
+    memset(objs, 0, count * ops->size);
+    return ns;
+}
+
+static void bench_print(const char * type, BenchOp op, uint64_t ops, uint64_t ns, size_t bytes, uint64_t allocs)
+{
+    DECLARE_STRUCT(BenchResult, result);
+    result.type = (char *) type;
+    result.op = (char *) g_op_names[op];
+    result.ops = ops;
+    result.ns_per_op = (double) ns / ops;
+    result.bytes_per_s = bytes ? (double) bytes * ops * 1e9 / ns : 0;
+    result.allocs_per_op = (double) allocs / ops;
+    if (g_json)
+    {
+        char * line = S2J(BenchResult, &result);
+        if (line) printf("%s\n", line);
+        json_wrapper_free(line);
+        return;
+    }
+    char rate[32] = "";
+    if (bytes) snprintf(rate, sizeof(rate), "%10.1f MB/s", result.bytes_per_s / 1e6);
+    printf("%-8s %-20s %14.1f ns/op %15s %12.1f allocs/op\n", type, result.op, result.ns_per_op, rate, result.allocs_per_op);
+}
+
+/**
+ * @brief Run every operation of a type for at least the minimum time
+ *
+ * @param type The name of the type in the results
+ * @param ops The operations
+ * @param st The struct to encode and copy
+ */
+static void bench_type(const char * type, const BenchOps * ops, void * st)
+{
+    char * json = ops->s2j(st);
+    char * raw = ops->raw_print(st);
+    if (NULL == json || NULL == raw)
+    {
+        printf("%s: encoding failed\n", type);
+        return;
+    }
+    size_t bytes = strlen(json);
+    size_t raw_bytes = strlen(raw);
+    size_t batch = bytes > (1 << 20) ? 1 : BENCH_BATCH;
+    char * objs = calloc(batch, ops->size);
+    int op = 0;
+    for (op = 0; op < OP_COUNT && NULL != objs; ++op)
+    {
+        uint64_t count = 0;
+        uint64_t ns = 0;
+        g_allocs = 0;
+        do {
+            ns += bench_round(ops, op, st, OP_RAW_PARSE == op ? raw : json, objs, batch);
+            count += batch;
+        } while (ns < g_min_ns);
+        size_t op_bytes = OP_RAW_PRINT == op || OP_RAW_PARSE == op ? raw_bytes : bytes;
+        bench_print(type, op, count, ns, OP_COPY == op || OP_RECYCLE == op ? 0 : op_bytes, g_allocs);
+    }
+    free(objs);
+    cJSON_free(raw);
+    json_wrapper_free(json);
+}
+
+/**
+ * @brief Fill the deep types from their json text, level @p 7 outermost
+ */
+static void fill_deep(GET_STRUCT_NAME(Deep7) * deep)
+{
+    GET_STRUCT_NAME(Buffer) buf = { 0 };
+    char piece[96];
+    int level = 7;
+    for (level = 7; level >= 0; --level)
+    {
+        int n = snprintf(piece, sizeof(piece), "%s{\"name\":\"level %d\",\"id\":%d%d,\"xs\":[%d,%d,%d,%d]",
+            level < 7 ? ",\"child\":" : "", level, level, 1234567, level, level * 2, level * 3, level * 4);
+        json_wrapper_buffer_append(&buf, piece, n);
+    }
+    for (level = 7; level >= 0; --level) json_wrapper_buffer_append(&buf, "}", 1);
+    json_wrapper_buffer_append(&buf, "", 1);
+    J2S(buf.data, Deep7, deep);
+    json_wrapper_buffer_release(&buf);
+}
+
+/**
+ * @brief Fill the wide type from its json text
+ */
+static void fill_wide(GET_STRUCT_NAME(Wide) * wide)
+{
+    GET_STRUCT_NAME(Buffer) buf = { 0 };
+    char piece[160];
+    int i = 0;
+    for (i = 0; i < 12; ++i)
+    {
+        int n = snprintf(piece, sizeof(piece), "%c\"a%d\":%d,\"s%d\":\"value of field %d\",\"d%d\":%d.25,\"b%d\":%s",
+            i ? ',' : '{', i, i * 1000 + 7, i, i, i, i * 3, i, i & 1 ? "true" : "false");
+        json_wrapper_buffer_append(&buf, piece, n);
+    }
+    json_wrapper_buffer_append(&buf, "}", 1);
+    json_wrapper_buffer_append(&buf, "", 1);
+    J2S(buf.data, Wide, wide);
+    json_wrapper_buffer_release(&buf);
+}
+
+static bool selected(int argc, char * argv[], int first, const char * type)
+{
+    int i = first;
+    for (i = first; i < argc; ++i)
+    {
+        if (0 == strcmp(argv[i], type)) return true;
+    }
+    return first == argc;
+}
+
+int main(int argc, char * argv[])
+{
+    int first = 1;
+    for (; first < argc && 0 == strncmp(argv[first], "--", 2); ++first)
+    {
+        if (0 == strcmp(argv[first], "--json")) g_json = true;
+        else if (0 == strcmp(argv[first], "--min-ms") && first + 1 < argc) g_min_ns = strtoull(argv[++first], NULL, 10) * 1000000ULL;
+        else
+        {
+            printf("usage: %s [--json] [--min-ms N] [small|medium|deep|wide|huge...]\n", argv[0]);
+            return 1;
+        }
+    }
+    json_wrapper_hook_alloc(counting_alloc);
+    json_wrapper_hook_cjson(false);
+
+    DECLARE_STRUCT(Person, person);
+    bench_fill_person(&person, 0);
+    if (selected(argc, argv, first, "small")) bench_type("small", &g_Son_ops, &person.son);
+    bench_fill_person(&person, 10);
+    if (selected(argc, argv, first, "medium")) bench_type("medium", &g_Person_ops, &person);
+    json_wrapper_free(person.v_sons.v_sons);
+
+    if (selected(argc, argv, first, "deep"))
+    {
+        DECLARE_STRUCT(Deep7, deep);
+        fill_deep(&deep);
+        bench_type("deep", &g_Deep7_ops, &deep);
+        RECYCLE_ST(Deep7, &deep);
+    }
+    if (selected(argc, argv, first, "wide"))
+    {
+        DECLARE_STRUCT(Wide, wide);
+        fill_wide(&wide);
+        bench_type("wide", &g_Wide_ops, &wide);
+        RECYCLE_ST(Wide, &wide);
+    }
+    if (selected(argc, argv, first, "huge"))
+    {
+        bench_fill_person(&person, 1000000);
+        bench_type("huge", &g_Person_ops, &person);
+        json_wrapper_free(person.v_sons.v_sons);
+    }
+    return 0;
+}
@@ -0,0 +1,136 @@
+/**
+ * @file bench_threads.c
+ * @brief Scale J2S+RECYCLE_ST over threads, with the global hook and with a pool bound to each thread
+ *
+ * @note Link with -lpthread
+ */
+
+
+#include <pthread.h>
+#include <stddef.h>
+#include "bench.h"
+
+
+/**
+ * @brief A per-thread pool keeping freed blocks in power-of-two size classes
+ */
+#define POOL_CLASSES 9
+#define POOL_MIN_SHIFT 4
+
+typedef union PoolBlock
+{
+    union PoolBlock * next;
+    size_t klass;
+    max_align_t align;
+} PoolBlock;
+
+static __thread PoolBlock * t_free[POOL_CLASSES];
+
+static void * pool_alloc(size_t size)
+{
+    size_t klass = 0;
+    while (klass < POOL_CLASSES && ((size_t) 1 << (klass + POOL_MIN_SHIFT)) < size) ++klass;
+    PoolBlock * block = NULL;
+    if (klass < POOL_CLASSES && NULL != t_free[klass])
+    {
+        block = t_free[klass];
+        t_free[klass] = block->next;
+    } else
+    {
+        size_t bytes = klass < POOL_CLASSES ? (size_t) 1 << (klass + POOL_MIN_SHIFT) : size;
+        block = malloc(sizeof(PoolBlock) + bytes);
+        if (NULL == block) return NULL;
+    }
+    block->klass = klass;
+    return block + 1;
+}
+
+static void pool_free(void * ptr)
+{
+    PoolBlock * block = (PoolBlock *) ptr - 1;
+    size_t klass = block->klass;
+    if (klass >= POOL_CLASSES)
+    {
+        free(block);
+        return;
+    }
+    block->next = t_free[klass];
+    t_free[klass] = block;
+}
+
+static void pool_drain(void)
+{
+    size_t klass = 0;
+    for (klass = 0; klass < POOL_CLASSES; ++klass)
+    {
+        while (NULL != t_free[klass])
+        {
+            PoolBlock * block = t_free[klass];
+            t_free[klass] = block->next;
+            free(block);
+        }
+    }
+}
+
+
+typedef struct Task
+{
+    char * json;
+    int iterations;
+    int pooled;
+} Task;
+
+static void * worker(void * arg)
+{
+    Task * task = arg;
+    DECLARE_STRUCT(Person, decoded);
+    int i = 0;
+    if (task->pooled) json_wrapper_hook_thread(pool_alloc, pool_free);
+    for (i = 0; i < task->iterations; ++i)
+    {
+        J2S(task->json, Person, &decoded);
+        RECYCLE_ST(Person, &decoded);
+    }
+    if (task->pooled)
+    {
+        json_wrapper_hook_thread(NULL, NULL);
+        pool_drain();
+    }
+    return NULL;
+}
+
+static void run(char * json, int threads, int iterations, int pooled)
+{
+    char name[64];
+    pthread_t tids[64];
+    Task task = { json, iterations, pooled };
+    int i = 0;
+    uint64_t begin = bench_now_ns();
+    for (i = 0; i < threads; ++i) pthread_create(&tids[i], NULL, worker, &task);
+    for (i = 0; i < threads; ++i) pthread_join(tids[i], NULL);
+    uint64_t ns = bench_now_ns() - begin;
+    uint64_t ops = (uint64_t) threads * iterations;
+    snprintf(name, sizeof(name), "j2s+recycle %-6s (%2d threads)", pooled ? "pool" : "global", threads);
+    printf("%-40s %12.0f ops/s\n", name, ops * 1e9 / ns);
+}
+
+int main(int argc, char * argv[])
+{
+    int max_threads = argc > 1 ? atoi(argv[1]) : 8;
+    int iterations = argc > 2 ? atoi(argv[2]) : 20000;
+    int threads = 0;
+    if (max_threads < 1) max_threads = 1;
+    if (max_threads > 64) max_threads = 64;
+    DECLARE_STRUCT(Person, person);
+    bench_fill_person(&person, 8);
+    char * json = S2J(Person, &person);
+    json_wrapper_free(person.v_sons.v_sons);
+    if (NULL == json) return 1;
+    for (threads = 1; threads <= max_threads; threads *= 2)
+    {
+        run(json, threads, iterations, 0);
+        run(json, threads, iterations, 1);
+    }
+    json_wrapper_free(json);
+    return 0;
+}
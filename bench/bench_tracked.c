@@ -0,0 +1,105 @@
+/**
+ * @file bench_tracked.c
+ * @brief Compare encoding the sample model again after a change of its age with S2J
+ *        and with S2J_TRACKED of the same model defined by DEFINE_STRUCT_TRACKED
+ */
+
+
+#include "bench.h"
+
+
+DEFINE_STRUCT(TrackedSon,
+    (OBJ(STRING), name)
+    (OBJ(INT), age)
+    (OBJ(STRING), birthday)
+    (OBJ(CHAR), sex)
+)
+
+DEFINE_STRUCT_TRACKED(TrackedPerson,
+    (OBJ(STRING), name)
+    (OBJ(INT), age)
+    (OBJ(STRING), birthday)
+    (OBJ(CHAR), sex)
+    (OBJ(STRING), couple)
+    (OBJ(TrackedSon), son)
+    (ARRAY(TrackedSon, 2), sons)
+    (VA_ARRAY(TrackedSon), v_sons)
+)
+
+
+static uint64_t g_allocs = 0;
+
+static void * counting_alloc(size_t size)
+{
+    ++g_allocs;
+    return malloc(size);
+}
+
+static void report(const char * label, size_t children, uint64_t begin, int iterations, size_t bytes)
+{
+    char name[64];
+    snprintf(name, sizeof(name), "%-18s (%zu children)", label, children);
+    bench_report(name, bench_now_ns() - begin, iterations, (uint64_t) bytes * iterations);
+    printf("%-40s %12.1f allocs/op\n", "", (double) g_allocs / iterations);
+}
+
+static void run(size_t children, int iterations)
+{
+    DECLARE_STRUCT(Person, person);
+    bench_fill_person(&person, children);
+    char * json = S2J(Person, &person);
+    json_wrapper_free(person.v_sons.v_sons);
+    if (NULL == json) return;
+    size_t bytes = strlen(json);
+    DECLARE_STRUCT(Person, decoded);
+    DECLARE_TRACKED(TrackedPerson, tracked);
+    J2S(json, Person, &decoded);
+    J2S(json, TrackedPerson, &tracked.value);
+    long sum = 0;
+    int i = 0;
+
+    g_allocs = 0;
+    uint64_t begin = bench_now_ns();
+    for (i = 0; i < iterations; ++i)
+    {
+        ++decoded.age;
+        char * text = S2J(Person, &decoded);
+        sum += text[bytes / 2];
+        json_wrapper_free(text);
+    }
+    report("s2j", children, begin, iterations, bytes);
+
+    S2J_TRACKED(TrackedPerson, &tracked, NULL);
+    g_allocs = 0;
+    begin = bench_now_ns();
+    for (i = 0; i < iterations; ++i)
+    {
+        SET_ST(TrackedPerson, &tracked, age, tracked.value.age + 1);
+        const char * text = S2J_TRACKED(TrackedPerson, &tracked, NULL);
+        sum += text[bytes / 2];
+    }
+    report("s2j_tracked", children, begin, iterations, bytes);
+
+    g_allocs = 0;
+    begin = bench_now_ns();
+    for (i = 0; i < iterations; ++i)
+    {
+        const char * text = S2J_TRACKED(TrackedPerson, &tracked, NULL);
+        sum += text[bytes / 2];
+    }
+    report("s2j_tracked clean", children, begin, iterations, bytes);
+
+    printf("  (sum %ld)\n", sum);
+    RECYCLE_ST(Person, &decoded);
+    RECYCLE_TRACKED(TrackedPerson, &tracked);
+    json_wrapper_free(json);
+}
+
+int main(int argc, char * argv[])
+{
+    json_wrapper_hook_alloc(counting_alloc);
+    run(0, 200000);
+    run(10, 50000);
+    run(1000, 500);
+    return 0;
+}
@@ -0,0 +1,51 @@
+/**
+ * @file bench_va_array.c
+ * @brief Check VA_ARRAY decoding scales linearly from 1k to 1M elements, ns/elem should stay flat
+ */
+
+
+#include "bench.h"
+
+
+static void run(size_t children)
+{
+    char name[64];
+    DECLARE_STRUCT(Person, person);
+    bench_fill_person(&person, children);
+    char * json = S2J(Person, &person);
+    json_wrapper_free(person.v_sons.v_sons);
+    if (NULL == json) return;
+    size_t bytes = strlen(json);
+
+    DECLARE_STRUCT(Person, decoded);
+    uint64_t begin = bench_now_ns();
+    int rc = J2S(json, Person, &decoded);
+    uint64_t ns = bench_now_ns() - begin;
+    if (0 != rc || decoded.v_sons.size != children) printf("j2s failed with %zu children\n", children);
+    RECYCLE_ST(Person, &decoded);
+    snprintf(name, sizeof(name), "j2s  %8zu elems", children);
+    printf("%s %10.1f ns/elem %10.1f MB/s\n", name, (double) ns / children, bytes * 1000.0 / ns);
+
+    memset(&decoded, 0, sizeof(decoded));
+    begin = bench_now_ns();
+    cJSON * tree = cJSON_Parse(json);
+    rc = tree ? JSON_2_FUNCTION_NAME(Person)(tree, &decoded) : -1;
+    cJSON_Delete(tree);
+    ns = bench_now_ns() - begin;
+    if (0 != rc || decoded.v_sons.size != children) printf("tree failed with %zu children\n", children);
+    RECYCLE_ST(Person, &decoded);
+    snprintf(name, sizeof(name), "tree %8zu elems", children);
+    printf("%s %10.1f ns/elem %10.1f MB/s\n", name, (double) ns / children, bytes * 1000.0 / ns);
+
+    json_wrapper_free(json);
+}
+
+int main(int argc, char * argv[])
+{
+    size_t children = 1000;
+    for (; children <= 1000000; children *= 10)
+    {
+        run(children);
+    }
+    return 0;
+}
@@ -0,0 +1,117 @@
+/**
+ * @file bench_view.c
+ * @brief Compare decoding the sample model with STRING fields against the same model with STRING_VIEW fields
+ */
+
+
+#include "bench.h"
+
+
+DEFINE_STRUCT(ViewSon,
+    (OBJ(STRING_VIEW), name)
+    (OBJ(INT), age)
+    (OBJ(STRING_VIEW), birthday)
+    (OBJ(CHAR), sex)
+)
+
+DEFINE_STRUCT(ViewPerson,
+    (OBJ(STRING_VIEW), name)
+    (OBJ(INT), age)
+    (OBJ(STRING_VIEW), birthday)
+    (OBJ(CHAR), sex)
+    (OBJ(STRING_VIEW), couple)
+    (OBJ(ViewSon), son)
+    (ARRAY(ViewSon, 2), sons)
+    (VA_ARRAY(ViewSon), v_sons)
+)
+
+
+static uint64_t g_allocs = 0;
+
+static void * counting_alloc(size_t size)
+{
+    ++g_allocs;
+    return malloc(size);
+}
+
+static void report(const char * label, size_t children, uint64_t begin, int iterations, size_t bytes)
+{
+    char name[64];
+    snprintf(name, sizeof(name), "%-18s (%zu children)", label, children);
+    bench_report(name, bench_now_ns() - begin, iterations, (uint64_t) bytes * iterations);
+    printf("%-40s %12.1f allocs/op\n", "", (double) g_allocs / iterations);
+}
+
+static void run(size_t children, int iterations)
+{
+    DECLARE_STRUCT(Person, person);
+    bench_fill_person(&person, children);
+    char * json = S2J(Person, &person);
+    json_wrapper_free(person.v_sons.v_sons);
+    if (NULL == json) return;
+    size_t bytes = strlen(json);
+    char * text = json_wrapper_alloc(bytes + 1);
+    GET_STRUCT_NAME(Arena) arena;
+    json_wrapper_arena_init(&arena, 0);
+    DECLARE_STRUCT(Person, decoded);
+    DECLARE_STRUCT(ViewPerson, viewed);
+    long sum = 0;
+    int i = 0;
+
+    g_allocs = 0;
+    uint64_t begin = bench_now_ns();
+    for (i = 0; i < iterations; ++i)
+    {
+        J2S(json, Person, &decoded);
+        sum += strlen(decoded.name);
+        RECYCLE_ST(Person, &decoded);
+    }
+    report("j2s string", children, begin, iterations, bytes);
+
+    g_allocs = 0;
+    begin = bench_now_ns();
+    for (i = 0; i < iterations; ++i)
+    {
+        memset(&decoded, 0, sizeof(decoded));
+        J2S_ARENA(json, Person, &decoded, &arena);
+        sum += strlen(decoded.name);
+        json_wrapper_arena_reset(&arena);
+    }
+    report("j2s string arena", children, begin, iterations, bytes);
+
+    g_allocs = 0;
+    begin = bench_now_ns();
+    for (i = 0; i < iterations; ++i)
+    {
+        memcpy(text, json, bytes + 1);
+        J2S_VIEW(text, bytes, ViewPerson, &viewed);
+        sum += viewed.name.len;
+        RECYCLE_ST(ViewPerson, &viewed);
+    }
+    report("j2s_view + memcpy", children, begin, iterations, bytes);
+
+    g_allocs = 0;
+    begin = bench_now_ns();
+    for (i = 0; i < iterations; ++i)
+    {
+        memset(&viewed, 0, sizeof(viewed));
+        J2S_ARENA(json, ViewPerson, &viewed, &arena);
+        sum += viewed.name.len;
+        json_wrapper_arena_reset(&arena);
+    }
+    report("j2s view arena", children, begin, iterations, bytes);
+
+    printf("  (sum %ld)\n", sum);
+    json_wrapper_arena_release(&arena);
+    json_wrapper_free(text);
+    json_wrapper_free(json);
+}
+
+int main(int argc, char * argv[])
+{
+    json_wrapper_hook_alloc(counting_alloc);
+    run(0, 200000);
+    run(10, 50000);
+    run(1000, 500);
+    return 0;
+}
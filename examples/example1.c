@@ -25,6 +25,7 @@ int main(int argc, char * argv[])
     char * json = S2J(Person, &person);
     DECLARE_STRUCT(Person, person2);
     J2S(json, Person, &person2);
+    json_wrapper_free(json);
     COPY_ST(Person, &person, &person2);
     RECYCLE_ST(Person, &person);
     RECYCLE_ST(Person, &person2);
@@ -11,8 +11,11 @@
 
 
 #include <stdlib.h>
+#include <stddef.h>
 #include <stdbool.h>
+#include <stdint.h>
 #include <string.h>
+#include <limits.h>
 #include <cJSON.h>
 
 
@@ -36,10 +39,32 @@
 typedef bool BOOL_JSON;
 typedef char CHAR_JSON;
 typedef int INT_JSON;
+typedef int64_t INT64_JSON;
+typedef uint32_t UINT32_JSON;
+typedef uint64_t UINT64_JSON;
+typedef float FLOAT_JSON;
+typedef double DOUBLE_JSON;
 typedef char * STRING_JSON;
+
+/**
+ * @brief A string which points into memory it doesn't own, such as the text it was decoded from,
+ *        @p ptr is @p NULL for null and the string is not '\0' terminated
+ */
+typedef struct GET_STRUCT_NAME(STRING_VIEW)
+{
+    const char * ptr;
+    size_t len;
+} GET_STRUCT_NAME(STRING_VIEW);
 /**************************************** GET_STRUCT_NAME  END  ****************************************/
 
 
+#define ASSERT_RETURN(exp, rc) if (!(exp)) return rc
+#define ASSERT_RETURN_VOID(exp) if (!(exp)) return
+
+
+#define ASSERT_BREAK(exp) if (!(exp)) break
+
+
 /**
  * @brief Hook the memory alloc function
  * 
@@ -54,6 +79,29 @@ void json_wrapper_hook_alloc(void * (* alloc_)(size_t size));
  */
 void json_wrapper_hook_free(void (* free_)(void * ptr));
 
+/**
+ * @brief Bind the memory hook functions to the current thread only
+ *
+ * @param alloc_ The alloc function
+ * @param free_ The free function
+ * @return int 0 for success, -1 for failure
+ *
+ * @note Both of @p alloc_ and @p free_ are required, pass @p NULL for both to unbind them,
+ *       then the thread falls back to the global hooks of @link json_wrapper_hook_alloc and @link json_wrapper_hook_free.
+ *       The global hooks are shared by all threads, set them before other threads start using json wrapper.
+ *       Memory alloced under a thread hook must be freed on a thread bound to the same hook
+ */
+int json_wrapper_hook_thread(void * (* alloc_)(size_t size), void (* free_)(void * ptr));
+
+/**
+ * @brief Get the memory hook functions in effect for the current thread, the thread hooks if they're bound
+ *        or the global hooks, e.g. to bind them to the threads working for it by @link json_wrapper_hook_thread
+ *
+ * @param alloc_ The alloc function
+ * @param free_ The free function
+ */
+void json_wrapper_hook_current(void * (** alloc_)(size_t size), void (** free_)(void * ptr));
+
 
 /**
  * @brief Alloc memory using the hook in json wrapper
@@ -71,472 +119,3988 @@ void * json_wrapper_alloc(size_t size);
 void json_wrapper_free(void * ptr);
 
 
-#define ASSERT_RETURN(exp, rc) if (!(exp)) return rc
-#define ASSERT_RETURN_VOID(exp) if (!(exp)) return
+/**
+ * @brief Route the allocations of cJSON through the hooks in json wrapper
+ *
+ * @param pool Whether to alloc the cJSON items from a fixed-size node pool of each thread
+ *
+ * @note It installs the hooks of cJSON by cJSON_InitHooks, call it before any cJSON memory is alloced,
+ *       then the items, keys and printed strings of cJSON follow the thread or global hooks in json wrapper.
+ *       Free the printed strings by cJSON_free
+ */
+void json_wrapper_hook_cjson(bool pool);
 
+/**
+ * @brief Release the cJSON node pool of the current thread, the next item alloced on it starts a new pool
+ *
+ * @note The pooled items freed on another thread go back to the pool they were alloced from.
+ *       A pool is freed once its thread exits or releases it and all its items are freed,
+ *       so the items still alive stay valid, only release it to return the memory before the thread exits
+ */
+void json_wrapper_cjson_pool_release(void);
 
-#define ASSERT_BREAK(exp) if (!(exp)) break
 
+/**************************************** SIMD BEGIN ****************************************/
+/**
+ * @brief The instruction sets which the text scanners use, the best one the CPU supports is picked at runtime
+ */
+typedef enum GET_STRUCT_NAME(Simd)
+{
+    SIMD_SCALAR,                            // 8 bytes at a time in plain C
+    SIMD_SSE2,                              // 16 bytes at a time, x86 only
+    SIMD_AVX2,                              // 32 bytes at a time, x86 only
+} GET_STRUCT_NAME(Simd);
 
-#define EXPAND_(...) __VA_ARGS__
-#define EXPAND(...) EXPAND_(__VA_ARGS__)
+/**
+ * @brief Get the instruction set in use by the text scanners
+ * 
+ * @return GET_STRUCT_NAME(Simd) The instruction set
+ */
+GET_STRUCT_NAME(Simd) json_wrapper_simd_level(void);
 
+/**
+ * @brief Limit the text scanners to the instruction set @p level, mostly for benchmarks and tests
+ * 
+ * @note The level is lowered to the best one the CPU supports, the scans already running on other threads
+ *       finish with the scanners they started with
+ * 
+ * @param level The instruction set
+ * @return GET_STRUCT_NAME(Simd) The instruction set in use
+ */
+GET_STRUCT_NAME(Simd) json_wrapper_simd_limit(GET_STRUCT_NAME(Simd) level);
 
-#define CONCAT_(A, B) A##B
-#define CONCAT(A, B) CONCAT_(A, B)
+/**
+ * @brief Find the first byte in [@p p, @p end) which needs to be escaped in a json string,
+ *        that is '"', '\\' or a control character
+ * 
+ * @param p The begin of the bytes
+ * @param end The end of the bytes
+ * @return const char* The byte found, @p end for none
+ */
+const char * json_wrapper_scan_escape(const char * p, const char * end);
+/**************************************** SIMD  END  ****************************************/
 
-#define PRE_CONCAT(A, ...) CONCAT_(A, __VA_ARGS__)
-#define PRE_CONCAT_(A, ...) A##__VA_ARGS__
 
-#define POST_CONCAT_(end, ...) __VA_ARGS__##end
-#define POST_CONCAT(end, ...) POST_CONCAT_(end, __VA_ARGS__)
+/**************************************** BUFFER BEGIN ****************************************/
+/**
+ * @brief A growable output buffer which the streaming writers append json text into
+ * 
+ * @note A zeroed buffer is a valid empty buffer, the memory is managed by the hook in json wrapper.
+ *       A fixed buffer set by @link json_wrapper_buffer_init_fixed never grows, the text beyond its
+ *       capacity is dropped while @p len still counts the full length
+ */
+typedef struct GET_STRUCT_NAME(Buffer)
+{
+    char * data;
+    size_t len;
+    size_t cap;
+    bool fixed;
+} GET_STRUCT_NAME(Buffer);
 
+/**
+ * @brief Init a fixed buffer over the memory of the caller
+ * 
+ * @param buf The buffer
+ * @param data The memory, @p NULL with @p cap 0 to only count the length
+ * @param cap The size of @p data
+ */
+void json_wrapper_buffer_init_fixed(GET_STRUCT_NAME(Buffer) * buf, char * data, size_t cap);
 
-#define SECOND(a1, a2, ...) a2
-#define CHECK(...) SECOND(__VA_ARGS__, 0)
-#define PROBE(x) x, 1
+/**
+ * @brief Make sure there's room for @p size more bytes and the terminating '\0' in @p buf
+ * 
+ * @param buf The buffer
+ * @param size The size to append
+ * @return int @p 0 for success, @p -1 for failure
+ */
+int json_wrapper_buffer_reserve(GET_STRUCT_NAME(Buffer) * buf, size_t size);
 
+/**
+ * @brief Append @p len bytes of @p data into a fixed buffer @p buf which is out of room, the rest is dropped
+ * 
+ * @param buf The buffer
+ * @param data The data
+ * @param len The length of data
+ * @return int @p 0 for success
+ */
+static inline int json_wrapper_buffer_append_fixed(GET_STRUCT_NAME(Buffer) * buf, const char * data, size_t len);
+inline int json_wrapper_buffer_append_fixed(GET_STRUCT_NAME(Buffer) * buf, const char * data, size_t len)
+{
+    if (buf->len + 1 < buf->cap)
+    {
+        memcpy(buf->data + buf->len, data, buf->cap - 1 - buf->len);
+    }
+    buf->len += len;
+    return 0;
+}
 
-/**************************************** EMPTY BEGIN ****************************************/
 /**
- * @brief An empty macro, mainly for @link DEFER to use
- **/
-#define EMPTY()
-/**************************************** EMPTY  END  ****************************************/
+ * @brief Append @p len bytes of @p data into @p buf
+ * 
+ * @param buf The buffer
+ * @param data The data
+ * @param len The length of data
+ * @return int @p 0 for success, @p -1 for failure
+ */
+static inline int json_wrapper_buffer_append(GET_STRUCT_NAME(Buffer) * buf, const char * data, size_t len);
+inline int json_wrapper_buffer_append(GET_STRUCT_NAME(Buffer) * buf, const char * data, size_t len)
+{
+    if (buf->len + len >= buf->cap)
+    {
+        if (buf->fixed) return json_wrapper_buffer_append_fixed(buf, data, len);
+        ASSERT_RETURN(0 == json_wrapper_buffer_reserve(buf, len), -1);
+    }
+    memcpy(buf->data + buf->len, data, len);
+    buf->len += len;
+    return 0;
+}
 
+/**
+ * @brief Append an integer as a json number into @p buf
+ * 
+ * @param buf The buffer
+ * @param value The integer
+ * @return int @p 0 for success, @p -1 for failure
+ */
+int json_wrapper_buffer_append_int(GET_STRUCT_NAME(Buffer) * buf, long value);
 
-/**************************************** DEFER BEGIN ****************************************/
 /**
- * @brief Delay to expand the macro
- * @param x The name of the macro to delay to expand
- **/
-#define DEFER(x) x EMPTY()
-/**************************************** DEFER  END  ****************************************/
+ * @brief Append a 64 bits integer as a json number into @p buf
+ * 
+ * @param buf The buffer
+ * @param value The integer
+ * @return int @p 0 for success, @p -1 for failure
+ */
+int json_wrapper_buffer_append_int64(GET_STRUCT_NAME(Buffer) * buf, int64_t value);
 
 /**
- * @brief The base wrapper type
+ * @brief Append an unsigned 64 bits integer as a json number into @p buf
+ * 
+ * @param buf The buffer
+ * @param value The integer
+ * @return int @p 0 for success, @p -1 for failure
  */
-typedef enum GET_STRUCT_NAME(Type)
-{
-    BOOL,
-    CHAR,
-    INT,
-    STRING,
-    ARRAY_,
-    VA_ARRAY_,
-} GET_STRUCT_NAME(Type);
+int json_wrapper_buffer_append_uint64(GET_STRUCT_NAME(Buffer) * buf, uint64_t value);
 
+/**
+ * @brief Append a double as the shortest json number which is read back as the same value into @p buf,
+ *        infinities and NaN are appended as null
+ * 
+ * @param buf The buffer
+ * @param value The double
+ * @return int @p 0 for success, @p -1 for failure
+ */
+int json_wrapper_buffer_append_double(GET_STRUCT_NAME(Buffer) * buf, double value);
 
-#define OBJ(type) OBJ, 0, type
-#define ARRAY(type, num) ARRAY, num, type
-#define VA_ARRAY(type) VA_ARRAY, 0, type
+/**
+ * @brief Append a float as the shortest json number which is read back as the same float into @p buf,
+ *        infinities and NaN are appended as null
+ * 
+ * @param buf The buffer
+ * @param value The float
+ * @return int @p 0 for success, @p -1 for failure
+ */
+int json_wrapper_buffer_append_float(GET_STRUCT_NAME(Buffer) * buf, float value);
 
+/**
+ * @brief Append @p len bytes of @p str as a quoted and escaped json string into @p buf, @p NULL is appended as null
+ * 
+ * @param buf The buffer
+ * @param str The string
+ * @param len The length of the string
+ * @return int @p 0 for success, @p -1 for failure
+ */
+int json_wrapper_buffer_append_str(GET_STRUCT_NAME(Buffer) * buf, const char * str, size_t len);
 
-#define GET_VA_ARRAY_NAME(type) PRE_CONCAT(type##_, GET_STRUCT_NAME(VA_ARRAY_))
+/**
+ * @brief Append a string as a quoted and escaped json string into @p buf, @p NULL is appended as null
+ * 
+ * @param buf The buffer
+ * @param str The string
+ * @return int @p 0 for success, @p -1 for failure
+ */
+int json_wrapper_buffer_append_string(GET_STRUCT_NAME(Buffer) * buf, const char * str);
 
-#define DEFINE_VA_ARRAY(type, name) \
-typedef struct GET_VA_ARRAY_NAME(type) \
-{ \
-    GET_STRUCT_NAME(type) * name; \
-    size_t size; \
-} GET_VA_ARRAY_NAME(type);
+/**
+ * @brief Close a json object whose members were appended from @p start as ',"key":value' pairs
+ * 
+ * @param buf The buffer
+ * @param start The length of @p buf before the first member was appended
+ * @return int @p 0 for success, @p -1 for failure
+ */
+int json_wrapper_buffer_close_object(GET_STRUCT_NAME(Buffer) * buf, size_t start);
 
+/**
+ * @brief Take the '\0' terminated text out of @p buf, the buffer is reset to empty
+ * 
+ * @param buf The buffer
+ * @return char* The text which should be freed by @link json_wrapper_free, @p NULL for failure
+ */
+char * json_wrapper_buffer_detach(GET_STRUCT_NAME(Buffer) * buf);
 
-/**************************************** TYPE_2_CJSON_TYPE BEGIN ****************************************/
 /**
- * @brief Convert the wrapper type to json type
- * @param t The wrapper type
- **/
-#define TYPE_2_CJSON_TYPE(t) t##_2_CJSON_TYPE
-#define BOOL_2_CJSON_TYPE Bool
-#define CHAR_2_CJSON_TYPE Number
-#define INT_2_CJSON_TYPE Number
-#define STRING_2_CJSON_TYPE String
-/**************************************** TYPE_2_CJSON_TYPE  END  ****************************************/
+ * @brief Release the memory of @p buf, the buffer is reset to empty
+ * 
+ * @param buf The buffer
+ */
+void json_wrapper_buffer_release(GET_STRUCT_NAME(Buffer) * buf);
+/**************************************** BUFFER  END  ****************************************/
 
 
-/**************************************** STANDARD_TYPE BEGIN ****************************************/
+/**************************************** SINK BEGIN ****************************************/
 /**
- * @brief Convert the wrapper type to standard base type
- * @param t The wrapper type
- **/
-#define STANDARD_TYPE(t) t##_2_STANDARD_TYPE
-#define BOOL_2_STANDARD_TYPE bool
-#define CHAR_2_STANDARD_TYPE char
-#define INT_2_STANDARD_TYPE int
-#define STRING_2_STANDARD_TYPE char *
-/**************************************** STANDARD_TYPE  END  ****************************************/
+ * @brief The default number of bytes a sink gathers before calling its write callback
+ */
+#define SINK_FLUSH_SIZE 65536
 
+/**
+ * @brief The layout of the records written by a batch
+ */
+typedef enum GET_STRUCT_NAME(Batch)
+{
+    BATCH_ARRAY,        // one json array: [record,record]
+    BATCH_NDJSON,       // newline-delimited json: one record per line
+} GET_STRUCT_NAME(Batch);
 
-/**************************************** FIRST_FIELD BEGIN ****************************************/
 /**
- * @brief Extract the first field
- * @param has_parentheses If parentheses added into the result, @p TRUE for yes, @p FALSE for no
- * 
- * @note For example:
- *           FIRST_FIELD(TRUE, (int, age) (int height)) -> (int, age)
- *           FIRST_FIELD(FALSE, (int, age) (int height)) -> int, age
- **/
-#define FIRST_FIELD_(has_parentheses, ...) POST_CONCAT(_END, FIRST_FIELD_I_##has_parentheses __VA_ARGS__)
-#define FIRST_FIELD(has_parentheses, ...) FIRST_FIELD_(has_parentheses, __VA_ARGS__)  // Convert TRUE/FALSE to 1/0
-#define FIRST_FIELD_I_0(...) __VA_ARGS__ FIRST_FIELD_DEL_I
-#define FIRST_FIELD_I_1(...) (__VA_ARGS__) FIRST_FIELD_DEL_I
-#define FIRST_FIELD_I_0_END
-#define FIRST_FIELD_I_1_END
-#define FIRST_FIELD_DEL_I(...) FIRST_FIELD_DEL_II
-#define FIRST_FIELD_DEL_II(...) FIRST_FIELD_DEL_I
-#define FIRST_FIELD_DEL_I_END
-#define FIRST_FIELD_DEL_II_END
-/**************************************** FIRST_FIELD  END  ****************************************/
+ * @brief The callback of a sink to take the text written
+ *
+ * @param ctx The context given to the sink
+ * @param data The text, not '\0' terminated
+ * @param len The length of the text
+ * @return int @p 0 for success, @p -1 to stop the batch
+ */
+typedef int (*GET_STRUCT_NAME(SinkWrite))(void * ctx, const char * data, size_t len);
 
+/**
+ * @brief Where a batch writes its records: a buffer of the caller, or a write callback fed from a working buffer
+ *
+ * @note The working buffer is kept across batches and freed by @link json_wrapper_sink_release
+ */
+typedef struct GET_STRUCT_NAME(Sink)
+{
+    GET_STRUCT_NAME(Buffer) * buf;          // the buffer of the caller, NULL for the write callback
+    GET_STRUCT_NAME(Buffer) work;           // the working buffer of the write callback
+    GET_STRUCT_NAME(SinkWrite) write_;
+    void * ctx;
+    size_t flush;                           // call write_ once the working buffer holds this many bytes
+    GET_STRUCT_NAME(Batch) format;
+} GET_STRUCT_NAME(Sink);
 
-/**************************************** IS_EMPTY BEGIN ****************************************/
 /**
- * @brief Check if parameters is empty
- * @return @p 0 for not empty, @p 1 for empty
- * 
- * @note For example:
- *           IS_EMPTY(a) -> 0
- *           IS_EMPTY() -> 1
- **/
-#define IS_EMPTY_I(x, ...) CHECK(CONCAT(CONCAT_(IS_EMPTY_, x), 0))
-#define IS_EMPTY(x, ...) IS_EMPTY_I(x, ##__VA_ARGS__)
-#define IS_EMPTY_0 PROBE(1)
-/**************************************** IS_EMPTY  END  ****************************************/
+ * @brief Init a sink which appends the records into @p buf, which may be growable or fixed
+ *
+ * @note No '\0' is appended, the batch fails if a fixed @p buf has no room left for it after the records
+ *
+ * @param sink The sink
+ * @param buf The buffer
+ * @param format The layout of the records
+ */
+void json_wrapper_sink_init_buffer(GET_STRUCT_NAME(Sink) * sink, GET_STRUCT_NAME(Buffer) * buf, GET_STRUCT_NAME(Batch) format);
 
+/**
+ * @brief Init a sink which passes the records to @p write_ in pieces of about @p flush bytes
+ *
+ * @param sink The sink
+ * @param write_ The write callback
+ * @param ctx The context of @p write_
+ * @param flush The size of a piece, @p 0 for @link SINK_FLUSH_SIZE
+ * @param format The layout of the records
+ */
+void json_wrapper_sink_init_write(GET_STRUCT_NAME(Sink) * sink, GET_STRUCT_NAME(SinkWrite) write_, void * ctx,
+    size_t flush, GET_STRUCT_NAME(Batch) format);
 
-/**************************************** IS_EMPTY_FIELD BEGIN ****************************************/
 /**
- * @brief Check if there's field
- * @return @p 0 for there's field in the parameter, @p 1 for the empty parameter
- * 
- * @note For example:
- *           IS_EMPTY_FIELD((int, age) (char, sex)) -> 0
- *           IS_EMPTY_FIELD() -> 1
- **/
-#define IS_EMPTY_FIELD(...) IS_EMPTY(FIRST_FIELD(FALSE, __VA_ARGS__))
-/**************************************** IS_EMPTY_FIELD  END  ****************************************/
+ * @brief Get the buffer which the records of @p sink are encoded into
+ *
+ * @param sink The sink
+ * @return GET_STRUCT_NAME(Buffer)* The buffer
+ */
+static inline GET_STRUCT_NAME(Buffer) * json_wrapper_sink_buffer(GET_STRUCT_NAME(Sink) * sink);
+inline GET_STRUCT_NAME(Buffer) * json_wrapper_sink_buffer(GET_STRUCT_NAME(Sink) * sink)
+{
+    return NULL != sink->buf ? sink->buf : &sink->work;
+}
 
+/**
+ * @brief Pass the text gathered in the working buffer of @p sink to its write callback
+ *
+ * @param sink The sink
+ * @return int @p 0 for success, @p -1 for failure
+ */
+int json_wrapper_sink_flush(GET_STRUCT_NAME(Sink) * sink);
 
-/**************************************** OTHER_FIELDS BEGIN ****************************************/
 /**
- * @brief Extract other fields except the first one
- * 
- * @note For example:
- *           FIRST_FIELD((int, age) (int height)) -> (int, height)
- **/
-#define OTHER_FIELDS(...) CONCAT(OTHER_FIELDS_, IS_EMPTY_FIELD(__VA_ARGS__)) __VA_ARGS__
-#define OTHER_FIELDS_0(...)
-#define OTHER_FIELDS_1
-/**************************************** OTHER_FIELDS  END  ****************************************/
+ * @brief Start a batch, a json array is opened
+ *
+ * @param sink The sink
+ * @return int @p 0 for success, @p -1 for failure
+ */
+int json_wrapper_sink_begin(GET_STRUCT_NAME(Sink) * sink);
 
+/**
+ * @brief Start the record @p index of a batch, the records of a json array are separated by ','
+ *
+ * @param sink The sink
+ * @param index The index of the record
+ * @return int @p 0 for success, @p -1 for failure
+ */
+static inline int json_wrapper_sink_next(GET_STRUCT_NAME(Sink) * sink, size_t index);
+inline int json_wrapper_sink_next(GET_STRUCT_NAME(Sink) * sink, size_t index)
+{
+    if (BATCH_ARRAY != sink->format || 0 == index) return 0;
+    return json_wrapper_buffer_append(json_wrapper_sink_buffer(sink), ",", 1);
+}
 
-/**************************************** EVAL BEGIN ****************************************/
 /**
- * @brief To expand the macro recursively
- **/
-#define EVAL(...) EVAL1(EVAL1(EVAL1(__VA_ARGS__)))
-#define EVAL1(...) EVAL2(EVAL2(EVAL2(__VA_ARGS__)))
-#define EVAL2(...) EVAL3(EVAL3(EVAL3(__VA_ARGS__)))
-#define EVAL3(...) EVAL4(EVAL4(EVAL4(__VA_ARGS__)))
-#define EVAL4(...) EVAL5(EVAL5(EVAL5(__VA_ARGS__)))
-#define EVAL5(...) __VA_ARGS__
-/**************************************** EVAL BEGIN ****************************************/
+ * @brief End a record of a batch, a line of NDJSON is ended by '\n' and the working buffer is flushed once it's full
+ *
+ * @param sink The sink
+ * @return int @p 0 for success, @p -1 for failure
+ */
+static inline int json_wrapper_sink_end_record(GET_STRUCT_NAME(Sink) * sink);
+inline int json_wrapper_sink_end_record(GET_STRUCT_NAME(Sink) * sink)
+{
+    GET_STRUCT_NAME(Buffer) * buf = json_wrapper_sink_buffer(sink);
+    if (BATCH_NDJSON == sink->format) ASSERT_RETURN(0 == json_wrapper_buffer_append(buf, "\n", 1), -1);
+    if (NULL == sink->buf && buf->len >= sink->flush) return json_wrapper_sink_flush(sink);
+    return 0;
+}
 
+/**
+ * @brief End a batch, a json array is closed and the working buffer is flushed
+ *
+ * @param sink The sink
+ * @return int @p 0 for success, @p -1 for failure
+ */
+int json_wrapper_sink_end(GET_STRUCT_NAME(Sink) * sink);
 
-/**************************************** SPLIT_FIELDS BEGIN ****************************************/
 /**
- * @brief Split the fields with comma
- * @param has_parentheses If parentheses added into the result, @p TRUE for yes, @p FALSE for no
- * 
- * @note For example:
- *           SPLIT_FIELDS(TRUE, (int, a) (int, b) (char, c) (double d))
- *               ->  (int, a) , (int, b) , (char, c) , (double d)
- *           SPLIT_FIELDS(FALSE, (int, a) (int, b) (char, c) (double d))
- *               ->  int, a , int, b , char, c , double d
- **/
-#define SPLIT_FIELDS_PARAMS(...) CONCAT(SPLIT_FIELDS_PARAMS_, IS_EMPTY_FIELD(__VA_ARGS__))(__VA_ARGS__)
-#define SPLIT_FIELDS_PARAMS_1(...)
-#define SPLIT_FIELDS_PARAMS_0(...) (__VA_ARGS__)
+ * @brief Release the working buffer of @p sink
+ *
+ * @param sink The sink
+ */
+void json_wrapper_sink_release(GET_STRUCT_NAME(Sink) * sink);
+/**************************************** SINK  END  ****************************************/
 
-// We use SPLIT_FIELDS_EXPAND to let EXPAND in SPLIT_FIELDS_x_0 work
-#define SPLIT_FIELDS_EXPAND(...) SPLIT_FIELDS_EXPAND_(__VA_ARGS__)
-#define SPLIT_FIELDS_EXPAND_(...) __VA_ARGS__
-#define SPLIT_FIELDS(has_parentheses, ...) SPLIT_FIELDS_(has_parentheses, __VA_ARGS__)
-#define SPLIT_FIELDS_(has_parentheses, ...) \
-    SPLIT_FIELDS_EXPAND( \
-        CONCAT(SPLIT_FIELDS_##has_parentheses##_, IS_EMPTY_FIELD(__VA_ARGS__)) \
-            SPLIT_FIELDS_PARAMS(__VA_ARGS__))
 
-#define SPLIT_FIELDS_1_1
-#define SPLIT_FIELDS_1_0(...) \
-    FIRST_FIELD(TRUE, __VA_ARGS__) \
-    POST_CONCAT(_END, EXPAND(SPLIT_FIELDS_1_0_I OTHER_FIELDS(__VA_ARGS__)))
-#define SPLIT_FIELDS_1_0_I(...) , (__VA_ARGS__) SPLIT_FIELDS_1_0_II
-#define SPLIT_FIELDS_1_0_II(...) , (__VA_ARGS__) SPLIT_FIELDS_1_0_I
-#define SPLIT_FIELDS_1_0_I_END
-#define SPLIT_FIELDS_1_0_II_END
+/**************************************** INSTRUMENT BEGIN ****************************************/
+/**
+ * @brief The operations recorded per type when json wrapper is built with @p JSON_WRAPPER_INSTRUMENT defined
+ */
+typedef enum GET_STRUCT_NAME(InstrumentOp)
+{
+    INSTRUMENT_S2J,                         // json_wrapper_json_str_from_*
+    INSTRUMENT_J2S,                         // json_wrapper_json_str_*to_*
+    INSTRUMENT_COPY,                        // json_wrapper_copy_*
+    INSTRUMENT_RECYCLE,                     // json_wrapper_recycle_*
+    INSTRUMENT_OPS,
+} GET_STRUCT_NAME(InstrumentOp);
 
-#define SPLIT_FIELDS_0_1
-#define SPLIT_FIELDS_0_0(...) \
-    FIRST_FIELD(FALSE, __VA_ARGS__) \
-    POST_CONCAT(_END, EXPAND(SPLIT_FIELDS_0_0_I OTHER_FIELDS(__VA_ARGS__)))
-#define SPLIT_FIELDS_0_0_I(...) , __VA_ARGS__ SPLIT_FIELDS_0_0_II
-#define SPLIT_FIELDS_0_0_II(...) , __VA_ARGS__ SPLIT_FIELDS_0_0_I
-#define SPLIT_FIELDS_0_0_I_END
-#define SPLIT_FIELDS_0_0_II_END
-/**************************************** SPLIT_FIELDS  END  ****************************************/
+/**
+ * @brief The max number of type names recorded, the calls of the types beyond it are not recorded
+ */
+#define INSTRUMENT_TYPES_MAX 256
+
+/**
+ * @brief The number of buckets of the latency histograms, bucket @p i counts the calls which took
+ *        [2^i, 2^(i+1)) nanoseconds, the first one from 0 and the last one up to any time
+ */
+#define INSTRUMENT_BUCKETS 32
 
+/**
+ * @brief A call being recorded, see @link INSTRUMENT_ENTER
+ */
+typedef struct GET_STRUCT_NAME(Probe)
+{
+    void * stats;
+    uint64_t begin;
+} GET_STRUCT_NAME(Probe);
 
-/**************************************** JOIN_TYPES BEGIN ****************************************/
 /**
- * @brief Add the struct name into the field tuples
- * @param st The name of the struct
+ * @brief Start recording a call of the operation @p op on the type @p name
  * 
- * @note For example:
- *           JOIN_TYPES(Person, (int, age) (char, sex) (char, married) (char, good))
- *               -> (Person, int, age) (Person, char, sex) (Person, char, married) (Person, char, good)
- **/
-#define JOIN_TYPES_FOR_EACH(target, st, ...) \
-    CONCAT(JOIN_TYPES_FOR_EACH_, IS_EMPTY(SPLIT_FIELDS(FALSE, ##__VA_ARGS__))) (target, st, ##__VA_ARGS__)
-#define JOIN_TYPES_FOR_EACH_0_(target, st, ...) \
-    target(st, FIRST_FIELD(TRUE, __VA_ARGS__)) \
-    DEFER(JOIN_TYPES_FOR_EACH_I)()(target, st, OTHER_FIELDS(__VA_ARGS__))
-#define JOIN_TYPES_FOR_EACH_0(...) JOIN_TYPES_FOR_EACH_0_(__VA_ARGS__)
-#define JOIN_TYPES_FOR_EACH_1(...)
-#define JOIN_TYPES_FOR_EACH_I() JOIN_TYPES_FOR_EACH
-#define JOIN_TYPES_TARGET(st, tuple) (st, EXPAND tuple)
-#define JOIN_TYPES(st, ...) EVAL(JOIN_TYPES_FOR_EACH(JOIN_TYPES_TARGET, st, ##__VA_ARGS__))
-// #define JOIN_TYPES_(st, ...) EVAL(JOIN_TYPES_FOR_EACH(JOIN_TYPES_TARGET, st, ##__VA_ARGS__))
-// #define JOIN_TYPES(st, ...) JOIN_TYPES_(st, SPLIT_FIELDS(TRUE, __VA_ARGS__))
-/**************************************** JOIN_TYPES  END  ****************************************/
+ * @note Only the outermost call of a thread is recorded, the nested calls such as copying the struct fields
+ *       and the allocations they make are accounted to it
+ * 
+ * @param probe The call
+ * @param id The cached id of the type name, @p -1 until the name is registered on the first call
+ * @param name The type name
+ * @param op The operation
+ */
+void json_wrapper_instrument_enter(GET_STRUCT_NAME(Probe) * probe, int * id, const char * name,
+    GET_STRUCT_NAME(InstrumentOp) op);
 
+/**
+ * @brief Stop recording a call and count its latency and bytes into the counters of the thread
+ * 
+ * @param probe The call
+ * @param bytes_in The bytes of text read
+ * @param bytes_out The bytes of text written
+ */
+void json_wrapper_instrument_leave(GET_STRUCT_NAME(Probe) * probe, size_t bytes_in, size_t bytes_out);
 
-/**************************************** JOIN_TYPES_EX BEGIN ****************************************/
 /**
- * @brief Add a tuple of struct names into the field tuples
- * @param st_tuple A tuple of struct names
+ * @brief Count an allocation of @p size bytes into the call being recorded in the current thread,
+ *        it's called by @link json_wrapper_alloc
  * 
- * @note For example:
- *           JOIN_TYPES_EX((json, st), (int, age) (char, sex) (char, married))
- *               -> (json, Person, int, age) (json, Person, char, sex) (json, Person, char, married)
- **/
-#define JOIN_TYPES_EX_FOR_EACH(target, st_tuple, ...) \
-    CONCAT(JOIN_TYPES_EX_FOR_EACH_, IS_EMPTY(SPLIT_FIELDS(FALSE, ##__VA_ARGS__))) (target, st_tuple, ##__VA_ARGS__)
-#define JOIN_TYPES_EX_FOR_EACH_0_(target, st_tuple, ...) \
-    target(st_tuple, FIRST_FIELD(TRUE, __VA_ARGS__)) \
-    DEFER(JOIN_TYPES_EX_FOR_EACH_I)()(target, st_tuple, OTHER_FIELDS(__VA_ARGS__))
-#define JOIN_TYPES_EX_FOR_EACH_0(...) JOIN_TYPES_EX_FOR_EACH_0_(__VA_ARGS__)
-#define JOIN_TYPES_EX_FOR_EACH_1(...)
-#define JOIN_TYPES_EX_FOR_EACH_I() JOIN_TYPES_EX_FOR_EACH
-#define JOIN_TYPES_EX_TARGET(st_tuple, tuple) (EXPAND st_tuple, EXPAND tuple)
-#define JOIN_TYPES_EX(st_tuple, ...) EVAL(JOIN_TYPES_EX_FOR_EACH(JOIN_TYPES_EX_TARGET, st_tuple, ##__VA_ARGS__))
-/**************************************** JOIN_TYPES_EX  END  ****************************************/
+ * @param size The memory size
+ */
+void json_wrapper_instrument_alloc(size_t size);
 
+/**
+ * @brief Write the counters of all the threads summed per type and operation as a text table into @p buf
+ * 
+ * @note Nothing is written unless json wrapper is built with @p JSON_WRAPPER_INSTRUMENT defined.
+ *       The counters are read while other threads may be updating them, so a dump taken under load is
+ *       consistent per counter but not across them
+ * 
+ * @param buf The buffer
+ * @return int @p 0 for success, @p -1 for failure or the instrumentation is compiled out
+ */
+int json_wrapper_instrument_dump_text(GET_STRUCT_NAME(Buffer) * buf);
 
-/**************************************** JOIN_JSON BEGIN ****************************************/
 /**
- * @brief Add the struct name into the field tuples
- * @param st The name of the struct
+ * @brief Write the counters the same as @link json_wrapper_instrument_dump_text but as a json array
+ *        of an object per type and operation, with the latency histogram in @p histogram
  * 
- * @note For example:
- *           JOIN_JSON(json, (st, int, age) (st, char, sex) (st, char, married) (st, char, good))
- *               -> (json, st, int, age) (json, st, char, sex) (json, st, char, married) (json, st, char, good)
- **/
-// TODO: How to merge these macros with JOIN_TYPES
-#define JOIN_JSON_FOR_EACH(target, json, ...) \
-    CONCAT(JOIN_JSON_FOR_EACH_, IS_EMPTY(__VA_ARGS__)) (target, json, __VA_ARGS__)
-#define JOIN_JSON_FOR_EACH_0_(target, json, st, t, n, ...) \
-    target(json, st, t, n) \
-    DEFER(JOIN_JSON_FOR_EACH_I)()(target, json, __VA_ARGS__)
-#define JOIN_JSON_FOR_EACH_0(...) JOIN_JSON_FOR_EACH_0_(__VA_ARGS__)
-#define JOIN_JSON_FOR_EACH_1(...)
-#define JOIN_JSON_FOR_EACH_I() JOIN_JSON_FOR_EACH
-#define JOIN_JSON_TARGET(json, st, t, n) (json, st, t, n)
-#define JOIN_JSON_(json, ...) EVAL(JOIN_JSON_FOR_EACH(JOIN_JSON_TARGET, json, ##__VA_ARGS__))
-#define JOIN_JSON(json, ...) JOIN_JSON_(json, SPLIT_FIELDS(FALSE, __VA_ARGS__))
-/**************************************** JOIN_JSON  END  ****************************************/
+ * @param buf The buffer
+ * @return int @p 0 for success, @p -1 for failure or the instrumentation is compiled out
+ */
+int json_wrapper_instrument_dump_json(GET_STRUCT_NAME(Buffer) * buf);
 
+/**
+ * @brief Zero the counters of all the threads, the type names stay registered
+ * 
+ * @note Each thread zeros its own counters on its next call, until then they are left out of the dumps,
+ *       a call in flight across the reset is dropped
+ */
+void json_wrapper_instrument_reset(void);
 
-/**************************************** STRUCT_2 BEGIN ****************************************/
+#if defined(JSON_WRAPPER_INSTRUMENT)
 /**
- * @brief Convert field to json object
- * @param type The type of the field
- * @param st The struct object of the field
- * @param n The name of the field
- **/
-#define STRUCT_2_FUNCTION_NAME(type) CONCAT(json_wrapper_json_from_, GET_STRUCT_NAME(type))
-#define STRUCT_2(type, st, n) STRUCT_2_FUNCTION_NAME(type) (&((st)->n))
+ * @brief Record the calls of a generated function, it's expanded at the top of the function after its arguments
+ *        are checked, and @link INSTRUMENT_LEAVE before it returns
+ */
+#define INSTRUMENT_ENTER(type, op) \
+    static int instrument_id_ = -1; \
+    GET_STRUCT_NAME(Probe) instrument_probe_; \
+    json_wrapper_instrument_enter(&instrument_probe_, &instrument_id_, #type, op);
+#define INSTRUMENT_LEAVE(bytes_in, bytes_out) \
+    json_wrapper_instrument_leave(&instrument_probe_, bytes_in, bytes_out);
+#else
+#define INSTRUMENT_ENTER(type, op)
+#define INSTRUMENT_LEAVE(bytes_in, bytes_out)
+#endif
+/**************************************** INSTRUMENT  END  ****************************************/
 
-static inline cJSON * STRUCT_2_FUNCTION_NAME(BOOL)(STANDARD_TYPE(BOOL) * value);
-inline cJSON * STRUCT_2_FUNCTION_NAME(BOOL)(STANDARD_TYPE(BOOL) * value)
-{
-    return PRE_CONCAT(cJSON_Create, TYPE_2_CJSON_TYPE(BOOL))(*value);
-}
 
-static inline cJSON * STRUCT_2_FUNCTION_NAME(CHAR)(STANDARD_TYPE(CHAR) * value);
-inline cJSON * STRUCT_2_FUNCTION_NAME(CHAR)(STANDARD_TYPE(CHAR) * value)
-{
-    return PRE_CONCAT(cJSON_Create, TYPE_2_CJSON_TYPE(CHAR))(*value);
-}
+/**************************************** ARENA BEGIN ****************************************/
+/**
+ * @brief The default size of an arena chunk
+ */
+#define ARENA_CHUNK_SIZE 4096
 
-static inline cJSON * STRUCT_2_FUNCTION_NAME(INT)(STANDARD_TYPE(INT) * value);
-inline cJSON * STRUCT_2_FUNCTION_NAME(INT)(STANDARD_TYPE(INT) * value)
-{
-    return PRE_CONCAT(cJSON_Create, TYPE_2_CJSON_TYPE(INT))(*value);
-}
+/**
+ * @brief The alignment of memory alloced from an arena
+ */
+#define ARENA_ALIGN 16
 
-static inline cJSON * STRUCT_2_FUNCTION_NAME(STRING)(STANDARD_TYPE(STRING) * value);
-inline cJSON * STRUCT_2_FUNCTION_NAME(STRING)(STANDARD_TYPE(STRING) * value)
+/**
+ * @brief A chunk of an arena, the memory to alloc follows the header
+ */
+typedef struct GET_STRUCT_NAME(ArenaChunk)
 {
-    return PRE_CONCAT(cJSON_Create, TYPE_2_CJSON_TYPE(STRING))(*value);
-}
-/**************************************** STRUCT_2  END  ****************************************/
-
+    struct GET_STRUCT_NAME(ArenaChunk) * next;
+    size_t size;
+} GET_STRUCT_NAME(ArenaChunk);
 
 /**
- * @brief Define a function name about converting json string to struct
+ * @brief A bump allocator whose memory is released all at once
+ * 
+ * @note A zeroed arena is a valid empty arena using @link ARENA_CHUNK_SIZE, the chunks are alloced by the hook
+ *       in json wrapper. Objects whose strings and arrays are in an arena must not be recycled by @link RECYCLE_ST
  */
-#define JSON_STR_2_FUNCTION_NAME(type) CONCAT(json_wrapper_json_str_to_, GET_STRUCT_NAME(type))
+typedef struct GET_STRUCT_NAME(Arena)
+{
+    GET_STRUCT_NAME(ArenaChunk) * head;
+    GET_STRUCT_NAME(ArenaChunk) * chunk;
+    char * cur;
+    char * end;
+    size_t chunk_size;
+} GET_STRUCT_NAME(Arena);
 
+/**
+ * @brief Init an arena
+ * 
+ * @param arena The arena
+ * @param chunk_size The size of each chunk, @p 0 for @link ARENA_CHUNK_SIZE
+ */
+void json_wrapper_arena_init(GET_STRUCT_NAME(Arena) * arena, size_t chunk_size);
 
-/**************************************** JSON_2 BEGIN ****************************************/
 /**
- * @brief Convert json object to struct field
- * @param type The type of the struct field
- * @param obj The json object
- * @param dst The struct field
- **/
-#define JSON_2_FUNCTION_NAME(type) CONCAT(json_wrapper_json_to_, GET_STRUCT_NAME(type))
-#define JSON_2(type, obj, dst) JSON_2_FUNCTION_NAME(type) (obj, dst)
+ * @brief Move to the next chunk which has room for @p size bytes, a new chunk is alloced if there's none
+ * 
+ * @param arena The arena
+ * @param size The aligned size
+ * @return void* The pointer of memory, @p NULL for failure
+ */
+void * json_wrapper_arena_grow(GET_STRUCT_NAME(Arena) * arena, size_t size);
 
-static inline void JSON_2_FUNCTION_NAME(BOOL)(cJSON * obj, STANDARD_TYPE(BOOL) * dst);
-inline void JSON_2_FUNCTION_NAME(BOOL)(cJSON * obj, STANDARD_TYPE(BOOL) * dst)
+/**
+ * @brief Alloc memory from an arena
+ * 
+ * @param arena The arena
+ * @param size The memory size
+ * @return void* The pointer of memory, @p NULL for failure
+ */
+static inline void * json_wrapper_arena_alloc(GET_STRUCT_NAME(Arena) * arena, size_t size);
+inline void * json_wrapper_arena_alloc(GET_STRUCT_NAME(Arena) * arena, size_t size)
 {
-    *dst = (obj)->valueint;
-    // *dst = CONCAT(PRE_CONCAT(cJSON_Get, TYPE_2_CJSON_TYPE(BOOL)), Value)(obj);
+    size = (size + ARENA_ALIGN - 1) & ~((size_t) ARENA_ALIGN - 1);
+    ASSERT_RETURN((size_t) (arena->end - arena->cur) >= size, json_wrapper_arena_grow(arena, size));
+    void * ptr = arena->cur;
+    arena->cur += size;
+    return ptr;
 }
 
-static inline void JSON_2_FUNCTION_NAME(CHAR)(cJSON * obj, STANDARD_TYPE(CHAR) * dst);
-inline void JSON_2_FUNCTION_NAME(CHAR)(cJSON * obj, STANDARD_TYPE(CHAR) * dst)
-{
-    *dst = (obj)->valueint;
-    // *dst = CONCAT(PRE_CONCAT(cJSON_Get, TYPE_2_CJSON_TYPE(CHAR)), Value)(obj);
-}
+/**
+ * @brief Release everything alloced from an arena at once, the chunks are kept to be reused
+ * 
+ * @param arena The arena
+ */
+void json_wrapper_arena_reset(GET_STRUCT_NAME(Arena) * arena);
 
-static inline void JSON_2_FUNCTION_NAME(INT)(cJSON * obj, STANDARD_TYPE(INT) * dst);
-inline void JSON_2_FUNCTION_NAME(INT)(cJSON * obj, STANDARD_TYPE(INT) * dst)
+/**
+ * @brief Free all the chunks of an arena, the arena is reset to empty
+ * 
+ * @param arena The arena
+ */
+void json_wrapper_arena_release(GET_STRUCT_NAME(Arena) * arena);
+
+/**
+ * @brief Alloc memory from @p arena, or using the hook in json wrapper if @p arena is @p NULL
+ * 
+ * @param arena The arena
+ * @param size The memory size
+ * @return void* The pointer of memory, @p NULL for failure
+ */
+static inline void * json_wrapper_alloc_from(GET_STRUCT_NAME(Arena) * arena, size_t size);
+inline void * json_wrapper_alloc_from(GET_STRUCT_NAME(Arena) * arena, size_t size)
 {
-    *dst = (obj)->valueint;
-    // *dst = CONCAT(PRE_CONCAT(cJSON_Get, TYPE_2_CJSON_TYPE(INT)), Value)(obj);
+    return arena ? json_wrapper_arena_alloc(arena, size) : json_wrapper_alloc(size);
 }
+/**************************************** ARENA  END  ****************************************/
 
-void JSON_2_FUNCTION_NAME(STRING)(cJSON * obj, STANDARD_TYPE(STRING) * dst);
-/**************************************** JSON_2  END  ****************************************/
 
+/**************************************** INDEX BEGIN ****************************************/
+/**
+ * @brief The structural index of a json text, built in one SIMD pass before it's read
+ * 
+ * @note @p positions are the offsets of the structural characters '{', '}', '[', ']', ':', ',' out of strings
+ *       and of the quotes opening and closing the strings, in order. For the entry @p k of an opening brace
+ *       or bracket, @p jumps[k] is the entry of its closing one, the other entries of @p jumps are undefined.
+ *       A reader with the index skips any string, object or array without scanning it, in O(log n) of the entries
+ *       at worst to find the entry at the cursor, which is a few steps from the entry of the last skip when
+ *       the skips are close, see @link GET_STRUCT_NAME(Reader)
+ */
+typedef struct GET_STRUCT_NAME(Index)
+{
+    uint32_t * positions;
+    uint32_t * jumps;
+    size_t count;
+    size_t cap;
+} GET_STRUCT_NAME(Index);
 
-/**************************************** DEFINE_VA_ARRAY_TYPES BEGIN ****************************************/
-#define DEFINE_VA_ARRAY_TYPE_VA_ARRAY(num, type, name) DEFINE_VA_ARRAY(type, name)
-#define DEFINE_VA_ARRAY_TYPE_ARRAY(num, type, name)
-#define DEFINE_VA_ARRAY_TYPE_OBJ(num, type, name)
-#define DEFINE_VA_ARRAY_TYPE_(t, num, type, name) DEFINE_VA_ARRAY_TYPE_##t(num, type, name)
-#define DEFINE_VA_ARRAY_TYPE(t, num, type, name) DEFINE_VA_ARRAY_TYPE_(t, num, type, name)
-#define DEFINE_VA_ARRAY_TYPES(...) CONCAT(DEFINE_VA_ARRAY_TYPES_I __VA_ARGS__, _END)
-#define DEFINE_VA_ARRAY_TYPES_I(...) DEFINE_VA_ARRAY_TYPE(__VA_ARGS__) DEFINE_VA_ARRAY_TYPES_II
-#define DEFINE_VA_ARRAY_TYPES_II(...) DEFINE_VA_ARRAY_TYPE(__VA_ARGS__) DEFINE_VA_ARRAY_TYPES_I
-#define DEFINE_VA_ARRAY_TYPES_I_END
-#define DEFINE_VA_ARRAY_TYPES_II_END
-/**************************************** DEFINE_VA_ARRAY_TYPES  END  ****************************************/
-
+/**
+ * @brief Build the structural index of @p len bytes of @p data, the memory of the index is reused
+ * 
+ * @note The text is classified by 64 bytes blocks with the instruction set of @link json_wrapper_simd_level,
+ *       it's a failure if the text is longer than 4GB, a string is not closed or the braces and brackets
+ *       are not matched. Nothing else is validated, that's left to the reader
+ * 
+ * @param index The index, zeroed before the first build
+ * @param data The json text
+ * @param len The length of json text
+ * @return int @p 0 for success, @p -1 for failure
+ */
+int json_wrapper_index_build(GET_STRUCT_NAME(Index) * index, const char * data, size_t len);
 
-/**************************************** DEFINE_STRUCT_ BEGIN ****************************************/
 /**
- * @brief Define the header of the struct
+ * @brief Free the memory of an index, the index is reset to empty
  * 
- * @note For example:
- *           DEFINE_STRUCT_(Person)
- *               -> struct Person_JSON;
- *                  typedef struct Person_JSON Person_JSON;
- *                  struct Person_JSON
- **/
-#define DEFINE_STRUCT_(type) \
-struct GET_STRUCT_NAME(type); \
-typedef struct GET_STRUCT_NAME(type) GET_STRUCT_NAME(type); \
-struct GET_STRUCT_NAME(type)
-/**************************************** DEFINE_STRUCT_  END  ****************************************/
+ * @param index The index
+ */
+void json_wrapper_index_release(GET_STRUCT_NAME(Index) * index);
+/**************************************** INDEX  END  ****************************************/
 
 
-/**************************************** DEFINE_FIELDS BEGIN ****************************************/
+/**************************************** READER BEGIN ****************************************/
 /**
- * @brief Define the fields
- * 
- * @note For example:
- *           (int, age) (char, sex) -> int age; char sex;
- **/
-#define DEFINE_FIELD_VA_ARRAY(num, type, name) GET_VA_ARRAY_NAME(type) name;
-#define DEFINE_FIELD_ARRAY(num, type, name) GET_STRUCT_NAME(type) name[num];
-#define DEFINE_FIELD_OBJ(num, type, name) GET_STRUCT_NAME(type) name;
-#define DEFINE_FIELD_(t, num, type, name) DEFINE_FIELD_##t(num, type, name)
-#define DEFINE_FIELD(t, num, type, name) DEFINE_FIELD_(t, num, type, name)
-#define DEFINE_FIELDS(...) CONCAT(DEFINE_FIELDS_I __VA_ARGS__, _END)
-#define DEFINE_FIELDS_I(...) DEFINE_FIELD(__VA_ARGS__) DEFINE_FIELDS_II
-#define DEFINE_FIELDS_II(...) DEFINE_FIELD(__VA_ARGS__) DEFINE_FIELDS_I
-#define DEFINE_FIELDS_I_END
-#define DEFINE_FIELDS_II_END
-/**************************************** DEFINE_FIELDS  END  ****************************************/
+ * @brief The max length of an escaped object key which can be matched with a field name
+ */
+#define READER_KEY_MAX 64
 
+/**
+ * @brief The max nesting of the objects and arrays of a skipped value, a multiple of 64
+ */
+#define READER_DEPTH_MAX 1024
 
 /**
- * @brief Define a function name to convert wrapper struct to json string
+ * @brief A cursor which tokenizes json text in one pass without building any json object
+ * 
+ * @note The text doesn't need to be '\0' terminated, the cursor never reads at or beyond @p end.
+ *       With @p index built over the text from @p begin, the values skipped are jumped over instead of scanned,
+ *       @p token is the entry of the index after the last jump, a hint to find the next one from
  */
-#define STRUCT_2_JSON_STR_FUNCTION_NAME(type) CONCAT(json_wrapper_json_str_from_, GET_STRUCT_NAME(type))
+typedef struct GET_STRUCT_NAME(Reader)
+{
+    const char * cur;
+    const char * end;
+    GET_STRUCT_NAME(Arena) * arena;
+    bool writable;
+    bool patch;
+    const GET_STRUCT_NAME(Index) * index;
+    const char * begin;
+    size_t token;
+    char key[READER_KEY_MAX];
+} GET_STRUCT_NAME(Reader);
 
+/**
+ * @brief A mask of the fields to decode from a struct, the other fields are skipped with their whole subtrees
+ *        and left unchanged
+ * 
+ * @note Bit @p i of @p fields is the field of index @p i, see @link GET_FIELD_BIT, fields from the 65th on
+ *       are always decoded. @p subs has an entry per field, it's the mask of a struct field or of the elements
+ *       of a struct array, @p NULL for decoding them whole. For example:
+ *           static const Mask_JSON son_mask = { GET_FIELD_BIT(Son, name), NULL };
+ *           static const Mask_JSON * const person_subs[GET_FIELD_COUNT(Person)] = {
+ *               [GET_FIELD_INDEX(Person, v_sons)] = &son_mask };
+ *           static const Mask_JSON person_mask = {
+ *               GET_FIELD_BIT(Person, name) | GET_FIELD_BIT(Person, v_sons), person_subs };
+ */
+typedef struct GET_STRUCT_NAME(Mask)
+{
+    uint64_t fields;
+    const struct GET_STRUCT_NAME(Mask) * const * subs;
+} GET_STRUCT_NAME(Mask);
 
-/**************************************** DEFINE_STRUCT_2_JSON BEGIN ****************************************/
 /**
- * @brief Define a function to convert the struct to json string
- * @param type The type name of the struct
- **/
-#define DEFINE_STRUCT_2_JSON__OBJ(json, st, num, t, n) { \
-    cJSON * obj = STRUCT_2(t, st, n); \
-    ASSERT_BREAK(obj); \
+ * @brief Whether the field of index @p field is decoded under @p mask, @p NULL for all the fields
+ * 
+ * @param mask The mask
+ * @param field The field index, @p -1 for an unknown key
+ * @return bool @p true for decoding it
+ */
+static inline bool json_wrapper_mask_has(const GET_STRUCT_NAME(Mask) * mask, int field);
+inline bool json_wrapper_mask_has(const GET_STRUCT_NAME(Mask) * mask, int field)
+{
+    return NULL == mask || field < 0 || field >= 64 || 0 != ((mask->fields >> field) & 1);
+}
+
+/**
+ * @brief Get the mask of the field of index @p field under @p mask
+ * 
+ * @param mask The mask
+ * @param field The field index
+ * @return const Mask_JSON* The mask, @p NULL for all the fields
+ */
+static inline const GET_STRUCT_NAME(Mask) * json_wrapper_mask_sub(const GET_STRUCT_NAME(Mask) * mask, int field);
+inline const GET_STRUCT_NAME(Mask) * json_wrapper_mask_sub(const GET_STRUCT_NAME(Mask) * mask, int field)
+{
+    return NULL != mask && NULL != mask->subs && field >= 0 ? mask->subs[field] : NULL;
+}
+
+/**
+ * @brief Init a reader over @p len bytes of @p data
+ * 
+ * @note The strings and arrays read are alloced by the hook in json wrapper, set @p arena of the reader
+ *       to alloc them from an arena instead, in which case the old values are not freed.
+ *       Set @p writable of the reader if the text may be modified, then escaped strings read as views
+ *       are unescaped in place. Set @p patch of the reader to read the text as a merge patch, then a member
+ *       of null resets its field to zero instead of being skipped. Set @p index of the reader to an index
+ *       built over the same bytes by @link json_wrapper_index_build to skip values without scanning them,
+ *       in O(log n) of the index entries at worst
+ * 
+ * @param r The reader
+ * @param data The json text
+ * @param len The length of json text
+ */
+void json_wrapper_reader_init(GET_STRUCT_NAME(Reader) * r, const char * data, size_t len);
+
+/**
+ * @brief Skip the whitespaces and peek the next character
+ * 
+ * @param r The reader
+ * @return int The next character, @p -1 for the end of text
+ */
+static inline int json_wrapper_reader_peek(GET_STRUCT_NAME(Reader) * r);
+inline int json_wrapper_reader_peek(GET_STRUCT_NAME(Reader) * r)
+{
+    while (r->cur < r->end && (unsigned char) *r->cur <= 32) ++r->cur;
+    return r->cur < r->end ? (unsigned char) *r->cur : -1;
+}
+
+/**
+ * @brief Skip the whitespaces and consume the character @p c
+ * 
+ * @param r The reader
+ * @param c The expected character
+ * @return int @p 0 for success, @p -1 for the next character is not @p c
+ */
+int json_wrapper_reader_expect(GET_STRUCT_NAME(Reader) * r, char c);
+
+/**
+ * @brief Move to the item @p index of an object or array which has been opened by @link json_wrapper_reader_expect
+ * 
+ * @param r The reader
+ * @param close The closing character, '}' for an object and ']' for an array
+ * @param index The index of the item to move to, the comma is consumed for the items except the first one
+ * @return int @p 1 for there's an item, @p 0 for the closing character is consumed, @p -1 for failure
+ */
+int json_wrapper_reader_next(GET_STRUCT_NAME(Reader) * r, char close, size_t index);
+
+/**
+ * @brief Read an object key and the colon after it
+ * 
+ * @note The key is not copied unless it's escaped, an escaped key longer than @link READER_KEY_MAX
+ *       is returned with length @p 0 so that it matches nothing
+ * 
+ * @param r The reader
+ * @param key The key, which points into the text or the reader, it's not '\0' terminated
+ * @param len The length of the key
+ * @return int @p 0 for success, @p -1 for failure
+ */
+int json_wrapper_reader_key(GET_STRUCT_NAME(Reader) * r, const char ** key, size_t * len);
+
+/**
+ * @brief Skip a value of any type without allocating
+ * 
+ * @note The value is checked against the grammar of json: the literals, the numbers, the commas between the items
+ *       and the colons after the keys, objects and arrays are nested up to @link READER_DEPTH_MAX levels.
+ *       With an index, a string, object or array is jumped over without being scanned, so only its
+ *       quotes, braces and brackets are checked, by @link json_wrapper_index_build
+ * 
+ * @param r The reader
+ * @return int @p 0 for success, @p -1 for failure
+ */
+int json_wrapper_reader_skip(GET_STRUCT_NAME(Reader) * r);
+
+/**
+ * @brief Count the items of the array at the cursor without consuming it
+ * 
+ * @param r The reader
+ * @param count The number of items
+ * @return int @p 0 for success, @p -1 for failure
+ */
+int json_wrapper_reader_count(GET_STRUCT_NAME(Reader) * r, size_t * count);
+
+/**
+ * @brief Read a boolean, a number is read as @p true if it's not zero
+ * 
+ * @note Values of other types are skipped and @p value is left unchanged, the same for the other readers
+ * 
+ * @param r The reader
+ * @param value The value
+ * @return int @p 0 for success, @p -1 for failure
+ */
+int json_wrapper_reader_bool(GET_STRUCT_NAME(Reader) * r, bool * value);
+
+/**
+ * @brief Read an integer, fractions are truncated and out of range values are saturated,
+ *        @p true and @p false are read as @p 1 and @p 0
+ * 
+ * @param r The reader
+ * @param value The value
+ * @return int @p 0 for success, @p -1 for failure
+ */
+int json_wrapper_reader_int(GET_STRUCT_NAME(Reader) * r, long * value);
+
+/**
+ * @brief Read a 64 bits integer exactly, fractions are truncated and out of range values are saturated,
+ *        @p true and @p false are read as @p 1 and @p 0
+ * 
+ * @param r The reader
+ * @param value The value
+ * @return int @p 0 for success, @p -1 for failure
+ */
+int json_wrapper_reader_int64(GET_STRUCT_NAME(Reader) * r, int64_t * value);
+
+/**
+ * @brief Read an unsigned 64 bits integer exactly, fractions are truncated and out of range values,
+ *        the negative ones included, are saturated, @p true and @p false are read as @p 1 and @p 0
+ * 
+ * @param r The reader
+ * @param value The value
+ * @return int @p 0 for success, @p -1 for failure
+ */
+int json_wrapper_reader_uint64(GET_STRUCT_NAME(Reader) * r, uint64_t * value);
+
+/**
+ * @brief Read a double, @p true and @p false are read as @p 1 and @p 0
+ * 
+ * @param r The reader
+ * @param value The value
+ * @return int @p 0 for success, @p -1 for failure
+ */
+int json_wrapper_reader_double(GET_STRUCT_NAME(Reader) * r, double * value);
+
+/**
+ * @brief Read and unescape a string into memory alloced for the reader, the old @p *value is freed
+ * 
+ * @param r The reader
+ * @param value The value
+ * @return int @p 0 for success, @p -1 for failure
+ */
+int json_wrapper_reader_string(GET_STRUCT_NAME(Reader) * r, char ** value);
+
+/**
+ * @brief Read a string as a view into the text, nothing is copied unless the string is escaped
+ * 
+ * @note An escaped string is unescaped in place if the reader is writable, or else into its arena,
+ *       it's a failure if the reader has neither
+ * 
+ * @param r The reader
+ * @param value The value
+ * @return int @p 0 for success, @p -1 for failure
+ */
+int json_wrapper_reader_view(GET_STRUCT_NAME(Reader) * r, GET_STRUCT_NAME(STRING_VIEW) * value);
+
+/**
+ * @brief Read a string into a fixed-capacity buffer, nothing is alloced
+ * 
+ * @note A string longer than @p cap - 1 bytes is truncated on a UTF-8 character boundary,
+ *       the result is always '\0' terminated
+ * 
+ * @param r The reader
+ * @param value The buffer
+ * @param cap The capacity of the buffer, at least @p 1
+ * @return int @p 0 for success, @p -1 for failure
+ */
+int json_wrapper_reader_fixed(GET_STRUCT_NAME(Reader) * r, char * value, size_t cap);
+/**************************************** READER  END  ****************************************/
+
+
+/**************************************** LINES BEGIN ****************************************/
+/**
+ * @brief The default size of the refill buffer of a line source over a file descriptor
+ */
+#define LINES_BUFFER_SIZE 65536
+
+/**
+ * @brief The default length limit of a line read from a file descriptor
+ */
+#define LINES_MAX_LINE (16 << 20)
+
+/**
+ * @brief A source of the lines of NDJSON text, read from a file descriptor, a mapped file or memory
+ *
+ * @note The lines are handed out in place without being copied or '\0' terminated. The memory taken is
+ *       the refill buffer, which only grows for a line longer than it, so it's bounded by the longest line
+ *       rather than the size of the file. The lines of a file descriptor or a mapped file are writable,
+ *       so that the escaped string views of the records are unescaped in place
+ */
+typedef struct GET_STRUCT_NAME(Lines)
+{
+    int fd;                                 // -1 for mapped file or memory
+    const char * data;                      // the refill buffer, the mapped file or the memory
+    size_t len;                             // the bytes available in data
+    size_t pos;                             // the start of the next line
+    size_t cap;                             // the size of the refill buffer
+    size_t max;                             // the length limit of a line read from fd
+    size_t line;                            // the number of the last line handed out, from 1
+    bool mapped;
+    bool eof;
+    bool skip;                              // dropping the rest of a line which is too long
+    GET_STRUCT_NAME(Arena) * arena;         // where the records decoded are alloced, NULL for the hook
+    const GET_STRUCT_NAME(Mask) * mask;     // the fields of the records to decode, NULL for all
+} GET_STRUCT_NAME(Lines);
+
+/**
+ * @brief Init a line source which reads @p fd through a refill buffer, the descriptor is not closed by the source
+ *
+ * @param lines The line source
+ * @param fd The file descriptor
+ * @param max The length limit of a line, @p 0 for @link LINES_MAX_LINE, longer lines are reported as failures
+ * @return int @p 0 for success, @p -1 for failure
+ */
+int json_wrapper_lines_init_fd(GET_STRUCT_NAME(Lines) * lines, int fd, size_t max);
+
+/**
+ * @brief Init a line source over a file mapped into memory, the pages are read ahead and cached by the system
+ *
+ * @note Only available on POSIX systems. The mapping is private, the changes made to it are never written back
+ *
+ * @param lines The line source
+ * @param path The path of the file
+ * @return int @p 0 for success, @p -1 for failure
+ */
+int json_wrapper_lines_init_map(GET_STRUCT_NAME(Lines) * lines, const char * path);
+
+/**
+ * @brief Init a line source over @p len bytes of @p data of the caller
+ *
+ * @param lines The line source
+ * @param data The text
+ * @param len The length of text
+ */
+void json_wrapper_lines_init_memory(GET_STRUCT_NAME(Lines) * lines, const char * data, size_t len);
+
+/**
+ * @brief Get the next line, without the '\n' nor the '\r' before it
+ *
+ * @note The line stays valid until the next call. A line which is too long or an error of reading
+ *       is reported once by @p -1, the next call goes on with the line after it
+ *
+ * @param lines The line source
+ * @param line The line
+ * @param len The length of the line
+ * @return int @p 1 for there's a line, @p 0 for the end, @p -1 for failure
+ */
+int json_wrapper_lines_next(GET_STRUCT_NAME(Lines) * lines, const char ** line, size_t * len);
+
+/**
+ * @brief Release the refill buffer or unmap the file of @p lines
+ *
+ * @param lines The line source
+ */
+void json_wrapper_lines_release(GET_STRUCT_NAME(Lines) * lines);
+/**************************************** LINES  END  ****************************************/
+
+
+/**************************************** PARALLEL BEGIN ****************************************/
+/**
+ * @brief The default number of bytes of NDJSON text in a piece of work of a parallel decode
+ */
+#define PARALLEL_CHUNK_SIZE 65536
+
+/**
+ * @brief The options of a parallel decode, a zeroed one is valid
+ */
+typedef struct GET_STRUCT_NAME(Parallel)
+{
+    int threads;                            // the number of workers, 0 for the number of online cores
+    size_t chunk;                           // the bytes of a piece of work, 0 for PARALLEL_CHUNK_SIZE
+    GET_STRUCT_NAME(Arena) * arenas;        // one arena per worker to decode into, NULL for the hook
+} GET_STRUCT_NAME(Parallel);
+
+/**
+ * @brief Decode a record from a reader into the struct at @p st
+ */
+typedef int (*GET_STRUCT_NAME(Decode))(GET_STRUCT_NAME(Reader) * r, void * st);
+
+/**
+ * @brief Decode the non-empty lines of NDJSON text into an array on a pool of worker threads
+ *
+ * @note The text is split into pieces of about @p chunk bytes on line ends, the records of each piece
+ *       are counted first so that every record knows its slot in @p array, then the workers decode their
+ *       own ranges of pieces and steal half of the rest of another worker when they run out.
+ *       The workers are bound to the hook in effect on the calling thread, the thread hook if it's bound,
+ *       so the records are freed by RECYCLE_ST on the calling thread the same as if it decoded them all,
+ *       and the hook is called from all the workers, it must be thread safe.
+ *       With arenas, the records decoded by worker @p i live in @p arenas[i], grown by the same hook
+ *
+ * @param data The NDJSON text
+ * @param len The length of text
+ * @param array The array of structs, the records decode into it the same as @link J2S does
+ * @param size The size of a struct
+ * @param count The number of structs in @p array, the records after them are ignored
+ * @param decode The decode function of the struct
+ * @param options The options, @p NULL for the defaults
+ * @param records The number of records decoded into @p array
+ * @return int @p 0 for success, @p -1 for any record or the pool failed
+ */
+int json_wrapper_parallel_decode(const char * data, size_t len, void * array, size_t size, size_t count,
+    GET_STRUCT_NAME(Decode) decode, const GET_STRUCT_NAME(Parallel) * options, size_t * records);
+/**************************************** PARALLEL  END  ****************************************/
+
+
+/**************************************** MSGPACK BEGIN ****************************************/
+/**
+ * @brief The MessagePack writers append into a buffer and the readers consume from a reader,
+ *        a reader inited by @link json_wrapper_reader_init over the bytes is used as a plain byte cursor
+ * 
+ * @note The integers are written in the smallest format, the strings as str and the structs as maps
+ *       keyed by the field names, so the data is readable by any MessagePack implementation
+ */
+
+/**
+ * @brief Append a nil into @p buf
+ * 
+ * @param buf The buffer
+ * @return int @p 0 for success, @p -1 for failure
+ */
+int json_wrapper_msgpack_write_nil(GET_STRUCT_NAME(Buffer) * buf);
+
+/**
+ * @brief Append a boolean into @p buf
+ * 
+ * @param buf The buffer
+ * @param value The boolean
+ * @return int @p 0 for success, @p -1 for failure
+ */
+int json_wrapper_msgpack_write_bool(GET_STRUCT_NAME(Buffer) * buf, bool value);
+
+/**
+ * @brief Append an integer into @p buf
+ * 
+ * @param buf The buffer
+ * @param value The integer
+ * @return int @p 0 for success, @p -1 for failure
+ */
+int json_wrapper_msgpack_write_int(GET_STRUCT_NAME(Buffer) * buf, long value);
+
+/**
+ * @brief Append a 64 bits integer into @p buf
+ * 
+ * @param buf The buffer
+ * @param value The integer
+ * @return int @p 0 for success, @p -1 for failure
+ */
+int json_wrapper_msgpack_write_int64(GET_STRUCT_NAME(Buffer) * buf, int64_t value);
+
+/**
+ * @brief Append an unsigned 64 bits integer into @p buf
+ * 
+ * @param buf The buffer
+ * @param value The integer
+ * @return int @p 0 for success, @p -1 for failure
+ */
+int json_wrapper_msgpack_write_uint64(GET_STRUCT_NAME(Buffer) * buf, uint64_t value);
+
+/**
+ * @brief Append a float as a float 32 into @p buf
+ * 
+ * @param buf The buffer
+ * @param value The float
+ * @return int @p 0 for success, @p -1 for failure
+ */
+int json_wrapper_msgpack_write_float(GET_STRUCT_NAME(Buffer) * buf, float value);
+
+/**
+ * @brief Append a double as a float 64 into @p buf
+ * 
+ * @param buf The buffer
+ * @param value The double
+ * @return int @p 0 for success, @p -1 for failure
+ */
+int json_wrapper_msgpack_write_double(GET_STRUCT_NAME(Buffer) * buf, double value);
+
+/**
+ * @brief Append @p len bytes of @p str as a string into @p buf
+ * 
+ * @param buf The buffer
+ * @param str The string, which doesn't need to be '\0' terminated
+ * @param len The length of the string
+ * @return int @p 0 for success, @p -1 for failure
+ */
+int json_wrapper_msgpack_write_str(GET_STRUCT_NAME(Buffer) * buf, const char * str, size_t len);
+
+/**
+ * @brief Append a map key into @p buf, the same as @link json_wrapper_msgpack_write_str
+ *        with one copy for the short keys
+ * 
+ * @param buf The buffer
+ * @param key The key
+ * @param len The length of the key
+ * @return int @p 0 for success, @p -1 for failure
+ */
+static inline int json_wrapper_msgpack_write_key(GET_STRUCT_NAME(Buffer) * buf, const char * key, size_t len);
+inline int json_wrapper_msgpack_write_key(GET_STRUCT_NAME(Buffer) * buf, const char * key, size_t len)
+{
+    if (len > 31 || buf->len + len + 1 >= buf->cap) return json_wrapper_msgpack_write_str(buf, key, len);
+    buf->data[buf->len] = (char) (0xA0 | len);
+    memcpy(buf->data + buf->len + 1, key, len);
+    buf->len += len + 1;
+    return 0;
+}
+
+/**
+ * @brief Append a small integer as a fixint into @p buf, or fall back to @link json_wrapper_msgpack_write_int
+ * 
+ * @param buf The buffer
+ * @param value The integer
+ * @return int @p 0 for success, @p -1 for failure
+ */
+static inline int json_wrapper_msgpack_write_small_int(GET_STRUCT_NAME(Buffer) * buf, long value);
+inline int json_wrapper_msgpack_write_small_int(GET_STRUCT_NAME(Buffer) * buf, long value)
+{
+    if (value < -32 || value > 127 || buf->len + 1 >= buf->cap) return json_wrapper_msgpack_write_int(buf, value);
+    buf->data[buf->len++] = (char) value;
+    return 0;
+}
+
+/**
+ * @brief Append a '\0' terminated string into @p buf, @p NULL is appended as nil
+ * 
+ * @param buf The buffer
+ * @param str The string
+ * @return int @p 0 for success, @p -1 for failure
+ */
+int json_wrapper_msgpack_write_string(GET_STRUCT_NAME(Buffer) * buf, const char * str);
+
+/**
+ * @brief Append the header of an array of @p count items into @p buf
+ * 
+ * @param buf The buffer
+ * @param count The number of items
+ * @return int @p 0 for success, @p -1 for failure
+ */
+int json_wrapper_msgpack_write_array(GET_STRUCT_NAME(Buffer) * buf, size_t count);
+
+/**
+ * @brief Append the header of a map of @p count pairs into @p buf
+ * 
+ * @param buf The buffer
+ * @param count The number of pairs
+ * @return int @p 0 for success, @p -1 for failure
+ */
+int json_wrapper_msgpack_write_map(GET_STRUCT_NAME(Buffer) * buf, size_t count);
+
+/**
+ * @brief Peek the first byte of the next value
+ * 
+ * @param r The reader
+ * @return int The byte, @p -1 for the end of data
+ */
+static inline int json_wrapper_msgpack_peek(GET_STRUCT_NAME(Reader) * r);
+inline int json_wrapper_msgpack_peek(GET_STRUCT_NAME(Reader) * r)
+{
+    return r->cur < r->end ? (unsigned char) *r->cur : -1;
+}
+
+/**
+ * @brief Check whether a first byte from @link json_wrapper_msgpack_peek starts an array
+ */
+#define JSON_WRAPPER_MSGPACK_IS_ARRAY(c) (0x90 == ((c) & 0xF0) || 0xDC == (c) || 0xDD == (c))
+
+/**
+ * @brief Check whether a first byte from @link json_wrapper_msgpack_peek starts a map
+ */
+#define JSON_WRAPPER_MSGPACK_IS_MAP(c) (0x80 == ((c) & 0xF0) || 0xDE == (c) || 0xDF == (c))
+
+/**
+ * @brief Read the header of an array
+ * 
+ * @param r The reader
+ * @param count The number of items
+ * @return int @p 0 for success, @p -1 for the next value is not an array or the data is truncated
+ */
+int json_wrapper_msgpack_read_array(GET_STRUCT_NAME(Reader) * r, size_t * count);
+
+/**
+ * @brief Read the header of a map
+ * 
+ * @param r The reader
+ * @param count The number of pairs
+ * @return int @p 0 for success, @p -1 for the next value is not a map or the data is truncated
+ */
+int json_wrapper_msgpack_read_map(GET_STRUCT_NAME(Reader) * r, size_t * count);
+
+/**
+ * @brief Read a map key without copying it, a key which is not a string is skipped and returned with length @p 0
+ * 
+ * @param r The reader
+ * @param key The key, which points into the data, it's not '\0' terminated
+ * @param len The length of the key
+ * @return int @p 0 for success, @p -1 for failure
+ */
+int json_wrapper_msgpack_read_key(GET_STRUCT_NAME(Reader) * r, const char ** key, size_t * len);
+
+/**
+ * @brief Skip a value of any type without allocating
+ * 
+ * @param r The reader
+ * @return int @p 0 for success, @p -1 for failure
+ */
+int json_wrapper_msgpack_skip(GET_STRUCT_NAME(Reader) * r);
+
+/**
+ * @brief Read a boolean, a number is read as @p true if it's not zero
+ * 
+ * @note Values of other types are skipped and @p value is left unchanged, the same for the other readers
+ * 
+ * @param r The reader
+ * @param value The value
+ * @return int @p 0 for success, @p -1 for failure
+ */
+int json_wrapper_msgpack_read_bool(GET_STRUCT_NAME(Reader) * r, bool * value);
+
+/**
+ * @brief Read an integer, floats are truncated and out of range values are saturated,
+ *        booleans are read as @p 1 and @p 0
+ * 
+ * @param r The reader
+ * @param value The value
+ * @return int @p 0 for success, @p -1 for failure
+ */
+int json_wrapper_msgpack_read_int(GET_STRUCT_NAME(Reader) * r, long * value);
+
+/**
+ * @brief Read a 64 bits integer exactly, floats are truncated and out of range values are saturated,
+ *        booleans are read as @p 1 and @p 0
+ * 
+ * @param r The reader
+ * @param value The value
+ * @return int @p 0 for success, @p -1 for failure
+ */
+int json_wrapper_msgpack_read_int64(GET_STRUCT_NAME(Reader) * r, int64_t * value);
+
+/**
+ * @brief Read an unsigned 64 bits integer exactly, floats are truncated and out of range values,
+ *        the negative ones included, are saturated, booleans are read as @p 1 and @p 0
+ * 
+ * @param r The reader
+ * @param value The value
+ * @return int @p 0 for success, @p -1 for failure
+ */
+int json_wrapper_msgpack_read_uint64(GET_STRUCT_NAME(Reader) * r, uint64_t * value);
+
+/**
+ * @brief Read a double, integers are converted and booleans are read as @p 1 and @p 0
+ * 
+ * @param r The reader
+ * @param value The value
+ * @return int @p 0 for success, @p -1 for failure
+ */
+int json_wrapper_msgpack_read_double(GET_STRUCT_NAME(Reader) * r, double * value);
+
+/**
+ * @brief Read a string into memory alloced for the reader, the old @p *value is freed
+ * 
+ * @param r The reader
+ * @param value The value
+ * @return int @p 0 for success, @p -1 for failure
+ */
+int json_wrapper_msgpack_read_string(GET_STRUCT_NAME(Reader) * r, char ** value);
+
+/**
+ * @brief Read a string as a view into the data, nothing is copied
+ * 
+ * @param r The reader
+ * @param value The value
+ * @return int @p 0 for success, @p -1 for failure
+ */
+int json_wrapper_msgpack_read_view(GET_STRUCT_NAME(Reader) * r, GET_STRUCT_NAME(STRING_VIEW) * value);
+
+/**
+ * @brief Read a string into a fixed-capacity buffer, nothing is alloced
+ * 
+ * @note A string longer than @p cap - 1 bytes is truncated on a UTF-8 character boundary,
+ *       the result is always '\0' terminated
+ * 
+ * @param r The reader
+ * @param value The buffer
+ * @param cap The capacity of the buffer, at least @p 1
+ * @return int @p 0 for success, @p -1 for failure
+ */
+int json_wrapper_msgpack_read_fixed(GET_STRUCT_NAME(Reader) * r, char * value, size_t cap);
+/**************************************** MSGPACK  END  ****************************************/
+
+
+/**************************************** FIXED_STRING BEGIN ****************************************/
+/**
+ * @brief Get the length of a fixed-capacity string, which is @p cap if the buffer is full without a '\0'
+ * 
+ * @param str The buffer
+ * @param cap The capacity of the buffer
+ * @return size_t The length
+ */
+static inline size_t json_wrapper_fixed_string_len(const char * str, size_t cap);
+inline size_t json_wrapper_fixed_string_len(const char * str, size_t cap)
+{
+    const char * end = memchr(str, '\0', cap);
+    return NULL != end ? (size_t) (end - str) : cap;
+}
+
+/**
+ * @brief Store @p len bytes of @p src into a fixed-capacity buffer, @p src may be the buffer itself
+ * 
+ * @note A string longer than @p cap - 1 bytes is truncated on a UTF-8 character boundary,
+ *       the result is always '\0' terminated
+ * 
+ * @param dst The buffer
+ * @param cap The capacity of the buffer, at least @p 1
+ * @param src The string
+ * @param len The length of the string
+ * @return size_t The length stored
+ */
+size_t json_wrapper_fixed_string_set(char * dst, size_t cap, const char * src, size_t len);
+
+/**
+ * @brief Convert a fixed-capacity string to json object
+ * 
+ * @param str The buffer
+ * @param cap The capacity of the buffer
+ * @return cJSON* The json object, @p NULL for failure
+ */
+cJSON * json_wrapper_fixed_string_to_json(const char * str, size_t cap);
+/**************************************** FIXED_STRING  END  ****************************************/
+
+
+/**************************************** TRACKED BEGIN ****************************************/
+/**
+ * @brief Whether the field of index @p field is dirty in the bitmap of the clean fields of a tracked struct
+ * 
+ * @note The bitmap keeps the clean fields, so a zeroed bitmap has all the fields dirty
+ * 
+ * @param clean The bitmap
+ * @param field The field index
+ * @return bool @p true for the field should be encoded again
+ */
+static inline bool json_wrapper_tracked_dirty(const uint64_t * clean, size_t field);
+inline bool json_wrapper_tracked_dirty(const uint64_t * clean, size_t field)
+{
+    return 0 == ((clean[field / 64] >> (field % 64)) & 1);
+}
+
+/**
+ * @brief Mark the field of index @p field dirty in the bitmap of the clean fields of a tracked struct
+ * 
+ * @param clean The bitmap
+ * @param field The field index
+ */
+static inline void json_wrapper_tracked_touch(uint64_t * clean, size_t field);
+inline void json_wrapper_tracked_touch(uint64_t * clean, size_t field)
+{
+    clean[field / 64] &= ~((uint64_t) 1 << (field % 64));
+}
+
+/**
+ * @brief Stitch the json members encoded into @p fragments as ',"key":value' into a json object in @p out
+ * 
+ * @param out The buffer of the object, which is '\0' terminated
+ * @param fragments The fragments
+ * @param count The number of fragments
+ * @return int @p 0 for success, @p -1 for failure
+ */
+int json_wrapper_tracked_stitch(GET_STRUCT_NAME(Buffer) * out, const GET_STRUCT_NAME(Buffer) * fragments, size_t count);
+/**************************************** TRACKED  END  ****************************************/
+
+
+#define EXPAND_(...) __VA_ARGS__
+#define EXPAND(...) EXPAND_(__VA_ARGS__)
+
+
+#define CONCAT_(A, B) A##B
+#define CONCAT(A, B) CONCAT_(A, B)
+
+#define PRE_CONCAT(A, ...) CONCAT_(A, __VA_ARGS__)
+#define PRE_CONCAT_(A, ...) A##__VA_ARGS__
+
+#define POST_CONCAT_(end, ...) __VA_ARGS__##end
+#define POST_CONCAT(end, ...) POST_CONCAT_(end, __VA_ARGS__)
+
+
+#define SECOND(a1, a2, ...) a2
+#define CHECK(...) SECOND(__VA_ARGS__, 0)
+#define PROBE(x) x, 1
+
+
+/**************************************** EMPTY BEGIN ****************************************/
+/**
+ * @brief An empty macro, mainly for @link DEFER to use
+ **/
+#define EMPTY()
+/**************************************** EMPTY  END  ****************************************/
+
+
+/**************************************** DEFER BEGIN ****************************************/
+/**
+ * @brief Delay to expand the macro
+ * @param x The name of the macro to delay to expand
+ **/
+#define DEFER(x) x EMPTY()
+/**************************************** DEFER  END  ****************************************/
+
+/**
+ * @brief The base wrapper type
+ */
+typedef enum GET_STRUCT_NAME(Type)
+{
+    BOOL,
+    CHAR,
+    INT,
+    INT64,
+    UINT32,
+    UINT64,
+    FLOAT,
+    DOUBLE,
+    STRING,
+    STRING_VIEW,
+    ARRAY_,
+    VA_ARRAY_,
+    FIXED_STRING_,
+    OBJ_,
+    STRUCT_,
+} GET_STRUCT_NAME(Type);
+
+
+#define OBJ(type) OBJ, 0, type
+#define ARRAY(type, num) ARRAY, num, type
+#define VA_ARRAY(type) VA_ARRAY, 0, type
+/**
+ * @brief A string stored inline as @p char name[num], which is '\0' terminated so holds up to @p num - 1 bytes.
+ *        The longer strings decoded are truncated on a UTF-8 character boundary, null or a non-string value
+ *        leaves the field unchanged. Nothing is alloced to decode, copy or recycle it
+ */
+#define FIXED_STRING(num) FIXED_STRING, num, CHAR
+
+
+#define GET_VA_ARRAY_NAME(type) PRE_CONCAT(type##_, GET_STRUCT_NAME(VA_ARRAY_))
+
+#define DEFINE_VA_ARRAY(type, name) \
+typedef struct GET_VA_ARRAY_NAME(type) \
+{ \
+    GET_STRUCT_NAME(type) * name; \
+    size_t size; \
+} GET_VA_ARRAY_NAME(type);
+
+
+/**************************************** TYPE_2_CJSON_TYPE BEGIN ****************************************/
+/**
+ * @brief Convert the wrapper type to json type
+ * @param t The wrapper type
+ **/
+#define TYPE_2_CJSON_TYPE(t) t##_2_CJSON_TYPE
+#define BOOL_2_CJSON_TYPE Bool
+#define CHAR_2_CJSON_TYPE Number
+#define INT_2_CJSON_TYPE Number
+#define INT64_2_CJSON_TYPE Number
+#define UINT32_2_CJSON_TYPE Number
+#define UINT64_2_CJSON_TYPE Number
+#define FLOAT_2_CJSON_TYPE Number
+#define DOUBLE_2_CJSON_TYPE Number
+#define STRING_2_CJSON_TYPE String
+#define STRING_VIEW_2_CJSON_TYPE String
+/**************************************** TYPE_2_CJSON_TYPE  END  ****************************************/
+
+
+/**************************************** STANDARD_TYPE BEGIN ****************************************/
+/**
+ * @brief Convert the wrapper type to standard base type
+ * @param t The wrapper type
+ **/
+#define STANDARD_TYPE(t) t##_2_STANDARD_TYPE
+#define BOOL_2_STANDARD_TYPE bool
+#define CHAR_2_STANDARD_TYPE char
+#define INT_2_STANDARD_TYPE int
+#define INT64_2_STANDARD_TYPE int64_t
+#define UINT32_2_STANDARD_TYPE uint32_t
+#define UINT64_2_STANDARD_TYPE uint64_t
+#define FLOAT_2_STANDARD_TYPE float
+#define DOUBLE_2_STANDARD_TYPE double
+#define STRING_2_STANDARD_TYPE char *
+#define STRING_VIEW_2_STANDARD_TYPE GET_STRUCT_NAME(STRING_VIEW)
+/**************************************** STANDARD_TYPE  END  ****************************************/
+
+
+/**************************************** FIRST_FIELD BEGIN ****************************************/
+/**
+ * @brief Extract the first field
+ * @param has_parentheses If parentheses added into the result, @p TRUE for yes, @p FALSE for no
+ * 
+ * @note For example:
+ *           FIRST_FIELD(TRUE, (int, age) (int height)) -> (int, age)
+ *           FIRST_FIELD(FALSE, (int, age) (int height)) -> int, age
+ **/
+#define FIRST_FIELD_(has_parentheses, ...) POST_CONCAT(_END, FIRST_FIELD_I_##has_parentheses __VA_ARGS__)
+#define FIRST_FIELD(has_parentheses, ...) FIRST_FIELD_(has_parentheses, __VA_ARGS__)  // Convert TRUE/FALSE to 1/0
+#define FIRST_FIELD_I_0(...) __VA_ARGS__ FIRST_FIELD_DEL_I
+#define FIRST_FIELD_I_1(...) (__VA_ARGS__) FIRST_FIELD_DEL_I
+#define FIRST_FIELD_I_0_END
+#define FIRST_FIELD_I_1_END
+#define FIRST_FIELD_DEL_I(...) FIRST_FIELD_DEL_II
+#define FIRST_FIELD_DEL_II(...) FIRST_FIELD_DEL_I
+#define FIRST_FIELD_DEL_I_END
+#define FIRST_FIELD_DEL_II_END
+/**************************************** FIRST_FIELD  END  ****************************************/
+
+
+/**************************************** IS_EMPTY BEGIN ****************************************/
+/**
+ * @brief Check if parameters is empty
+ * @return @p 0 for not empty, @p 1 for empty
+ * 
+ * @note For example:
+ *           IS_EMPTY(a) -> 0
+ *           IS_EMPTY() -> 1
+ **/
+#define IS_EMPTY_I(x, ...) CHECK(CONCAT(CONCAT_(IS_EMPTY_, x), 0))
+#define IS_EMPTY(x, ...) IS_EMPTY_I(x, ##__VA_ARGS__)
+#define IS_EMPTY_0 PROBE(1)
+/**************************************** IS_EMPTY  END  ****************************************/
+
+
+/**************************************** IS_EMPTY_FIELD BEGIN ****************************************/
+/**
+ * @brief Check if there's field
+ * @return @p 0 for there's field in the parameter, @p 1 for the empty parameter
+ * 
+ * @note For example:
+ *           IS_EMPTY_FIELD((int, age) (char, sex)) -> 0
+ *           IS_EMPTY_FIELD() -> 1
+ **/
+#define IS_EMPTY_FIELD(...) IS_EMPTY(FIRST_FIELD(FALSE, __VA_ARGS__))
+/**************************************** IS_EMPTY_FIELD  END  ****************************************/
+
+
+/**************************************** OTHER_FIELDS BEGIN ****************************************/
+/**
+ * @brief Extract other fields except the first one
+ * 
+ * @note For example:
+ *           FIRST_FIELD((int, age) (int height)) -> (int, height)
+ **/
+#define OTHER_FIELDS(...) CONCAT(OTHER_FIELDS_, IS_EMPTY_FIELD(__VA_ARGS__)) __VA_ARGS__
+#define OTHER_FIELDS_0(...)
+#define OTHER_FIELDS_1
+/**************************************** OTHER_FIELDS  END  ****************************************/
+
+
+/**************************************** EVAL BEGIN ****************************************/
+/**
+ * @brief To expand the macro recursively
+ **/
+#define EVAL(...) EVAL1(EVAL1(EVAL1(__VA_ARGS__)))
+#define EVAL1(...) EVAL2(EVAL2(EVAL2(__VA_ARGS__)))
+#define EVAL2(...) EVAL3(EVAL3(EVAL3(__VA_ARGS__)))
+#define EVAL3(...) EVAL4(EVAL4(EVAL4(__VA_ARGS__)))
+#define EVAL4(...) EVAL5(EVAL5(EVAL5(__VA_ARGS__)))
+#define EVAL5(...) __VA_ARGS__
+/**************************************** EVAL BEGIN ****************************************/
+
+
+/**************************************** SPLIT_FIELDS BEGIN ****************************************/
+/**
+ * @brief Split the fields with comma
+ * @param has_parentheses If parentheses added into the result, @p TRUE for yes, @p FALSE for no
+ * 
+ * @note For example:
+ *           SPLIT_FIELDS(TRUE, (int, a) (int, b) (char, c) (double d))
+ *               ->  (int, a) , (int, b) , (char, c) , (double d)
+ *           SPLIT_FIELDS(FALSE, (int, a) (int, b) (char, c) (double d))
+ *               ->  int, a , int, b , char, c , double d
+ **/
+#define SPLIT_FIELDS_PARAMS(...) CONCAT(SPLIT_FIELDS_PARAMS_, IS_EMPTY_FIELD(__VA_ARGS__))(__VA_ARGS__)
+#define SPLIT_FIELDS_PARAMS_1(...)
+#define SPLIT_FIELDS_PARAMS_0(...) (__VA_ARGS__)
+
+// We use SPLIT_FIELDS_EXPAND to let EXPAND in SPLIT_FIELDS_x_0 work
+#define SPLIT_FIELDS_EXPAND(...) SPLIT_FIELDS_EXPAND_(__VA_ARGS__)
+#define SPLIT_FIELDS_EXPAND_(...) __VA_ARGS__
+#define SPLIT_FIELDS(has_parentheses, ...) SPLIT_FIELDS_(has_parentheses, __VA_ARGS__)
+#define SPLIT_FIELDS_(has_parentheses, ...) \
+    SPLIT_FIELDS_EXPAND( \
+        CONCAT(SPLIT_FIELDS_##has_parentheses##_, IS_EMPTY_FIELD(__VA_ARGS__)) \
+            SPLIT_FIELDS_PARAMS(__VA_ARGS__))
+
+#define SPLIT_FIELDS_1_1
+#define SPLIT_FIELDS_1_0(...) \
+    FIRST_FIELD(TRUE, __VA_ARGS__) \
+    POST_CONCAT(_END, EXPAND(SPLIT_FIELDS_1_0_I OTHER_FIELDS(__VA_ARGS__)))
+#define SPLIT_FIELDS_1_0_I(...) , (__VA_ARGS__) SPLIT_FIELDS_1_0_II
+#define SPLIT_FIELDS_1_0_II(...) , (__VA_ARGS__) SPLIT_FIELDS_1_0_I
+#define SPLIT_FIELDS_1_0_I_END
+#define SPLIT_FIELDS_1_0_II_END
+
+#define SPLIT_FIELDS_0_1
+#define SPLIT_FIELDS_0_0(...) \
+    FIRST_FIELD(FALSE, __VA_ARGS__) \
+    POST_CONCAT(_END, EXPAND(SPLIT_FIELDS_0_0_I OTHER_FIELDS(__VA_ARGS__)))
+#define SPLIT_FIELDS_0_0_I(...) , __VA_ARGS__ SPLIT_FIELDS_0_0_II
+#define SPLIT_FIELDS_0_0_II(...) , __VA_ARGS__ SPLIT_FIELDS_0_0_I
+#define SPLIT_FIELDS_0_0_I_END
+#define SPLIT_FIELDS_0_0_II_END
+/**************************************** SPLIT_FIELDS  END  ****************************************/
+
+
+/**************************************** JOIN_TYPES BEGIN ****************************************/
+/**
+ * @brief Add the struct name into the field tuples
+ * @param st The name of the struct
+ * 
+ * @note For example:
+ *           JOIN_TYPES(Person, (int, age) (char, sex) (char, married) (char, good))
+ *               -> (Person, int, age) (Person, char, sex) (Person, char, married) (Person, char, good)
+ **/
+#define JOIN_TYPES_FOR_EACH(target, st, ...) \
+    CONCAT(JOIN_TYPES_FOR_EACH_, IS_EMPTY(SPLIT_FIELDS(FALSE, ##__VA_ARGS__))) (target, st, ##__VA_ARGS__)
+#define JOIN_TYPES_FOR_EACH_0_(target, st, ...) \
+    target(st, FIRST_FIELD(TRUE, __VA_ARGS__)) \
+    DEFER(JOIN_TYPES_FOR_EACH_I)()(target, st, OTHER_FIELDS(__VA_ARGS__))
+#define JOIN_TYPES_FOR_EACH_0(...) JOIN_TYPES_FOR_EACH_0_(__VA_ARGS__)
+#define JOIN_TYPES_FOR_EACH_1(...)
+#define JOIN_TYPES_FOR_EACH_I() JOIN_TYPES_FOR_EACH
+#define JOIN_TYPES_TARGET(st, tuple) (st, EXPAND tuple)
+#define JOIN_TYPES(st, ...) EVAL(JOIN_TYPES_FOR_EACH(JOIN_TYPES_TARGET, st, ##__VA_ARGS__))
+// #define JOIN_TYPES_(st, ...) EVAL(JOIN_TYPES_FOR_EACH(JOIN_TYPES_TARGET, st, ##__VA_ARGS__))
+// #define JOIN_TYPES(st, ...) JOIN_TYPES_(st, SPLIT_FIELDS(TRUE, __VA_ARGS__))
+/**************************************** JOIN_TYPES  END  ****************************************/
+
+
+/**************************************** JOIN_TYPES_EX BEGIN ****************************************/
+/**
+ * @brief Add a tuple of struct names into the field tuples
+ * @param st_tuple A tuple of struct names
+ * 
+ * @note For example:
+ *           JOIN_TYPES_EX((json, st), (int, age) (char, sex) (char, married))
+ *               -> (json, Person, int, age) (json, Person, char, sex) (json, Person, char, married)
+ **/
+#define JOIN_TYPES_EX_FOR_EACH(target, st_tuple, ...) \
+    CONCAT(JOIN_TYPES_EX_FOR_EACH_, IS_EMPTY(SPLIT_FIELDS(FALSE, ##__VA_ARGS__))) (target, st_tuple, ##__VA_ARGS__)
+#define JOIN_TYPES_EX_FOR_EACH_0_(target, st_tuple, ...) \
+    target(st_tuple, FIRST_FIELD(TRUE, __VA_ARGS__)) \
+    DEFER(JOIN_TYPES_EX_FOR_EACH_I)()(target, st_tuple, OTHER_FIELDS(__VA_ARGS__))
+#define JOIN_TYPES_EX_FOR_EACH_0(...) JOIN_TYPES_EX_FOR_EACH_0_(__VA_ARGS__)
+#define JOIN_TYPES_EX_FOR_EACH_1(...)
+#define JOIN_TYPES_EX_FOR_EACH_I() JOIN_TYPES_EX_FOR_EACH
+#define JOIN_TYPES_EX_TARGET(st_tuple, tuple) (EXPAND st_tuple, EXPAND tuple)
+#define JOIN_TYPES_EX(st_tuple, ...) EVAL(JOIN_TYPES_EX_FOR_EACH(JOIN_TYPES_EX_TARGET, st_tuple, ##__VA_ARGS__))
+/**************************************** JOIN_TYPES_EX  END  ****************************************/
+
+
+/**************************************** JOIN_JSON BEGIN ****************************************/
+/**
+ * @brief Add the struct name into the field tuples
+ * @param st The name of the struct
+ * 
+ * @note For example:
+ *           JOIN_JSON(json, (st, int, age) (st, char, sex) (st, char, married) (st, char, good))
+ *               -> (json, st, int, age) (json, st, char, sex) (json, st, char, married) (json, st, char, good)
+ **/
+// TODO: How to merge these macros with JOIN_TYPES
+#define JOIN_JSON_FOR_EACH(target, json, ...) \
+    CONCAT(JOIN_JSON_FOR_EACH_, IS_EMPTY(__VA_ARGS__)) (target, json, __VA_ARGS__)
+#define JOIN_JSON_FOR_EACH_0_(target, json, st, t, n, ...) \
+    target(json, st, t, n) \
+    DEFER(JOIN_JSON_FOR_EACH_I)()(target, json, __VA_ARGS__)
+#define JOIN_JSON_FOR_EACH_0(...) JOIN_JSON_FOR_EACH_0_(__VA_ARGS__)
+#define JOIN_JSON_FOR_EACH_1(...)
+#define JOIN_JSON_FOR_EACH_I() JOIN_JSON_FOR_EACH
+#define JOIN_JSON_TARGET(json, st, t, n) (json, st, t, n)
+#define JOIN_JSON_(json, ...) EVAL(JOIN_JSON_FOR_EACH(JOIN_JSON_TARGET, json, ##__VA_ARGS__))
+#define JOIN_JSON(json, ...) JOIN_JSON_(json, SPLIT_FIELDS(FALSE, __VA_ARGS__))
+/**************************************** JOIN_JSON  END  ****************************************/
+
+
+/**************************************** STRUCT_2 BEGIN ****************************************/
+/**
+ * @brief Convert field to json object
+ * @param type The type of the field
+ * @param st The struct object of the field
+ * @param n The name of the field
+ **/
+#define STRUCT_2_FUNCTION_NAME(type) CONCAT(json_wrapper_json_from_, GET_STRUCT_NAME(type))
+#define STRUCT_2(type, st, n) STRUCT_2_FUNCTION_NAME(type) (&((st)->n))
+
+static inline cJSON * STRUCT_2_FUNCTION_NAME(BOOL)(STANDARD_TYPE(BOOL) * value);
+inline cJSON * STRUCT_2_FUNCTION_NAME(BOOL)(STANDARD_TYPE(BOOL) * value)
+{
+    return PRE_CONCAT(cJSON_Create, TYPE_2_CJSON_TYPE(BOOL))(*value);
+}
+
+static inline cJSON * STRUCT_2_FUNCTION_NAME(CHAR)(STANDARD_TYPE(CHAR) * value);
+inline cJSON * STRUCT_2_FUNCTION_NAME(CHAR)(STANDARD_TYPE(CHAR) * value)
+{
+    return PRE_CONCAT(cJSON_Create, TYPE_2_CJSON_TYPE(CHAR))(*value);
+}
+
+static inline cJSON * STRUCT_2_FUNCTION_NAME(INT)(STANDARD_TYPE(INT) * value);
+inline cJSON * STRUCT_2_FUNCTION_NAME(INT)(STANDARD_TYPE(INT) * value)
+{
+    return PRE_CONCAT(cJSON_Create, TYPE_2_CJSON_TYPE(INT))(*value);
+}
+
+/**
+ * @note A cJSON number holds a double, so the integers beyond 2^53 are created as raw numbers to keep their digits
+ */
+cJSON * STRUCT_2_FUNCTION_NAME(INT64)(STANDARD_TYPE(INT64) * value);
+
+static inline cJSON * STRUCT_2_FUNCTION_NAME(UINT32)(STANDARD_TYPE(UINT32) * value);
+inline cJSON * STRUCT_2_FUNCTION_NAME(UINT32)(STANDARD_TYPE(UINT32) * value)
+{
+    return PRE_CONCAT(cJSON_Create, TYPE_2_CJSON_TYPE(UINT32))(*value);
+}
+
+cJSON * STRUCT_2_FUNCTION_NAME(UINT64)(STANDARD_TYPE(UINT64) * value);
+
+static inline cJSON * STRUCT_2_FUNCTION_NAME(FLOAT)(STANDARD_TYPE(FLOAT) * value);
+inline cJSON * STRUCT_2_FUNCTION_NAME(FLOAT)(STANDARD_TYPE(FLOAT) * value)
+{
+    return PRE_CONCAT(cJSON_Create, TYPE_2_CJSON_TYPE(FLOAT))(*value);
+}
+
+static inline cJSON * STRUCT_2_FUNCTION_NAME(DOUBLE)(STANDARD_TYPE(DOUBLE) * value);
+inline cJSON * STRUCT_2_FUNCTION_NAME(DOUBLE)(STANDARD_TYPE(DOUBLE) * value)
+{
+    return PRE_CONCAT(cJSON_Create, TYPE_2_CJSON_TYPE(DOUBLE))(*value);
+}
+
+static inline cJSON * STRUCT_2_FUNCTION_NAME(STRING)(STANDARD_TYPE(STRING) * value);
+inline cJSON * STRUCT_2_FUNCTION_NAME(STRING)(STANDARD_TYPE(STRING) * value)
+{
+    ASSERT_RETURN(*value, cJSON_CreateNull());
+    return PRE_CONCAT(cJSON_Create, TYPE_2_CJSON_TYPE(STRING))(*value);
+}
+
+cJSON * STRUCT_2_FUNCTION_NAME(STRING_VIEW)(STANDARD_TYPE(STRING_VIEW) * value);
+/**************************************** STRUCT_2  END  ****************************************/
+
+
+/**************************************** STRUCT_2_BUFFER BEGIN ****************************************/
+/**
+ * @brief Write field as json text into a buffer
+ * @param type The type of the field
+ * @param st The struct object of the field
+ * @param n The name of the field
+ * @param buf The buffer
+ **/
+#define STRUCT_2_BUFFER_FUNCTION_NAME(type) CONCAT(json_wrapper_json_buffer_from_, GET_STRUCT_NAME(type))
+#define STRUCT_2_BUFFER(type, st, n, buf) STRUCT_2_BUFFER_FUNCTION_NAME(type) (&((st)->n), buf)
+
+static inline int STRUCT_2_BUFFER_FUNCTION_NAME(BOOL)(STANDARD_TYPE(BOOL) * value, GET_STRUCT_NAME(Buffer) * buf);
+inline int STRUCT_2_BUFFER_FUNCTION_NAME(BOOL)(STANDARD_TYPE(BOOL) * value, GET_STRUCT_NAME(Buffer) * buf)
+{
+    return *value ? json_wrapper_buffer_append(buf, "true", 4) : json_wrapper_buffer_append(buf, "false", 5);
+}
+
+static inline int STRUCT_2_BUFFER_FUNCTION_NAME(CHAR)(STANDARD_TYPE(CHAR) * value, GET_STRUCT_NAME(Buffer) * buf);
+inline int STRUCT_2_BUFFER_FUNCTION_NAME(CHAR)(STANDARD_TYPE(CHAR) * value, GET_STRUCT_NAME(Buffer) * buf)
+{
+    return json_wrapper_buffer_append_int(buf, *value);
+}
+
+static inline int STRUCT_2_BUFFER_FUNCTION_NAME(INT)(STANDARD_TYPE(INT) * value, GET_STRUCT_NAME(Buffer) * buf);
+inline int STRUCT_2_BUFFER_FUNCTION_NAME(INT)(STANDARD_TYPE(INT) * value, GET_STRUCT_NAME(Buffer) * buf)
+{
+    return json_wrapper_buffer_append_int(buf, *value);
+}
+
+static inline int STRUCT_2_BUFFER_FUNCTION_NAME(INT64)(STANDARD_TYPE(INT64) * value, GET_STRUCT_NAME(Buffer) * buf);
+inline int STRUCT_2_BUFFER_FUNCTION_NAME(INT64)(STANDARD_TYPE(INT64) * value, GET_STRUCT_NAME(Buffer) * buf)
+{
+    return json_wrapper_buffer_append_int64(buf, *value);
+}
+
+static inline int STRUCT_2_BUFFER_FUNCTION_NAME(UINT32)(STANDARD_TYPE(UINT32) * value, GET_STRUCT_NAME(Buffer) * buf);
+inline int STRUCT_2_BUFFER_FUNCTION_NAME(UINT32)(STANDARD_TYPE(UINT32) * value, GET_STRUCT_NAME(Buffer) * buf)
+{
+    return json_wrapper_buffer_append_uint64(buf, *value);
+}
+
+static inline int STRUCT_2_BUFFER_FUNCTION_NAME(UINT64)(STANDARD_TYPE(UINT64) * value, GET_STRUCT_NAME(Buffer) * buf);
+inline int STRUCT_2_BUFFER_FUNCTION_NAME(UINT64)(STANDARD_TYPE(UINT64) * value, GET_STRUCT_NAME(Buffer) * buf)
+{
+    return json_wrapper_buffer_append_uint64(buf, *value);
+}
+
+static inline int STRUCT_2_BUFFER_FUNCTION_NAME(FLOAT)(STANDARD_TYPE(FLOAT) * value, GET_STRUCT_NAME(Buffer) * buf);
+inline int STRUCT_2_BUFFER_FUNCTION_NAME(FLOAT)(STANDARD_TYPE(FLOAT) * value, GET_STRUCT_NAME(Buffer) * buf)
+{
+    return json_wrapper_buffer_append_float(buf, *value);
+}
+
+static inline int STRUCT_2_BUFFER_FUNCTION_NAME(DOUBLE)(STANDARD_TYPE(DOUBLE) * value, GET_STRUCT_NAME(Buffer) * buf);
+inline int STRUCT_2_BUFFER_FUNCTION_NAME(DOUBLE)(STANDARD_TYPE(DOUBLE) * value, GET_STRUCT_NAME(Buffer) * buf)
+{
+    return json_wrapper_buffer_append_double(buf, *value);
+}
+
+static inline int STRUCT_2_BUFFER_FUNCTION_NAME(STRING)(STANDARD_TYPE(STRING) * value, GET_STRUCT_NAME(Buffer) * buf);
+inline int STRUCT_2_BUFFER_FUNCTION_NAME(STRING)(STANDARD_TYPE(STRING) * value, GET_STRUCT_NAME(Buffer) * buf)
+{
+    return json_wrapper_buffer_append_string(buf, *value);
+}
+
+static inline int STRUCT_2_BUFFER_FUNCTION_NAME(STRING_VIEW)(STANDARD_TYPE(STRING_VIEW) * value, GET_STRUCT_NAME(Buffer) * buf);
+inline int STRUCT_2_BUFFER_FUNCTION_NAME(STRING_VIEW)(STANDARD_TYPE(STRING_VIEW) * value, GET_STRUCT_NAME(Buffer) * buf)
+{
+    return json_wrapper_buffer_append_str(buf, value->ptr, value->len);
+}
+
+/**
+ * @brief Get the largest length of the json text of a type, and whether the length is bounded by it
+ * @param type The type
+ * 
+ * @note For the unbounded types the value is the fixed part only: a STRING takes its quotes or null
+ *       plus up to 6 bytes per byte of content, a VA_ARRAY takes its brackets plus its elements and commas
+ **/
+#define GET_MAX_SIZE(type) CONCAT(GET_STRUCT_NAME(type), _MAX_SIZE)
+#define GET_IS_BOUNDED(type) CONCAT(GET_STRUCT_NAME(type), _IS_BOUNDED)
+#define JSON_INT_MAX_SIZE(type) (((int) sizeof(type) * CHAR_BIT - 1) * 302 / 1000 + 2)
+
+enum { GET_MAX_SIZE(BOOL) = 5, GET_IS_BOUNDED(BOOL) = 1 };
+enum { GET_MAX_SIZE(CHAR) = JSON_INT_MAX_SIZE(STANDARD_TYPE(CHAR)), GET_IS_BOUNDED(CHAR) = 1 };
+enum { GET_MAX_SIZE(INT) = JSON_INT_MAX_SIZE(STANDARD_TYPE(INT)), GET_IS_BOUNDED(INT) = 1 };
+enum { GET_MAX_SIZE(INT64) = JSON_INT_MAX_SIZE(STANDARD_TYPE(INT64)), GET_IS_BOUNDED(INT64) = 1 };
+enum { GET_MAX_SIZE(UINT32) = JSON_INT_MAX_SIZE(STANDARD_TYPE(UINT32)), GET_IS_BOUNDED(UINT32) = 1 };
+enum { GET_MAX_SIZE(UINT64) = JSON_INT_MAX_SIZE(STANDARD_TYPE(UINT64)), GET_IS_BOUNDED(UINT64) = 1 };
+enum { GET_MAX_SIZE(FLOAT) = 15, GET_IS_BOUNDED(FLOAT) = 1 };         // -1.17549435e-38
+enum { GET_MAX_SIZE(DOUBLE) = 24, GET_IS_BOUNDED(DOUBLE) = 1 };       // -2.2250738585072014e-308
+enum { GET_MAX_SIZE(STRING) = 4, GET_IS_BOUNDED(STRING) = 0 };
+enum { GET_MAX_SIZE(STRING_VIEW) = 4, GET_IS_BOUNDED(STRING_VIEW) = 0 };
+/**************************************** STRUCT_2_BUFFER  END  ****************************************/
+
+
+/**
+ * @brief Define a function name about converting json string to struct
+ */
+#define JSON_STR_2_FUNCTION_NAME(type) CONCAT(json_wrapper_json_str_to_, GET_STRUCT_NAME(type))
+
+/**
+ * @brief Define a function name about converting json string to struct with the memory in an arena
+ */
+#define JSON_STR_2_ARENA_FUNCTION_NAME(type) CONCAT(json_wrapper_json_str_arena_to_, GET_STRUCT_NAME(type))
+
+/**
+ * @brief Define a function name about converting json text to struct with the string views pointing into the text
+ */
+#define JSON_STR_2_VIEW_FUNCTION_NAME(type) CONCAT(json_wrapper_json_str_view_to_, GET_STRUCT_NAME(type))
+
+/**
+ * @brief Define a function name about converting the fields in a mask of json text to struct
+ */
+#define JSON_STR_2_MASK_FUNCTION_NAME(type) CONCAT(json_wrapper_json_str_mask_to_, GET_STRUCT_NAME(type))
+
+/**
+ * @brief Define a function name about converting json text to struct over its structural index
+ */
+#define JSON_STR_2_INDEX_FUNCTION_NAME(type) CONCAT(json_wrapper_json_str_index_to_, GET_STRUCT_NAME(type))
+
+/**
+ * @brief Define a function name about applying a json merge patch to struct
+ */
+#define PATCH_FUNCTION_NAME(type) CONCAT(json_wrapper_json_patch_to_, GET_STRUCT_NAME(type))
+
+
+/**************************************** JSON_2 BEGIN ****************************************/
+/**
+ * @brief Convert json object to struct field
+ * @param type The type of the struct field
+ * @param obj The json object
+ * @param dst The struct field
+ **/
+#define JSON_2_FUNCTION_NAME(type) CONCAT(json_wrapper_json_to_, GET_STRUCT_NAME(type))
+#define JSON_2(type, obj, dst) JSON_2_FUNCTION_NAME(type) (obj, dst)
+
+static inline void JSON_2_FUNCTION_NAME(BOOL)(cJSON * obj, STANDARD_TYPE(BOOL) * dst);
+inline void JSON_2_FUNCTION_NAME(BOOL)(cJSON * obj, STANDARD_TYPE(BOOL) * dst)
+{
+    *dst = (obj)->valueint;
+    // *dst = CONCAT(PRE_CONCAT(cJSON_Get, TYPE_2_CJSON_TYPE(BOOL)), Value)(obj);
+}
+
+static inline void JSON_2_FUNCTION_NAME(CHAR)(cJSON * obj, STANDARD_TYPE(CHAR) * dst);
+inline void JSON_2_FUNCTION_NAME(CHAR)(cJSON * obj, STANDARD_TYPE(CHAR) * dst)
+{
+    *dst = (obj)->valueint;
+    // *dst = CONCAT(PRE_CONCAT(cJSON_Get, TYPE_2_CJSON_TYPE(CHAR)), Value)(obj);
+}
+
+static inline void JSON_2_FUNCTION_NAME(INT)(cJSON * obj, STANDARD_TYPE(INT) * dst);
+inline void JSON_2_FUNCTION_NAME(INT)(cJSON * obj, STANDARD_TYPE(INT) * dst)
+{
+    *dst = (obj)->valueint;
+    // *dst = CONCAT(PRE_CONCAT(cJSON_Get, TYPE_2_CJSON_TYPE(INT)), Value)(obj);
+}
+
+/**
+ * @note A cJSON number holds a double, so the 64 bits integers beyond 2^53 lose their low digits here,
+ *       the readers of @link JSON_STR_2_FUNCTION_NAME parse the digits exactly
+ */
+static inline void JSON_2_FUNCTION_NAME(INT64)(cJSON * obj, STANDARD_TYPE(INT64) * dst);
+inline void JSON_2_FUNCTION_NAME(INT64)(cJSON * obj, STANDARD_TYPE(INT64) * dst)
+{
+    double d = (obj)->valuedouble;
+    *dst = d >= 9223372036854775807.0 ? INT64_MAX : (d <= -9223372036854775808.0 ? INT64_MIN : (int64_t) d);
+}
+
+static inline void JSON_2_FUNCTION_NAME(UINT32)(cJSON * obj, STANDARD_TYPE(UINT32) * dst);
+inline void JSON_2_FUNCTION_NAME(UINT32)(cJSON * obj, STANDARD_TYPE(UINT32) * dst)
+{
+    double d = (obj)->valuedouble;
+    *dst = d >= 4294967295.0 ? UINT32_MAX : (d <= 0 ? 0 : (uint32_t) d);
+}
+
+static inline void JSON_2_FUNCTION_NAME(UINT64)(cJSON * obj, STANDARD_TYPE(UINT64) * dst);
+inline void JSON_2_FUNCTION_NAME(UINT64)(cJSON * obj, STANDARD_TYPE(UINT64) * dst)
+{
+    double d = (obj)->valuedouble;
+    *dst = d >= 18446744073709551615.0 ? UINT64_MAX : (d <= 0 ? 0 : (uint64_t) d);
+}
+
+static inline void JSON_2_FUNCTION_NAME(FLOAT)(cJSON * obj, STANDARD_TYPE(FLOAT) * dst);
+inline void JSON_2_FUNCTION_NAME(FLOAT)(cJSON * obj, STANDARD_TYPE(FLOAT) * dst)
+{
+    *dst = (float) (obj)->valuedouble;
+}
+
+static inline void JSON_2_FUNCTION_NAME(DOUBLE)(cJSON * obj, STANDARD_TYPE(DOUBLE) * dst);
+inline void JSON_2_FUNCTION_NAME(DOUBLE)(cJSON * obj, STANDARD_TYPE(DOUBLE) * dst)
+{
+    *dst = (obj)->valuedouble;
+}
+
+void JSON_2_FUNCTION_NAME(STRING)(cJSON * obj, STANDARD_TYPE(STRING) * dst);
+
+/**
+ * @note The view points into the json object, it's valid as long as the object is
+ */
+static inline void JSON_2_FUNCTION_NAME(STRING_VIEW)(cJSON * obj, STANDARD_TYPE(STRING_VIEW) * dst);
+inline void JSON_2_FUNCTION_NAME(STRING_VIEW)(cJSON * obj, STANDARD_TYPE(STRING_VIEW) * dst)
+{
+    ASSERT_RETURN_VOID((obj)->valuestring);
+    dst->ptr = (obj)->valuestring;
+    dst->len = strlen(dst->ptr);
+}
+/**************************************** JSON_2  END  ****************************************/
+
+
+/**************************************** READER_2 BEGIN ****************************************/
+/**
+ * @brief Read the next json value from a reader into struct field
+ * @param type The type of the struct field
+ * @param r The reader
+ * @param dst The struct field
+ **/
+#define READER_2_FUNCTION_NAME(type) CONCAT(json_wrapper_json_reader_to_, GET_STRUCT_NAME(type))
+#define READER_2(type, r, dst) READER_2_FUNCTION_NAME(type) (r, dst)
+/**
+ * @brief Read the next json value from a reader into struct field, decoding only the fields in @p mask of a struct
+ **/
+#define READER_2_MASK_FUNCTION_NAME(type) CONCAT(json_wrapper_json_reader_mask_to_, GET_STRUCT_NAME(type))
+#define READER_2_MASK(type, r, dst, mask) READER_2_MASK_FUNCTION_NAME(type) (r, dst, mask)
+
+static inline int READER_2_FUNCTION_NAME(BOOL)(GET_STRUCT_NAME(Reader) * r, STANDARD_TYPE(BOOL) * dst);
+inline int READER_2_FUNCTION_NAME(BOOL)(GET_STRUCT_NAME(Reader) * r, STANDARD_TYPE(BOOL) * dst)
+{
+    return json_wrapper_reader_bool(r, dst);
+}
+
+static inline int READER_2_FUNCTION_NAME(CHAR)(GET_STRUCT_NAME(Reader) * r, STANDARD_TYPE(CHAR) * dst);
+inline int READER_2_FUNCTION_NAME(CHAR)(GET_STRUCT_NAME(Reader) * r, STANDARD_TYPE(CHAR) * dst)
+{
+    long value = *dst;
+    ASSERT_RETURN(0 == json_wrapper_reader_int(r, &value), -1);
+    *dst = (STANDARD_TYPE(CHAR)) (value < INT_MIN ? INT_MIN : (value > INT_MAX ? INT_MAX : value));
+    return 0;
+}
+
+static inline int READER_2_FUNCTION_NAME(INT)(GET_STRUCT_NAME(Reader) * r, STANDARD_TYPE(INT) * dst);
+inline int READER_2_FUNCTION_NAME(INT)(GET_STRUCT_NAME(Reader) * r, STANDARD_TYPE(INT) * dst)
+{
+    long value = *dst;
+    ASSERT_RETURN(0 == json_wrapper_reader_int(r, &value), -1);
+    *dst = value < INT_MIN ? INT_MIN : (value > INT_MAX ? INT_MAX : value);
+    return 0;
+}
+
+static inline int READER_2_FUNCTION_NAME(INT64)(GET_STRUCT_NAME(Reader) * r, STANDARD_TYPE(INT64) * dst);
+inline int READER_2_FUNCTION_NAME(INT64)(GET_STRUCT_NAME(Reader) * r, STANDARD_TYPE(INT64) * dst)
+{
+    return json_wrapper_reader_int64(r, dst);
+}
+
+static inline int READER_2_FUNCTION_NAME(UINT32)(GET_STRUCT_NAME(Reader) * r, STANDARD_TYPE(UINT32) * dst);
+inline int READER_2_FUNCTION_NAME(UINT32)(GET_STRUCT_NAME(Reader) * r, STANDARD_TYPE(UINT32) * dst)
+{
+    uint64_t value = *dst;
+    ASSERT_RETURN(0 == json_wrapper_reader_uint64(r, &value), -1);
+    *dst = value > UINT32_MAX ? UINT32_MAX : (uint32_t) value;
+    return 0;
+}
+
+static inline int READER_2_FUNCTION_NAME(UINT64)(GET_STRUCT_NAME(Reader) * r, STANDARD_TYPE(UINT64) * dst);
+inline int READER_2_FUNCTION_NAME(UINT64)(GET_STRUCT_NAME(Reader) * r, STANDARD_TYPE(UINT64) * dst)
+{
+    return json_wrapper_reader_uint64(r, dst);
+}
+
+static inline int READER_2_FUNCTION_NAME(FLOAT)(GET_STRUCT_NAME(Reader) * r, STANDARD_TYPE(FLOAT) * dst);
+inline int READER_2_FUNCTION_NAME(FLOAT)(GET_STRUCT_NAME(Reader) * r, STANDARD_TYPE(FLOAT) * dst)
+{
+    double value = *dst;
+    ASSERT_RETURN(0 == json_wrapper_reader_double(r, &value), -1);
+    *dst = (float) value;
+    return 0;
+}
+
+static inline int READER_2_FUNCTION_NAME(DOUBLE)(GET_STRUCT_NAME(Reader) * r, STANDARD_TYPE(DOUBLE) * dst);
+inline int READER_2_FUNCTION_NAME(DOUBLE)(GET_STRUCT_NAME(Reader) * r, STANDARD_TYPE(DOUBLE) * dst)
+{
+    return json_wrapper_reader_double(r, dst);
+}
+
+static inline int READER_2_FUNCTION_NAME(STRING)(GET_STRUCT_NAME(Reader) * r, STANDARD_TYPE(STRING) * dst);
+inline int READER_2_FUNCTION_NAME(STRING)(GET_STRUCT_NAME(Reader) * r, STANDARD_TYPE(STRING) * dst)
+{
+    return json_wrapper_reader_string(r, dst);
+}
+
+static inline int READER_2_FUNCTION_NAME(STRING_VIEW)(GET_STRUCT_NAME(Reader) * r, STANDARD_TYPE(STRING_VIEW) * dst);
+inline int READER_2_FUNCTION_NAME(STRING_VIEW)(GET_STRUCT_NAME(Reader) * r, STANDARD_TYPE(STRING_VIEW) * dst)
+{
+    return json_wrapper_reader_view(r, dst);
+}
+
+#define DEFINE_READER_2_MASK_BASE(type) \
+static inline int READER_2_MASK_FUNCTION_NAME(type)(GET_STRUCT_NAME(Reader) * r, STANDARD_TYPE(type) * dst, \
+    const GET_STRUCT_NAME(Mask) * mask); \
+inline int READER_2_MASK_FUNCTION_NAME(type)(GET_STRUCT_NAME(Reader) * r, STANDARD_TYPE(type) * dst, \
+    const GET_STRUCT_NAME(Mask) * mask) \
+{ \
+    (void) mask; \
+    return READER_2_FUNCTION_NAME(type)(r, dst); \
+}
+DEFINE_READER_2_MASK_BASE(BOOL)
+DEFINE_READER_2_MASK_BASE(CHAR)
+DEFINE_READER_2_MASK_BASE(INT)
+DEFINE_READER_2_MASK_BASE(INT64)
+DEFINE_READER_2_MASK_BASE(UINT32)
+DEFINE_READER_2_MASK_BASE(UINT64)
+DEFINE_READER_2_MASK_BASE(FLOAT)
+DEFINE_READER_2_MASK_BASE(DOUBLE)
+DEFINE_READER_2_MASK_BASE(STRING)
+DEFINE_READER_2_MASK_BASE(STRING_VIEW)
+/**************************************** READER_2  END  ****************************************/
+
+
+/**************************************** MSGPACK_2 BEGIN ****************************************/
+/**
+ * @brief Write struct field as MessagePack into a buffer, and read it back from a reader
+ * @param type The type of the struct field
+ * @param buf The buffer
+ * @param r The reader
+ * @param dst The struct field
+ **/
+#define STRUCT_2_MSGPACK_BUFFER_FUNCTION_NAME(type) CONCAT(json_wrapper_msgpack_buffer_from_, GET_STRUCT_NAME(type))
+#define STRUCT_2_MSGPACK_BUFFER(type, st, n, buf) STRUCT_2_MSGPACK_BUFFER_FUNCTION_NAME(type) (&((st)->n), buf)
+#define MSGPACK_READER_2_FUNCTION_NAME(type) CONCAT(json_wrapper_msgpack_reader_to_, GET_STRUCT_NAME(type))
+#define MSGPACK_READER_2(type, r, dst) MSGPACK_READER_2_FUNCTION_NAME(type) (r, dst)
+
+static inline int STRUCT_2_MSGPACK_BUFFER_FUNCTION_NAME(BOOL)(STANDARD_TYPE(BOOL) * value, GET_STRUCT_NAME(Buffer) * buf);
+inline int STRUCT_2_MSGPACK_BUFFER_FUNCTION_NAME(BOOL)(STANDARD_TYPE(BOOL) * value, GET_STRUCT_NAME(Buffer) * buf)
+{
+    return json_wrapper_msgpack_write_bool(buf, *value);
+}
+
+static inline int STRUCT_2_MSGPACK_BUFFER_FUNCTION_NAME(CHAR)(STANDARD_TYPE(CHAR) * value, GET_STRUCT_NAME(Buffer) * buf);
+inline int STRUCT_2_MSGPACK_BUFFER_FUNCTION_NAME(CHAR)(STANDARD_TYPE(CHAR) * value, GET_STRUCT_NAME(Buffer) * buf)
+{
+    return json_wrapper_msgpack_write_small_int(buf, *value);
+}
+
+static inline int STRUCT_2_MSGPACK_BUFFER_FUNCTION_NAME(INT)(STANDARD_TYPE(INT) * value, GET_STRUCT_NAME(Buffer) * buf);
+inline int STRUCT_2_MSGPACK_BUFFER_FUNCTION_NAME(INT)(STANDARD_TYPE(INT) * value, GET_STRUCT_NAME(Buffer) * buf)
+{
+    return json_wrapper_msgpack_write_small_int(buf, *value);
+}
+
+static inline int STRUCT_2_MSGPACK_BUFFER_FUNCTION_NAME(INT64)(STANDARD_TYPE(INT64) * value, GET_STRUCT_NAME(Buffer) * buf);
+inline int STRUCT_2_MSGPACK_BUFFER_FUNCTION_NAME(INT64)(STANDARD_TYPE(INT64) * value, GET_STRUCT_NAME(Buffer) * buf)
+{
+    return json_wrapper_msgpack_write_int64(buf, *value);
+}
+
+static inline int STRUCT_2_MSGPACK_BUFFER_FUNCTION_NAME(UINT32)(STANDARD_TYPE(UINT32) * value, GET_STRUCT_NAME(Buffer) * buf);
+inline int STRUCT_2_MSGPACK_BUFFER_FUNCTION_NAME(UINT32)(STANDARD_TYPE(UINT32) * value, GET_STRUCT_NAME(Buffer) * buf)
+{
+    return json_wrapper_msgpack_write_uint64(buf, *value);
+}
+
+static inline int STRUCT_2_MSGPACK_BUFFER_FUNCTION_NAME(UINT64)(STANDARD_TYPE(UINT64) * value, GET_STRUCT_NAME(Buffer) * buf);
+inline int STRUCT_2_MSGPACK_BUFFER_FUNCTION_NAME(UINT64)(STANDARD_TYPE(UINT64) * value, GET_STRUCT_NAME(Buffer) * buf)
+{
+    return json_wrapper_msgpack_write_uint64(buf, *value);
+}
+
+static inline int STRUCT_2_MSGPACK_BUFFER_FUNCTION_NAME(FLOAT)(STANDARD_TYPE(FLOAT) * value, GET_STRUCT_NAME(Buffer) * buf);
+inline int STRUCT_2_MSGPACK_BUFFER_FUNCTION_NAME(FLOAT)(STANDARD_TYPE(FLOAT) * value, GET_STRUCT_NAME(Buffer) * buf)
+{
+    return json_wrapper_msgpack_write_float(buf, *value);
+}
+
+static inline int STRUCT_2_MSGPACK_BUFFER_FUNCTION_NAME(DOUBLE)(STANDARD_TYPE(DOUBLE) * value, GET_STRUCT_NAME(Buffer) * buf);
+inline int STRUCT_2_MSGPACK_BUFFER_FUNCTION_NAME(DOUBLE)(STANDARD_TYPE(DOUBLE) * value, GET_STRUCT_NAME(Buffer) * buf)
+{
+    return json_wrapper_msgpack_write_double(buf, *value);
+}
+
+static inline int STRUCT_2_MSGPACK_BUFFER_FUNCTION_NAME(STRING)(STANDARD_TYPE(STRING) * value, GET_STRUCT_NAME(Buffer) * buf);
+inline int STRUCT_2_MSGPACK_BUFFER_FUNCTION_NAME(STRING)(STANDARD_TYPE(STRING) * value, GET_STRUCT_NAME(Buffer) * buf)
+{
+    return json_wrapper_msgpack_write_string(buf, *value);
+}
+
+static inline int STRUCT_2_MSGPACK_BUFFER_FUNCTION_NAME(STRING_VIEW)(STANDARD_TYPE(STRING_VIEW) * value, GET_STRUCT_NAME(Buffer) * buf);
+inline int STRUCT_2_MSGPACK_BUFFER_FUNCTION_NAME(STRING_VIEW)(STANDARD_TYPE(STRING_VIEW) * value, GET_STRUCT_NAME(Buffer) * buf)
+{
+    ASSERT_RETURN(value->ptr, json_wrapper_msgpack_write_nil(buf));
+    return json_wrapper_msgpack_write_str(buf, value->ptr, value->len);
+}
+
+static inline int MSGPACK_READER_2_FUNCTION_NAME(BOOL)(GET_STRUCT_NAME(Reader) * r, STANDARD_TYPE(BOOL) * dst);
+inline int MSGPACK_READER_2_FUNCTION_NAME(BOOL)(GET_STRUCT_NAME(Reader) * r, STANDARD_TYPE(BOOL) * dst)
+{
+    return json_wrapper_msgpack_read_bool(r, dst);
+}
+
+static inline int MSGPACK_READER_2_FUNCTION_NAME(CHAR)(GET_STRUCT_NAME(Reader) * r, STANDARD_TYPE(CHAR) * dst);
+inline int MSGPACK_READER_2_FUNCTION_NAME(CHAR)(GET_STRUCT_NAME(Reader) * r, STANDARD_TYPE(CHAR) * dst)
+{
+    long value = *dst;
+    ASSERT_RETURN(0 == json_wrapper_msgpack_read_int(r, &value), -1);
+    *dst = (STANDARD_TYPE(CHAR)) (value < INT_MIN ? INT_MIN : (value > INT_MAX ? INT_MAX : value));
+    return 0;
+}
+
+static inline int MSGPACK_READER_2_FUNCTION_NAME(INT)(GET_STRUCT_NAME(Reader) * r, STANDARD_TYPE(INT) * dst);
+inline int MSGPACK_READER_2_FUNCTION_NAME(INT)(GET_STRUCT_NAME(Reader) * r, STANDARD_TYPE(INT) * dst)
+{
+    long value = *dst;
+    ASSERT_RETURN(0 == json_wrapper_msgpack_read_int(r, &value), -1);
+    *dst = value < INT_MIN ? INT_MIN : (value > INT_MAX ? INT_MAX : value);
+    return 0;
+}
+
+static inline int MSGPACK_READER_2_FUNCTION_NAME(INT64)(GET_STRUCT_NAME(Reader) * r, STANDARD_TYPE(INT64) * dst);
+inline int MSGPACK_READER_2_FUNCTION_NAME(INT64)(GET_STRUCT_NAME(Reader) * r, STANDARD_TYPE(INT64) * dst)
+{
+    return json_wrapper_msgpack_read_int64(r, dst);
+}
+
+static inline int MSGPACK_READER_2_FUNCTION_NAME(UINT32)(GET_STRUCT_NAME(Reader) * r, STANDARD_TYPE(UINT32) * dst);
+inline int MSGPACK_READER_2_FUNCTION_NAME(UINT32)(GET_STRUCT_NAME(Reader) * r, STANDARD_TYPE(UINT32) * dst)
+{
+    uint64_t value = *dst;
+    ASSERT_RETURN(0 == json_wrapper_msgpack_read_uint64(r, &value), -1);
+    *dst = value > UINT32_MAX ? UINT32_MAX : (uint32_t) value;
+    return 0;
+}
+
+static inline int MSGPACK_READER_2_FUNCTION_NAME(UINT64)(GET_STRUCT_NAME(Reader) * r, STANDARD_TYPE(UINT64) * dst);
+inline int MSGPACK_READER_2_FUNCTION_NAME(UINT64)(GET_STRUCT_NAME(Reader) * r, STANDARD_TYPE(UINT64) * dst)
+{
+    return json_wrapper_msgpack_read_uint64(r, dst);
+}
+
+static inline int MSGPACK_READER_2_FUNCTION_NAME(FLOAT)(GET_STRUCT_NAME(Reader) * r, STANDARD_TYPE(FLOAT) * dst);
+inline int MSGPACK_READER_2_FUNCTION_NAME(FLOAT)(GET_STRUCT_NAME(Reader) * r, STANDARD_TYPE(FLOAT) * dst)
+{
+    double value = *dst;
+    ASSERT_RETURN(0 == json_wrapper_msgpack_read_double(r, &value), -1);
+    *dst = (float) value;
+    return 0;
+}
+
+static inline int MSGPACK_READER_2_FUNCTION_NAME(DOUBLE)(GET_STRUCT_NAME(Reader) * r, STANDARD_TYPE(DOUBLE) * dst);
+inline int MSGPACK_READER_2_FUNCTION_NAME(DOUBLE)(GET_STRUCT_NAME(Reader) * r, STANDARD_TYPE(DOUBLE) * dst)
+{
+    return json_wrapper_msgpack_read_double(r, dst);
+}
+
+static inline int MSGPACK_READER_2_FUNCTION_NAME(STRING)(GET_STRUCT_NAME(Reader) * r, STANDARD_TYPE(STRING) * dst);
+inline int MSGPACK_READER_2_FUNCTION_NAME(STRING)(GET_STRUCT_NAME(Reader) * r, STANDARD_TYPE(STRING) * dst)
+{
+    return json_wrapper_msgpack_read_string(r, dst);
+}
+
+static inline int MSGPACK_READER_2_FUNCTION_NAME(STRING_VIEW)(GET_STRUCT_NAME(Reader) * r, STANDARD_TYPE(STRING_VIEW) * dst);
+inline int MSGPACK_READER_2_FUNCTION_NAME(STRING_VIEW)(GET_STRUCT_NAME(Reader) * r, STANDARD_TYPE(STRING_VIEW) * dst)
+{
+    return json_wrapper_msgpack_read_view(r, dst);
+}
+/**************************************** MSGPACK_2  END  ****************************************/
+
+
+/**************************************** DEFINE_VA_ARRAY_TYPES BEGIN ****************************************/
+#define DEFINE_VA_ARRAY_TYPE_VA_ARRAY(num, type, name) DEFINE_VA_ARRAY(type, name)
+#define DEFINE_VA_ARRAY_TYPE_ARRAY(num, type, name)
+#define DEFINE_VA_ARRAY_TYPE_OBJ(num, type, name)
+#define DEFINE_VA_ARRAY_TYPE_FIXED_STRING(num, type, name)
+#define DEFINE_VA_ARRAY_TYPE_(t, num, type, name) DEFINE_VA_ARRAY_TYPE_##t(num, type, name)
+#define DEFINE_VA_ARRAY_TYPE(t, num, type, name) DEFINE_VA_ARRAY_TYPE_(t, num, type, name)
+#define DEFINE_VA_ARRAY_TYPES(...) CONCAT(DEFINE_VA_ARRAY_TYPES_I __VA_ARGS__, _END)
+#define DEFINE_VA_ARRAY_TYPES_I(...) DEFINE_VA_ARRAY_TYPE(__VA_ARGS__) DEFINE_VA_ARRAY_TYPES_II
+#define DEFINE_VA_ARRAY_TYPES_II(...) DEFINE_VA_ARRAY_TYPE(__VA_ARGS__) DEFINE_VA_ARRAY_TYPES_I
+#define DEFINE_VA_ARRAY_TYPES_I_END
+#define DEFINE_VA_ARRAY_TYPES_II_END
+/**************************************** DEFINE_VA_ARRAY_TYPES  END  ****************************************/
+
+
+/**************************************** DEFINE_STRUCT_ BEGIN ****************************************/
+/**
+ * @brief Define the header of the struct
+ * 
+ * @note For example:
+ *           DEFINE_STRUCT_(Person)
+ *               -> struct Person_JSON;
+ *                  typedef struct Person_JSON Person_JSON;
+ *                  struct Person_JSON
+ **/
+#define DEFINE_STRUCT_(type) \
+struct GET_STRUCT_NAME(type); \
+typedef struct GET_STRUCT_NAME(type) GET_STRUCT_NAME(type); \
+struct GET_STRUCT_NAME(type)
+/**************************************** DEFINE_STRUCT_  END  ****************************************/
+
+
+/**************************************** DEFINE_FIELDS BEGIN ****************************************/
+/**
+ * @brief Define the fields
+ * 
+ * @note For example:
+ *           (int, age) (char, sex) -> int age; char sex;
+ **/
+#define DEFINE_FIELD_VA_ARRAY(num, type, name) GET_VA_ARRAY_NAME(type) name;
+#define DEFINE_FIELD_ARRAY(num, type, name) GET_STRUCT_NAME(type) name[num];
+#define DEFINE_FIELD_OBJ(num, type, name) GET_STRUCT_NAME(type) name;
+#define DEFINE_FIELD_FIXED_STRING(num, type, name) GET_STRUCT_NAME(type) name[num];
+#define DEFINE_FIELD_(t, num, type, name) DEFINE_FIELD_##t(num, type, name)
+#define DEFINE_FIELD(t, num, type, name) DEFINE_FIELD_(t, num, type, name)
+#define DEFINE_FIELDS(...) CONCAT(DEFINE_FIELDS_I __VA_ARGS__, _END)
+#define DEFINE_FIELDS_I(...) DEFINE_FIELD(__VA_ARGS__) DEFINE_FIELDS_II
+#define DEFINE_FIELDS_II(...) DEFINE_FIELD(__VA_ARGS__) DEFINE_FIELDS_I
+#define DEFINE_FIELDS_I_END
+#define DEFINE_FIELDS_II_END
+/**************************************** DEFINE_FIELDS  END  ****************************************/
+
+
+/**************************************** DEFINE_FIELD_KEYS BEGIN ****************************************/
+/**
+ * @brief Get the index of a field, which is an enumerator generated in the field order
+ * @param type The type name of the struct
+ * @param n The name of the field
+ **/
+#define GET_FIELD_INDEX(type, n) CONCAT(GET_STRUCT_NAME(type), CONCAT(_FIELD_, n))
+#define GET_FIELD_COUNT(type) CONCAT(GET_STRUCT_NAME(type), _FIELDS)
+/**
+ * @brief Get the bit of a field in @link Mask_JSON
+ **/
+#define GET_FIELD_BIT(type, n) ((uint64_t) 1 << GET_FIELD_INDEX(type, n))
+#define GET_FIELD_KEYS(type) CONCAT(GET_STRUCT_NAME(type), _KEYS)
+#define GET_FIELD_HASH(type) CONCAT(GET_STRUCT_NAME(type), _HASH)
+
+/**
+ * @brief The json key of a field
+ */
+typedef struct GET_STRUCT_NAME(Key)
+{
+    const char * name;
+    size_t len;
+} GET_STRUCT_NAME(Key);
+
+/**
+ * @brief The number of slots of the key hash of a struct, the structs with more than half as many fields
+ *        find their keys by a linear scan
+ */
+#define KEY_HASH_SLOTS 128
+
+/**
+ * @brief The open addressing hash of the keys of a struct, built on the first lookup of the struct
+ */
+typedef struct GET_STRUCT_NAME(KeyHash)
+{
+    long state;                             // 0 for not built, 1 for being built, 2 for built
+    uint8_t slots[KEY_HASH_SLOTS];          // The field index plus one, 0 for an empty slot
+} GET_STRUCT_NAME(KeyHash);
+
+/**
+ * @brief Find the field index of a json key by the key hash, built from @p keys if it's not yet
+ * 
+ * @note While another thread is building the hash, the keys are scanned instead
+ * 
+ * @param hash The key hash of the struct
+ * @param keys The keys of the fields
+ * @param count The number of fields
+ * @param key The json key, which doesn't need to be '\0' terminated
+ * @param len The length of the json key
+ * @return int The field index, @p -1 for no field matched
+ */
+int json_wrapper_key_find(GET_STRUCT_NAME(KeyHash) * hash, const GET_STRUCT_NAME(Key) * keys, size_t count,
+    const char * key, size_t len);
+
+/**
+ * @brief Find the field index of a json key
+ * 
+ * @note @p hint is checked first, it's the field after the last matched one so that keys written
+ *       in the field order are matched with one compare, otherwise the key is looked up in @p hash
+ * 
+ * @param keys The keys of the fields
+ * @param count The number of fields
+ * @param hash The key hash of the struct
+ * @param key The json key, which doesn't need to be '\0' terminated
+ * @param len The length of the json key
+ * @param hint The expected field index
+ * @return int The field index, @p -1 for no field matched
+ */
+static inline int json_wrapper_key_index(const GET_STRUCT_NAME(Key) * keys, size_t count, GET_STRUCT_NAME(KeyHash) * hash,
+    const char * key, size_t len, size_t hint);
+inline int json_wrapper_key_index(const GET_STRUCT_NAME(Key) * keys, size_t count, GET_STRUCT_NAME(KeyHash) * hash,
+    const char * key, size_t len, size_t hint)
+{
+    ASSERT_RETURN(len > 0, -1);
+    if (hint < count && keys[hint].len == len && 0 == memcmp(keys[hint].name, key, len)) return (int) hint;
+    return json_wrapper_key_find(hash, keys, count, key, len);
+}
+
+/**
+ * @brief Define the field indexes, the key table and the key dispatcher of the struct
+ * 
+ * @note For example:
+ *           DEFINE_FIELD_KEYS(Person, (OBJ(INT), age) (OBJ(CHAR), sex))
+ *               -> enum { Person_JSON_FIELD_age, Person_JSON_FIELD_sex, Person_JSON_FIELDS };
+ *                  static const Key_JSON Person_JSON_KEYS[] = { [Person_JSON_FIELD_age] = { "age", 3 }, ... };
+ *                  static KeyHash_JSON Person_JSON_HASH;
+ *                  static inline int json_wrapper_field_index_Person_JSON(const char * key, size_t len, size_t hint);
+ **/
+#define FIELD_INDEX_FUNCTION_NAME(type) CONCAT(json_wrapper_field_index_, GET_STRUCT_NAME(type))
+#define DEFINE_FIELD_INDEX(type, kind, num, t, n) GET_FIELD_INDEX(type, n),
+#define DEFINE_FIELD_INDEX_(...) DEFINE_FIELD_INDEX(__VA_ARGS__)
+#define DEFINE_FIELD_INDEX_TARGET(st_tuple, tuple) DEFINE_FIELD_INDEX_(EXPAND st_tuple, EXPAND tuple)
+#define DEFINE_FIELD_INDEXES(type, ...) EVAL(JOIN_TYPES_EX_FOR_EACH(DEFINE_FIELD_INDEX_TARGET, (type), ##__VA_ARGS__))
+#define DEFINE_FIELD_KEY(type, kind, num, t, n) [GET_FIELD_INDEX(type, n)] = { #n, sizeof(#n) - 1 },
+#define DEFINE_FIELD_KEY_(...) DEFINE_FIELD_KEY(__VA_ARGS__)
+#define DEFINE_FIELD_KEY_TARGET(st_tuple, tuple) DEFINE_FIELD_KEY_(EXPAND st_tuple, EXPAND tuple)
+#define DEFINE_FIELD_KEYS_(type, ...) EVAL(JOIN_TYPES_EX_FOR_EACH(DEFINE_FIELD_KEY_TARGET, (type), ##__VA_ARGS__))
+#define DEFINE_FIELD_KEYS(type, ...) \
+enum \
+{ \
+    DEFINE_FIELD_INDEXES(type, ##__VA_ARGS__) \
+    GET_FIELD_COUNT(type) \
+}; \
+static const GET_STRUCT_NAME(Key) GET_FIELD_KEYS(type)[] = \
+{ \
+    DEFINE_FIELD_KEYS_(type, ##__VA_ARGS__) \
+}; \
+static GET_STRUCT_NAME(KeyHash) GET_FIELD_HASH(type); \
+static inline int \
+FIELD_INDEX_FUNCTION_NAME(type) \
+    (const char * key, size_t len, size_t hint); \
+inline int \
+FIELD_INDEX_FUNCTION_NAME(type) \
+    (const char * key, size_t len, size_t hint) \
+{ \
+    return json_wrapper_key_index(GET_FIELD_KEYS(type), GET_FIELD_COUNT(type), &GET_FIELD_HASH(type), key, len, hint); \
+}
+/**************************************** DEFINE_FIELD_KEYS  END  ****************************************/
+
+
+/**
+ * @brief Define a function name to convert wrapper struct to json string
+ */
+#define STRUCT_2_JSON_STR_FUNCTION_NAME(type) CONCAT(json_wrapper_json_str_from_, GET_STRUCT_NAME(type))
+
+/**
+ * @brief Define a function name to write wrapper struct as json string into the memory of the caller
+ */
+#define STRUCT_2_JSON_INTO_FUNCTION_NAME(type) CONCAT(json_wrapper_json_into_from_, GET_STRUCT_NAME(type))
+
+/**
+ * @brief Define a function name to get the length of the json string of wrapper struct
+ */
+#define STRUCT_2_JSON_SIZE_FUNCTION_NAME(type) CONCAT(json_wrapper_json_size_from_, GET_STRUCT_NAME(type))
+
+/**
+ * @brief Define a function name to write an array of wrapper structs into a sink
+ */
+#define STRUCT_2_JSON_BATCH_FUNCTION_NAME(type) CONCAT(json_wrapper_json_batch_from_, GET_STRUCT_NAME(type))
+
+
+/**************************************** DEFINE_STRUCT_2_JSON BEGIN ****************************************/
+/**
+ * @brief Define a function to convert the struct to json string
+ * @param type The type name of the struct
+ **/
+#define DEFINE_STRUCT_2_JSON__OBJ(json, st, num, t, n) { \
+    cJSON * obj = STRUCT_2(t, st, n); \
+    ASSERT_BREAK(obj); \
+    cJSON_AddItemToObject(json, #n, obj); \
+}
+#define DEFINE_STRUCT_2_JSON__ARRAY(json, st, num, t, n) { \
+    cJSON * array_ = cJSON_CreateArray(); \
+    ASSERT_BREAK(array_); \
+    int i = 0; \
+    for (; i < num; ++i) \
+    { \
+        cJSON * obj = STRUCT_2(t, st, n[i]); \
+        ASSERT_BREAK(obj); \
+        cJSON_AddItemToArray(array_, obj); \
+    } \
+    cJSON_AddItemToObject(json, #n, array_); \
+}
+#define DEFINE_STRUCT_2_JSON__VA_ARRAY(json, st, num, t, n) { \
+    cJSON * array_ = cJSON_CreateArray(); \
+    ASSERT_BREAK(array_); \
+    if (NULL != (st)->n.n) \
+    { \
+        int i = 0; \
+        for (; i < (st)->n.size; ++i) \
+        { \
+            cJSON * obj = STRUCT_2(t, st, n.n[i]); \
+            ASSERT_BREAK(obj); \
+            cJSON_AddItemToArray(array_, obj); \
+        } \
+    } \
+    cJSON_AddItemToObject(json, #n, array_); \
+}
+#define DEFINE_STRUCT_2_JSON__FIXED_STRING(json, st, num, t, n) { \
+    cJSON * obj = json_wrapper_fixed_string_to_json((st)->n, num); \
+    ASSERT_BREAK(obj); \
     cJSON_AddItemToObject(json, #n, obj); \
 }
-#define DEFINE_STRUCT_2_JSON__ARRAY(json, st, num, t, n) { \
-    cJSON * array_ = cJSON_CreateArray(); \
-    ASSERT_BREAK(array_); \
+#define DEFINE_STRUCT_2_JSON__(json, st, type, num, t, n) DEFINE_STRUCT_2_JSON__##type(json, st, num, t, n)
+#define DEFINE_STRUCT_2_JSON_(json, st, ...) \
+    CONCAT(EXPAND(DEFINE_STRUCT_2_JSON_I JOIN_TYPES_EX((json, st), ##__VA_ARGS__)), _END)
+#define DEFINE_STRUCT_2_JSON_I(json, st, type, num, t, n) DEFINE_STRUCT_2_JSON__(json, st, type, num, t, n) DEFINE_STRUCT_2_JSON_II
+#define DEFINE_STRUCT_2_JSON_II(json, st, type, num, t, n) DEFINE_STRUCT_2_JSON__(json, st, type, num, t, n) DEFINE_STRUCT_2_JSON_I
+#define DEFINE_STRUCT_2_JSON_I_END
+#define DEFINE_STRUCT_2_JSON_II_END
+#define DEFINE_STRUCT_2_JSON(type, ...) \
+static inline cJSON * \
+STRUCT_2_FUNCTION_NAME(type) \
+    (GET_STRUCT_NAME(type) * st); \
+inline cJSON * \
+STRUCT_2_FUNCTION_NAME(type) \
+    (GET_STRUCT_NAME(type) * st) \
+{ \
+    ASSERT_RETURN(st, NULL); \
+    cJSON * json = cJSON_CreateObject(); \
+    ASSERT_RETURN(json, NULL); \
+    do { \
+        DEFINE_STRUCT_2_JSON_(json, st, ##__VA_ARGS__) \
+    } while (0); \
+    return json; \
+}
+/**************************************** DEFINE_STRUCT_2_JSON  END  ****************************************/
+
+
+/**************************************** DEFINE_STRUCT_2_BUFFER BEGIN ****************************************/
+/**
+ * @brief Define a function to write the struct as json text into a buffer directly,
+ *        the result is the same as printing the json object from @link DEFINE_STRUCT_2_JSON unformatted
+ * @param type The type name of the struct
+ **/
+#define DEFINE_STRUCT_2_BUFFER_KEY(buf, n) \
+    ASSERT_RETURN(0 == json_wrapper_buffer_append(buf, ",\"" #n "\":", sizeof(",\"" #n "\":") - 1), -1)
+#define DEFINE_STRUCT_2_BUFFER__OBJ(buf, st, num, t, n) { \
+    DEFINE_STRUCT_2_BUFFER_KEY(buf, n); \
+    ASSERT_RETURN(0 == STRUCT_2_BUFFER(t, st, n, buf), -1); \
+}
+#define DEFINE_STRUCT_2_BUFFER__ARRAY(buf, st, num, t, n) { \
+    DEFINE_STRUCT_2_BUFFER_KEY(buf, n); \
+    ASSERT_RETURN(0 == json_wrapper_buffer_append(buf, "[", 1), -1); \
+    int i = 0; \
+    for (; i < num; ++i) \
+    { \
+        if (i > 0) ASSERT_RETURN(0 == json_wrapper_buffer_append(buf, ",", 1), -1); \
+        ASSERT_RETURN(0 == STRUCT_2_BUFFER(t, st, n[i], buf), -1); \
+    } \
+    ASSERT_RETURN(0 == json_wrapper_buffer_append(buf, "]", 1), -1); \
+}
+#define DEFINE_STRUCT_2_BUFFER__VA_ARRAY(buf, st, num, t, n) { \
+    DEFINE_STRUCT_2_BUFFER_KEY(buf, n); \
+    ASSERT_RETURN(0 == json_wrapper_buffer_append(buf, "[", 1), -1); \
+    if (NULL != (st)->n.n) \
+    { \
+        size_t i = 0; \
+        for (; i < (st)->n.size; ++i) \
+        { \
+            if (i > 0) ASSERT_RETURN(0 == json_wrapper_buffer_append(buf, ",", 1), -1); \
+            ASSERT_RETURN(0 == STRUCT_2_BUFFER(t, st, n.n[i], buf), -1); \
+        } \
+    } \
+    ASSERT_RETURN(0 == json_wrapper_buffer_append(buf, "]", 1), -1); \
+}
+#define DEFINE_STRUCT_2_BUFFER__FIXED_STRING(buf, st, num, t, n) { \
+    DEFINE_STRUCT_2_BUFFER_KEY(buf, n); \
+    ASSERT_RETURN(0 == json_wrapper_buffer_append_str(buf, (st)->n, json_wrapper_fixed_string_len((st)->n, num)), -1); \
+}
+#define DEFINE_STRUCT_2_BUFFER__(buf, st, type, num, t, n) DEFINE_STRUCT_2_BUFFER__##type(buf, st, num, t, n)
+#define DEFINE_STRUCT_2_BUFFER_(buf, st, ...) \
+    CONCAT(EXPAND(DEFINE_STRUCT_2_BUFFER_I JOIN_TYPES_EX((buf, st), ##__VA_ARGS__)), _END)
+#define DEFINE_STRUCT_2_BUFFER_I(buf, st, type, num, t, n) DEFINE_STRUCT_2_BUFFER__(buf, st, type, num, t, n) DEFINE_STRUCT_2_BUFFER_II
+#define DEFINE_STRUCT_2_BUFFER_II(buf, st, type, num, t, n) DEFINE_STRUCT_2_BUFFER__(buf, st, type, num, t, n) DEFINE_STRUCT_2_BUFFER_I
+#define DEFINE_STRUCT_2_BUFFER_I_END
+#define DEFINE_STRUCT_2_BUFFER_II_END
+#define DEFINE_STRUCT_2_BUFFER(type, ...) \
+static inline int \
+STRUCT_2_BUFFER_FUNCTION_NAME(type) \
+    (GET_STRUCT_NAME(type) * st, GET_STRUCT_NAME(Buffer) * buf); \
+inline int \
+STRUCT_2_BUFFER_FUNCTION_NAME(type) \
+    (GET_STRUCT_NAME(type) * st, GET_STRUCT_NAME(Buffer) * buf) \
+{ \
+    ASSERT_RETURN(st && buf, -1); \
+    size_t start = buf->len; \
+    DEFINE_STRUCT_2_BUFFER_(buf, st, ##__VA_ARGS__) \
+    return json_wrapper_buffer_close_object(buf, start); \
+} \
+DEFINE_STRUCT_2_JSON_STR(type)
+
+/**
+ * @brief Define the functions to convert the struct to json string on top of its buffer writer
+ * @param type The type name of the struct
+ **/
+#define DEFINE_STRUCT_2_JSON_STR(type) \
+static inline char * \
+STRUCT_2_JSON_STR_FUNCTION_NAME(type) \
+    (GET_STRUCT_NAME(type) * st); \
+inline char * \
+STRUCT_2_JSON_STR_FUNCTION_NAME(type) \
+    (GET_STRUCT_NAME(type) * st) \
+{ \
+    ASSERT_RETURN(st, NULL); \
+    INSTRUMENT_ENTER(type, INSTRUMENT_S2J) \
+    GET_STRUCT_NAME(Buffer) buf; \
+    memset(&buf, 0, sizeof(GET_STRUCT_NAME(Buffer))); \
+    int rc = STRUCT_2_BUFFER_FUNCTION_NAME(type)(st, &buf); \
+    INSTRUMENT_LEAVE(0, buf.len) \
+    if (0 != rc) \
+    { \
+        json_wrapper_buffer_release(&buf); \
+        return NULL; \
+    } \
+    return json_wrapper_buffer_detach(&buf); \
+} \
+static inline size_t \
+STRUCT_2_JSON_INTO_FUNCTION_NAME(type) \
+    (GET_STRUCT_NAME(type) * st, char * data, size_t cap); \
+inline size_t \
+STRUCT_2_JSON_INTO_FUNCTION_NAME(type) \
+    (GET_STRUCT_NAME(type) * st, char * data, size_t cap) \
+{ \
+    ASSERT_RETURN(st, 0); \
+    GET_STRUCT_NAME(Buffer) buf; \
+    json_wrapper_buffer_init_fixed(&buf, data, cap); \
+    STRUCT_2_BUFFER_FUNCTION_NAME(type)(st, &buf); \
+    if (buf.cap > 0) buf.data[buf.len < buf.cap ? buf.len : buf.cap - 1] = '\0'; \
+    return buf.len; \
+} \
+static inline size_t \
+STRUCT_2_JSON_SIZE_FUNCTION_NAME(type) \
+    (GET_STRUCT_NAME(type) * st); \
+inline size_t \
+STRUCT_2_JSON_SIZE_FUNCTION_NAME(type) \
+    (GET_STRUCT_NAME(type) * st) \
+{ \
+    return STRUCT_2_JSON_INTO_FUNCTION_NAME(type)(st, NULL, 0); \
+} \
+static inline int \
+STRUCT_2_JSON_BATCH_FUNCTION_NAME(type) \
+    (GET_STRUCT_NAME(type) * array, size_t count, GET_STRUCT_NAME(Sink) * sink); \
+inline int \
+STRUCT_2_JSON_BATCH_FUNCTION_NAME(type) \
+    (GET_STRUCT_NAME(type) * array, size_t count, GET_STRUCT_NAME(Sink) * sink) \
+{ \
+    ASSERT_RETURN((array || 0 == count) && sink, -1); \
+    GET_STRUCT_NAME(Buffer) * buf = json_wrapper_sink_buffer(sink); \
+    size_t start = buf->len; \
+    int rc = json_wrapper_sink_begin(sink); \
+    size_t i = 0; \
+    for (; 0 == rc && i < count; ++i) \
+    { \
+        rc = json_wrapper_sink_next(sink, i); \
+        if (0 == rc) rc = STRUCT_2_BUFFER_FUNCTION_NAME(type)(&array[i], buf); \
+        if (0 == rc) rc = json_wrapper_sink_end_record(sink); \
+    } \
+    if (0 == rc) rc = json_wrapper_sink_end(sink); \
+    if (0 == rc && buf->fixed && buf->len >= buf->cap) rc = -1; \
+    if (0 != rc) buf->len = NULL != sink->buf ? start : 0; \
+    return rc; \
+}
+/**************************************** DEFINE_STRUCT_2_BUFFER  END  ****************************************/
+
+
+/**************************************** DEFINE_MAX_SIZE BEGIN ****************************************/
+/**
+ * @brief Define the largest length of the json text of the struct, and whether the length is bounded by it
+ * @param type The type name of the struct
+ * 
+ * @note Each field takes ',"key":' plus its value, the first comma is the opening brace,
+ *       an ARRAY takes its brackets and the commas between its elements, none for an empty one.
+ *       For example:
+ *           DEFINE_MAX_SIZE(Point, (OBJ(INT), x) (ARRAY(BOOL, 2), flags))
+ *               -> enum { Point_JSON_MAX_SIZE = 1 + (sizeof("x") + 3 + 11) + (sizeof("flags") + 3 + (2 + 2 * 5 + 2 - 1)),
+ *                         Point_JSON_IS_BOUNDED = 1 && 1 && 1 };
+ **/
+#define DEFINE_MAX_SIZE__OBJ(num, t, n) + (int) (sizeof(#n) + 3 + GET_MAX_SIZE(t))
+#define DEFINE_MAX_SIZE__ARRAY(num, t, n) + (int) (sizeof(#n) + 3 + 2 + (num) * GET_MAX_SIZE(t) + ((num) > 0 ? (num) - 1 : 0))
+#define DEFINE_MAX_SIZE__VA_ARRAY(num, t, n) + (int) (sizeof(#n) + 3 + 2)
+#define DEFINE_MAX_SIZE__FIXED_STRING(num, t, n) + (int) (sizeof(#n) + 3 + 2 + 6 * (num))
+#define DEFINE_MAX_SIZE__(st, kind, num, t, n) DEFINE_MAX_SIZE__##kind(num, t, n)
+#define DEFINE_MAX_SIZE_(type, ...) \
+    CONCAT(EXPAND(DEFINE_MAX_SIZE_I JOIN_TYPES(type, ##__VA_ARGS__)), _END)
+#define DEFINE_MAX_SIZE_I(st, kind, num, t, n) DEFINE_MAX_SIZE__(st, kind, num, t, n) DEFINE_MAX_SIZE_II
+#define DEFINE_MAX_SIZE_II(st, kind, num, t, n) DEFINE_MAX_SIZE__(st, kind, num, t, n) DEFINE_MAX_SIZE_I
+#define DEFINE_MAX_SIZE_I_END
+#define DEFINE_MAX_SIZE_II_END
+#define DEFINE_IS_BOUNDED__OBJ(num, t, n) && GET_IS_BOUNDED(t)
+#define DEFINE_IS_BOUNDED__ARRAY(num, t, n) && GET_IS_BOUNDED(t)
+#define DEFINE_IS_BOUNDED__VA_ARRAY(num, t, n) && 0
+#define DEFINE_IS_BOUNDED__FIXED_STRING(num, t, n) && 1
+#define DEFINE_IS_BOUNDED__(st, kind, num, t, n) DEFINE_IS_BOUNDED__##kind(num, t, n)
+#define DEFINE_IS_BOUNDED_(type, ...) \
+    CONCAT(EXPAND(DEFINE_IS_BOUNDED_I JOIN_TYPES(type, ##__VA_ARGS__)), _END)
+#define DEFINE_IS_BOUNDED_I(st, kind, num, t, n) DEFINE_IS_BOUNDED__(st, kind, num, t, n) DEFINE_IS_BOUNDED_II
+#define DEFINE_IS_BOUNDED_II(st, kind, num, t, n) DEFINE_IS_BOUNDED__(st, kind, num, t, n) DEFINE_IS_BOUNDED_I
+#define DEFINE_IS_BOUNDED_I_END
+#define DEFINE_IS_BOUNDED_II_END
+#define DEFINE_MAX_SIZE(type, ...) \
+enum \
+{ \
+    GET_MAX_SIZE(type) = 1 DEFINE_MAX_SIZE_(type, ##__VA_ARGS__), \
+    GET_IS_BOUNDED(type) = 1 DEFINE_IS_BOUNDED_(type, ##__VA_ARGS__) \
+};
+/**************************************** DEFINE_MAX_SIZE  END  ****************************************/
+
+
+/**************************************** DESC BEGIN ****************************************/
+/**
+ * @brief The descriptor of a wrapper type, which the table-driven engine walks instead of unrolled code
+ */
+typedef struct GET_STRUCT_NAME(Desc) GET_STRUCT_NAME(Desc);
+
+/**
+ * @brief The descriptor of a struct field
+ */
+typedef struct GET_STRUCT_NAME(FieldDesc)
+{
+    const char * name;                      // The field name
+    size_t len;                             // The length of the field name
+    const char * member;                    // The json member prefix ',"name":'
+    size_t member_len;                      // The length of the json member prefix
+    size_t offset;                          // The offset of the field in the struct
+    GET_STRUCT_NAME(Type) kind;             // OBJ_, ARRAY_, VA_ARRAY_ or FIXED_STRING_
+    size_t count;                           // The number of elements of ARRAY_, or the capacity of FIXED_STRING_
+    const GET_STRUCT_NAME(Desc) * desc;     // The descriptor of the field or element type
+} GET_STRUCT_NAME(FieldDesc);
+
+struct GET_STRUCT_NAME(Desc)
+{
+    const char * name;                      // The type name
+    size_t size;                            // The size of the type
+    GET_STRUCT_NAME(Type) type;             // One of the base types or STRUCT_
+    const GET_STRUCT_NAME(FieldDesc) * fields;
+    size_t count;                           // The number of fields
+    const GET_STRUCT_NAME(Key) * keys;      // The keys of the fields for @link json_wrapper_key_index
+    GET_STRUCT_NAME(KeyHash) * hash;        // The key hash of the fields
+};
+
+/**
+ * @brief Get the descriptor of a wrapper type
+ * @param type The type
+ **/
+#define GET_DESC(type) CONCAT(GET_STRUCT_NAME(type), _DESC)
+#define GET_FIELD_DESCS(type) CONCAT(GET_STRUCT_NAME(type), _FIELD_DESCS)
+
+extern const GET_STRUCT_NAME(Desc) GET_DESC(BOOL);
+extern const GET_STRUCT_NAME(Desc) GET_DESC(CHAR);
+extern const GET_STRUCT_NAME(Desc) GET_DESC(INT);
+extern const GET_STRUCT_NAME(Desc) GET_DESC(INT64);
+extern const GET_STRUCT_NAME(Desc) GET_DESC(UINT32);
+extern const GET_STRUCT_NAME(Desc) GET_DESC(UINT64);
+extern const GET_STRUCT_NAME(Desc) GET_DESC(FLOAT);
+extern const GET_STRUCT_NAME(Desc) GET_DESC(DOUBLE);
+extern const GET_STRUCT_NAME(Desc) GET_DESC(STRING);
+extern const GET_STRUCT_NAME(Desc) GET_DESC(STRING_VIEW);
+
+/**
+ * @brief Write @p value of the type @p desc as json text into @p buf
+ * 
+ * @param desc The descriptor
+ * @param value The value
+ * @param buf The buffer
+ * @return int @p 0 for success, @p -1 for failure
+ */
+int json_wrapper_desc_to_buffer(const GET_STRUCT_NAME(Desc) * desc, const void * value, GET_STRUCT_NAME(Buffer) * buf);
+
+/**
+ * @brief Read @p value of the type @p desc from a json reader
+ * 
+ * @param desc The descriptor
+ * @param r The reader
+ * @param value The value
+ * @return int @p 0 for success, @p -1 for failure
+ */
+int json_wrapper_desc_from_reader(const GET_STRUCT_NAME(Desc) * desc, GET_STRUCT_NAME(Reader) * r, void * value);
+
+/**
+ * @brief Read the fields in @p mask of @p value of the type @p desc from a json reader, the others are skipped
+ * 
+ * @param desc The descriptor
+ * @param r The reader
+ * @param value The value
+ * @param mask The mask, @p NULL for all the fields
+ * @return int @p 0 for success, @p -1 for failure
+ */
+int json_wrapper_desc_from_reader_mask(const GET_STRUCT_NAME(Desc) * desc, GET_STRUCT_NAME(Reader) * r, void * value,
+    const GET_STRUCT_NAME(Mask) * mask);
+
+/**
+ * @brief Write @p value of the type @p desc as MessagePack into @p buf
+ * 
+ * @param desc The descriptor
+ * @param value The value
+ * @param buf The buffer
+ * @return int @p 0 for success, @p -1 for failure
+ */
+int json_wrapper_desc_to_msgpack(const GET_STRUCT_NAME(Desc) * desc, const void * value, GET_STRUCT_NAME(Buffer) * buf);
+
+/**
+ * @brief Read @p value of the type @p desc from a MessagePack reader
+ * 
+ * @param desc The descriptor
+ * @param r The reader
+ * @param value The value
+ * @return int @p 0 for success, @p -1 for failure
+ */
+int json_wrapper_desc_from_msgpack(const GET_STRUCT_NAME(Desc) * desc, GET_STRUCT_NAME(Reader) * r, void * value);
+
+/**
+ * @brief Convert @p value of the type @p desc to json object
+ * 
+ * @param desc The descriptor
+ * @param value The value
+ * @return cJSON* The json object, @p NULL for failure
+ */
+cJSON * json_wrapper_desc_to_json(const GET_STRUCT_NAME(Desc) * desc, const void * value);
+
+/**
+ * @brief Convert json object to @p value of the type @p desc
+ * 
+ * @param desc The descriptor
+ * @param json The json object
+ * @param value The value
+ * @return int @p 0 for success, @p -1 for failure
+ */
+int json_wrapper_desc_from_json(const GET_STRUCT_NAME(Desc) * desc, cJSON * json, void * value);
+
+/**
+ * @brief Copy @p src of the type @p desc to @p dst deeply
+ * 
+ * @param desc The descriptor
+ * @param src The src value
+ * @param dst The dst value
+ * @param arena The arena to alloc the strings and arrays of dst from, @p NULL for the hook in json wrapper
+ */
+void json_wrapper_desc_copy(const GET_STRUCT_NAME(Desc) * desc, const void * src, void * dst, GET_STRUCT_NAME(Arena) * arena);
+
+/**
+ * @brief Recycle @p value of the type @p desc
+ * 
+ * @param desc The descriptor
+ * @param value The value
+ */
+void json_wrapper_desc_recycle(const GET_STRUCT_NAME(Desc) * desc, void * value);
+
+/**
+ * @brief Reset the field of index @p index of @p value of the type @p desc to zero
+ * 
+ * @param desc The descriptor
+ * @param value The value
+ * @param index The field index
+ * @param recycle Whether to recycle the field first, @p false if its memory is from an arena
+ */
+void json_wrapper_desc_reset_field(const GET_STRUCT_NAME(Desc) * desc, void * value, size_t index, bool recycle);
+
+/**
+ * @brief Compare @p a and @p b of the type @p desc deeply
+ * 
+ * @param desc The descriptor
+ * @param a The value
+ * @param b The other value
+ * @return bool @p true for they are equal
+ */
+bool json_wrapper_desc_equal(const GET_STRUCT_NAME(Desc) * desc, const void * a, const void * b);
+
+/**
+ * @brief Write the merge patch which turns @p old of the type @p desc into @p value into @p buf,
+ *        nothing is written if they are equal
+ * 
+ * @param desc The descriptor
+ * @param old The old value
+ * @param value The new value
+ * @param buf The buffer
+ * @return int @p 1 for a patch is written, @p 0 for they are equal, @p -1 for failure
+ */
+int json_wrapper_desc_diff(const GET_STRUCT_NAME(Desc) * desc, const void * old, const void * value, GET_STRUCT_NAME(Buffer) * buf);
+/**************************************** DESC  END  ****************************************/
+
+
+/**************************************** DEFINE_DESC BEGIN ****************************************/
+/**
+ * @brief Define the descriptor of the struct
+ * 
+ * @note For example:
+ *           DEFINE_DESC(Person, (OBJ(INT), age) (ARRAY(Son, 2), sons))
+ *               -> static const FieldDesc_JSON Person_JSON_FIELD_DESCS[] = {
+ *                      [Person_JSON_FIELD_age] = { "age", 3, ",\"age\":", 7, offsetof(Person_JSON, age), OBJ_, 0, &INT_JSON_DESC }, ...
+ *                  };
+ *                  static const Desc_JSON Person_JSON_DESC = { "Person", sizeof(Person_JSON), STRUCT_, Person_JSON_FIELD_DESCS, ... };
+ **/
+#define DESC_FUNCTION_NAME(type) CONCAT(json_wrapper_desc_of_, GET_STRUCT_NAME(type))
+#define DEFINE_FIELD_DESC(type, kind, num, t, n) \
+    [GET_FIELD_INDEX(type, n)] = { \
+        #n, sizeof(#n) - 1, ",\"" #n "\":", sizeof(",\"" #n "\":") - 1, \
+        offsetof(GET_STRUCT_NAME(type), n), kind##_, num, &GET_DESC(t) \
+    },
+#define DEFINE_FIELD_DESC_(...) DEFINE_FIELD_DESC(__VA_ARGS__)
+#define DEFINE_FIELD_DESC_TARGET(st_tuple, tuple) DEFINE_FIELD_DESC_(EXPAND st_tuple, EXPAND tuple)
+#define DEFINE_FIELD_DESCS(type, ...) EVAL(JOIN_TYPES_EX_FOR_EACH(DEFINE_FIELD_DESC_TARGET, (type), ##__VA_ARGS__))
+#define DEFINE_DESC(type, ...) \
+static const GET_STRUCT_NAME(FieldDesc) GET_FIELD_DESCS(type)[] = \
+{ \
+    DEFINE_FIELD_DESCS(type, ##__VA_ARGS__) \
+}; \
+static const GET_STRUCT_NAME(Desc) GET_DESC(type) = \
+{ \
+    #type, sizeof(GET_STRUCT_NAME(type)), STRUCT_, GET_FIELD_DESCS(type), GET_FIELD_COUNT(type), GET_FIELD_KEYS(type), \
+    &GET_FIELD_HASH(type) \
+}; \
+static inline const GET_STRUCT_NAME(Desc) * \
+DESC_FUNCTION_NAME(type)(void); \
+inline const GET_STRUCT_NAME(Desc) * \
+DESC_FUNCTION_NAME(type)(void) \
+{ \
+    return &GET_DESC(type); \
+}
+/**************************************** DEFINE_DESC  END  ****************************************/
+
+
+/**************************************** DEFINE_JSON_2_STRUCT BEGIN ****************************************/
+/**
+ * @brief Define a function to convert the json string to struct
+ * @param type The type name of the struct
+ **/
+#define DEFINE_JSON_2_STRUCT__OBJ(obj, st, num, t, n) { \
+    JSON_2(t, obj, &((st)->n)); \
+}
+#define DEFINE_JSON_2_STRUCT__ARRAY(obj, st, num, t, n) { \
+    ASSERT_BREAK(cJSON_IsArray(obj)); \
+    cJSON * elem = NULL; \
+    int i = 0; \
+    cJSON_ArrayForEach(elem, obj) { \
+        ASSERT_BREAK(i < num); \
+        JSON_2(t, elem, &((st)->n[i])); \
+        ++i; \
+    } \
+}
+#define DEFINE_JSON_2_STRUCT__VA_ARRAY(obj, st, num, t, n) { \
+    ASSERT_BREAK(cJSON_IsArray(obj)); \
+    size_t num_ = cJSON_GetArraySize(obj); \
+    RECYCLE_VA_ARRAY(st, num, t, n) \
+    (st)->n.n = NULL; \
+    (st)->n.size = 0; \
+    ASSERT_BREAK(num_ > 0); \
+    (st)->n.n = json_wrapper_alloc(sizeof(GET_STRUCT_NAME(t)) * num_); \
+    ASSERT_BREAK((st)->n.n); \
+    memset((st)->n.n, 0, sizeof(GET_STRUCT_NAME(t)) * num_); \
+    (st)->n.size = num_; \
+    cJSON * elem = NULL; \
+    size_t i = 0; \
+    cJSON_ArrayForEach(elem, obj) { \
+        JSON_2(t, elem, &((st)->n.n[i])); \
+        ++i; \
+    } \
+}
+#define DEFINE_JSON_2_STRUCT__FIXED_STRING(obj, st, num, t, n) { \
+    ASSERT_BREAK(cJSON_IsString(obj) && (obj)->valuestring); \
+    json_wrapper_fixed_string_set((st)->n, num, (obj)->valuestring, strlen((obj)->valuestring)); \
+}
+#define DEFINE_JSON_2_STRUCT__(obj, st, stype, type, num, t, n) \
+    case GET_FIELD_INDEX(stype, n): DEFINE_JSON_2_STRUCT__##type(obj, st, num, t, n) break;
+#define DEFINE_JSON_2_STRUCT_(obj, st, stype, ...) \
+    CONCAT(EXPAND(DEFINE_JOSN_2_STRUCT_I JOIN_TYPES_EX((obj, st, stype), ##__VA_ARGS__)), _END)
+#define DEFINE_JOSN_2_STRUCT_I(obj, st, stype, type, num, t, n) DEFINE_JSON_2_STRUCT__(obj, st, stype, type, num, t, n) DEFINE_JOSN_2_STRUCT_II
+#define DEFINE_JOSN_2_STRUCT_II(obj, st, stype, type, num, t, n) DEFINE_JSON_2_STRUCT__(obj, st, stype, type, num, t, n) DEFINE_JOSN_2_STRUCT_I
+#define DEFINE_JOSN_2_STRUCT_I_END
+#define DEFINE_JOSN_2_STRUCT_II_END
+#define DEFINE_JSON_2_STRUCT(type, ...) \
+static inline int \
+JSON_2_FUNCTION_NAME(type) \
+    (cJSON * json, GET_STRUCT_NAME(type) * st); \
+inline int \
+JSON_2_FUNCTION_NAME(type) \
+    (cJSON * json, GET_STRUCT_NAME(type) * st) \
+{ \
+    ASSERT_RETURN(json && st, -1); \
+    size_t hint = 0; \
+    cJSON * obj = NULL; \
+    cJSON_ArrayForEach(obj, json) \
+    { \
+        if (NULL == obj->string) continue; \
+        int field = FIELD_INDEX_FUNCTION_NAME(type)(obj->string, strlen(obj->string), hint); \
+        switch (field) \
+        { \
+            DEFINE_JSON_2_STRUCT_(obj, st, type, ##__VA_ARGS__) \
+            default: break; \
+        } \
+        if (field >= 0) hint = field + 1; \
+    } \
+    return 0; \
+}
+/**************************************** DEFINE_JSON_2_STRUCT  END  ****************************************/
+
+
+/**************************************** DEFINE_READER_2_STRUCT BEGIN ****************************************/
+/**
+ * @brief Define a function to read the struct from a reader in one pass, each value is written into
+ *        the field as soon as its key is seen, unknown keys are skipped without allocating
+ * @param type The type name of the struct
+ **/
+#define DEFINE_READER_2_STRUCT__OBJ(r, sub, st, num, t, n) { \
+    ASSERT_RETURN(0 == READER_2_MASK(t, r, &((st)->n), sub), -1); \
+}
+#define DEFINE_READER_2_STRUCT__ARRAY(r, sub, st, num, t, n) { \
+    if ('[' != json_wrapper_reader_peek(r)) \
+    { \
+        ASSERT_RETURN(0 == json_wrapper_reader_skip(r), -1); \
+    } else \
+    { \
+        ASSERT_RETURN(0 == json_wrapper_reader_expect(r, '['), -1); \
+        size_t index_ = 0; \
+        int rc_ = 0; \
+        for (; 1 == (rc_ = json_wrapper_reader_next(r, ']', index_)); ++index_) \
+        { \
+            if (index_ < num) \
+            { \
+                ASSERT_RETURN(0 == READER_2_MASK(t, r, &((st)->n[index_]), sub), -1); \
+            } else \
+            { \
+                ASSERT_RETURN(0 == json_wrapper_reader_skip(r), -1); \
+            } \
+        } \
+        ASSERT_RETURN(0 == rc_, -1); \
+    } \
+}
+#define DEFINE_READER_2_STRUCT__VA_ARRAY(r, sub, st, num, t, n) { \
+    if ('[' != json_wrapper_reader_peek(r)) \
+    { \
+        ASSERT_RETURN(0 == json_wrapper_reader_skip(r), -1); \
+    } else \
+    { \
+        size_t count_ = 0; \
+        ASSERT_RETURN(0 == json_wrapper_reader_count(r, &count_), -1); \
+        if (NULL == (r)->arena) RECYCLE_VA_ARRAY(st, num, t, n) \
+        (st)->n.n = NULL; \
+        (st)->n.size = 0; \
+        if (count_ > 0) \
+        { \
+            (st)->n.n = json_wrapper_alloc_from((r)->arena, sizeof(GET_STRUCT_NAME(t)) * count_); \
+            ASSERT_RETURN((st)->n.n, -1); \
+            memset((st)->n.n, 0, sizeof(GET_STRUCT_NAME(t)) * count_); \
+            (st)->n.size = count_; \
+        } \
+        ASSERT_RETURN(0 == json_wrapper_reader_expect(r, '['), -1); \
+        size_t index_ = 0; \
+        int rc_ = 0; \
+        for (; 1 == (rc_ = json_wrapper_reader_next(r, ']', index_)); ++index_) \
+        { \
+            ASSERT_RETURN(index_ < count_, -1); \
+            ASSERT_RETURN(0 == READER_2_MASK(t, r, &((st)->n.n[index_]), sub), -1); \
+        } \
+        ASSERT_RETURN(0 == rc_, -1); \
+    } \
+}
+#define DEFINE_READER_2_STRUCT__FIXED_STRING(r, sub, st, num, t, n) { \
+    ASSERT_RETURN(0 == json_wrapper_reader_fixed(r, (st)->n, num), -1); \
+}
+#define DEFINE_READER_2_STRUCT__(r, sub, st, stype, type, num, t, n) \
+    case GET_FIELD_INDEX(stype, n): DEFINE_READER_2_STRUCT__##type(r, sub, st, num, t, n) break;
+#define DEFINE_READER_2_STRUCT_(r, sub, st, stype, ...) \
+    CONCAT(EXPAND(DEFINE_READER_2_STRUCT_I JOIN_TYPES_EX((r, sub, st, stype), ##__VA_ARGS__)), _END)
+#define DEFINE_READER_2_STRUCT_I(r, sub, st, stype, type, num, t, n) DEFINE_READER_2_STRUCT__(r, sub, st, stype, type, num, t, n) DEFINE_READER_2_STRUCT_II
+#define DEFINE_READER_2_STRUCT_II(r, sub, st, stype, type, num, t, n) DEFINE_READER_2_STRUCT__(r, sub, st, stype, type, num, t, n) DEFINE_READER_2_STRUCT_I
+#define DEFINE_READER_2_STRUCT_I_END
+#define DEFINE_READER_2_STRUCT_II_END
+#define DEFINE_READER_2_STRUCT(type, ...) \
+static inline int \
+READER_2_MASK_FUNCTION_NAME(type) \
+    (GET_STRUCT_NAME(Reader) * r, GET_STRUCT_NAME(type) * st, const GET_STRUCT_NAME(Mask) * mask); \
+inline int \
+READER_2_MASK_FUNCTION_NAME(type) \
+    (GET_STRUCT_NAME(Reader) * r, GET_STRUCT_NAME(type) * st, const GET_STRUCT_NAME(Mask) * mask) \
+{ \
+    ASSERT_RETURN(r && st, -1); \
+    ASSERT_RETURN('{' == json_wrapper_reader_peek(r), json_wrapper_reader_skip(r)); \
+    ASSERT_RETURN(0 == json_wrapper_reader_expect(r, '{'), -1); \
+    size_t index = 0; \
+    size_t hint = 0; \
+    int rc = 0; \
+    for (; 1 == (rc = json_wrapper_reader_next(r, '}', index)); ++index) \
+    { \
+        const char * key = NULL; \
+        size_t len = 0; \
+        ASSERT_RETURN(0 == json_wrapper_reader_key(r, &key, &len), -1); \
+        int field = FIELD_INDEX_FUNCTION_NAME(type)(key, len, hint); \
+        if (field >= 0) hint = field + 1; \
+        if (!json_wrapper_mask_has(mask, field)) field = -1; \
+        if ((r)->patch && field >= 0 && 'n' == json_wrapper_reader_peek(r)) \
+        { \
+            json_wrapper_desc_reset_field(&GET_DESC(type), st, field, NULL == (r)->arena); \
+            field = -1; \
+        } \
+        const GET_STRUCT_NAME(Mask) * sub = json_wrapper_mask_sub(mask, field); \
+        switch (field) \
+        { \
+            DEFINE_READER_2_STRUCT_(r, sub, st, type, ##__VA_ARGS__) \
+            default: \
+                ASSERT_RETURN(0 == json_wrapper_reader_skip(r), -1); \
+                break; \
+        } \
+    } \
+    return rc; \
+} \
+DEFINE_READER_2_STRUCT_ALL(type) \
+DEFINE_JSON_STR_2_STRUCT(type)
+
+/**
+ * @brief Define the function to read all the fields of the struct on top of its masked reader
+ * @param type The type name of the struct
+ **/
+#define DEFINE_READER_2_STRUCT_ALL(type) \
+static inline int \
+READER_2_FUNCTION_NAME(type) \
+    (GET_STRUCT_NAME(Reader) * r, GET_STRUCT_NAME(type) * st); \
+inline int \
+READER_2_FUNCTION_NAME(type) \
+    (GET_STRUCT_NAME(Reader) * r, GET_STRUCT_NAME(type) * st) \
+{ \
+    return READER_2_MASK_FUNCTION_NAME(type)(r, st, NULL); \
+}
+
+/**
+ * @brief Define the functions to convert json string to the struct on top of its reader
+ * @param type The type name of the struct
+ **/
+#define DEFINE_JSON_STR_2_STRUCT(type) \
+static inline int \
+JSON_STR_2_ARENA_FUNCTION_NAME(type) \
+    (char * json_str, GET_STRUCT_NAME(type) * st, GET_STRUCT_NAME(Arena) * arena); \
+inline int \
+JSON_STR_2_ARENA_FUNCTION_NAME(type) \
+    (char * json_str, GET_STRUCT_NAME(type) * st, GET_STRUCT_NAME(Arena) * arena) \
+{ \
+    ASSERT_RETURN(json_str && st, -1); \
+    GET_STRUCT_NAME(Reader) r; \
+    json_wrapper_reader_init(&r, json_str, strlen(json_str)); \
+    r.arena = arena; \
+    INSTRUMENT_ENTER(type, INSTRUMENT_J2S) \
+    int rc = READER_2_FUNCTION_NAME(type)(&r, st); \
+    INSTRUMENT_LEAVE(r.end - r.begin, 0) \
+    return rc; \
+} \
+static inline int \
+JSON_STR_2_FUNCTION_NAME(type) \
+    (char * json_str, GET_STRUCT_NAME(type) * st); \
+inline int \
+JSON_STR_2_FUNCTION_NAME(type) \
+    (char * json_str, GET_STRUCT_NAME(type) * st) \
+{ \
+    return JSON_STR_2_ARENA_FUNCTION_NAME(type)(json_str, st, NULL); \
+} \
+static inline int \
+JSON_STR_2_VIEW_FUNCTION_NAME(type) \
+    (char * json_str, size_t len, GET_STRUCT_NAME(type) * st, GET_STRUCT_NAME(Arena) * arena); \
+inline int \
+JSON_STR_2_VIEW_FUNCTION_NAME(type) \
+    (char * json_str, size_t len, GET_STRUCT_NAME(type) * st, GET_STRUCT_NAME(Arena) * arena) \
+{ \
+    ASSERT_RETURN(json_str && st, -1); \
+    GET_STRUCT_NAME(Reader) r; \
+    json_wrapper_reader_init(&r, json_str, len); \
+    r.arena = arena; \
+    r.writable = true; \
+    INSTRUMENT_ENTER(type, INSTRUMENT_J2S) \
+    int rc = READER_2_FUNCTION_NAME(type)(&r, st); \
+    INSTRUMENT_LEAVE(len, 0) \
+    return rc; \
+} \
+static inline int \
+JSON_STR_2_MASK_FUNCTION_NAME(type) \
+    (char * json_str, GET_STRUCT_NAME(type) * st, const GET_STRUCT_NAME(Mask) * mask, GET_STRUCT_NAME(Arena) * arena); \
+inline int \
+JSON_STR_2_MASK_FUNCTION_NAME(type) \
+    (char * json_str, GET_STRUCT_NAME(type) * st, const GET_STRUCT_NAME(Mask) * mask, GET_STRUCT_NAME(Arena) * arena) \
+{ \
+    ASSERT_RETURN(json_str && st, -1); \
+    GET_STRUCT_NAME(Reader) r; \
+    json_wrapper_reader_init(&r, json_str, strlen(json_str)); \
+    r.arena = arena; \
+    INSTRUMENT_ENTER(type, INSTRUMENT_J2S) \
+    int rc = READER_2_MASK_FUNCTION_NAME(type)(&r, st, mask); \
+    INSTRUMENT_LEAVE(r.end - r.begin, 0) \
+    return rc; \
+} \
+static inline int \
+JSON_STR_2_INDEX_FUNCTION_NAME(type) \
+    (const char * json_str, size_t len, GET_STRUCT_NAME(type) * st, const GET_STRUCT_NAME(Mask) * mask, \
+    GET_STRUCT_NAME(Index) * index, GET_STRUCT_NAME(Arena) * arena); \
+inline int \
+JSON_STR_2_INDEX_FUNCTION_NAME(type) \
+    (const char * json_str, size_t len, GET_STRUCT_NAME(type) * st, const GET_STRUCT_NAME(Mask) * mask, \
+    GET_STRUCT_NAME(Index) * index, GET_STRUCT_NAME(Arena) * arena) \
+{ \
+    ASSERT_RETURN(json_str && st && index, -1); \
+    INSTRUMENT_ENTER(type, INSTRUMENT_J2S) \
+    int rc = json_wrapper_index_build(index, json_str, len); \
+    GET_STRUCT_NAME(Reader) r; \
+    json_wrapper_reader_init(&r, json_str, len); \
+    r.arena = arena; \
+    r.index = index; \
+    if (0 == rc) rc = READER_2_MASK_FUNCTION_NAME(type)(&r, st, mask); \
+    INSTRUMENT_LEAVE(len, 0) \
+    return rc; \
+} \
+static inline int \
+PATCH_FUNCTION_NAME(type) \
+    (char * patch, GET_STRUCT_NAME(type) * st, GET_STRUCT_NAME(Arena) * arena); \
+inline int \
+PATCH_FUNCTION_NAME(type) \
+    (char * patch, GET_STRUCT_NAME(type) * st, GET_STRUCT_NAME(Arena) * arena) \
+{ \
+    ASSERT_RETURN(patch && st, -1); \
+    GET_STRUCT_NAME(Reader) r; \
+    json_wrapper_reader_init(&r, patch, strlen(patch)); \
+    r.arena = arena; \
+    r.patch = true; \
+    return READER_2_FUNCTION_NAME(type)(&r, st); \
+}
+/**************************************** DEFINE_READER_2_STRUCT  END  ****************************************/
+
+
+/**
+ * @brief Define the function names about converting struct to MessagePack data and back
+ */
+#define STRUCT_2_MSGPACK_FUNCTION_NAME(type) CONCAT(json_wrapper_msgpack_data_from_, GET_STRUCT_NAME(type))
+#define MSGPACK_2_FUNCTION_NAME(type) CONCAT(json_wrapper_msgpack_data_to_, GET_STRUCT_NAME(type))
+#define MSGPACK_2_ARENA_FUNCTION_NAME(type) CONCAT(json_wrapper_msgpack_data_arena_to_, GET_STRUCT_NAME(type))
+
+
+/**************************************** DEFINE_STRUCT_2_MSGPACK BEGIN ****************************************/
+/**
+ * @brief Define a function to write the struct as a MessagePack map keyed by the field names into a buffer
+ * @param type The type name of the struct
+ **/
+#define DEFINE_STRUCT_2_MSGPACK_KEY(buf, n) \
+    ASSERT_RETURN(0 == json_wrapper_msgpack_write_key(buf, #n, sizeof(#n) - 1), -1)
+#define DEFINE_STRUCT_2_MSGPACK__OBJ(buf, st, num, t, n) { \
+    DEFINE_STRUCT_2_MSGPACK_KEY(buf, n); \
+    ASSERT_RETURN(0 == STRUCT_2_MSGPACK_BUFFER(t, st, n, buf), -1); \
+}
+#define DEFINE_STRUCT_2_MSGPACK__ARRAY(buf, st, num, t, n) { \
+    DEFINE_STRUCT_2_MSGPACK_KEY(buf, n); \
+    ASSERT_RETURN(0 == json_wrapper_msgpack_write_array(buf, num), -1); \
+    int i = 0; \
+    for (; i < num; ++i) \
+    { \
+        ASSERT_RETURN(0 == STRUCT_2_MSGPACK_BUFFER(t, st, n[i], buf), -1); \
+    } \
+}
+#define DEFINE_STRUCT_2_MSGPACK__VA_ARRAY(buf, st, num, t, n) { \
+    DEFINE_STRUCT_2_MSGPACK_KEY(buf, n); \
+    size_t size_ = NULL != (st)->n.n ? (st)->n.size : 0; \
+    ASSERT_RETURN(0 == json_wrapper_msgpack_write_array(buf, size_), -1); \
+    size_t i = 0; \
+    for (; i < size_; ++i) \
+    { \
+        ASSERT_RETURN(0 == STRUCT_2_MSGPACK_BUFFER(t, st, n.n[i], buf), -1); \
+    } \
+}
+#define DEFINE_STRUCT_2_MSGPACK__FIXED_STRING(buf, st, num, t, n) { \
+    DEFINE_STRUCT_2_MSGPACK_KEY(buf, n); \
+    ASSERT_RETURN(0 == json_wrapper_msgpack_write_str(buf, (st)->n, json_wrapper_fixed_string_len((st)->n, num)), -1); \
+}
+#define DEFINE_STRUCT_2_MSGPACK__(buf, st, type, num, t, n) DEFINE_STRUCT_2_MSGPACK__##type(buf, st, num, t, n)
+#define DEFINE_STRUCT_2_MSGPACK_(buf, st, ...) \
+    CONCAT(EXPAND(DEFINE_STRUCT_2_MSGPACK_I JOIN_TYPES_EX((buf, st), ##__VA_ARGS__)), _END)
+#define DEFINE_STRUCT_2_MSGPACK_I(buf, st, type, num, t, n) DEFINE_STRUCT_2_MSGPACK__(buf, st, type, num, t, n) DEFINE_STRUCT_2_MSGPACK_II
+#define DEFINE_STRUCT_2_MSGPACK_II(buf, st, type, num, t, n) DEFINE_STRUCT_2_MSGPACK__(buf, st, type, num, t, n) DEFINE_STRUCT_2_MSGPACK_I
+#define DEFINE_STRUCT_2_MSGPACK_I_END
+#define DEFINE_STRUCT_2_MSGPACK_II_END
+#define DEFINE_STRUCT_2_MSGPACK(type, ...) \
+static inline int \
+STRUCT_2_MSGPACK_BUFFER_FUNCTION_NAME(type) \
+    (GET_STRUCT_NAME(type) * st, GET_STRUCT_NAME(Buffer) * buf); \
+inline int \
+STRUCT_2_MSGPACK_BUFFER_FUNCTION_NAME(type) \
+    (GET_STRUCT_NAME(type) * st, GET_STRUCT_NAME(Buffer) * buf) \
+{ \
+    ASSERT_RETURN(st && buf, -1); \
+    ASSERT_RETURN(0 == json_wrapper_msgpack_write_map(buf, GET_FIELD_COUNT(type)), -1); \
+    DEFINE_STRUCT_2_MSGPACK_(buf, st, ##__VA_ARGS__) \
+    return 0; \
+} \
+DEFINE_STRUCT_2_MSGPACK_DATA(type)
+
+/**
+ * @brief Define the function to convert the struct to MessagePack data on top of its buffer writer
+ * @param type The type name of the struct
+ **/
+#define DEFINE_STRUCT_2_MSGPACK_DATA(type) \
+static inline char * \
+STRUCT_2_MSGPACK_FUNCTION_NAME(type) \
+    (GET_STRUCT_NAME(type) * st, size_t * len); \
+inline char * \
+STRUCT_2_MSGPACK_FUNCTION_NAME(type) \
+    (GET_STRUCT_NAME(type) * st, size_t * len) \
+{ \
+    ASSERT_RETURN(st && len, NULL); \
+    GET_STRUCT_NAME(Buffer) buf; \
+    memset(&buf, 0, sizeof(GET_STRUCT_NAME(Buffer))); \
+    if (0 != STRUCT_2_MSGPACK_BUFFER_FUNCTION_NAME(type)(st, &buf)) \
+    { \
+        json_wrapper_buffer_release(&buf); \
+        return NULL; \
+    } \
+    *len = buf.len; \
+    return json_wrapper_buffer_detach(&buf); \
+}
+/**************************************** DEFINE_STRUCT_2_MSGPACK  END  ****************************************/
+
+
+/**************************************** DEFINE_MSGPACK_2_STRUCT BEGIN ****************************************/
+/**
+ * @brief Define a function to read the struct from a MessagePack map in one pass,
+ *        unknown keys and values of mismatched types are skipped without allocating
+ * @param type The type name of the struct
+ **/
+#define DEFINE_MSGPACK_2_STRUCT__OBJ(r, st, num, t, n) { \
+    ASSERT_RETURN(0 == MSGPACK_READER_2(t, r, &((st)->n)), -1); \
+}
+#define DEFINE_MSGPACK_2_STRUCT__ARRAY(r, st, num, t, n) { \
+    int c_ = json_wrapper_msgpack_peek(r); \
+    if (!JSON_WRAPPER_MSGPACK_IS_ARRAY(c_)) \
+    { \
+        ASSERT_RETURN(0 == json_wrapper_msgpack_skip(r), -1); \
+    } else \
+    { \
+        size_t count_ = 0; \
+        ASSERT_RETURN(0 == json_wrapper_msgpack_read_array(r, &count_), -1); \
+        size_t index_ = 0; \
+        for (; index_ < count_; ++index_) \
+        { \
+            if (index_ < num) \
+            { \
+                ASSERT_RETURN(0 == MSGPACK_READER_2(t, r, &((st)->n[index_])), -1); \
+            } else \
+            { \
+                ASSERT_RETURN(0 == json_wrapper_msgpack_skip(r), -1); \
+            } \
+        } \
+    } \
+}
+#define DEFINE_MSGPACK_2_STRUCT__VA_ARRAY(r, st, num, t, n) { \
+    int c_ = json_wrapper_msgpack_peek(r); \
+    if (!JSON_WRAPPER_MSGPACK_IS_ARRAY(c_)) \
+    { \
+        ASSERT_RETURN(0 == json_wrapper_msgpack_skip(r), -1); \
+    } else \
+    { \
+        size_t count_ = 0; \
+        ASSERT_RETURN(0 == json_wrapper_msgpack_read_array(r, &count_), -1); \
+        if (NULL == (r)->arena) RECYCLE_VA_ARRAY(st, num, t, n) \
+        (st)->n.n = NULL; \
+        (st)->n.size = 0; \
+        if (count_ > 0) \
+        { \
+            (st)->n.n = json_wrapper_alloc_from((r)->arena, sizeof(GET_STRUCT_NAME(t)) * count_); \
+            ASSERT_RETURN((st)->n.n, -1); \
+            memset((st)->n.n, 0, sizeof(GET_STRUCT_NAME(t)) * count_); \
+            (st)->n.size = count_; \
+        } \
+        size_t index_ = 0; \
+        for (; index_ < count_; ++index_) \
+        { \
+            ASSERT_RETURN(0 == MSGPACK_READER_2(t, r, &((st)->n.n[index_])), -1); \
+        } \
+    } \
+}
+#define DEFINE_MSGPACK_2_STRUCT__FIXED_STRING(r, st, num, t, n) { \
+    ASSERT_RETURN(0 == json_wrapper_msgpack_read_fixed(r, (st)->n, num), -1); \
+}
+#define DEFINE_MSGPACK_2_STRUCT__(r, st, stype, type, num, t, n) \
+    case GET_FIELD_INDEX(stype, n): DEFINE_MSGPACK_2_STRUCT__##type(r, st, num, t, n) break;
+#define DEFINE_MSGPACK_2_STRUCT_(r, st, stype, ...) \
+    CONCAT(EXPAND(DEFINE_MSGPACK_2_STRUCT_I JOIN_TYPES_EX((r, st, stype), ##__VA_ARGS__)), _END)
+#define DEFINE_MSGPACK_2_STRUCT_I(r, st, stype, type, num, t, n) DEFINE_MSGPACK_2_STRUCT__(r, st, stype, type, num, t, n) DEFINE_MSGPACK_2_STRUCT_II
+#define DEFINE_MSGPACK_2_STRUCT_II(r, st, stype, type, num, t, n) DEFINE_MSGPACK_2_STRUCT__(r, st, stype, type, num, t, n) DEFINE_MSGPACK_2_STRUCT_I
+#define DEFINE_MSGPACK_2_STRUCT_I_END
+#define DEFINE_MSGPACK_2_STRUCT_II_END
+#define DEFINE_MSGPACK_2_STRUCT(type, ...) \
+static inline int \
+MSGPACK_READER_2_FUNCTION_NAME(type) \
+    (GET_STRUCT_NAME(Reader) * r, GET_STRUCT_NAME(type) * st); \
+inline int \
+MSGPACK_READER_2_FUNCTION_NAME(type) \
+    (GET_STRUCT_NAME(Reader) * r, GET_STRUCT_NAME(type) * st) \
+{ \
+    ASSERT_RETURN(r && st, -1); \
+    int c = json_wrapper_msgpack_peek(r); \
+    ASSERT_RETURN(JSON_WRAPPER_MSGPACK_IS_MAP(c), json_wrapper_msgpack_skip(r)); \
+    size_t count = 0; \
+    ASSERT_RETURN(0 == json_wrapper_msgpack_read_map(r, &count), -1); \
+    size_t index = 0; \
+    size_t hint = 0; \
+    for (; index < count; ++index) \
+    { \
+        const char * key = NULL; \
+        size_t len = 0; \
+        ASSERT_RETURN(0 == json_wrapper_msgpack_read_key(r, &key, &len), -1); \
+        int field = FIELD_INDEX_FUNCTION_NAME(type)(key, len, hint); \
+        switch (field) \
+        { \
+            DEFINE_MSGPACK_2_STRUCT_(r, st, type, ##__VA_ARGS__) \
+            default: \
+                ASSERT_RETURN(0 == json_wrapper_msgpack_skip(r), -1); \
+                break; \
+        } \
+        if (field >= 0) hint = field + 1; \
+    } \
+    return 0; \
+} \
+DEFINE_MSGPACK_DATA_2_STRUCT(type)
+
+/**
+ * @brief Define the functions to convert MessagePack data to the struct on top of its reader
+ * @param type The type name of the struct
+ **/
+#define DEFINE_MSGPACK_DATA_2_STRUCT(type) \
+static inline int \
+MSGPACK_2_ARENA_FUNCTION_NAME(type) \
+    (const char * data, size_t len, GET_STRUCT_NAME(type) * st, GET_STRUCT_NAME(Arena) * arena); \
+inline int \
+MSGPACK_2_ARENA_FUNCTION_NAME(type) \
+    (const char * data, size_t len, GET_STRUCT_NAME(type) * st, GET_STRUCT_NAME(Arena) * arena) \
+{ \
+    ASSERT_RETURN(data && st, -1); \
+    GET_STRUCT_NAME(Reader) r; \
+    json_wrapper_reader_init(&r, data, len); \
+    r.arena = arena; \
+    return MSGPACK_READER_2_FUNCTION_NAME(type)(&r, st); \
+} \
+static inline int \
+MSGPACK_2_FUNCTION_NAME(type) \
+    (const char * data, size_t len, GET_STRUCT_NAME(type) * st); \
+inline int \
+MSGPACK_2_FUNCTION_NAME(type) \
+    (const char * data, size_t len, GET_STRUCT_NAME(type) * st) \
+{ \
+    return MSGPACK_2_ARENA_FUNCTION_NAME(type)(data, len, st, NULL); \
+}
+/**************************************** DEFINE_MSGPACK_2_STRUCT  END  ****************************************/
+
+
+/**
+ * @brief Define a function name about copying struct
+ */
+#define COPY_FUNCTION_NAME(type) CONCAT(json_wrapper_copy_, GET_STRUCT_NAME(type))
+
+/**
+ * @brief Define a function name about copying struct with the memory in an arena
+ */
+#define COPY_ARENA_FUNCTION_NAME(type) CONCAT(json_wrapper_copy_arena_, GET_STRUCT_NAME(type))
+
+
+/**************************************** COPY BEGIN ****************************************/
+/**
+ * @brief Copy value from src to dst
+ * @param type The type of the value
+ * @param src The src value
+ * @param dst The dst value
+ * @param arena The arena to alloc the strings and arrays of dst from, @p NULL for the hook in json wrapper
+ * 
+ * @note A string of @p NULL is copied as @p NULL, the old string of dst is freed if there's no arena
+ **/
+#define COPY(type, src, dst) COPY_FUNCTION_NAME(type)(src, dst)
+#define COPY_ARENA(type, src, dst, arena) COPY_ARENA_FUNCTION_NAME(type)(src, dst, arena)
+static inline void COPY_FUNCTION_NAME(BOOL)(GET_STRUCT_NAME(BOOL) * src, GET_STRUCT_NAME(BOOL) * dst);
+inline void COPY_FUNCTION_NAME(BOOL)(GET_STRUCT_NAME(BOOL) * src, GET_STRUCT_NAME(BOOL) * dst)
+{
+    ASSERT_RETURN_VOID(src && dst);
+    *dst = *src;
+}
+static inline void COPY_ARENA_FUNCTION_NAME(BOOL)(GET_STRUCT_NAME(BOOL) * src, GET_STRUCT_NAME(BOOL) * dst, GET_STRUCT_NAME(Arena) * arena);
+inline void COPY_ARENA_FUNCTION_NAME(BOOL)(GET_STRUCT_NAME(BOOL) * src, GET_STRUCT_NAME(BOOL) * dst, GET_STRUCT_NAME(Arena) * arena)
+{
+    COPY_FUNCTION_NAME(BOOL)(src, dst);
+}
+static inline void COPY_FUNCTION_NAME(CHAR)(GET_STRUCT_NAME(CHAR) * src, GET_STRUCT_NAME(CHAR) * dst);
+inline void COPY_FUNCTION_NAME(CHAR)(GET_STRUCT_NAME(CHAR) * src, GET_STRUCT_NAME(CHAR) * dst)
+{
+    ASSERT_RETURN_VOID(src && dst);
+    *dst = *src;
+}
+static inline void COPY_ARENA_FUNCTION_NAME(CHAR)(GET_STRUCT_NAME(CHAR) * src, GET_STRUCT_NAME(CHAR) * dst, GET_STRUCT_NAME(Arena) * arena);
+inline void COPY_ARENA_FUNCTION_NAME(CHAR)(GET_STRUCT_NAME(CHAR) * src, GET_STRUCT_NAME(CHAR) * dst, GET_STRUCT_NAME(Arena) * arena)
+{
+    COPY_FUNCTION_NAME(CHAR)(src, dst);
+}
+static inline void COPY_FUNCTION_NAME(INT)(GET_STRUCT_NAME(INT) * src, GET_STRUCT_NAME(INT) * dst);
+inline void COPY_FUNCTION_NAME(INT)(GET_STRUCT_NAME(INT) * src, GET_STRUCT_NAME(INT) * dst)
+{
+    ASSERT_RETURN_VOID(src && dst);
+    *dst = *src;
+}
+static inline void COPY_ARENA_FUNCTION_NAME(INT)(GET_STRUCT_NAME(INT) * src, GET_STRUCT_NAME(INT) * dst, GET_STRUCT_NAME(Arena) * arena);
+inline void COPY_ARENA_FUNCTION_NAME(INT)(GET_STRUCT_NAME(INT) * src, GET_STRUCT_NAME(INT) * dst, GET_STRUCT_NAME(Arena) * arena)
+{
+    COPY_FUNCTION_NAME(INT)(src, dst);
+}
+static inline void COPY_FUNCTION_NAME(INT64)(GET_STRUCT_NAME(INT64) * src, GET_STRUCT_NAME(INT64) * dst);
+inline void COPY_FUNCTION_NAME(INT64)(GET_STRUCT_NAME(INT64) * src, GET_STRUCT_NAME(INT64) * dst)
+{
+    ASSERT_RETURN_VOID(src && dst);
+    *dst = *src;
+}
+static inline void COPY_ARENA_FUNCTION_NAME(INT64)(GET_STRUCT_NAME(INT64) * src, GET_STRUCT_NAME(INT64) * dst, GET_STRUCT_NAME(Arena) * arena);
+inline void COPY_ARENA_FUNCTION_NAME(INT64)(GET_STRUCT_NAME(INT64) * src, GET_STRUCT_NAME(INT64) * dst, GET_STRUCT_NAME(Arena) * arena)
+{
+    COPY_FUNCTION_NAME(INT64)(src, dst);
+}
+static inline void COPY_FUNCTION_NAME(UINT32)(GET_STRUCT_NAME(UINT32) * src, GET_STRUCT_NAME(UINT32) * dst);
+inline void COPY_FUNCTION_NAME(UINT32)(GET_STRUCT_NAME(UINT32) * src, GET_STRUCT_NAME(UINT32) * dst)
+{
+    ASSERT_RETURN_VOID(src && dst);
+    *dst = *src;
+}
+static inline void COPY_ARENA_FUNCTION_NAME(UINT32)(GET_STRUCT_NAME(UINT32) * src, GET_STRUCT_NAME(UINT32) * dst, GET_STRUCT_NAME(Arena) * arena);
+inline void COPY_ARENA_FUNCTION_NAME(UINT32)(GET_STRUCT_NAME(UINT32) * src, GET_STRUCT_NAME(UINT32) * dst, GET_STRUCT_NAME(Arena) * arena)
+{
+    COPY_FUNCTION_NAME(UINT32)(src, dst);
+}
+static inline void COPY_FUNCTION_NAME(UINT64)(GET_STRUCT_NAME(UINT64) * src, GET_STRUCT_NAME(UINT64) * dst);
+inline void COPY_FUNCTION_NAME(UINT64)(GET_STRUCT_NAME(UINT64) * src, GET_STRUCT_NAME(UINT64) * dst)
+{
+    ASSERT_RETURN_VOID(src && dst);
+    *dst = *src;
+}
+static inline void COPY_ARENA_FUNCTION_NAME(UINT64)(GET_STRUCT_NAME(UINT64) * src, GET_STRUCT_NAME(UINT64) * dst, GET_STRUCT_NAME(Arena) * arena);
+inline void COPY_ARENA_FUNCTION_NAME(UINT64)(GET_STRUCT_NAME(UINT64) * src, GET_STRUCT_NAME(UINT64) * dst, GET_STRUCT_NAME(Arena) * arena)
+{
+    COPY_FUNCTION_NAME(UINT64)(src, dst);
+}
+static inline void COPY_FUNCTION_NAME(FLOAT)(GET_STRUCT_NAME(FLOAT) * src, GET_STRUCT_NAME(FLOAT) * dst);
+inline void COPY_FUNCTION_NAME(FLOAT)(GET_STRUCT_NAME(FLOAT) * src, GET_STRUCT_NAME(FLOAT) * dst)
+{
+    ASSERT_RETURN_VOID(src && dst);
+    *dst = *src;
+}
+static inline void COPY_ARENA_FUNCTION_NAME(FLOAT)(GET_STRUCT_NAME(FLOAT) * src, GET_STRUCT_NAME(FLOAT) * dst, GET_STRUCT_NAME(Arena) * arena);
+inline void COPY_ARENA_FUNCTION_NAME(FLOAT)(GET_STRUCT_NAME(FLOAT) * src, GET_STRUCT_NAME(FLOAT) * dst, GET_STRUCT_NAME(Arena) * arena)
+{
+    COPY_FUNCTION_NAME(FLOAT)(src, dst);
+}
+static inline void COPY_FUNCTION_NAME(DOUBLE)(GET_STRUCT_NAME(DOUBLE) * src, GET_STRUCT_NAME(DOUBLE) * dst);
+inline void COPY_FUNCTION_NAME(DOUBLE)(GET_STRUCT_NAME(DOUBLE) * src, GET_STRUCT_NAME(DOUBLE) * dst)
+{
+    ASSERT_RETURN_VOID(src && dst);
+    *dst = *src;
+}
+static inline void COPY_ARENA_FUNCTION_NAME(DOUBLE)(GET_STRUCT_NAME(DOUBLE) * src, GET_STRUCT_NAME(DOUBLE) * dst, GET_STRUCT_NAME(Arena) * arena);
+inline void COPY_ARENA_FUNCTION_NAME(DOUBLE)(GET_STRUCT_NAME(DOUBLE) * src, GET_STRUCT_NAME(DOUBLE) * dst, GET_STRUCT_NAME(Arena) * arena)
+{
+    COPY_FUNCTION_NAME(DOUBLE)(src, dst);
+}
+void COPY_FUNCTION_NAME(STRING)(GET_STRUCT_NAME(STRING) * src, GET_STRUCT_NAME(STRING) * dst);
+void COPY_ARENA_FUNCTION_NAME(STRING)(GET_STRUCT_NAME(STRING) * src, GET_STRUCT_NAME(STRING) * dst, GET_STRUCT_NAME(Arena) * arena);
+/**
+ * @note A view is copied shallowly, the copy points into the same memory
+ */
+static inline void COPY_FUNCTION_NAME(STRING_VIEW)(GET_STRUCT_NAME(STRING_VIEW) * src, GET_STRUCT_NAME(STRING_VIEW) * dst);
+inline void COPY_FUNCTION_NAME(STRING_VIEW)(GET_STRUCT_NAME(STRING_VIEW) * src, GET_STRUCT_NAME(STRING_VIEW) * dst)
+{
+    ASSERT_RETURN_VOID(src && dst);
+    *dst = *src;
+}
+static inline void COPY_ARENA_FUNCTION_NAME(STRING_VIEW)(GET_STRUCT_NAME(STRING_VIEW) * src, GET_STRUCT_NAME(STRING_VIEW) * dst, GET_STRUCT_NAME(Arena) * arena);
+inline void COPY_ARENA_FUNCTION_NAME(STRING_VIEW)(GET_STRUCT_NAME(STRING_VIEW) * src, GET_STRUCT_NAME(STRING_VIEW) * dst, GET_STRUCT_NAME(Arena) * arena)
+{
+    COPY_FUNCTION_NAME(STRING_VIEW)(src, dst);
+}
+/**************************************** COPY  END  ****************************************/
+
+
+/**************************************** DEFINE_COPY_STRUCT BEGIN ****************************************/
+/**
+ * @brief Define the functions to copy the struct deeply, the strings and VA_ARRAY buffers of dst are alloced
+ *        from the arena or using the hook in json wrapper, the old VA_ARRAY buffers of dst are recycled in the latter case.
+ *        Copying a struct onto itself does nothing
+ * @param type The type name of the struct
+ **/
+#define COPY_OBJ(src, dst, arena, num, t, n) COPY_ARENA(t, &((src)->n), &((dst)->n), arena);
+#define COPY_ARRAY(src, dst, arena, num, t, n) { \
     int i = 0; \
     for (; i < num; ++i) \
     { \
-        cJSON * obj = STRUCT_2(t, st, n[i]); \
-        ASSERT_BREAK(obj); \
-        cJSON_AddItemToArray(json, obj); \
+        COPY_ARENA(t, &((src)->n[i]), &((dst)->n[i]), arena); \
     } \
-    cJSON_AddItemToObject(json, #n, array_); \
 }
-#define DEFINE_STRUCT_2_JSON__VA_ARRAY(json, st, num, t, n) { \
-    cJSON * array_ = cJSON_CreateArray(); \
-    ASSERT_BREAK(array_); \
-    if (NULL != (st)->n.n) \
+#define COPY_VA_ARRAY(src, dst, arena, num, t, n) { \
+    if (NULL == arena) RECYCLE_VA_ARRAY(dst, num, t, n) \
+    (dst)->n.n = NULL; \
+    (dst)->n.size = 0; \
+    if (NULL != (src)->n.n && (src)->n.size > 0) \
     { \
-        int i = 0; \
-        for (; i < (st)->n.size; ++i) \
+        (dst)->n.n = json_wrapper_alloc_from(arena, sizeof(GET_STRUCT_NAME(t)) * (src)->n.size); \
+        if (NULL != (dst)->n.n) \
         { \
-            cJSON * obj = STRUCT_2(t, st, n.n[i]); \
-            ASSERT_BREAK(obj); \
-            cJSON_AddItemToArray(json, obj); \
+            memset((dst)->n.n, 0, sizeof(GET_STRUCT_NAME(t)) * (src)->n.size); \
+            (dst)->n.size = (src)->n.size; \
+            size_t i = 0; \
+            for (; i < (src)->n.size; ++i) \
+            { \
+                COPY_ARENA(t, &((src)->n.n[i]), &((dst)->n.n[i]), arena); \
+            } \
         } \
     } \
-    cJSON_AddItemToObject(json, #n, array_); \
 }
-#define DEFINE_STRUCT_2_JSON__(json, st, type, num, t, n) DEFINE_STRUCT_2_JSON__##type(json, st, num, t, n)
-#define DEFINE_STRUCT_2_JSON_(json, st, ...) \
-    CONCAT(EXPAND(DEFINE_STRUCT_2_JSON_I JOIN_TYPES_EX((json, st), ##__VA_ARGS__)), _END)
-#define DEFINE_STRUCT_2_JSON_I(json, st, type, num, t, n) DEFINE_STRUCT_2_JSON__(json, st, type, num, t, n) DEFINE_STRUCT_2_JSON_II
-#define DEFINE_STRUCT_2_JSON_II(json, st, type, num, t, n) DEFINE_STRUCT_2_JSON__(json, st, type, num, t, n) DEFINE_STRUCT_2_JSON_I
-#define DEFINE_STRUCT_2_JSON_I_END
-#define DEFINE_STRUCT_2_JSON_II_END
-#define DEFINE_STRUCT_2_JSON(type, ...) \
+#define COPY_FIXED_STRING(src, dst, arena, num, t, n) memcpy((dst)->n, (src)->n, num);
+#define DEFINE_COPY_STRUCT__(src, dst, arena, type, num, t, n) COPY_##type(src, dst, arena, num, t, n)
+#define DEFINE_COPY_STRUCT_(src, dst, arena, ...) \
+    CONCAT(EXPAND(DEFINE_COPY_STRUCT_I JOIN_TYPES_EX((src, dst, arena), ##__VA_ARGS__)), _END)
+#define DEFINE_COPY_STRUCT_I(src, dst, arena, type, num, t, n) DEFINE_COPY_STRUCT__(src, dst, arena, type, num, t, n) DEFINE_COPY_STRUCT_II
+#define DEFINE_COPY_STRUCT_II(src, dst, arena, type, num, t, n) DEFINE_COPY_STRUCT__(src, dst, arena, type, num, t, n) DEFINE_COPY_STRUCT_I
+#define DEFINE_COPY_STRUCT_I_END
+#define DEFINE_COPY_STRUCT_II_END
+#define DEFINE_COPY_STRUCT(type, ...) \
+static inline void \
+COPY_ARENA_FUNCTION_NAME(type) \
+    (GET_STRUCT_NAME(type) * src, GET_STRUCT_NAME(type) * dst, GET_STRUCT_NAME(Arena) * arena); \
+inline void \
+COPY_ARENA_FUNCTION_NAME(type) \
+    (GET_STRUCT_NAME(type) * src, GET_STRUCT_NAME(type) * dst, GET_STRUCT_NAME(Arena) * arena) \
+{ \
+    ASSERT_RETURN_VOID(src && dst && src != dst); \
+    INSTRUMENT_ENTER(type, INSTRUMENT_COPY) \
+    DEFINE_COPY_STRUCT_(src, dst, arena, ##__VA_ARGS__) \
+    INSTRUMENT_LEAVE(0, 0) \
+} \
+DEFINE_COPY_STRUCT_HEAP(type)
+
+/**
+ * @brief Define the function to copy the struct deeply using the hook in json wrapper on top of its arena copy
+ * @param type The type name of the struct
+ **/
+#define DEFINE_COPY_STRUCT_HEAP(type) \
+static inline void \
+COPY_FUNCTION_NAME(type) \
+    (GET_STRUCT_NAME(type) * src, GET_STRUCT_NAME(type) * dst); \
+inline void \
+COPY_FUNCTION_NAME(type) \
+    (GET_STRUCT_NAME(type) * src, GET_STRUCT_NAME(type) * dst) \
+{ \
+    COPY_ARENA_FUNCTION_NAME(type)(src, dst, NULL); \
+}
+/**************************************** DEFINE_COPY_STRUCT  END  ****************************************/
+
+
+/**
+ * @brief Define a function name about recycling struct
+ */
+#define RECYCLE_FUNCTION_NAME(type) CONCAT(json_wrapper_recycle_, GET_STRUCT_NAME(type))
+
+
+/**************************************** RECYCLE BEGIN ****************************************/
+/**
+ * @brief Recycle a wrapper type object
+ **/
+#define RECYCLE(type, ptr) RECYCLE_FUNCTION_NAME(type)(ptr)
+static inline void RECYCLE_FUNCTION_NAME(BOOL)(GET_STRUCT_NAME(BOOL) * ptr);
+inline void RECYCLE_FUNCTION_NAME(BOOL)(GET_STRUCT_NAME(BOOL) * ptr)
+{}
+static inline void RECYCLE_FUNCTION_NAME(CHAR)(GET_STRUCT_NAME(CHAR) * ptr);
+inline void RECYCLE_FUNCTION_NAME(CHAR)(GET_STRUCT_NAME(CHAR) * ptr)
+{}
+static inline void RECYCLE_FUNCTION_NAME(INT)(GET_STRUCT_NAME(INT) * ptr);
+inline void RECYCLE_FUNCTION_NAME(INT)(GET_STRUCT_NAME(INT) * ptr)
+{}
+static inline void RECYCLE_FUNCTION_NAME(INT64)(GET_STRUCT_NAME(INT64) * ptr);
+inline void RECYCLE_FUNCTION_NAME(INT64)(GET_STRUCT_NAME(INT64) * ptr)
+{}
+static inline void RECYCLE_FUNCTION_NAME(UINT32)(GET_STRUCT_NAME(UINT32) * ptr);
+inline void RECYCLE_FUNCTION_NAME(UINT32)(GET_STRUCT_NAME(UINT32) * ptr)
+{}
+static inline void RECYCLE_FUNCTION_NAME(UINT64)(GET_STRUCT_NAME(UINT64) * ptr);
+inline void RECYCLE_FUNCTION_NAME(UINT64)(GET_STRUCT_NAME(UINT64) * ptr)
+{}
+static inline void RECYCLE_FUNCTION_NAME(FLOAT)(GET_STRUCT_NAME(FLOAT) * ptr);
+inline void RECYCLE_FUNCTION_NAME(FLOAT)(GET_STRUCT_NAME(FLOAT) * ptr)
+{}
+static inline void RECYCLE_FUNCTION_NAME(DOUBLE)(GET_STRUCT_NAME(DOUBLE) * ptr);
+inline void RECYCLE_FUNCTION_NAME(DOUBLE)(GET_STRUCT_NAME(DOUBLE) * ptr)
+{}
+void RECYCLE_FUNCTION_NAME(STRING)(GET_STRUCT_NAME(STRING) * ptr);
+static inline void RECYCLE_FUNCTION_NAME(STRING_VIEW)(GET_STRUCT_NAME(STRING_VIEW) * ptr);
+inline void RECYCLE_FUNCTION_NAME(STRING_VIEW)(GET_STRUCT_NAME(STRING_VIEW) * ptr)
+{}
+/**************************************** RECYCLE  END  ****************************************/
+
+
+/**************************************** DEFINE_RECYCLE_STRUCT BEGIN ****************************************/
+#define RECYCLE_OBJ(ptr, num, t, n) RECYCLE(t, &((ptr)->n));
+#define RECYCLE_ARRAY(ptr, num, t, n) { \
+    int i = 0; \
+    for (; i < num; ++i) \
+    { \
+        RECYCLE(t, &((ptr)->n[i])); \
+    } \
+}
+#define RECYCLE_VA_ARRAY(ptr, num, t, n) { \
+    int i = 0; \
+    for (; i < (ptr)->n.size; ++i) \
+    { \
+        RECYCLE(t, &((ptr)->n.n[i])); \
+    } \
+    json_wrapper_free((ptr)->n.n); \
+    (ptr)->n.n = NULL; \
+    (ptr)->n.size = 0; \
+}
+#define RECYCLE_FIXED_STRING(ptr, num, t, n)
+#define DEFINE_RECYCLE_STRUCT__(ptr, type, num, t, n) RECYCLE_##type(ptr, num, t, n)
+#define DEFINE_RECYCLE_STRUCT_(ptr, ...) \
+    CONCAT(EXPAND(DEFINE_RECYCLE_STRUCT_I JOIN_TYPES_EX((ptr), ##__VA_ARGS__)), _END)
+#define DEFINE_RECYCLE_STRUCT_I(ptr, type, num, t, n) DEFINE_RECYCLE_STRUCT__(ptr, type, num, t, n) DEFINE_RECYCLE_STRUCT_II
+#define DEFINE_RECYCLE_STRUCT_II(ptr, type, num, t, n) DEFINE_RECYCLE_STRUCT__(ptr, type, num, t, n) DEFINE_RECYCLE_STRUCT_I
+#define DEFINE_RECYCLE_STRUCT_I_END
+#define DEFINE_RECYCLE_STRUCT_II_END
+#define DEFINE_RECYCLE_STRUCT(type, ...) \
+static inline void \
+RECYCLE_FUNCTION_NAME(type) \
+    (GET_STRUCT_NAME(type) * ptr); \
+inline void \
+RECYCLE_FUNCTION_NAME(type) \
+    (GET_STRUCT_NAME(type) * ptr) \
+{ \
+    ASSERT_RETURN_VOID(ptr); \
+    INSTRUMENT_ENTER(type, INSTRUMENT_RECYCLE) \
+    DEFINE_RECYCLE_STRUCT_(ptr, ##__VA_ARGS__) \
+    INSTRUMENT_LEAVE(0, 0) \
+} \
+DEFINE_MOVE_STRUCT(type)
+/**************************************** DEFINE_RECYCLE_STRUCT  END  ****************************************/
+
+
+/**
+ * @brief Define a function name about moving struct
+ */
+#define MOVE_FUNCTION_NAME(type) CONCAT(json_wrapper_move_, GET_STRUCT_NAME(type))
+
+
+/**************************************** DEFINE_MOVE_STRUCT BEGIN ****************************************/
+/**
+ * @brief Define the function to move the struct from src to dst without copying any string or array:
+ *        dst is recycled, takes over the strings and VA_ARRAY buffers of src, and src is left zeroed
+ * @param type The type name of the struct
+ * 
+ * @note The strings and arrays of dst must not be from an arena, which can't be recycled,
+ *       reset such a dst to zero before the move instead
+ **/
+#define DEFINE_MOVE_STRUCT(type) \
+static inline void \
+MOVE_FUNCTION_NAME(type) \
+    (GET_STRUCT_NAME(type) * src, GET_STRUCT_NAME(type) * dst); \
+inline void \
+MOVE_FUNCTION_NAME(type) \
+    (GET_STRUCT_NAME(type) * src, GET_STRUCT_NAME(type) * dst) \
+{ \
+    ASSERT_RETURN_VOID(src && dst && src != dst); \
+    RECYCLE_FUNCTION_NAME(type)(dst); \
+    memcpy(dst, src, sizeof(GET_STRUCT_NAME(type))); \
+    memset(src, 0, sizeof(GET_STRUCT_NAME(type))); \
+}
+/**************************************** DEFINE_MOVE_STRUCT  END  ****************************************/
+
+
+/**
+ * @brief Define the function names about comparing structs and writing the json merge patch between them
+ */
+#define EQUAL_FUNCTION_NAME(type) CONCAT(json_wrapper_equal_, GET_STRUCT_NAME(type))
+#define DIFF_BUFFER_FUNCTION_NAME(type) CONCAT(json_wrapper_diff_buffer_, GET_STRUCT_NAME(type))
+#define DIFF_FUNCTION_NAME(type) CONCAT(json_wrapper_diff_, GET_STRUCT_NAME(type))
+
+
+/**************************************** DIFF BEGIN ****************************************/
+/**
+ * @brief Compare two wrapper type objects deeply, or write the json merge patch value which turns @p old into @p value
+ *        into a buffer, which is @p 1 if a value is written, @p 0 if they are equal and @p -1 for failure
+ * @param type The type of the values
+ * @param a The value
+ * @param b The other value
+ * @param buf The buffer
+ * 
+ * @note A string of @p NULL is written as null, which resets the string when the patch is applied
+ **/
+#define EQUAL(type, a, b) EQUAL_FUNCTION_NAME(type)(a, b)
+#define DIFF_BUFFER(type, old, value, buf) DIFF_BUFFER_FUNCTION_NAME(type)(old, value, buf)
+static inline bool EQUAL_FUNCTION_NAME(BOOL)(GET_STRUCT_NAME(BOOL) * a, GET_STRUCT_NAME(BOOL) * b);
+inline bool EQUAL_FUNCTION_NAME(BOOL)(GET_STRUCT_NAME(BOOL) * a, GET_STRUCT_NAME(BOOL) * b)
+{
+    return *a == *b;
+}
+static inline bool EQUAL_FUNCTION_NAME(CHAR)(GET_STRUCT_NAME(CHAR) * a, GET_STRUCT_NAME(CHAR) * b);
+inline bool EQUAL_FUNCTION_NAME(CHAR)(GET_STRUCT_NAME(CHAR) * a, GET_STRUCT_NAME(CHAR) * b)
+{
+    return *a == *b;
+}
+static inline bool EQUAL_FUNCTION_NAME(INT)(GET_STRUCT_NAME(INT) * a, GET_STRUCT_NAME(INT) * b);
+inline bool EQUAL_FUNCTION_NAME(INT)(GET_STRUCT_NAME(INT) * a, GET_STRUCT_NAME(INT) * b)
+{
+    return *a == *b;
+}
+static inline bool EQUAL_FUNCTION_NAME(INT64)(GET_STRUCT_NAME(INT64) * a, GET_STRUCT_NAME(INT64) * b);
+inline bool EQUAL_FUNCTION_NAME(INT64)(GET_STRUCT_NAME(INT64) * a, GET_STRUCT_NAME(INT64) * b)
+{
+    return *a == *b;
+}
+static inline bool EQUAL_FUNCTION_NAME(UINT32)(GET_STRUCT_NAME(UINT32) * a, GET_STRUCT_NAME(UINT32) * b);
+inline bool EQUAL_FUNCTION_NAME(UINT32)(GET_STRUCT_NAME(UINT32) * a, GET_STRUCT_NAME(UINT32) * b)
+{
+    return *a == *b;
+}
+static inline bool EQUAL_FUNCTION_NAME(UINT64)(GET_STRUCT_NAME(UINT64) * a, GET_STRUCT_NAME(UINT64) * b);
+inline bool EQUAL_FUNCTION_NAME(UINT64)(GET_STRUCT_NAME(UINT64) * a, GET_STRUCT_NAME(UINT64) * b)
+{
+    return *a == *b;
+}
+static inline bool EQUAL_FUNCTION_NAME(FLOAT)(GET_STRUCT_NAME(FLOAT) * a, GET_STRUCT_NAME(FLOAT) * b);
+inline bool EQUAL_FUNCTION_NAME(FLOAT)(GET_STRUCT_NAME(FLOAT) * a, GET_STRUCT_NAME(FLOAT) * b)
+{
+    return *a == *b;
+}
+static inline bool EQUAL_FUNCTION_NAME(DOUBLE)(GET_STRUCT_NAME(DOUBLE) * a, GET_STRUCT_NAME(DOUBLE) * b);
+inline bool EQUAL_FUNCTION_NAME(DOUBLE)(GET_STRUCT_NAME(DOUBLE) * a, GET_STRUCT_NAME(DOUBLE) * b)
+{
+    return *a == *b;
+}
+static inline bool EQUAL_FUNCTION_NAME(STRING)(GET_STRUCT_NAME(STRING) * a, GET_STRUCT_NAME(STRING) * b);
+inline bool EQUAL_FUNCTION_NAME(STRING)(GET_STRUCT_NAME(STRING) * a, GET_STRUCT_NAME(STRING) * b)
+{
+    return *a == *b || (NULL != *a && NULL != *b && 0 == strcmp(*a, *b));
+}
+static inline bool EQUAL_FUNCTION_NAME(STRING_VIEW)(GET_STRUCT_NAME(STRING_VIEW) * a, GET_STRUCT_NAME(STRING_VIEW) * b);
+inline bool EQUAL_FUNCTION_NAME(STRING_VIEW)(GET_STRUCT_NAME(STRING_VIEW) * a, GET_STRUCT_NAME(STRING_VIEW) * b)
+{
+    ASSERT_RETURN(NULL != a->ptr && NULL != b->ptr, a->ptr == b->ptr);
+    return a->len == b->len && 0 == memcmp(a->ptr, b->ptr, a->len);
+}
+#define DEFINE_DIFF_BASE(type) \
+static inline int DIFF_BUFFER_FUNCTION_NAME(type)(GET_STRUCT_NAME(type) * old, GET_STRUCT_NAME(type) * value, \
+    GET_STRUCT_NAME(Buffer) * buf); \
+inline int DIFF_BUFFER_FUNCTION_NAME(type)(GET_STRUCT_NAME(type) * old, GET_STRUCT_NAME(type) * value, \
+    GET_STRUCT_NAME(Buffer) * buf) \
+{ \
+    ASSERT_RETURN(!EQUAL_FUNCTION_NAME(type)(old, value), 0); \
+    return 0 == STRUCT_2_BUFFER_FUNCTION_NAME(type)(value, buf) ? 1 : -1; \
+}
+DEFINE_DIFF_BASE(BOOL)
+DEFINE_DIFF_BASE(CHAR)
+DEFINE_DIFF_BASE(INT)
+DEFINE_DIFF_BASE(INT64)
+DEFINE_DIFF_BASE(UINT32)
+DEFINE_DIFF_BASE(UINT64)
+DEFINE_DIFF_BASE(FLOAT)
+DEFINE_DIFF_BASE(DOUBLE)
+DEFINE_DIFF_BASE(STRING)
+DEFINE_DIFF_BASE(STRING_VIEW)
+/**************************************** DIFF  END  ****************************************/
+
+
+/**************************************** DEFINE_DIFF_STRUCT BEGIN ****************************************/
+/**
+ * @brief Define the functions to compare the struct deeply, and to write the json merge patch (RFC 7386)
+ *        which turns an old struct into a new one into a buffer. Only the changed fields are written,
+ *        a struct field as the patch of its changed fields, an array field as the whole new array
+ *        since a merge patch replaces arrays
+ * @param type The type name of the struct
+ **/
+#define EQUAL_OBJ(a, b, equal, num, t, n) equal = EQUAL(t, &((a)->n), &((b)->n));
+#define EQUAL_ARRAY(a, b, equal, num, t, n) { \
+    int i = 0; \
+    for (equal = true; equal && i < num; ++i) \
+    { \
+        equal = EQUAL(t, &((a)->n[i]), &((b)->n[i])); \
+    } \
+}
+#define EQUAL_VA_ARRAY(a, b, equal, num, t, n) { \
+    size_t size_ = NULL != (a)->n.n ? (a)->n.size : 0; \
+    size_t i = 0; \
+    for (equal = size_ == (NULL != (b)->n.n ? (b)->n.size : 0); equal && i < size_; ++i) \
+    { \
+        equal = EQUAL(t, &((a)->n.n[i]), &((b)->n.n[i])); \
+    } \
+}
+#define EQUAL_FIXED_STRING(a, b, equal, num, t, n) equal = 0 == strncmp((a)->n, (b)->n, num);
+#define DEFINE_EQUAL_STRUCT__(a, b, equal, type, num, t, n) EQUAL_##type(a, b, equal, num, t, n) ASSERT_RETURN(equal, false);
+#define DEFINE_EQUAL_STRUCT_(a, b, equal, ...) \
+    CONCAT(EXPAND(DEFINE_EQUAL_STRUCT_I JOIN_TYPES_EX((a, b, equal), ##__VA_ARGS__)), _END)
+#define DEFINE_EQUAL_STRUCT_I(a, b, equal, type, num, t, n) DEFINE_EQUAL_STRUCT__(a, b, equal, type, num, t, n) DEFINE_EQUAL_STRUCT_II
+#define DEFINE_EQUAL_STRUCT_II(a, b, equal, type, num, t, n) DEFINE_EQUAL_STRUCT__(a, b, equal, type, num, t, n) DEFINE_EQUAL_STRUCT_I
+#define DEFINE_EQUAL_STRUCT_I_END
+#define DEFINE_EQUAL_STRUCT_II_END
+#define DIFF_OBJ(old, st, buf, num, t, n) { \
+    size_t key_ = (buf)->len; \
+    DEFINE_STRUCT_2_BUFFER_KEY(buf, n); \
+    int rc_ = DIFF_BUFFER(t, &((old)->n), &((st)->n), buf); \
+    ASSERT_RETURN(rc_ >= 0, -1); \
+    if (0 == rc_) (buf)->len = key_; \
+}
+#define DIFF_WHOLE(old, st, buf, kind, num, t, n) { \
+    bool equal_ = true; \
+    EQUAL_##kind(old, st, equal_, num, t, n) \
+    if (!equal_) DEFINE_STRUCT_2_BUFFER__##kind(buf, st, num, t, n) \
+}
+#define DIFF_ARRAY(old, st, buf, num, t, n) DIFF_WHOLE(old, st, buf, ARRAY, num, t, n)
+#define DIFF_VA_ARRAY(old, st, buf, num, t, n) DIFF_WHOLE(old, st, buf, VA_ARRAY, num, t, n)
+#define DIFF_FIXED_STRING(old, st, buf, num, t, n) DIFF_WHOLE(old, st, buf, FIXED_STRING, num, t, n)
+#define DEFINE_DIFF_STRUCT__(old, st, buf, type, num, t, n) DIFF_##type(old, st, buf, num, t, n)
+#define DEFINE_DIFF_STRUCT_(old, st, buf, ...) \
+    CONCAT(EXPAND(DEFINE_DIFF_STRUCT_I JOIN_TYPES_EX((old, st, buf), ##__VA_ARGS__)), _END)
+#define DEFINE_DIFF_STRUCT_I(old, st, buf, type, num, t, n) DEFINE_DIFF_STRUCT__(old, st, buf, type, num, t, n) DEFINE_DIFF_STRUCT_II
+#define DEFINE_DIFF_STRUCT_II(old, st, buf, type, num, t, n) DEFINE_DIFF_STRUCT__(old, st, buf, type, num, t, n) DEFINE_DIFF_STRUCT_I
+#define DEFINE_DIFF_STRUCT_I_END
+#define DEFINE_DIFF_STRUCT_II_END
+#define DEFINE_DIFF_STRUCT(type, ...) \
+static inline bool \
+EQUAL_FUNCTION_NAME(type) \
+    (GET_STRUCT_NAME(type) * a, GET_STRUCT_NAME(type) * b); \
+inline bool \
+EQUAL_FUNCTION_NAME(type) \
+    (GET_STRUCT_NAME(type) * a, GET_STRUCT_NAME(type) * b) \
+{ \
+    ASSERT_RETURN(a && b, a == b); \
+    bool equal = true; \
+    DEFINE_EQUAL_STRUCT_(a, b, equal, ##__VA_ARGS__) \
+    return equal; \
+} \
+static inline int \
+DIFF_BUFFER_FUNCTION_NAME(type) \
+    (GET_STRUCT_NAME(type) * old, GET_STRUCT_NAME(type) * st, GET_STRUCT_NAME(Buffer) * buf); \
+inline int \
+DIFF_BUFFER_FUNCTION_NAME(type) \
+    (GET_STRUCT_NAME(type) * old, GET_STRUCT_NAME(type) * st, GET_STRUCT_NAME(Buffer) * buf) \
+{ \
+    ASSERT_RETURN(old && st && buf, -1); \
+    size_t start = buf->len; \
+    DEFINE_DIFF_STRUCT_(old, st, buf, ##__VA_ARGS__) \
+    ASSERT_RETURN(buf->len != start, 0); \
+    return 0 == json_wrapper_buffer_close_object(buf, start) ? 1 : -1; \
+} \
+DEFINE_DIFF_STRUCT_STR(type)
+
+/**
+ * @brief Define the function to write the json merge patch between two structs as a string on top of its buffer writer
+ * @param type The type name of the struct
+ **/
+#define DEFINE_DIFF_STRUCT_STR(type) \
+static inline char * \
+DIFF_FUNCTION_NAME(type) \
+    (GET_STRUCT_NAME(type) * old, GET_STRUCT_NAME(type) * st); \
+inline char * \
+DIFF_FUNCTION_NAME(type) \
+    (GET_STRUCT_NAME(type) * old, GET_STRUCT_NAME(type) * st) \
+{ \
+    ASSERT_RETURN(old && st, NULL); \
+    GET_STRUCT_NAME(Buffer) buf; \
+    memset(&buf, 0, sizeof(GET_STRUCT_NAME(Buffer))); \
+    int rc = DIFF_BUFFER_FUNCTION_NAME(type)(old, st, &buf); \
+    if (0 == rc) rc = json_wrapper_buffer_append(&buf, "{}", 2); \
+    if (rc < 0) \
+    { \
+        json_wrapper_buffer_release(&buf); \
+        return NULL; \
+    } \
+    return json_wrapper_buffer_detach(&buf); \
+}
+/**************************************** DEFINE_DIFF_STRUCT  END  ****************************************/
+
+
+/**
+ * @brief Define a function name to decode the next NDJSON record of a line source into wrapper struct
+ */
+#define NDJSON_2_FUNCTION_NAME(type) CONCAT(json_wrapper_ndjson_to_, GET_STRUCT_NAME(type))
+
+/**
+ * @brief Define the function names to decode NDJSON text into an array of wrapper structs on worker threads
+ */
+#define NDJSON_PARALLEL_2_FUNCTION_NAME(type) CONCAT(json_wrapper_ndjson_parallel_to_, GET_STRUCT_NAME(type))
+#define PARALLEL_DECODE_FUNCTION_NAME(type) CONCAT(json_wrapper_parallel_decode_, GET_STRUCT_NAME(type))
+
+
+/**************************************** DEFINE_NDJSON_2_STRUCT BEGIN ****************************************/
+/**
+ * @brief Define a function to decode the next non-empty line of a line source into the struct,
+ *        and a function to decode all the lines of NDJSON text into an array of the struct on worker threads
+ * @param type The type name of the struct
+ *
+ * @note The struct is recycled before each record, or only cleared if the line source has an arena,
+ *       so no field is left over from the record before. The string views of a record read from a file
+ *       descriptor or a mapped file are valid until the next call
+ * @note A record is a line of one object, only whitespace may follow it, any other line fails
+ **/
+#define DEFINE_NDJSON_2_STRUCT(type) \
+static inline int \
+NDJSON_2_FUNCTION_NAME(type) \
+    (GET_STRUCT_NAME(Lines) * lines, GET_STRUCT_NAME(type) * st); \
+inline int \
+NDJSON_2_FUNCTION_NAME(type) \
+    (GET_STRUCT_NAME(Lines) * lines, GET_STRUCT_NAME(type) * st) \
+{ \
+    ASSERT_RETURN(lines && st, -1); \
+    const char * line = NULL; \
+    size_t len = 0; \
+    int rc = 0; \
+    GET_STRUCT_NAME(Reader) r; \
+    while (1 == (rc = json_wrapper_lines_next(lines, &line, &len))) \
+    { \
+        json_wrapper_reader_init(&r, line, len); \
+        if (-1 == json_wrapper_reader_peek(&r)) continue; \
+        r.arena = lines->arena; \
+        r.writable = lines->fd >= 0 || lines->mapped; \
+        if (NULL == r.arena) RECYCLE_FUNCTION_NAME(type)(st); \
+        memset(st, 0, sizeof(GET_STRUCT_NAME(type))); \
+        ASSERT_RETURN('{' == json_wrapper_reader_peek(&r), -1); \
+        ASSERT_RETURN(0 == READER_2_MASK_FUNCTION_NAME(type)(&r, st, lines->mask), -1); \
+        ASSERT_RETURN(-1 == json_wrapper_reader_peek(&r), -1); \
+        return 1; \
+    } \
+    return rc; \
+} \
+static inline int \
+PARALLEL_DECODE_FUNCTION_NAME(type) \
+    (GET_STRUCT_NAME(Reader) * r, void * st); \
+inline int \
+PARALLEL_DECODE_FUNCTION_NAME(type) \
+    (GET_STRUCT_NAME(Reader) * r, void * st) \
+{ \
+    ASSERT_RETURN('{' == json_wrapper_reader_peek(r), -1); \
+    ASSERT_RETURN(0 == READER_2_FUNCTION_NAME(type)(r, st), -1); \
+    return -1 == json_wrapper_reader_peek(r) ? 0 : -1; \
+} \
+static inline int \
+NDJSON_PARALLEL_2_FUNCTION_NAME(type) \
+    (const char * data, size_t len, GET_STRUCT_NAME(type) * array, size_t count, \
+     const GET_STRUCT_NAME(Parallel) * options, size_t * records); \
+inline int \
+NDJSON_PARALLEL_2_FUNCTION_NAME(type) \
+    (const char * data, size_t len, GET_STRUCT_NAME(type) * array, size_t count, \
+     const GET_STRUCT_NAME(Parallel) * options, size_t * records) \
+{ \
+    return json_wrapper_parallel_decode(data, len, array, sizeof(GET_STRUCT_NAME(type)), count, \
+        PARALLEL_DECODE_FUNCTION_NAME(type), options, records); \
+}
+/**************************************** DEFINE_NDJSON_2_STRUCT  END  ****************************************/
+
+
+/**************************************** DEFINE_COMPACT_STRUCT BEGIN ****************************************/
+/**
+ * @brief Define the same functions as the unrolled generators as thin wrappers over the table-driven engine
+ * @param type The type name of the struct
+ **/
+#define DEFINE_COMPACT_STRUCT(type) \
 static inline cJSON * \
 STRUCT_2_FUNCTION_NAME(type) \
     (GET_STRUCT_NAME(type) * st); \
@@ -545,82 +4109,8 @@ STRUCT_2_FUNCTION_NAME(type) \
     (GET_STRUCT_NAME(type) * st) \
 { \
     ASSERT_RETURN(st, NULL); \
-    cJSON * json = cJSON_CreateObject(); \
-    ASSERT_RETURN(json, NULL); \
-    do { \
-        DEFINE_STRUCT_2_JSON_(json, st, ##__VA_ARGS__) \
-    } while (0); \
-    return json; \
+    return json_wrapper_desc_to_json(&GET_DESC(type), st); \
 } \
-static inline char * \
-STRUCT_2_JSON_STR_FUNCTION_NAME(type) \
-    (GET_STRUCT_NAME(type) * st); \
-inline char * \
-STRUCT_2_JSON_STR_FUNCTION_NAME(type) \
-    (GET_STRUCT_NAME(type) * st) \
-{ \
-    cJSON * json = STRUCT_2_FUNCTION_NAME(type)(st); \
-    ASSERT_RETURN(json, NULL); \
-    char * result = cJSON_PrintUnformatted(json); \
-    cJSON_Delete(json); \
-    return result; \
-}
-/**************************************** DEFINE_STRUCT_2_JSON  END  ****************************************/
-
-
-/**************************************** DEFINE_JSON_2_STRUCT BEGIN ****************************************/
-/**
- * @brief Define a function to convert the json string to struct
- * @param type The type name of the struct
- **/
-#define DEFINE_JSON_2_STRUCT__OBJ(json, st, num, t, n) { \
-    cJSON * obj = cJSON_GetObjectItem(json, #n); \
-    if (NULL != obj) { \
-        JSON_2(t, obj, &((st)->n)); \
-    } \
-}
-#define DEFINE_JSON_2_STRUCT__ARRAY(json, st, num, t, n) { \
-    cJSON * obj = cJSON_GetObjectItem(json, #n); \
-    if (NULL != obj) { \
-        ASSERT_BREAK(cJSON_IsArray(obj)); \
-        int n = num > cJSON_GetArraySize(obj) ? cJSON_GetArraySize(obj) : num; \
-        int i = 0; \
-        for (; i < n; ++i) { \
-            cJSON * elem = cJSON_GetArrayItem(obj, i); \
-            ASSERT_BREAK(elem); \
-            JSON_2(t, elem, &((st)->n[i])); \
-        } \
-    } \
-}
-#define DEFINE_JSON_2_STRUCT__VA_ARRAY(json, st, num, t, n) { \
-    cJSON * obj = cJSON_GetObjectItem(json, #n); \
-    if (NULL != obj) { \
-        ASSERT_BREAK(cJSON_IsArray(obj)); \
-        int num_ = cJSON_GetArraySize(obj); \
-        if (0 == num_) { \
-            (st)->n.n = NULL; \
-            (st)->n.size = 0; \
-        } else { \
-            (st)->n.size = num_; \
-            (st)->n.n = json_wrapper_alloc(sizeof(GET_STRUCT_NAME(t)) * num_); \
-            ASSERT_BREAK((st)->n.n); \
-            int i = 0; \
-            for (; i < num_; ++i) { \
-                cJSON * elem = cJSON_GetArrayItem(obj, i); \
-                ASSERT_BREAK(elem); \
-                JSON_2(t, elem, &((st)->n.n[i])); \
-            } \
-        } \
-    } \
-}
-#define DEFINE_JSON_2_STRUCT__(json, st, type, num, t, n) DEFINE_JSON_2_STRUCT__##type(json, st, num, t, n)
-#define DEFINE_JSON_2_STRUCT_(json, st, ...) \
-    CONCAT(EXPAND(DEFINE_JOSN_2_STRUCT_I JOIN_TYPES_EX((json, st), ##__VA_ARGS__)), _END)
-#define DEFINE_JOSN_2_STRUCT_I(json, st, type, num, t, n) DEFINE_JSON_2_STRUCT__(json, st, type, num, t, n) DEFINE_JOSN_2_STRUCT_II
-#define DEFINE_JOSN_2_STRUCT_II(json, st, type, num, t, n) DEFINE_JSON_2_STRUCT__(json, st, type, num, t, n) DEFINE_JOSN_2_STRUCT_I
-#define DEFINE_JOSN_2_STRUCT_I_END
-#define DEFINE_JOSN_2_STRUCT_II_END
-#define DEFINE_JSON_2_STRUCT(type, ...) \
 static inline int \
 JSON_2_FUNCTION_NAME(type) \
     (cJSON * json, GET_STRUCT_NAME(type) * st); \
@@ -628,160 +4118,292 @@ inline int \
 JSON_2_FUNCTION_NAME(type) \
     (cJSON * json, GET_STRUCT_NAME(type) * st) \
 { \
-    do { \
-        DEFINE_JSON_2_STRUCT_(json, st, ##__VA_ARGS__) \
-    } while (0); \
+    ASSERT_RETURN(json && st, -1); \
+    return json_wrapper_desc_from_json(&GET_DESC(type), json, st); \
 } \
 static inline int \
-JSON_STR_2_FUNCTION_NAME(type) \
-    (char * json_str, GET_STRUCT_NAME(type) * st); \
+STRUCT_2_BUFFER_FUNCTION_NAME(type) \
+    (GET_STRUCT_NAME(type) * st, GET_STRUCT_NAME(Buffer) * buf); \
 inline int \
-JSON_STR_2_FUNCTION_NAME(type) \
-    (char * json_str, GET_STRUCT_NAME(type) * st) \
+STRUCT_2_BUFFER_FUNCTION_NAME(type) \
+    (GET_STRUCT_NAME(type) * st, GET_STRUCT_NAME(Buffer) * buf) \
 { \
-    ASSERT_RETURN(json_str && st, -1); \
-    cJSON * json = cJSON_Parse(json_str); \
-    ASSERT_RETURN(json, -1); \
-    int rc = JSON_2_FUNCTION_NAME(type)(json, st); \
-    cJSON_Delete(json); \
-    return rc; \
-}
-/**************************************** DEFINE_JSON_2_STRUCT  END  ****************************************/
+    ASSERT_RETURN(st && buf, -1); \
+    return json_wrapper_desc_to_buffer(&GET_DESC(type), st, buf); \
+} \
+DEFINE_STRUCT_2_JSON_STR(type) \
+static inline int \
+READER_2_MASK_FUNCTION_NAME(type) \
+    (GET_STRUCT_NAME(Reader) * r, GET_STRUCT_NAME(type) * st, const GET_STRUCT_NAME(Mask) * mask); \
+inline int \
+READER_2_MASK_FUNCTION_NAME(type) \
+    (GET_STRUCT_NAME(Reader) * r, GET_STRUCT_NAME(type) * st, const GET_STRUCT_NAME(Mask) * mask) \
+{ \
+    ASSERT_RETURN(r && st, -1); \
+    return json_wrapper_desc_from_reader_mask(&GET_DESC(type), r, st, mask); \
+} \
+DEFINE_READER_2_STRUCT_ALL(type) \
+DEFINE_JSON_STR_2_STRUCT(type) \
+static inline int \
+STRUCT_2_MSGPACK_BUFFER_FUNCTION_NAME(type) \
+    (GET_STRUCT_NAME(type) * st, GET_STRUCT_NAME(Buffer) * buf); \
+inline int \
+STRUCT_2_MSGPACK_BUFFER_FUNCTION_NAME(type) \
+    (GET_STRUCT_NAME(type) * st, GET_STRUCT_NAME(Buffer) * buf) \
+{ \
+    ASSERT_RETURN(st && buf, -1); \
+    return json_wrapper_desc_to_msgpack(&GET_DESC(type), st, buf); \
+} \
+DEFINE_STRUCT_2_MSGPACK_DATA(type) \
+static inline int \
+MSGPACK_READER_2_FUNCTION_NAME(type) \
+    (GET_STRUCT_NAME(Reader) * r, GET_STRUCT_NAME(type) * st); \
+inline int \
+MSGPACK_READER_2_FUNCTION_NAME(type) \
+    (GET_STRUCT_NAME(Reader) * r, GET_STRUCT_NAME(type) * st) \
+{ \
+    ASSERT_RETURN(r && st, -1); \
+    return json_wrapper_desc_from_msgpack(&GET_DESC(type), r, st); \
+} \
+DEFINE_MSGPACK_DATA_2_STRUCT(type) \
+static inline void \
+COPY_ARENA_FUNCTION_NAME(type) \
+    (GET_STRUCT_NAME(type) * src, GET_STRUCT_NAME(type) * dst, GET_STRUCT_NAME(Arena) * arena); \
+inline void \
+COPY_ARENA_FUNCTION_NAME(type) \
+    (GET_STRUCT_NAME(type) * src, GET_STRUCT_NAME(type) * dst, GET_STRUCT_NAME(Arena) * arena) \
+{ \
+    ASSERT_RETURN_VOID(src && dst && src != dst); \
+    INSTRUMENT_ENTER(type, INSTRUMENT_COPY) \
+    json_wrapper_desc_copy(&GET_DESC(type), src, dst, arena); \
+    INSTRUMENT_LEAVE(0, 0) \
+} \
+DEFINE_COPY_STRUCT_HEAP(type) \
+static inline void \
+RECYCLE_FUNCTION_NAME(type) \
+    (GET_STRUCT_NAME(type) * ptr); \
+inline void \
+RECYCLE_FUNCTION_NAME(type) \
+    (GET_STRUCT_NAME(type) * ptr) \
+{ \
+    ASSERT_RETURN_VOID(ptr); \
+    INSTRUMENT_ENTER(type, INSTRUMENT_RECYCLE) \
+    json_wrapper_desc_recycle(&GET_DESC(type), ptr); \
+    INSTRUMENT_LEAVE(0, 0) \
+} \
+DEFINE_MOVE_STRUCT(type) \
+static inline bool \
+EQUAL_FUNCTION_NAME(type) \
+    (GET_STRUCT_NAME(type) * a, GET_STRUCT_NAME(type) * b); \
+inline bool \
+EQUAL_FUNCTION_NAME(type) \
+    (GET_STRUCT_NAME(type) * a, GET_STRUCT_NAME(type) * b) \
+{ \
+    ASSERT_RETURN(a && b, a == b); \
+    return json_wrapper_desc_equal(&GET_DESC(type), a, b); \
+} \
+static inline int \
+DIFF_BUFFER_FUNCTION_NAME(type) \
+    (GET_STRUCT_NAME(type) * old, GET_STRUCT_NAME(type) * st, GET_STRUCT_NAME(Buffer) * buf); \
+inline int \
+DIFF_BUFFER_FUNCTION_NAME(type) \
+    (GET_STRUCT_NAME(type) * old, GET_STRUCT_NAME(type) * st, GET_STRUCT_NAME(Buffer) * buf) \
+{ \
+    ASSERT_RETURN(old && st && buf, -1); \
+    return json_wrapper_desc_diff(&GET_DESC(type), old, st, buf); \
+} \
+DEFINE_DIFF_STRUCT_STR(type)
+/**************************************** DEFINE_COMPACT_STRUCT  END  ****************************************/
 
 
 /**
- * @brief Define a function name about copying struct
+ * @brief Define the names about the tracked struct, which caches the json text of each field of the struct
+ *        and encodes again only the fields changed
  */
-#define COPY_FUNCTION_NAME(type) CONCAT(json_wrapper_copy_, GET_STRUCT_NAME(type))
+#define GET_TRACKED_NAME(type) CONCAT(GET_STRUCT_NAME(type), _TRACKED)
+#define SET_FUNCTION_NAME(type, n) CONCAT(CONCAT(json_wrapper_set_, GET_STRUCT_NAME(type)), CONCAT(_, n))
+#define STRUCT_FIELD_2_BUFFER_FUNCTION_NAME(type) CONCAT(json_wrapper_json_buffer_field_from_, GET_STRUCT_NAME(type))
+#define TRACKED_2_JSON_STR_FUNCTION_NAME(type) CONCAT(json_wrapper_json_str_from_tracked_, GET_STRUCT_NAME(type))
+#define RECYCLE_TRACKED_FUNCTION_NAME(type) CONCAT(json_wrapper_recycle_tracked_, GET_STRUCT_NAME(type))
 
 
-/**************************************** COPY BEGIN ****************************************/
+/**************************************** DEFINE_TRACKED_STRUCT BEGIN ****************************************/
 /**
- * @brief Copy value from src to dst
- * @param type The type of the value
- * @param src The src value
- * @param dst The dst value
+ * @brief Define the tracked struct of the struct, which is the struct as @p value with the bitmap of its clean fields
+ *        and the json members encoded for them, and define a setter for each field which marks it dirty.
+ *        The json text of the tracked struct encodes only the dirty fields again and stitches the members together
+ * @param type The type name of the struct
+ * 
+ * @note For example:
+ *           DEFINE_TRACKED_STRUCT(Person, (OBJ(INT), age))
+ *               -> typedef struct Person_JSON_TRACKED
+ *                  {
+ *                      Person_JSON value;
+ *                      uint64_t clean[1];
+ *                      Buffer_JSON fragments[1];
+ *                      Buffer_JSON out;
+ *                  } Person_JSON_TRACKED;
+ *                  void json_wrapper_set_Person_JSON_age(Person_JSON_TRACKED * tracked, INT_JSON value);
+ * 
+ *       The setters copy the value deeply as @link COPY does, the old value of the field is recycled.
+ *       A field changed in place in @p value must be marked by @link TOUCH_ST
  **/
-#define COPY(type, src, dst) COPY_FUNCTION_NAME(type)(src, dst)
-static inline void COPY_FUNCTION_NAME(BOOL)(GET_STRUCT_NAME(BOOL) * src, GET_STRUCT_NAME(BOOL) * dst);
-inline void COPY_FUNCTION_NAME(BOOL)(GET_STRUCT_NAME(BOOL) * src, GET_STRUCT_NAME(BOOL) * dst)
-{
-    ASSERT_RETURN_VOID(src && dst);
-    *dst = *src;
-}
-static inline void COPY_FUNCTION_NAME(CHAR)(GET_STRUCT_NAME(CHAR) * src, GET_STRUCT_NAME(CHAR) * dst);
-inline void COPY_FUNCTION_NAME(CHAR)(GET_STRUCT_NAME(CHAR) * src, GET_STRUCT_NAME(CHAR) * dst)
-{
-    ASSERT_RETURN_VOID(src && dst);
-    *dst = *src;
-}
-static inline void COPY_FUNCTION_NAME(INT)(GET_STRUCT_NAME(INT) * src, GET_STRUCT_NAME(INT) * dst);
-inline void COPY_FUNCTION_NAME(INT)(GET_STRUCT_NAME(INT) * src, GET_STRUCT_NAME(INT) * dst)
-{
-    ASSERT_RETURN_VOID(src && dst);
-    *dst = *src;
+#define DEFINE_TRACKED_SETTER_OBJ(stype, num, t, n) \
+static inline void \
+SET_FUNCTION_NAME(stype, n) \
+    (GET_TRACKED_NAME(stype) * tracked, GET_STRUCT_NAME(t) value); \
+inline void \
+SET_FUNCTION_NAME(stype, n) \
+    (GET_TRACKED_NAME(stype) * tracked, GET_STRUCT_NAME(t) value) \
+{ \
+    ASSERT_RETURN_VOID(tracked); \
+    GET_STRUCT_NAME(t) copy; \
+    memset(&copy, 0, sizeof(GET_STRUCT_NAME(t))); \
+    COPY(t, &value, &copy); \
+    RECYCLE(t, &(tracked->value.n)); \
+    tracked->value.n = copy; \
+    json_wrapper_tracked_touch(tracked->clean, GET_FIELD_INDEX(stype, n)); \
 }
-void COPY_FUNCTION_NAME(STRING)(GET_STRUCT_NAME(STRING) * src, GET_STRUCT_NAME(STRING) * dst);
-/**************************************** COPY  END  ****************************************/
-
-
-/**************************************** DEFINE_COPY_STRUCT BEGIN ****************************************/
-#define COPY_OBJ(src, dst, num, t, n) COPY(t, &((src)->n), &((dst)->n));
-#define COPY_ARRAY(src, dst, num, t, n) { \
+#define DEFINE_TRACKED_SETTER_ARRAY(stype, num, t, n) \
+static inline void \
+SET_FUNCTION_NAME(stype, n) \
+    (GET_TRACKED_NAME(stype) * tracked, GET_STRUCT_NAME(t) * value); \
+inline void \
+SET_FUNCTION_NAME(stype, n) \
+    (GET_TRACKED_NAME(stype) * tracked, GET_STRUCT_NAME(t) * value) \
+{ \
+    ASSERT_RETURN_VOID(tracked && value); \
     int i = 0; \
     for (; i < num; ++i) \
     { \
-        COPY(t, &((src)->n[i]), &((dst)->n[i])); \
+        GET_STRUCT_NAME(t) copy; \
+        memset(&copy, 0, sizeof(GET_STRUCT_NAME(t))); \
+        COPY(t, &value[i], &copy); \
+        RECYCLE(t, &(tracked->value.n[i])); \
+        tracked->value.n[i] = copy; \
     } \
+    json_wrapper_tracked_touch(tracked->clean, GET_FIELD_INDEX(stype, n)); \
 }
-#define COPY_VA_ARRAY(src, dst, num, t, n) { \
-    int i = 0; \
-    for (; i < (src)->n.size; ++i) \
+#define DEFINE_TRACKED_SETTER_VA_ARRAY(stype, num, t, n) \
+static inline void \
+SET_FUNCTION_NAME(stype, n) \
+    (GET_TRACKED_NAME(stype) * tracked, GET_STRUCT_NAME(t) * value, size_t size); \
+inline void \
+SET_FUNCTION_NAME(stype, n) \
+    (GET_TRACKED_NAME(stype) * tracked, GET_STRUCT_NAME(t) * value, size_t size) \
+{ \
+    ASSERT_RETURN_VOID(tracked && (value || 0 == size)); \
+    GET_VA_ARRAY_NAME(t) copy; \
+    copy.n = NULL; \
+    copy.size = 0; \
+    if (size > 0) \
     { \
-        COPY(t, &((src)->n.n[i]), &((dst)->n.n[i])); \
+        copy.n = json_wrapper_alloc(sizeof(GET_STRUCT_NAME(t)) * size); \
+        ASSERT_RETURN_VOID(copy.n); \
+        memset(copy.n, 0, sizeof(GET_STRUCT_NAME(t)) * size); \
+        copy.size = size; \
+        size_t i = 0; \
+        for (; i < size; ++i) \
+        { \
+            COPY(t, &value[i], &copy.n[i]); \
+        } \
     } \
+    RECYCLE_VA_ARRAY(&(tracked->value), num, t, n) \
+    tracked->value.n = copy; \
+    json_wrapper_tracked_touch(tracked->clean, GET_FIELD_INDEX(stype, n)); \
 }
-#define DEFINE_COPY_STRUCT__(src, dst, type, num, t, n) COPY_##type(src, dst, num, t, n)
-#define DEFINE_COPY_STRUCT_(src, dst, ...) \
-    CONCAT(EXPAND(DEFINE_COPY_STRUCT_I JOIN_TYPES_EX((src, dst), ##__VA_ARGS__)), _END)
-#define DEFINE_COPY_STRUCT_I(src, dst, type, num, t, n) DEFINE_COPY_STRUCT__(src, dst, type, num, t, n) DEFINE_COPY_STRUCT_II
-#define DEFINE_COPY_STRUCT_II(src, dst, type, num, t, n) DEFINE_COPY_STRUCT__(src, dst, type, num, t, n) DEFINE_COPY_STRUCT_I
-#define DEFINE_COPY_STRUCT_I_END
-#define DEFINE_COPY_STRUCT_II_END
-#define DEFINE_COPY_STRUCT(type, ...) \
+#define DEFINE_TRACKED_SETTER_FIXED_STRING(stype, num, t, n) \
 static inline void \
-COPY_FUNCTION_NAME(type) \
-    (GET_STRUCT_NAME(type) * src, GET_STRUCT_NAME(type) * dst); \
+SET_FUNCTION_NAME(stype, n) \
+    (GET_TRACKED_NAME(stype) * tracked, const char * value); \
 inline void \
-COPY_FUNCTION_NAME(type) \
-    (GET_STRUCT_NAME(type) * src, GET_STRUCT_NAME(type) * dst) \
+SET_FUNCTION_NAME(stype, n) \
+    (GET_TRACKED_NAME(stype) * tracked, const char * value) \
 { \
-    ASSERT_RETURN_VOID(src && dst); \
-    DEFINE_COPY_STRUCT_(src, dst, ##__VA_ARGS__) \
+    ASSERT_RETURN_VOID(tracked); \
+    json_wrapper_fixed_string_set(tracked->value.n, num, NULL != value ? value : "", NULL != value ? strlen(value) : 0); \
+    json_wrapper_tracked_touch(tracked->clean, GET_FIELD_INDEX(stype, n)); \
 }
-/**************************************** DEFINE_COPY_STRUCT  END  ****************************************/
-
-
-/**
- * @brief Define a function name about recycling struct
- */
-#define RECYCLE_FUNCTION_NAME(type) CONCAT(json_wrapper_recycle_, GET_STRUCT_NAME(type))
-
-
-/**************************************** RECYCLE BEGIN ****************************************/
-/**
- * @brief Recycle a wrapper type object
- **/
-#define RECYCLE(type, ptr) RECYCLE_FUNCTION_NAME(type)(ptr)
-static inline void RECYCLE_FUNCTION_NAME(BOOL)(GET_STRUCT_NAME(BOOL) * ptr);
-inline void RECYCLE_FUNCTION_NAME(BOOL)(GET_STRUCT_NAME(BOOL) * ptr)
-{}
-static inline void RECYCLE_FUNCTION_NAME(CHAR)(GET_STRUCT_NAME(CHAR) * ptr);
-inline void RECYCLE_FUNCTION_NAME(CHAR)(GET_STRUCT_NAME(CHAR) * ptr)
-{}
-static inline void RECYCLE_FUNCTION_NAME(INT)(GET_STRUCT_NAME(INT) * ptr);
-inline void RECYCLE_FUNCTION_NAME(INT)(GET_STRUCT_NAME(INT) * ptr)
-{}
-void RECYCLE_FUNCTION_NAME(STRING)(GET_STRUCT_NAME(STRING) * ptr);
-/**************************************** RECYCLE  END  ****************************************/
-
-
-/**************************************** DEFINE_RECYCLE_STRUCT BEGIN ****************************************/
-#define RECYCLE_OBJ(ptr, num, t, n) RECYCLE(t, &((ptr)->n));
-#define RECYCLE_ARRAY(ptr, num, t, n) { \
-    int i = 0; \
-    for (; i < num; ++i) \
+#define DEFINE_TRACKED_SETTER__(stype, type, num, t, n) DEFINE_TRACKED_SETTER_##type(stype, num, t, n)
+#define DEFINE_TRACKED_SETTERS(stype, ...) \
+    CONCAT(EXPAND(DEFINE_TRACKED_SETTER_I JOIN_TYPES_EX((stype), ##__VA_ARGS__)), _END)
+#define DEFINE_TRACKED_SETTER_I(stype, type, num, t, n) DEFINE_TRACKED_SETTER__(stype, type, num, t, n) DEFINE_TRACKED_SETTER_II
+#define DEFINE_TRACKED_SETTER_II(stype, type, num, t, n) DEFINE_TRACKED_SETTER__(stype, type, num, t, n) DEFINE_TRACKED_SETTER_I
+#define DEFINE_TRACKED_SETTER_I_END
+#define DEFINE_TRACKED_SETTER_II_END
+#define DEFINE_STRUCT_FIELD_2_BUFFER__(buf, st, stype, type, num, t, n) \
+    case GET_FIELD_INDEX(stype, n): DEFINE_STRUCT_2_BUFFER__##type(buf, st, num, t, n) break;
+#define DEFINE_STRUCT_FIELD_2_BUFFER_(buf, st, stype, ...) \
+    CONCAT(EXPAND(DEFINE_STRUCT_FIELD_2_BUFFER_I JOIN_TYPES_EX((buf, st, stype), ##__VA_ARGS__)), _END)
+#define DEFINE_STRUCT_FIELD_2_BUFFER_I(buf, st, stype, type, num, t, n) DEFINE_STRUCT_FIELD_2_BUFFER__(buf, st, stype, type, num, t, n) DEFINE_STRUCT_FIELD_2_BUFFER_II
+#define DEFINE_STRUCT_FIELD_2_BUFFER_II(buf, st, stype, type, num, t, n) DEFINE_STRUCT_FIELD_2_BUFFER__(buf, st, stype, type, num, t, n) DEFINE_STRUCT_FIELD_2_BUFFER_I
+#define DEFINE_STRUCT_FIELD_2_BUFFER_I_END
+#define DEFINE_STRUCT_FIELD_2_BUFFER_II_END
+#define DEFINE_TRACKED_STRUCT(type, ...) \
+typedef struct GET_TRACKED_NAME(type) \
+{ \
+    GET_STRUCT_NAME(type) value; \
+    uint64_t clean[(GET_FIELD_COUNT(type) + 63) / 64]; \
+    GET_STRUCT_NAME(Buffer) fragments[GET_FIELD_COUNT(type)]; \
+    GET_STRUCT_NAME(Buffer) out; \
+} GET_TRACKED_NAME(type); \
+DEFINE_TRACKED_SETTERS(type, ##__VA_ARGS__) \
+static inline int \
+STRUCT_FIELD_2_BUFFER_FUNCTION_NAME(type) \
+    (GET_STRUCT_NAME(type) * st, size_t index, GET_STRUCT_NAME(Buffer) * buf); \
+inline int \
+STRUCT_FIELD_2_BUFFER_FUNCTION_NAME(type) \
+    (GET_STRUCT_NAME(type) * st, size_t index, GET_STRUCT_NAME(Buffer) * buf) \
+{ \
+    ASSERT_RETURN(st && buf, -1); \
+    switch (index) \
     { \
-        RECYCLE(t, &((ptr)->n[i])); \
+        DEFINE_STRUCT_FIELD_2_BUFFER_(buf, st, type, ##__VA_ARGS__) \
+        default: \
+            return -1; \
     } \
-}
-#define RECYCLE_VA_ARRAY(ptr, num, t, n) { \
-    int i = 0; \
-    for (; i < (ptr)->n.size; ++i) \
+    return 0; \
+} \
+static inline const char * \
+TRACKED_2_JSON_STR_FUNCTION_NAME(type) \
+    (GET_TRACKED_NAME(type) * tracked, size_t * len); \
+inline const char * \
+TRACKED_2_JSON_STR_FUNCTION_NAME(type) \
+    (GET_TRACKED_NAME(type) * tracked, size_t * len) \
+{ \
+    ASSERT_RETURN(tracked, NULL); \
+    bool changed = NULL == tracked->out.data; \
+    size_t i = 0; \
+    for (; i < GET_FIELD_COUNT(type); ++i) \
     { \
-        RECYCLE(t, &((ptr)->n.n[i])); \
+        if (!json_wrapper_tracked_dirty(tracked->clean, i)) continue; \
+        tracked->fragments[i].len = 0; \
+        ASSERT_RETURN(0 == STRUCT_FIELD_2_BUFFER_FUNCTION_NAME(type)(&(tracked->value), i, &(tracked->fragments[i])), NULL); \
+        tracked->clean[i / 64] |= (uint64_t) 1 << (i % 64); \
+        changed = true; \
     } \
-    json_wrapper_free((ptr)->n.n); \
-}
-#define DEFINE_RECYCLE_STRUCT__(ptr, type, num, t, n) RECYCLE_##type(ptr, num, t, n)
-#define DEFINE_RECYCLE_STRUCT_(ptr, ...) \
-    CONCAT(EXPAND(DEFINE_RECYCLE_STRUCT_I JOIN_TYPES_EX((ptr), ##__VA_ARGS__)), _END)
-#define DEFINE_RECYCLE_STRUCT_I(ptr, type, num, t, n) DEFINE_RECYCLE_STRUCT__(ptr, type, num, t, n) DEFINE_RECYCLE_STRUCT_II
-#define DEFINE_RECYCLE_STRUCT_II(ptr, type, num, t, n) DEFINE_RECYCLE_STRUCT__(ptr, type, num, t, n) DEFINE_RECYCLE_STRUCT_I
-#define DEFINE_RECYCLE_STRUCT_I_END
-#define DEFINE_RECYCLE_STRUCT_II_END
-#define DEFINE_RECYCLE_STRUCT(type, ...) \
+    if (changed) ASSERT_RETURN(0 == json_wrapper_tracked_stitch(&(tracked->out), tracked->fragments, GET_FIELD_COUNT(type)), NULL); \
+    if (NULL != len) *len = tracked->out.len; \
+    return tracked->out.data; \
+} \
 static inline void \
-RECYCLE_FUNCTION_NAME(type) \
-    (GET_STRUCT_NAME(type) * ptr); \
+RECYCLE_TRACKED_FUNCTION_NAME(type) \
+    (GET_TRACKED_NAME(type) * tracked); \
 inline void \
-RECYCLE_FUNCTION_NAME(type) \
-    (GET_STRUCT_NAME(type) * ptr) \
+RECYCLE_TRACKED_FUNCTION_NAME(type) \
+    (GET_TRACKED_NAME(type) * tracked) \
 { \
-    ASSERT_RETURN_VOID(ptr); \
-    DEFINE_RECYCLE_STRUCT_(ptr, ##__VA_ARGS__) \
+    ASSERT_RETURN_VOID(tracked); \
+    RECYCLE_FUNCTION_NAME(type)(&(tracked->value)); \
+    size_t i = 0; \
+    for (; i < GET_FIELD_COUNT(type); ++i) \
+    { \
+        json_wrapper_buffer_release(&(tracked->fragments[i])); \
+    } \
+    json_wrapper_buffer_release(&(tracked->out)); \
+    memset(tracked, 0, sizeof(GET_TRACKED_NAME(type))); \
 }
-/**************************************** DEFINE_RECYCLE_STRUCT  END  ****************************************/
+/**************************************** DEFINE_TRACKED_STRUCT  END  ****************************************/
 
 
 #define DEFINE_STRUCT(type, ...) \
@@ -790,10 +4412,44 @@ DEFINE_STRUCT_(type) \
 { \
     DEFINE_FIELDS(__VA_ARGS__) \
 }; \
+DEFINE_FIELD_KEYS(type, ##__VA_ARGS__) \
+DEFINE_MAX_SIZE(type, ##__VA_ARGS__) \
+DEFINE_DESC(type, ##__VA_ARGS__) \
 DEFINE_STRUCT_2_JSON(type, ##__VA_ARGS__) \
+DEFINE_STRUCT_2_BUFFER(type, ##__VA_ARGS__) \
 DEFINE_JSON_2_STRUCT(type, ##__VA_ARGS__) \
 DEFINE_COPY_STRUCT(type, ##__VA_ARGS__) \
-DEFINE_RECYCLE_STRUCT(type, ##__VA_ARGS__)
+DEFINE_RECYCLE_STRUCT(type, ##__VA_ARGS__) \
+DEFINE_DIFF_STRUCT(type, ##__VA_ARGS__) \
+DEFINE_READER_2_STRUCT(type, ##__VA_ARGS__) \
+DEFINE_STRUCT_2_MSGPACK(type, ##__VA_ARGS__) \
+DEFINE_MSGPACK_2_STRUCT(type, ##__VA_ARGS__) \
+DEFINE_NDJSON_2_STRUCT(type)
+
+/**
+ * @brief Define a struct the same as @link DEFINE_STRUCT, but all its functions walk the descriptor of the struct
+ *        in the table-driven engine instead of being unrolled per field, which trades some speed for much less code.
+ *        The two kinds of structs can be nested in each other freely
+ */
+#define DEFINE_STRUCT_COMPACT(type, ...) \
+DEFINE_VA_ARRAY_TYPES(__VA_ARGS__) \
+DEFINE_STRUCT_(type) \
+{ \
+    DEFINE_FIELDS(__VA_ARGS__) \
+}; \
+DEFINE_FIELD_KEYS(type, ##__VA_ARGS__) \
+DEFINE_MAX_SIZE(type, ##__VA_ARGS__) \
+DEFINE_DESC(type, ##__VA_ARGS__) \
+DEFINE_COMPACT_STRUCT(type) \
+DEFINE_NDJSON_2_STRUCT(type)
+
+/**
+ * @brief Define a struct the same as @link DEFINE_STRUCT, and its tracked struct by @link DEFINE_TRACKED_STRUCT
+ *        for the structs which are encoded again and again with few fields changed between
+ */
+#define DEFINE_STRUCT_TRACKED(type, ...) \
+DEFINE_STRUCT(type, ##__VA_ARGS__) \
+DEFINE_TRACKED_STRUCT(type, ##__VA_ARGS__)
 
 
 #define DECLARE_STRUCT(type, obj) \
@@ -801,7 +4457,163 @@ DEFINE_RECYCLE_STRUCT(type, ##__VA_ARGS__)
     memset(&obj, 0, sizeof(GET_STRUCT_NAME(type)))
 
 
+/**
+ * @brief Convert the struct to json string, the result should be freed by @link json_wrapper_free
+ */
 #define S2J(type, obj_ptr) STRUCT_2_JSON_STR_FUNCTION_NAME(type)(obj_ptr)
+/**
+ * @brief The largest length of the json string of the struct without the terminating '\0', a constant expression.
+ *        It bounds every value of the type if S2J_IS_BOUNDED(type) is true, which is when the struct has no STRING
+ *        or VA_ARRAY field at any depth, for example:
+ *            char text[S2J_MAX_SIZE(Telemetry) + 1];
+ *            S2J_INTO(Telemetry, &telemetry, text, sizeof(text));
+ */
+#define S2J_MAX_SIZE(type) GET_MAX_SIZE(type)
+#define S2J_IS_BOUNDED(type) GET_IS_BOUNDED(type)
+/**
+ * @brief Get the exact length of the json string of the struct without the terminating '\0', nothing is alloced
+ */
+#define S2J_SIZE(type, obj_ptr) STRUCT_2_JSON_SIZE_FUNCTION_NAME(type)(obj_ptr)
+/**
+ * @brief Write the json string of the struct into @p buf of @p cap bytes, nothing is alloced.
+ *        Like snprintf the result is '\0' terminated if @p cap isn't 0 and the full length is returned,
+ *        the text was truncated if it's not less than @p cap, @p 0 for failure
+ */
+#define S2J_INTO(type, obj_ptr, buf, cap) STRUCT_2_JSON_INTO_FUNCTION_NAME(type)(obj_ptr, buf, cap)
+/**
+ * @brief Write @p count structs of @p array into @p sink as a json array or NDJSON, the encoding buffer is reused
+ *        across the records, @p 0 for success, @p -1 for failure.
+ *        On failure the records appended into the buffer of a buffer sink are dropped, but the pieces
+ *        already passed to a write callback stay written. A fixed buffer which can't hold the records
+ *        and a terminating '\0' fails the batch.
+ * @note For example:
+ *           GET_STRUCT_NAME(Sink) sink;
+ *           json_wrapper_sink_init_write(&sink, write_to_file, file, 0, BATCH_NDJSON);
+ *           S2J_BATCH(Telemetry, records, count, &sink);
+ *           json_wrapper_sink_release(&sink);
+ */
+#define S2J_BATCH(type, array, count, sink) STRUCT_2_JSON_BATCH_FUNCTION_NAME(type)(array, count, sink)
 #define J2S(json, type, obj_ptr) JSON_STR_2_FUNCTION_NAME(type)(json, obj_ptr)
+/**
+ * @brief Convert @p len bytes of json text to the struct in place: the STRING_VIEW fields point into the text,
+ *        whose escaped strings are unescaped in place, so the text is modified and must outlive the views.
+ *        The STRING fields are alloced as usual
+ */
+#define J2S_VIEW(json, len, type, obj_ptr) JSON_STR_2_VIEW_FUNCTION_NAME(type)(json, len, obj_ptr, NULL)
+#define J2S_VIEW_ARENA(json, len, type, obj_ptr, arena) JSON_STR_2_VIEW_FUNCTION_NAME(type)(json, len, obj_ptr, arena)
+/**
+ * @brief Convert json string to the struct decoding only the fields in @p mask_ptr, see @link Mask_JSON.
+ *        The other fields and their whole subtrees are skipped without allocating and left unchanged
+ */
+#define J2S_MASK(json, type, obj_ptr, mask_ptr) JSON_STR_2_MASK_FUNCTION_NAME(type)(json, obj_ptr, mask_ptr, NULL)
+#define J2S_MASK_ARENA(json, type, obj_ptr, mask_ptr, arena) JSON_STR_2_MASK_FUNCTION_NAME(type)(json, obj_ptr, mask_ptr, arena)
+/**
+ * @brief Convert @p len bytes of json text to the struct over its structural index, which is built first into
+ *        @p index_ptr, see @link json_wrapper_index_build. The fields out of @p mask_ptr, @p NULL for all,
+ *        the unknown keys and the counting pass of the VA_ARRAY fields jump over their values instead of
+ *        scanning them, which pays off for large texts. The index is reused across calls
+ *        and freed by @link json_wrapper_index_release
+ * @note For example:
+ *           GET_STRUCT_NAME(Index) index = { 0 };
+ *           J2S_INDEX(text, len, Person, &person, &name_mask, &index);
+ *           json_wrapper_index_release(&index);
+ */
+#define J2S_INDEX(json, len, type, obj_ptr, mask_ptr, index_ptr) \
+    JSON_STR_2_INDEX_FUNCTION_NAME(type)(json, len, obj_ptr, mask_ptr, index_ptr, NULL)
+#define J2S_INDEX_ARENA(json, len, type, obj_ptr, mask_ptr, index_ptr, arena) \
+    JSON_STR_2_INDEX_FUNCTION_NAME(type)(json, len, obj_ptr, mask_ptr, index_ptr, arena)
+/**
+ * @brief Decode the next record of the NDJSON line source @p lines_ptr into the struct,
+ *        @p 1 for a record, @p 0 for the end, @p -1 for a bad record, after which the next call goes on
+ * @note For example:
+ *           GET_STRUCT_NAME(Lines) lines;
+ *           json_wrapper_lines_init_fd(&lines, fd, 0);
+ *           DECLARE_STRUCT(Event, event);
+ *           int rc = 0;
+ *           while (0 != (rc = J2S_NEXT(&lines, Event, &event))) if (1 == rc) handle(&event);
+ *           RECYCLE_ST(Event, &event);
+ *           json_wrapper_lines_release(&lines);
+ */
+#define J2S_NEXT(lines_ptr, type, obj_ptr) NDJSON_2_FUNCTION_NAME(type)(lines_ptr, obj_ptr)
+/**
+ * @brief Decode the non-empty lines of @p len bytes of NDJSON text into @p array of @p count structs on worker threads,
+ *        the number of records decoded is set into @p records_ptr, @p 0 for success, @p -1 for any record failed
+ * @note For example:
+ *           GET_STRUCT_NAME(Parallel) options = { .threads = 8 };
+ *           size_t records = 0;
+ *           J2S_PARALLEL(text, len, Event, events, capacity, &options, &records);
+ */
+#define J2S_PARALLEL(data, len, type, array, count, options, records_ptr) \
+    NDJSON_PARALLEL_2_FUNCTION_NAME(type)(data, len, array, count, options, records_ptr)
 #define COPY_ST(type, src_ptr, dst_ptr)  COPY_FUNCTION_NAME(type)(src_ptr, dst_ptr)
+/**
+ * @brief The same as @link J2S and @link COPY_ST, but the strings and arrays are alloced from @p arena,
+ *        the object is released by resetting the arena instead of @link RECYCLE_ST
+ */
+#define J2S_ARENA(json, type, obj_ptr, arena) JSON_STR_2_ARENA_FUNCTION_NAME(type)(json, obj_ptr, arena)
+#define COPY_ST_ARENA(type, src_ptr, dst_ptr, arena)  COPY_ARENA_FUNCTION_NAME(type)(src_ptr, dst_ptr, arena)
 #define RECYCLE_ST(type, obj_ptr)  RECYCLE_FUNCTION_NAME(type)(obj_ptr)
+/**
+ * @brief Move the struct from @p src_ptr to @p dst_ptr by taking over its strings and arrays,
+ *        @p src_ptr is left zeroed, see @link DEFINE_MOVE_STRUCT
+ */
+#define MOVE_ST(type, src_ptr, dst_ptr)  MOVE_FUNCTION_NAME(type)(src_ptr, dst_ptr)
+/**
+ * @brief Compare two structs deeply
+ */
+#define EQUAL_ST(type, a_ptr, b_ptr) EQUAL_FUNCTION_NAME(type)(a_ptr, b_ptr)
+/**
+ * @brief Get the json merge patch (RFC 7386) of only the fields changed from @p old_ptr to @p new_ptr,
+ *        "{}" if nothing changed, the result should be freed by @link json_wrapper_free.
+ *        DIFF_ST_BUFFER writes the patch into a buffer instead, nothing for nothing changed
+ * @note For example:
+ *           person.age = 31;
+ *           char * patch = DIFF_ST(Person, &sent, &person);        // {"age":31}
+ *           send(patch);
+ *           COPY_ST(Person, &person, &sent);
+ */
+#define DIFF_ST(type, old_ptr, new_ptr) DIFF_FUNCTION_NAME(type)(old_ptr, new_ptr)
+#define DIFF_ST_BUFFER(type, old_ptr, new_ptr, buf) DIFF_BUFFER_FUNCTION_NAME(type)(old_ptr, new_ptr, buf)
+/**
+ * @brief Apply the json merge patch @p patch to the struct in place: the members present are decoded over the fields,
+ *        the struct members recursively as patches, and a member of null resets its field to zero
+ */
+#define PATCH_ST(type, patch, obj_ptr) PATCH_FUNCTION_NAME(type)(patch, obj_ptr, NULL)
+#define PATCH_ST_ARENA(type, patch, obj_ptr, arena) PATCH_FUNCTION_NAME(type)(patch, obj_ptr, arena)
+/**
+ * @brief Declare a tracked struct of a type defined by @link DEFINE_STRUCT_TRACKED, all its fields are dirty
+ */
+#define DECLARE_TRACKED(type, obj) \
+    GET_TRACKED_NAME(type) obj; \
+    memset(&obj, 0, sizeof(GET_TRACKED_NAME(type)))
+/**
+ * @brief Set the field @p n of the tracked struct and mark it dirty, the value is copied deeply.
+ *        The value of an ARRAY field is a pointer to its elements, of a VA_ARRAY field a pointer
+ *        and a number of elements, of a FIXED_STRING field a string
+ * @note For example:
+ *           DECLARE_TRACKED(Person, person);
+ *           SET_ST(Person, &person, age, 31);
+ *           SET_ST(Person, &person, name, "Alice");
+ *           SET_ST(Person, &person, v_sons, sons, count);
+ */
+#define SET_ST(type, tracked_ptr, n, ...) SET_FUNCTION_NAME(type, n)(tracked_ptr, __VA_ARGS__)
+/**
+ * @brief Mark the field @p n of the tracked struct dirty after changing it in place, or all the fields
+ */
+#define TOUCH_ST(type, tracked_ptr, n) json_wrapper_tracked_touch((tracked_ptr)->clean, GET_FIELD_INDEX(type, n))
+#define TOUCH_ST_ALL(tracked_ptr) memset((tracked_ptr)->clean, 0, sizeof((tracked_ptr)->clean))
+/**
+ * @brief Convert the tracked struct to json string of @p *len_ptr bytes, only the dirty fields are encoded again.
+ *        The result is owned by the tracked struct and stays valid until its next conversion or recycling
+ */
+#define S2J_TRACKED(type, tracked_ptr, len_ptr) TRACKED_2_JSON_STR_FUNCTION_NAME(type)(tracked_ptr, len_ptr)
+#define RECYCLE_TRACKED(type, tracked_ptr) RECYCLE_TRACKED_FUNCTION_NAME(type)(tracked_ptr)
+/**
+ * @brief Convert the struct to MessagePack data of @p *len_ptr bytes, the result should be freed by @link json_wrapper_free
+ */
+#define S2M(type, obj_ptr, len_ptr) STRUCT_2_MSGPACK_FUNCTION_NAME(type)(obj_ptr, len_ptr)
+/**
+ * @brief Convert @p len bytes of MessagePack data to the struct, optionally with the memory in @p arena
+ */
+#define M2S(data, len, type, obj_ptr) MSGPACK_2_FUNCTION_NAME(type)(data, len, obj_ptr)
+#define M2S_ARENA(data, len, type, obj_ptr, arena) MSGPACK_2_ARENA_FUNCTION_NAME(type)(data, len, obj_ptr, arena)
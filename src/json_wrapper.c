@@ -10,8 +10,19 @@
  */
 
 
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <math.h>
+#include <float.h>
 #include <json_wrapper/json_wrapper.h>
 
+#if defined(_WIN32)
+#include <windows.h>
+#else
+#include <pthread.h>
+#endif
+
 
 /**
  * @brief The hook functions collection
@@ -25,6 +36,8 @@ typedef struct GET_STRUCT_NAME(Hook)
 
 /**
  * @brief A static global variable to store the hook functions with the default values initialized
+ * 
+ * @note It's shared by all threads, hook it before any other thread starts using json wrapper
  */
 static GET_STRUCT_NAME(Hook) g_hook = {
     .alloc_ = malloc,
@@ -32,6 +45,35 @@ static GET_STRUCT_NAME(Hook) g_hook = {
 };
 
 
+#if defined(__STDC_VERSION__) && __STDC_VERSION__ >= 201112L && !defined(__STDC_NO_THREADS__)
+#define THREAD_LOCAL _Thread_local
+#elif defined(_MSC_VER)
+#define THREAD_LOCAL __declspec(thread)
+#else
+#define THREAD_LOCAL __thread
+#endif
+
+/**
+ * @brief A static thread local variable to store the hook functions bound to the current thread
+ * 
+ * @note The hook functions are unbound while they're @p NULL, which falls back to @link g_hook
+ */
+static THREAD_LOCAL GET_STRUCT_NAME(Hook) t_hook;
+
+
+/**
+ * @brief Get the hook functions in effect for the current thread
+ * 
+ * @return const Hook_JSON* The hook bound to the current thread, or the global one
+ */
+static inline const GET_STRUCT_NAME(Hook) * hook_current(void);
+
+inline const GET_STRUCT_NAME(Hook) * hook_current(void)
+{
+    return NULL != t_hook.alloc_ ? &t_hook : &g_hook;
+}
+
+
 /**
  * @brief Hook the memory alloc function
  * 
@@ -64,6 +106,41 @@ void json_wrapper_hook_free(void (* free_)(void * ptr))
     }
 }
 
+/**
+ * @brief Bind the memory hook functions to the current thread only
+ * 
+ * @param alloc_ The alloc function
+ * @param free_ The free function
+ * @return int 0 for success, -1 for failure
+ */
+int json_wrapper_hook_thread(void * (* alloc_)(size_t size), void (* free_)(void * ptr))
+{
+    if (NULL == alloc_ && NULL == free_)
+    {
+        t_hook.alloc_ = NULL;
+        t_hook.free_ = NULL;
+        return 0;
+    }
+    ASSERT_RETURN(alloc_ && free_, -1);
+    t_hook.alloc_ = alloc_;
+    t_hook.free_ = free_;
+    return 0;
+}
+
+
+/**
+ * @brief Get the memory hook functions in effect for the current thread
+ * 
+ * @param alloc_ The alloc function
+ * @param free_ The free function
+ */
+void json_wrapper_hook_current(void * (** alloc_)(size_t size), void (** free_)(void * ptr))
+{
+    const GET_STRUCT_NAME(Hook) * hook = hook_current();
+    if (NULL != alloc_) *alloc_ = hook->alloc_;
+    if (NULL != free_) *free_ = hook->free_;
+}
+
 
 /**
  * @brief Alloc memory using the hook in json wrapper
@@ -73,7 +150,10 @@ void json_wrapper_hook_free(void (* free_)(void * ptr))
  */
 void * json_wrapper_alloc(size_t size)
 {
-    g_hook.alloc_(size);
+#if defined(JSON_WRAPPER_INSTRUMENT)
+    json_wrapper_instrument_alloc(size);
+#endif
+    return hook_current()->alloc_(size);
 }
 
 /**
@@ -84,33 +164,2482 @@ void * json_wrapper_alloc(size_t size)
 void json_wrapper_free(void * ptr)
 {
     ASSERT_RETURN_VOID(ptr);
-    g_hook.free_(ptr);
+    hook_current()->free_(ptr);
 }
 
 
-void JSON_2_FUNCTION_NAME(STRING)(cJSON * obj, STANDARD_TYPE(STRING) * dst)
+/**
+ * @brief The tag in front of every cJSON allocation telling where the memory comes from
+ */
+typedef union GET_STRUCT_NAME(CJSONTag)
 {
-    STANDARD_TYPE(STRING) src = (obj)->valuestring;
-    // STANDARD_TYPE(STRING) src = CONCAT(PRE_CONCAT(cJSON_Get, TYPE_2_CJSON_TYPE(STRING)), Value)(obj);
-    ASSERT_RETURN_VOID(src);
-    if (NULL != *dst) g_hook.free_(*dst);
-    size_t len = strlen(src);
-    *dst = g_hook.alloc_(1 + len);
-    ASSERT_RETURN_VOID(*dst);
-    memcpy(*dst, src, len);
-    (*dst)[len] = '\0';
+    struct GET_STRUCT_NAME(CJSONPool) * pool;   // the pool owning the node, NULL for alloced by the hook
+    max_align_t align_;
+} GET_STRUCT_NAME(CJSONTag);
+
+
+/**
+ * @brief A block of the cJSON node pool, linked in the free list while it's free
+ */
+typedef union GET_STRUCT_NAME(CJSONNode)
+{
+    union GET_STRUCT_NAME(CJSONNode) * next;
+    struct
+    {
+        GET_STRUCT_NAME(CJSONTag) tag;
+        char item[sizeof(cJSON)];
+    } used;
+} GET_STRUCT_NAME(CJSONNode);
+
+/**
+ * @brief The number of nodes in a chunk of the cJSON node pool
+ */
+#define CJSON_POOL_CHUNK_NODES 64
+
+/**
+ * @brief A chunk of the cJSON node pool, the nodes follow the header
+ */
+typedef struct GET_STRUCT_NAME(CJSONChunk)
+{
+    struct GET_STRUCT_NAME(CJSONChunk) * next;
+    void (* free_)(void * ptr);                 // the free function of the hook the chunk was alloced by
+    GET_STRUCT_NAME(CJSONNode) nodes[CJSON_POOL_CHUNK_NODES];
+} GET_STRUCT_NAME(CJSONChunk);
+
+/**
+ * @brief The cJSON node pool of a thread
+ * 
+ * @note Only the owner thread takes from @p free. The nodes freed on other threads are pushed to @p remote
+ *       and taken back by the owner when @p free runs out. @p pending goes down by one for each node pushed to
+ *       @p remote and up by @p out when the owner detaches, so after that it's the number of the nodes still alive,
+ *       the pool is freed by whoever brings it to @p 0, and the chunks stay until the last node is back
+ */
+typedef struct GET_STRUCT_NAME(CJSONPool)
+{
+    GET_STRUCT_NAME(CJSONNode) * free;
+    GET_STRUCT_NAME(CJSONNode) * remote;
+    GET_STRUCT_NAME(CJSONChunk) * chunks;
+    int64_t out;                                // the nodes taken minus the nodes freed on the owner thread
+    int64_t pending;
+    void (* free_)(void * ptr);                 // the free function of the hook the pool was alloced by
+} GET_STRUCT_NAME(CJSONPool);
+
+
+#if defined(_MSC_VER) && !defined(__clang__)
+#define POOL_CAS(ptr, old, new) \
+    ((void *) (old) == InterlockedCompareExchangePointer((void * volatile *) (ptr), (void *) (new), (void *) (old)))
+#define POOL_LOAD(ptr) (*(void * volatile *) (ptr))
+#define POOL_TAKE(ptr) InterlockedExchangePointer((void * volatile *) (ptr), NULL)
+#define POOL_ADD(counter, n) InterlockedAdd64((volatile LONG64 *) &(counter), (n))
+#else
+#define POOL_CAS(ptr, old, new) __sync_bool_compare_and_swap(ptr, old, new)
+#define POOL_LOAD(ptr) __atomic_load_n(ptr, __ATOMIC_RELAXED)
+#define POOL_TAKE(ptr) __atomic_exchange_n(ptr, NULL, __ATOMIC_ACQUIRE)
+#define POOL_ADD(counter, n) __atomic_add_fetch(&(counter), (n), __ATOMIC_ACQ_REL)
+#endif
+
+
+/**
+ * @brief Whether the cJSON items are alloced from the node pool, set once by @link json_wrapper_hook_cjson
+ */
+static bool g_cjson_pool = false;
+
+/**
+ * @brief A static thread local variable to store the cJSON node pool of the current thread
+ */
+static THREAD_LOCAL GET_STRUCT_NAME(CJSONPool) * t_cjson_pool;
+
+
+/**
+ * @brief Free the chunks and the pool itself
+ */
+static void cjson_pool_free(GET_STRUCT_NAME(CJSONPool) * pool)
+{
+    GET_STRUCT_NAME(CJSONChunk) * chunk = pool->chunks;
+    while (NULL != chunk)
+    {
+        GET_STRUCT_NAME(CJSONChunk) * next = chunk->next;
+        chunk->free_(chunk);
+        chunk = next;
+    }
+    pool->free_(pool);
+}
+
+/**
+ * @brief Detach the pool from its owner thread, it's freed now if all its nodes are back, or by the last free
+ * 
+ * @param ptr The pool
+ */
+static void cjson_pool_detach(void * ptr)
+{
+    GET_STRUCT_NAME(CJSONPool) * pool = ptr;
+    ASSERT_RETURN_VOID(pool);
+    if (0 == POOL_ADD(pool->pending, pool->out)) cjson_pool_free(pool);
+}
+
+/**
+ * @brief Detach the pool of a thread at its exit
+ * 
+ * @param ptr The pool
+ */
+#if defined(_WIN32)
+static void WINAPI cjson_pool_exit(void * ptr)
+#else
+static void cjson_pool_exit(void * ptr)
+#endif
+{
+    t_cjson_pool = NULL;
+    cjson_pool_detach(ptr);
 }
 
 
-void COPY_FUNCTION_NAME(STRING)(GET_STRUCT_NAME(STRING) * src, GET_STRUCT_NAME(STRING) * dst)
+#if defined(_WIN32)
+/**
+ * @brief The fiber local slot to detach the pool of a thread at its exit
+ */
+static DWORD g_cjson_pool_key = FLS_OUT_OF_INDEXES;
+static INIT_ONCE g_cjson_pool_once = INIT_ONCE_STATIC_INIT;
+
+static BOOL CALLBACK cjson_pool_key_create(PINIT_ONCE once, void * param, void ** context)
 {
-    ASSERT_RETURN_VOID(src && *src && dst);
-    if (NULL != *dst) g_hook.free_(*dst);
-    size_t len = strlen(*src);
-    *dst = g_hook.alloc_(len + 1);
-    ASSERT_RETURN_VOID(*dst);
-    memcpy(*dst, *src, len);
-    *dst[len] = '\0';
+    (void) once;
+    (void) param;
+    (void) context;
+    g_cjson_pool_key = FlsAlloc(cjson_pool_exit);
+    return TRUE;
+}
+
+/**
+ * @brief Register the pool of the current thread to be detached at its exit
+ */
+static void cjson_pool_register(GET_STRUCT_NAME(CJSONPool) * pool)
+{
+    InitOnceExecuteOnce(&g_cjson_pool_once, cjson_pool_key_create, NULL, NULL);
+    if (FLS_OUT_OF_INDEXES != g_cjson_pool_key) FlsSetValue(g_cjson_pool_key, pool);
+}
+#else
+/**
+ * @brief The thread specific key to detach the pool of a thread at its exit
+ */
+static pthread_key_t g_cjson_pool_key;
+static pthread_once_t g_cjson_pool_once = PTHREAD_ONCE_INIT;
+
+static void cjson_pool_key_create(void)
+{
+    pthread_key_create(&g_cjson_pool_key, cjson_pool_exit);
+}
+
+/**
+ * @brief Register the pool of the current thread to be detached at its exit
+ */
+static void cjson_pool_register(GET_STRUCT_NAME(CJSONPool) * pool)
+{
+    pthread_once(&g_cjson_pool_once, cjson_pool_key_create);
+    pthread_setspecific(g_cjson_pool_key, pool);
+}
+#endif
+
+
+/**
+ * @brief Take a free node from the pool of the current thread, created on its first use
+ *
+ * @return CJSONNode* The node, @p NULL for out of memory
+ */
+static GET_STRUCT_NAME(CJSONNode) * cjson_pool_take(void)
+{
+    GET_STRUCT_NAME(CJSONPool) * pool = t_cjson_pool;
+    if (NULL == pool)
+    {
+        pool = json_wrapper_alloc(sizeof(GET_STRUCT_NAME(CJSONPool)));
+        ASSERT_RETURN(pool, NULL);
+        memset(pool, 0, sizeof(GET_STRUCT_NAME(CJSONPool)));
+        pool->free_ = hook_current()->free_;
+        t_cjson_pool = pool;
+        cjson_pool_register(pool);
+    }
+    if (NULL == pool->free && NULL != POOL_LOAD(&pool->remote))
+    {
+        pool->free = POOL_TAKE(&pool->remote);
+    }
+    if (NULL == pool->free)
+    {
+        GET_STRUCT_NAME(CJSONChunk) * chunk = json_wrapper_alloc(sizeof(GET_STRUCT_NAME(CJSONChunk)));
+        ASSERT_RETURN(chunk, NULL);
+        chunk->free_ = hook_current()->free_;
+        size_t i = 0;
+        for (i = 0; i < CJSON_POOL_CHUNK_NODES; ++i)
+        {
+            chunk->nodes[i].next = pool->free;
+            pool->free = &chunk->nodes[i];
+        }
+        chunk->next = pool->chunks;
+        pool->chunks = chunk;
+    }
+    GET_STRUCT_NAME(CJSONNode) * node = pool->free;
+    pool->free = node->next;
+    ++pool->out;
+    node->used.tag.pool = pool;
+    return node;
+}
+
+/**
+ * @brief Give a node back to its pool, to the free list on the owner thread, or to the remote list on others
+ */
+static void cjson_pool_give(GET_STRUCT_NAME(CJSONNode) * node, GET_STRUCT_NAME(CJSONPool) * pool)
+{
+    if (pool == t_cjson_pool)
+    {
+        node->next = pool->free;
+        pool->free = node;
+        --pool->out;
+        return;
+    }
+    GET_STRUCT_NAME(CJSONNode) * head = NULL;
+    do
+    {
+        head = POOL_LOAD(&pool->remote);
+        node->next = head;
+    } while (!POOL_CAS(&pool->remote, head, node));
+    if (0 == POOL_ADD(pool->pending, -1)) cjson_pool_free(pool);
+}
+
+
+/**
+ * @brief The alloc function handed to cJSON, which allocs the items from the node pool and others by the hook
+ *
+ * @param size The memory size
+ * @return void* The pointer of memory
+ */
+static void * cjson_alloc(size_t size)
+{
+    GET_STRUCT_NAME(CJSONTag) * tag = NULL;
+    if (g_cjson_pool && sizeof(cJSON) == size)
+    {
+        GET_STRUCT_NAME(CJSONNode) * node = cjson_pool_take();
+        ASSERT_RETURN(node, NULL);
+        return node->used.item;
+    }
+    tag = json_wrapper_alloc(sizeof(GET_STRUCT_NAME(CJSONTag)) + size);
+    ASSERT_RETURN(tag, NULL);
+    tag->pool = NULL;
+    return tag + 1;
+}
+
+/**
+ * @brief The free function handed to cJSON
+ *
+ * @param ptr The pointer alloced by @link cjson_alloc
+ */
+static void cjson_free(void * ptr)
+{
+    ASSERT_RETURN_VOID(ptr);
+    GET_STRUCT_NAME(CJSONTag) * tag = (GET_STRUCT_NAME(CJSONTag) *) ptr - 1;
+    if (NULL != tag->pool)
+    {
+        cjson_pool_give((GET_STRUCT_NAME(CJSONNode) *) tag, tag->pool);
+        return;
+    }
+    json_wrapper_free(tag);
+}
+
+/**
+ * @brief Route the allocations of cJSON through the hooks in json wrapper
+ *
+ * @param pool Whether to alloc the cJSON items from a fixed-size node pool of each thread
+ */
+void json_wrapper_hook_cjson(bool pool)
+{
+    cJSON_Hooks hooks = {
+        .malloc_fn = cjson_alloc,
+        .free_fn = cjson_free,
+    };
+    g_cjson_pool = pool;
+    cJSON_InitHooks(&hooks);
+}
+
+/**
+ * @brief Release the cJSON node pool of the current thread, the next item alloced on it starts a new pool
+ */
+void json_wrapper_cjson_pool_release(void)
+{
+    GET_STRUCT_NAME(CJSONPool) * pool = t_cjson_pool;
+    ASSERT_RETURN_VOID(pool);
+    t_cjson_pool = NULL;
+#if defined(_WIN32)
+    if (FLS_OUT_OF_INDEXES != g_cjson_pool_key) FlsSetValue(g_cjson_pool_key, NULL);
+#else
+    pthread_setspecific(g_cjson_pool_key, NULL);
+#endif
+    cjson_pool_detach(pool);
+}
+
+
+#if defined(_MSC_VER) && !defined(__clang__)
+#define KEY_HASH_LOAD(state) (*(volatile long *) &(state))
+#define KEY_HASH_STORE(state, value) (*(volatile long *) &(state) = (value))
+#define KEY_HASH_CLAIM(state) (0 == InterlockedCompareExchange((volatile LONG *) &(state), 1, 0))
+#else
+#define KEY_HASH_LOAD(state) __atomic_load_n(&(state), __ATOMIC_ACQUIRE)
+#define KEY_HASH_STORE(state, value) __atomic_store_n(&(state), (value), __ATOMIC_RELEASE)
+#define KEY_HASH_CLAIM(state) __sync_bool_compare_and_swap(&(state), 0, 1)
+#endif
+
+/**
+ * @brief Hash a json key by FNV-1a
+ */
+static inline size_t key_hash(const char * key, size_t len)
+{
+    uint32_t h = 2166136261u;
+    size_t i = 0;
+    for (i = 0; i < len; ++i) h = (h ^ (unsigned char) key[i]) * 16777619u;
+    return h & (KEY_HASH_SLOTS - 1);
+}
+
+/**
+ * @brief Find the field index of a json key
+ * 
+ * @param hash The key hash of the struct
+ * @param keys The keys of the fields
+ * @param count The number of fields
+ * @param key The json key, which doesn't need to be '\0' terminated
+ * @param len The length of the json key
+ * @return int The field index, @p -1 for no field matched
+ */
+int json_wrapper_key_find(GET_STRUCT_NAME(KeyHash) * hash, const GET_STRUCT_NAME(Key) * keys, size_t count,
+    const char * key, size_t len)
+{
+    size_t i = 0;
+    if (NULL != hash && count <= KEY_HASH_SLOTS / 2 && 2 != KEY_HASH_LOAD(hash->state) && KEY_HASH_CLAIM(hash->state))
+    {
+        memset(hash->slots, 0, sizeof(hash->slots));
+        for (i = 0; i < count; ++i)
+        {
+            size_t slot = key_hash(keys[i].name, keys[i].len);
+            while (0 != hash->slots[slot]) slot = (slot + 1) & (KEY_HASH_SLOTS - 1);
+            hash->slots[slot] = (uint8_t) (i + 1);
+        }
+        KEY_HASH_STORE(hash->state, 2);
+    }
+    if (NULL != hash && 2 == KEY_HASH_LOAD(hash->state))
+    {
+        size_t slot = key_hash(key, len);
+        for (; 0 != hash->slots[slot]; slot = (slot + 1) & (KEY_HASH_SLOTS - 1))
+        {
+            i = hash->slots[slot] - 1;
+            if (keys[i].len == len && 0 == memcmp(keys[i].name, key, len)) return (int) i;
+        }
+        return -1;
+    }
+    for (i = 0; i < count; ++i)
+    {
+        if (keys[i].len == len && keys[i].name[0] == key[0] && 0 == memcmp(keys[i].name, key, len)) return (int) i;
+    }
+    return -1;
+}
+
+
+/**
+ * @brief The initial capacity of a buffer
+ */
+#define BUFFER_INIT_CAP 256
+
+
+/**
+ * @brief Init a fixed buffer over the memory of the caller
+ * 
+ * @param buf The buffer
+ * @param data The memory, @p NULL with @p cap 0 to only count the length
+ * @param cap The size of @p data
+ */
+void json_wrapper_buffer_init_fixed(GET_STRUCT_NAME(Buffer) * buf, char * data, size_t cap)
+{
+    ASSERT_RETURN_VOID(buf);
+    buf->data = data;
+    buf->len = 0;
+    buf->cap = NULL != data ? cap : 0;
+    buf->fixed = true;
+}
+
+/**
+ * @brief Make sure there's room for @p size more bytes and the terminating '\0' in @p buf
+ * 
+ * @param buf The buffer
+ * @param size The size to append
+ * @return int @p 0 for success, @p -1 for failure
+ */
+int json_wrapper_buffer_reserve(GET_STRUCT_NAME(Buffer) * buf, size_t size)
+{
+    ASSERT_RETURN(buf, -1);
+    size_t need = buf->len + size + 1;
+    ASSERT_RETURN(need > buf->cap, 0);
+    ASSERT_RETURN(!buf->fixed, -1);
+    size_t cap = buf->cap ? buf->cap : BUFFER_INIT_CAP;
+    while (cap < need) cap <<= 1;
+    char * data = json_wrapper_alloc(cap);
+    ASSERT_RETURN(data, -1);
+    if (NULL != buf->data)
+    {
+        memcpy(data, buf->data, buf->len);
+        json_wrapper_free(buf->data);
+    }
+    buf->data = data;
+    buf->cap = cap;
+    return 0;
+}
+
+/**
+ * @brief Append an integer as a json number into @p buf
+ * 
+ * @param buf The buffer
+ * @param value The integer
+ * @return int @p 0 for success, @p -1 for failure
+ */
+int json_wrapper_buffer_append_int(GET_STRUCT_NAME(Buffer) * buf, long value)
+{
+    return json_wrapper_buffer_append_int64(buf, value);
+}
+
+/**
+ * @brief The pairs of digits from "00" to "99", so the integers are converted 2 digits at a time
+ */
+static const char g_digit_pairs[] =
+    "00010203040506070809101112131415161718192021222324252627282930313233343536373839"
+    "40414243444546474849505152535455565758596061626364656667686970717273747576777879"
+    "8081828384858687888990919293949596979899";
+
+/**
+ * @brief The powers of ten which are exact in a double
+ */
+static const double g_pow10[] = {
+    1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+    1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22,
+};
+
+/**
+ * @brief Write the decimal digits of @p u backwards, ending before @p end
+ * 
+ * @param end The end of the digits
+ * @param u The integer
+ * @return char* The first digit
+ */
+static char * format_uint64(char * end, uint64_t u)
+{
+    char * p = end;
+    while (u >= 100)
+    {
+        unsigned i = (unsigned) (u % 100) * 2;
+        u /= 100;
+        *--p = g_digit_pairs[i + 1];
+        *--p = g_digit_pairs[i];
+    }
+    if (u >= 10)
+    {
+        *--p = g_digit_pairs[u * 2 + 1];
+        *--p = g_digit_pairs[u * 2];
+    } else
+    {
+        *--p = (char) ('0' + u);
+    }
+    return p;
+}
+
+/**
+ * @brief Format a finite double as the shortest decimal which is read back as the same value
+ * 
+ * @note The value is scaled by the powers of ten to the first integer which converts back to it, which finds
+ *       the decimals of a few fractional digits without printing, the others are printed by "%.*g" with increasing
+ *       precision from the digits a double always keeps, or from 1 for the subnormals, until they're read back the same
+ * 
+ * @param text The text, of at least 32 bytes
+ * @param value The value
+ * @param single Whether the value is a float, which needs only to be read back the same as a float
+ * @return size_t The length of the text, @p 0 for the value is not finite
+ */
+static size_t format_double(char * text, double value, bool single)
+{
+    ASSERT_RETURN(isfinite(value), 0);
+    char * p = text;
+    if (signbit(value))
+    {
+        *p++ = '-';
+        value = -value;
+    }
+    int max_scale = single ? 9 : 15;
+    double max_n = single ? 1e9 : 9007199254740992.0;
+    int k = 0;
+    for (k = 0; k <= max_scale; ++k)
+    {
+        double scaled = value * g_pow10[k];
+        ASSERT_BREAK(scaled < max_n);
+        uint64_t n = (uint64_t) (scaled + 0.5);
+        double back = (double) n / g_pow10[k];
+        if (single ? (float) back != (float) value : back != value) continue;
+        char digits[24];
+        char * end = digits + sizeof(digits);
+        char * first = format_uint64(end, n);
+        while (end - first <= k) *--first = '0';
+        for (; first < end; ++first)
+        {
+            if (end - first == k) *p++ = '.';
+            *p++ = *first;
+        }
+        return p - text;
+    }
+    int precision = single ? (value < FLT_MIN ? 1 : 6) : (value < DBL_MIN ? 1 : 15);
+    int max_precision = single ? 9 : 17;
+    int len = 0;
+    for (; precision <= max_precision; ++precision)
+    {
+        len = snprintf(p, 30, "%.*g", precision, value);
+        if (precision == max_precision) break;
+        if (single ? strtof(p, NULL) == (float) value : strtod(p, NULL) == value) break;
+    }
+    return p - text + len;
+}
+
+/**
+ * @brief Append a 64 bits integer as a json number into @p buf
+ * 
+ * @param buf The buffer
+ * @param value The integer
+ * @return int @p 0 for success, @p -1 for failure
+ */
+int json_wrapper_buffer_append_int64(GET_STRUCT_NAME(Buffer) * buf, int64_t value)
+{
+    char digits[24];
+    char * end = digits + sizeof(digits);
+    char * p = format_uint64(end, value < 0 ? 0 - (uint64_t) value : (uint64_t) value);
+    if (value < 0) *--p = '-';
+    return json_wrapper_buffer_append(buf, p, end - p);
+}
+
+/**
+ * @brief Append an unsigned 64 bits integer as a json number into @p buf
+ * 
+ * @param buf The buffer
+ * @param value The integer
+ * @return int @p 0 for success, @p -1 for failure
+ */
+int json_wrapper_buffer_append_uint64(GET_STRUCT_NAME(Buffer) * buf, uint64_t value)
+{
+    char digits[24];
+    char * end = digits + sizeof(digits);
+    char * p = format_uint64(end, value);
+    return json_wrapper_buffer_append(buf, p, end - p);
+}
+
+/**
+ * @brief Append a double as the shortest json number which is read back as the same value into @p buf,
+ *        infinities and NaN are appended as null
+ * 
+ * @param buf The buffer
+ * @param value The double
+ * @return int @p 0 for success, @p -1 for failure
+ */
+int json_wrapper_buffer_append_double(GET_STRUCT_NAME(Buffer) * buf, double value)
+{
+    char text[32];
+    size_t len = format_double(text, value, false);
+    ASSERT_RETURN(len, json_wrapper_buffer_append(buf, "null", 4));
+    return json_wrapper_buffer_append(buf, text, len);
+}
+
+/**
+ * @brief Append a float as the shortest json number which is read back as the same float into @p buf,
+ *        infinities and NaN are appended as null
+ * 
+ * @param buf The buffer
+ * @param value The float
+ * @return int @p 0 for success, @p -1 for failure
+ */
+int json_wrapper_buffer_append_float(GET_STRUCT_NAME(Buffer) * buf, float value)
+{
+    char text[32];
+    size_t len = format_double(text, value, true);
+    ASSERT_RETURN(len, json_wrapper_buffer_append(buf, "null", 4));
+    return json_wrapper_buffer_append(buf, text, len);
+}
+
+/**
+ * @brief Append @p len bytes of @p str as a quoted and escaped json string into @p buf, @p NULL is appended as null
+ * 
+ * @note The escaping is the same as cJSON: '"', '\\' and the short control escapes use a backslash,
+ *       other control characters, '\0' included, are written as \u00XX, all the other bytes are copied as they are.
+ *       The runs between the escapes are found by @link json_wrapper_scan_escape and copied at once
+ * 
+ * @param buf The buffer
+ * @param str The string
+ * @param len The length of the string
+ * @return int @p 0 for success, @p -1 for failure
+ */
+int json_wrapper_buffer_append_str(GET_STRUCT_NAME(Buffer) * buf, const char * str, size_t len)
+{
+    ASSERT_RETURN(str, json_wrapper_buffer_append(buf, "null", 4));
+    static const char hex[] = "0123456789abcdef";
+    if (!buf->fixed) ASSERT_RETURN(0 == json_wrapper_buffer_reserve(buf, len + 2), -1);
+    ASSERT_RETURN(0 == json_wrapper_buffer_append(buf, "\"", 1), -1);
+    const char * run = str;
+    const char * end = str + len;
+    for (;;)
+    {
+        const char * p = json_wrapper_scan_escape(run, end);
+        ASSERT_RETURN(0 == json_wrapper_buffer_append(buf, run, p - run), -1);
+        ASSERT_BREAK(p < end);
+        unsigned char c = (unsigned char) *p;
+        char escaped[6] = { '\\', 0, '0', '0', 0, 0 };
+        size_t len = 2;
+        if ('"' == c || '\\' == c) escaped[1] = c;
+        else if ('\b' == c) escaped[1] = 'b';
+        else if ('\f' == c) escaped[1] = 'f';
+        else if ('\n' == c) escaped[1] = 'n';
+        else if ('\r' == c) escaped[1] = 'r';
+        else if ('\t' == c) escaped[1] = 't';
+        else
+        {
+            escaped[1] = 'u';
+            escaped[4] = hex[c >> 4];
+            escaped[5] = hex[c & 0xF];
+            len = 6;
+        }
+        ASSERT_RETURN(0 == json_wrapper_buffer_append(buf, escaped, len), -1);
+        run = p + 1;
+    }
+    return json_wrapper_buffer_append(buf, "\"", 1);
+}
+
+/**
+ * @brief Append a string as a quoted and escaped json string into @p buf, @p NULL is appended as null
+ * 
+ * @param buf The buffer
+ * @param str The string
+ * @return int @p 0 for success, @p -1 for failure
+ */
+int json_wrapper_buffer_append_string(GET_STRUCT_NAME(Buffer) * buf, const char * str)
+{
+    ASSERT_RETURN(str, json_wrapper_buffer_append(buf, "null", 4));
+    return json_wrapper_buffer_append_str(buf, str, strlen(str));
+}
+
+/**
+ * @brief Close a json object whose members were appended from @p start as ',"key":value' pairs
+ * 
+ * @param buf The buffer
+ * @param start The length of @p buf before the first member was appended
+ * @return int @p 0 for success, @p -1 for failure
+ */
+int json_wrapper_buffer_close_object(GET_STRUCT_NAME(Buffer) * buf, size_t start)
+{
+    ASSERT_RETURN(buf, -1);
+    ASSERT_RETURN(buf->len != start, json_wrapper_buffer_append(buf, "{}", 2));
+    if (start + 1 < buf->cap) buf->data[start] = '{';
+    return json_wrapper_buffer_append(buf, "}", 1);
+}
+
+/**
+ * @brief Take the '\0' terminated text out of @p buf, the buffer is reset to empty
+ * 
+ * @param buf The buffer
+ * @return char* The text which should be freed by @link json_wrapper_free, @p NULL for failure
+ */
+char * json_wrapper_buffer_detach(GET_STRUCT_NAME(Buffer) * buf)
+{
+    ASSERT_RETURN(buf, NULL);
+    ASSERT_RETURN(0 == json_wrapper_buffer_reserve(buf, 0), NULL);
+    char * data = buf->data;
+    data[buf->len] = '\0';
+    memset(buf, 0, sizeof(GET_STRUCT_NAME(Buffer)));
+    return data;
+}
+
+/**
+ * @brief Release the memory of @p buf, the buffer is reset to empty
+ * 
+ * @param buf The buffer
+ */
+void json_wrapper_buffer_release(GET_STRUCT_NAME(Buffer) * buf)
+{
+    ASSERT_RETURN_VOID(buf);
+    if (NULL != buf->data) json_wrapper_free(buf->data);
+    memset(buf, 0, sizeof(GET_STRUCT_NAME(Buffer)));
+}
+
+/**
+ * @brief Stitch the json members encoded into @p fragments as ',"key":value' into a json object in @p out
+ * 
+ * @param out The buffer of the object, which is '\0' terminated
+ * @param fragments The fragments
+ * @param count The number of fragments
+ * @return int @p 0 for success, @p -1 for failure
+ */
+int json_wrapper_tracked_stitch(GET_STRUCT_NAME(Buffer) * out, const GET_STRUCT_NAME(Buffer) * fragments, size_t count)
+{
+    ASSERT_RETURN(out && (fragments || 0 == count), -1);
+    size_t size = 0;
+    size_t i = 0;
+    for (i = 0; i < count; ++i)
+    {
+        size += fragments[i].len;
+    }
+    out->len = 0;
+    ASSERT_RETURN(0 == json_wrapper_buffer_reserve(out, size + 2), -1);
+    for (i = 0; i < count; ++i)
+    {
+        ASSERT_RETURN(0 == json_wrapper_buffer_append(out, fragments[i].data, fragments[i].len), -1);
+    }
+    ASSERT_RETURN(0 == json_wrapper_buffer_close_object(out, 0), -1);
+    out->data[out->len] = '\0';
+    return 0;
+}
+
+
+/**
+ * @brief Init a sink which appends the records into @p buf, which may be growable or fixed
+ *
+ * @note No '\0' is appended, the batch fails if a fixed @p buf has no room left for it after the records
+ *
+ * @param sink The sink
+ * @param buf The buffer
+ * @param format The layout of the records
+ */
+void json_wrapper_sink_init_buffer(GET_STRUCT_NAME(Sink) * sink, GET_STRUCT_NAME(Buffer) * buf, GET_STRUCT_NAME(Batch) format)
+{
+    ASSERT_RETURN_VOID(sink && buf);
+    memset(sink, 0, sizeof(GET_STRUCT_NAME(Sink)));
+    sink->buf = buf;
+    sink->format = format;
+}
+
+/**
+ * @brief Init a sink which passes the records to @p write_ in pieces of about @p flush bytes
+ *
+ * @param sink The sink
+ * @param write_ The write callback
+ * @param ctx The context of @p write_
+ * @param flush The size of a piece, @p 0 for @link SINK_FLUSH_SIZE
+ * @param format The layout of the records
+ */
+void json_wrapper_sink_init_write(GET_STRUCT_NAME(Sink) * sink, GET_STRUCT_NAME(SinkWrite) write_, void * ctx,
+    size_t flush, GET_STRUCT_NAME(Batch) format)
+{
+    ASSERT_RETURN_VOID(sink && write_);
+    memset(sink, 0, sizeof(GET_STRUCT_NAME(Sink)));
+    sink->write_ = write_;
+    sink->ctx = ctx;
+    sink->flush = flush ? flush : SINK_FLUSH_SIZE;
+    sink->format = format;
+}
+
+/**
+ * @brief Pass the text gathered in the working buffer of @p sink to its write callback
+ *
+ * @param sink The sink
+ * @return int @p 0 for success, @p -1 for failure
+ */
+int json_wrapper_sink_flush(GET_STRUCT_NAME(Sink) * sink)
+{
+    ASSERT_RETURN(sink, -1);
+    ASSERT_RETURN(NULL == sink->buf && sink->work.len > 0, 0);
+    int rc = sink->write_(sink->ctx, sink->work.data, sink->work.len);
+    sink->work.len = 0;
+    return 0 == rc ? 0 : -1;
+}
+
+/**
+ * @brief Start a batch, a json array is opened
+ *
+ * @param sink The sink
+ * @return int @p 0 for success, @p -1 for failure
+ */
+int json_wrapper_sink_begin(GET_STRUCT_NAME(Sink) * sink)
+{
+    ASSERT_RETURN(sink, -1);
+    ASSERT_RETURN(BATCH_ARRAY == sink->format, 0);
+    return json_wrapper_buffer_append(json_wrapper_sink_buffer(sink), "[", 1);
+}
+
+/**
+ * @brief End a batch, a json array is closed and the working buffer is flushed
+ *
+ * @param sink The sink
+ * @return int @p 0 for success, @p -1 for failure
+ */
+int json_wrapper_sink_end(GET_STRUCT_NAME(Sink) * sink)
+{
+    ASSERT_RETURN(sink, -1);
+    if (BATCH_ARRAY == sink->format)
+    {
+        ASSERT_RETURN(0 == json_wrapper_buffer_append(json_wrapper_sink_buffer(sink), "]", 1), -1);
+    }
+    return json_wrapper_sink_flush(sink);
+}
+
+/**
+ * @brief Release the working buffer of @p sink
+ *
+ * @param sink The sink
+ */
+void json_wrapper_sink_release(GET_STRUCT_NAME(Sink) * sink)
+{
+    ASSERT_RETURN_VOID(sink);
+    json_wrapper_buffer_release(&sink->work);
+}
+
+
+/**
+ * @brief The size of an arena chunk header, which keeps the memory after it aligned
+ */
+#define ARENA_CHUNK_HEADER ((sizeof(GET_STRUCT_NAME(ArenaChunk)) + ARENA_ALIGN - 1) & ~((size_t) ARENA_ALIGN - 1))
+
+
+/**
+ * @brief Init an arena
+ * 
+ * @param arena The arena
+ * @param chunk_size The size of each chunk, @p 0 for @link ARENA_CHUNK_SIZE
+ */
+void json_wrapper_arena_init(GET_STRUCT_NAME(Arena) * arena, size_t chunk_size)
+{
+    ASSERT_RETURN_VOID(arena);
+    memset(arena, 0, sizeof(GET_STRUCT_NAME(Arena)));
+    arena->chunk_size = chunk_size;
+}
+
+/**
+ * @brief Move to the next chunk which has room for @p size bytes, a new chunk is alloced if there's none
+ * 
+ * @param arena The arena
+ * @param size The aligned size
+ * @return void* The pointer of memory, @p NULL for failure
+ */
+void * json_wrapper_arena_grow(GET_STRUCT_NAME(Arena) * arena, size_t size)
+{
+    ASSERT_RETURN(arena, NULL);
+    GET_STRUCT_NAME(ArenaChunk) * chunk = arena->chunk ? arena->chunk->next : arena->head;
+    if (NULL == chunk || chunk->size < size)
+    {
+        size_t chunk_size = arena->chunk_size ? arena->chunk_size : ARENA_CHUNK_SIZE;
+        if (chunk_size < size) chunk_size = size;
+        GET_STRUCT_NAME(ArenaChunk) * fresh = json_wrapper_alloc(ARENA_CHUNK_HEADER + chunk_size);
+        ASSERT_RETURN(fresh, NULL);
+        fresh->size = chunk_size;
+        fresh->next = chunk;
+        if (NULL != arena->chunk) arena->chunk->next = fresh;
+        else arena->head = fresh;
+        chunk = fresh;
+    }
+    arena->chunk = chunk;
+    arena->cur = (char *) chunk + ARENA_CHUNK_HEADER;
+    arena->end = arena->cur + chunk->size;
+    void * ptr = arena->cur;
+    arena->cur += size;
+    return ptr;
+}
+
+/**
+ * @brief Release everything alloced from an arena at once, the chunks are kept to be reused
+ * 
+ * @param arena The arena
+ */
+void json_wrapper_arena_reset(GET_STRUCT_NAME(Arena) * arena)
+{
+    ASSERT_RETURN_VOID(arena);
+    arena->chunk = NULL;
+    arena->cur = NULL;
+    arena->end = NULL;
+}
+
+/**
+ * @brief Free all the chunks of an arena, the arena is reset to empty
+ * 
+ * @param arena The arena
+ */
+void json_wrapper_arena_release(GET_STRUCT_NAME(Arena) * arena)
+{
+    ASSERT_RETURN_VOID(arena);
+    GET_STRUCT_NAME(ArenaChunk) * chunk = arena->head;
+    while (NULL != chunk)
+    {
+        GET_STRUCT_NAME(ArenaChunk) * next = chunk->next;
+        json_wrapper_free(chunk);
+        chunk = next;
+    }
+    json_wrapper_arena_init(arena, arena->chunk_size);
+}
+
+
+/**
+ * @brief Init a reader over @p len bytes of @p data
+ * 
+ * @param r The reader
+ * @param data The json text
+ * @param len The length of json text
+ */
+void json_wrapper_reader_init(GET_STRUCT_NAME(Reader) * r, const char * data, size_t len)
+{
+    ASSERT_RETURN_VOID(r);
+    r->cur = data;
+    r->end = data + len;
+    r->arena = NULL;
+    r->writable = false;
+    r->patch = false;
+    r->index = NULL;
+    r->begin = data;
+    r->token = 0;
+}
+
+/**
+ * @brief Skip the whitespaces and consume the character @p c
+ * 
+ * @param r The reader
+ * @param c The expected character
+ * @return int @p 0 for success, @p -1 for the next character is not @p c
+ */
+int json_wrapper_reader_expect(GET_STRUCT_NAME(Reader) * r, char c)
+{
+    ASSERT_RETURN((unsigned char) c == json_wrapper_reader_peek(r), -1);
+    ++r->cur;
+    return 0;
+}
+
+/**
+ * @brief Move to the item @p index of an object or array which has been opened by @link json_wrapper_reader_expect
+ * 
+ * @param r The reader
+ * @param close The closing character, '}' for an object and ']' for an array
+ * @param index The index of the item to move to, the comma is consumed for the items except the first one
+ * @return int @p 1 for there's an item, @p 0 for the closing character is consumed, @p -1 for failure
+ */
+int json_wrapper_reader_next(GET_STRUCT_NAME(Reader) * r, char close, size_t index)
+{
+    int c = json_wrapper_reader_peek(r);
+    if ((unsigned char) close == c)
+    {
+        ++r->cur;
+        return 0;
+    }
+    ASSERT_RETURN(-1 != c, -1);
+    if (index > 0)
+    {
+        ASSERT_RETURN(',' == c, -1);
+        ++r->cur;
+    }
+    return 1;
+}
+
+/**
+ * @brief Find the closing quote of the string which starts at @p p, @p p is just after the opening quote
+ * 
+ * @param p The begin of the string content
+ * @param end The end of text
+ * @param escaped Set to @p true if there're escapes in the string
+ * @return const char* The closing quote, @p NULL for an unterminated string
+ */
+static const char * reader_string_end(const char * p, const char * end, bool * escaped)
+{
+    *escaped = false;
+    const char * quote = memchr(p, '"', end - p);
+    ASSERT_RETURN(quote, NULL);
+    const char * slash = memchr(p, '\\', quote - p);
+    ASSERT_RETURN(slash, quote);
+    *escaped = true;
+    for (p = slash; p < end; ++p)
+    {
+        if ('\\' == *p) ++p;
+        else if ('"' == *p) return p;
+    }
+    return NULL;
+}
+
+/**
+ * @brief Parse 4 hex digits
+ * 
+ * @return int The value, @p -1 for invalid digits
+ */
+static int reader_hex4(const char * p)
+{
+    int value = 0;
+    int i = 0;
+    for (; i < 4; ++i)
+    {
+        char c = p[i];
+        value <<= 4;
+        if (c >= '0' && c <= '9') value |= c - '0';
+        else if (c >= 'a' && c <= 'f') value |= c - 'a' + 10;
+        else if (c >= 'A' && c <= 'F') value |= c - 'A' + 10;
+        else return -1;
+    }
+    return value;
+}
+
+/**
+ * @brief Append @p n bytes to the output of @link reader_unescape, the bytes beyond @p cap are counted but dropped
+ * 
+ * @note The output may overlap the input when a string is unescaped in place
+ */
+static void reader_put(char * out, size_t cap, size_t * len, const char * data, size_t n)
+{
+    if (*len < cap) memmove(out + *len, data, n < cap - *len ? n : cap - *len);
+    *len += n;
+}
+
+/**
+ * @brief Unescape the string content between @p p and @p end into @p out, which has @p cap bytes
+ * 
+ * @note At most @p end - @p p bytes are produced. Those beyond @p cap are dropped, the whole string is checked anyway
+ * 
+ * @return long The length of the unescaped string including the dropped bytes, @p -1 for invalid escapes
+ */
+static long reader_unescape(const char * p, const char * end, char * out, size_t cap)
+{
+    size_t len = 0;
+    while (p < end)
+    {
+        const char * slash = memchr(p, '\\', end - p);
+        const char * run = NULL != slash ? slash : end;
+        reader_put(out, cap, &len, p, run - p);
+        p = run;
+        if (p == end) break;
+        ASSERT_RETURN(p + 1 < end, -1);
+        char c = p[1];
+        char seq[4] = { c, 0, 0, 0 };
+        size_t n = 1;
+        p += 2;
+        if ('b' == c) seq[0] = '\b';
+        else if ('f' == c) seq[0] = '\f';
+        else if ('n' == c) seq[0] = '\n';
+        else if ('r' == c) seq[0] = '\r';
+        else if ('t' == c) seq[0] = '\t';
+        else if ('"' == c || '\\' == c || '/' == c) seq[0] = c;
+        else if ('u' == c)
+        {
+            ASSERT_RETURN(end - p >= 4, -1);
+            long code = reader_hex4(p);
+            ASSERT_RETURN(code >= 0, -1);
+            p += 4;
+            if (code >= 0xD800 && code <= 0xDBFF)
+            {
+                ASSERT_RETURN(end - p >= 6 && '\\' == p[0] && 'u' == p[1], -1);
+                long low = reader_hex4(p + 2);
+                ASSERT_RETURN(low >= 0xDC00 && low <= 0xDFFF, -1);
+                p += 6;
+                code = 0x10000 + (((code & 0x3FF) << 10) | (low & 0x3FF));
+            }
+            if (code < 0x80)
+            {
+                seq[0] = (char) code;
+            } else if (code < 0x800)
+            {
+                seq[0] = (char) (0xC0 | (code >> 6));
+                seq[1] = (char) (0x80 | (code & 0x3F));
+                n = 2;
+            } else if (code < 0x10000)
+            {
+                seq[0] = (char) (0xE0 | (code >> 12));
+                seq[1] = (char) (0x80 | ((code >> 6) & 0x3F));
+                seq[2] = (char) (0x80 | (code & 0x3F));
+                n = 3;
+            } else
+            {
+                seq[0] = (char) (0xF0 | (code >> 18));
+                seq[1] = (char) (0x80 | ((code >> 12) & 0x3F));
+                seq[2] = (char) (0x80 | ((code >> 6) & 0x3F));
+                seq[3] = (char) (0x80 | (code & 0x3F));
+                n = 4;
+            }
+        } else return -1;
+        reader_put(out, cap, &len, seq, n);
+    }
+    return (long) len;
+}
+
+/**
+ * @brief Read an object key and the colon after it
+ * 
+ * @note The key is not copied unless it's escaped, an escaped key longer than @link READER_KEY_MAX
+ *       is returned with length @p 0 so that it matches nothing
+ * 
+ * @param r The reader
+ * @param key The key, which points into the text or the reader, it's not '\0' terminated
+ * @param len The length of the key
+ * @return int @p 0 for success, @p -1 for failure
+ */
+int json_wrapper_reader_key(GET_STRUCT_NAME(Reader) * r, const char ** key, size_t * len)
+{
+    ASSERT_RETURN(0 == json_wrapper_reader_expect(r, '"'), -1);
+    bool escaped = false;
+    const char * quote = reader_string_end(r->cur, r->end, &escaped);
+    ASSERT_RETURN(quote, -1);
+    if (!escaped)
+    {
+        *key = r->cur;
+        *len = quote - r->cur;
+    } else
+    {
+        *key = r->key;
+        *len = 0;
+        if (quote - r->cur <= READER_KEY_MAX)
+        {
+            long n = reader_unescape(r->cur, quote, r->key, READER_KEY_MAX);
+            ASSERT_RETURN(n >= 0, -1);
+            *len = n;
+        }
+    }
+    r->cur = quote + 1;
+    return json_wrapper_reader_expect(r, ':');
+}
+
+/**
+ * @brief Find the entry of the index at the offset @p pos, looking from the entry the cursor was left last time
+ * 
+ * @note The reader doesn't track the entries it consumes without the index, so the entry of the last jump
+ *       is only a hint: the few entries after it are checked, then the rest are binary searched, O(log n)
+ * 
+ * @return size_t The entry, the count of the index for none
+ */
+static size_t reader_token(GET_STRUCT_NAME(Reader) * r, uint32_t pos)
+{
+    const GET_STRUCT_NAME(Index) * index = r->index;
+    size_t lo = r->token < index->count && index->positions[r->token] <= pos ? r->token : 0;
+    size_t hi = index->count;
+    size_t k = lo;
+    for (; k < hi && k < lo + 4; ++k)
+    {
+        ASSERT_RETURN(index->positions[k] != pos, k);
+        ASSERT_RETURN(index->positions[k] < pos, index->count);
+    }
+    for (lo = k; lo < hi;)
+    {
+        size_t mid = lo + (hi - lo) / 2;
+        if (index->positions[mid] < pos) lo = mid + 1;
+        else hi = mid;
+    }
+    return lo < index->count && index->positions[lo] == pos ? lo : index->count;
+}
+
+/**
+ * @brief Jump over the string, object or array at the cursor by the index of the reader
+ * 
+ * @return bool @p true for jumped, @p false for the cursor is not found in the index
+ */
+static bool reader_jump(GET_STRUCT_NAME(Reader) * r, int c)
+{
+    const GET_STRUCT_NAME(Index) * index = r->index;
+    size_t k = reader_token(r, (uint32_t) (r->cur - r->begin));
+    ASSERT_RETURN(k < index->count, false);
+    size_t close = '"' == c ? k + 1 : index->jumps[k];
+    ASSERT_RETURN(close < index->count && r->begin + index->positions[close] < r->end, false);
+    r->cur = r->begin + index->positions[close] + 1;
+    r->token = close + 1;
+    return true;
+}
+
+/**
+ * @brief Consume the literal @p word if it's at the cursor
+ * 
+ * @return bool @p true for consumed
+ */
+static bool reader_literal(GET_STRUCT_NAME(Reader) * r, const char * word, size_t len)
+{
+    ASSERT_RETURN((size_t) (r->end - r->cur) >= len && 0 == memcmp(r->cur, word, len), false);
+    r->cur += len;
+    return true;
+}
+
+/**
+ * @brief Consume the digits at @p p
+ * 
+ * @return const char* The end of the digits, @p p for none
+ */
+static const char * reader_digits(const char * p, const char * end)
+{
+    while (p < end && *p >= '0' && *p <= '9') ++p;
+    return p;
+}
+
+/**
+ * @brief Consume a number at the cursor if it follows the grammar of json, it's not converted
+ * 
+ * @return bool @p true for consumed
+ */
+static bool reader_skip_number(GET_STRUCT_NAME(Reader) * r)
+{
+    const char * p = r->cur;
+    if (p < r->end && '-' == *p) ++p;
+    ASSERT_RETURN(p < r->end && *p >= '0' && *p <= '9', false);
+    p = '0' == *p ? p + 1 : reader_digits(p, r->end);
+    if (p < r->end && '.' == *p)
+    {
+        const char * digits = ++p;
+        p = reader_digits(p, r->end);
+        ASSERT_RETURN(p > digits, false);
+    }
+    if (p < r->end && ('e' == *p || 'E' == *p))
+    {
+        ++p;
+        if (p < r->end && ('+' == *p || '-' == *p)) ++p;
+        const char * digits = p;
+        p = reader_digits(p, r->end);
+        ASSERT_RETURN(p > digits, false);
+    }
+    r->cur = p;
+    return true;
+}
+
+/**
+ * @brief Consume a string, a number, @p true, @p false or @p null starting with @p c at the cursor
+ * 
+ * @return bool @p true for consumed
+ */
+static bool reader_skip_scalar(GET_STRUCT_NAME(Reader) * r, int c)
+{
+    if ('"' == c)
+    {
+        bool escaped = false;
+        const char * quote = reader_string_end(r->cur + 1, r->end, &escaped);
+        ASSERT_RETURN(quote, false);
+        r->cur = quote + 1;
+        return true;
+    }
+    if ('t' == c) return reader_literal(r, "true", 4);
+    if ('f' == c) return reader_literal(r, "false", 5);
+    if ('n' == c) return reader_literal(r, "null", 4);
+    return reader_skip_number(r);
+}
+
+/**
+ * @brief Consume an object key and the colon after it without unescaping the key
+ * 
+ * @return bool @p true for consumed
+ */
+static bool reader_skip_key(GET_STRUCT_NAME(Reader) * r)
+{
+    ASSERT_RETURN(0 == json_wrapper_reader_expect(r, '"'), false);
+    bool escaped = false;
+    const char * quote = reader_string_end(r->cur, r->end, &escaped);
+    ASSERT_RETURN(quote, false);
+    r->cur = quote + 1;
+    return 0 == json_wrapper_reader_expect(r, ':');
+}
+
+/**
+ * @brief Skip a value of any type without allocating
+ * 
+ * @note The value is checked against the grammar of json: the literals, the numbers, the commas between the items
+ *       and the colons after the keys, objects and arrays are nested up to @link READER_DEPTH_MAX levels.
+ *       With an index, a string, object or array is jumped over without being scanned, so only its
+ *       quotes, braces and brackets are checked, by @link json_wrapper_index_build
+ * 
+ * @param r The reader
+ * @return int @p 0 for success, @p -1 for failure
+ */
+int json_wrapper_reader_skip(GET_STRUCT_NAME(Reader) * r)
+{
+    if (NULL != r->index)
+    {
+        int c = json_wrapper_reader_peek(r);
+        if (('"' == c || '{' == c || '[' == c) && reader_jump(r, c)) return 0;
+    }
+    uint64_t objects[READER_DEPTH_MAX / 64];    // bit d is set for the container at depth d is an object
+    size_t depth = 0;
+    for (;;)
+    {
+        int c = json_wrapper_reader_peek(r);
+        if ('{' == c || '[' == c)
+        {
+            ASSERT_RETURN(depth < READER_DEPTH_MAX, -1);
+            uint64_t bit = 1ULL << (depth % 64);
+            objects[depth / 64] = '{' == c ? objects[depth / 64] | bit : objects[depth / 64] & ~bit;
+            ++depth;
+            ++r->cur;
+            if (('{' == c ? '}' : ']') != json_wrapper_reader_peek(r))
+            {
+                ASSERT_RETURN('[' == c || reader_skip_key(r), -1);
+                continue;
+            }
+            ++r->cur;
+            --depth;
+        } else
+        {
+            ASSERT_RETURN(-1 != c && reader_skip_scalar(r, c), -1);
+        }
+        for (; depth > 0; --depth)
+        {
+            bool object = 0 != ((objects[(depth - 1) / 64] >> ((depth - 1) % 64)) & 1);
+            c = json_wrapper_reader_peek(r);
+            if (',' == c)
+            {
+                ++r->cur;
+                ASSERT_RETURN(!object || reader_skip_key(r), -1);
+                break;
+            }
+            ASSERT_RETURN((object ? '}' : ']') == c, -1);
+            ++r->cur;
+        }
+        ASSERT_RETURN(depth > 0, 0);
+    }
+}
+
+/**
+ * @brief Count the items of the array at the cursor without consuming it
+ * 
+ * @param r The reader
+ * @param count The number of items
+ * @return int @p 0 for success, @p -1 for failure
+ */
+int json_wrapper_reader_count(GET_STRUCT_NAME(Reader) * r, size_t * count)
+{
+    const char * begin = r->cur;
+    size_t token = r->token;
+    int rc = json_wrapper_reader_expect(r, '[');
+    size_t index = 0;
+    if (0 == rc)
+    {
+        for (; 1 == (rc = json_wrapper_reader_next(r, ']', index)); ++index)
+        {
+            ASSERT_BREAK(0 == (rc = json_wrapper_reader_skip(r)));
+        }
+    }
+    r->cur = begin;
+    r->token = token;
+    ASSERT_RETURN(0 == rc, -1);
+    *count = index;
+    return 0;
+}
+
+/**
+ * @brief A number read from json text or MessagePack, as an integer or a double
+ */
+typedef struct GET_STRUCT_NAME(Number)
+{
+    bool is_double;                 // Whether the number is @p d, or the integer of @p negative and @p u
+    bool negative;                  // Whether the integer is negative
+    uint64_t u;                     // The magnitude of the integer, saturated to UINT64_MAX
+    double d;
+} GET_STRUCT_NAME(Number);
+
+/**
+ * @brief Convert a number to a 64 bits integer, fractions are truncated and out of range values are saturated
+ */
+static int64_t number_to_int64(const GET_STRUCT_NAME(Number) * n)
+{
+    if (n->is_double)
+    {
+        if (n->d != n->d) return 0;
+        if (n->d >= 9223372036854775807.0) return INT64_MAX;
+        if (n->d <= -9223372036854775808.0) return INT64_MIN;
+        return (int64_t) n->d;
+    }
+    if (n->negative) return n->u > (uint64_t) INT64_MAX + 1 ? INT64_MIN : (int64_t) (0 - n->u);
+    return n->u > (uint64_t) INT64_MAX ? INT64_MAX : (int64_t) n->u;
+}
+
+/**
+ * @brief Convert a number to an unsigned 64 bits integer, fractions are truncated and out of range values are saturated
+ */
+static uint64_t number_to_uint64(const GET_STRUCT_NAME(Number) * n)
+{
+    if (n->is_double)
+    {
+        if (n->d != n->d || n->d <= 0) return 0;
+        if (n->d >= 18446744073709551615.0) return UINT64_MAX;
+        return (uint64_t) n->d;
+    }
+    return n->negative ? 0 : n->u;
+}
+
+/**
+ * @brief Convert a number to a double
+ */
+static double number_to_double(const GET_STRUCT_NAME(Number) * n)
+{
+    ASSERT_RETURN(!n->is_double, n->d);
+    return n->negative ? -(double) n->u : (double) n->u;
+}
+
+/**
+ * @brief Read a json number, an integer without fraction and exponent is read exactly,
+ *        the others are converted directly when the digits and the exponent are exact in a double
+ *        and by strtod otherwise
+ * 
+ * @return int @p 0 for success, @p -1 for failure
+ */
+static int reader_number_ex(GET_STRUCT_NAME(Reader) * r, GET_STRUCT_NAME(Number) * n)
+{
+    const char * p = r->cur;
+    n->is_double = false;
+    n->negative = false;
+    if (p < r->end && '-' == *p)
+    {
+        n->negative = true;
+        ++p;
+    }
+    const char * digits = p;
+    uint64_t u = 0;
+    bool exact = true;
+    for (; p < r->end && *p >= '0' && *p <= '9'; ++p)
+    {
+        unsigned d = *p - '0';
+        if (u > (UINT64_MAX - d) / 10) exact = false;
+        else u = u * 10 + d;
+    }
+    ASSERT_RETURN(p > digits, -1);
+    if (p >= r->end || ('.' != *p && 'e' != *p && 'E' != *p))
+    {
+        r->cur = p;
+        n->u = exact ? u : UINT64_MAX;
+        return 0;
+    }
+    int scale = 0;
+    if ('.' == *p)
+    {
+        digits = ++p;
+        for (; p < r->end && *p >= '0' && *p <= '9'; ++p)
+        {
+            unsigned d = *p - '0';
+            if (u > (UINT64_MAX - d) / 10) exact = false;
+            else
+            {
+                u = u * 10 + d;
+                --scale;
+            }
+        }
+        ASSERT_RETURN(p > digits, -1);
+    }
+    if (p < r->end && ('e' == *p || 'E' == *p))
+    {
+        ++p;
+        bool negative = false;
+        if (p < r->end && ('+' == *p || '-' == *p)) negative = '-' == *p++;
+        digits = p;
+        int e = 0;
+        for (; p < r->end && *p >= '0' && *p <= '9'; ++p)
+        {
+            if (e < 100000) e = e * 10 + (*p - '0');
+        }
+        ASSERT_RETURN(p > digits, -1);
+        scale += negative ? -e : e;
+    }
+    n->is_double = true;
+    if (exact && u <= (1ULL << 53) && scale >= -22 && scale <= 22)
+    {
+        n->d = scale < 0 ? (double) u / g_pow10[-scale] : (double) u * g_pow10[scale];
+        if (n->negative) n->d = -n->d;
+        r->cur = p;
+        return 0;
+    }
+    char text[64];
+    size_t len = p - r->cur;
+    char * copy = len < sizeof(text) ? text : json_wrapper_alloc(len + 1);
+    ASSERT_RETURN(copy, -1);
+    memcpy(copy, r->cur, len);
+    copy[len] = '\0';
+    n->d = strtod(copy, NULL);
+    if (copy != text) json_wrapper_free(copy);
+    r->cur = p;
+    return 0;
+}
+
+/**
+ * @brief Read a json number, fractions are truncated and out of range values are saturated
+ * 
+ * @return int @p 0 for success, @p -1 for failure
+ */
+static int reader_number(GET_STRUCT_NAME(Reader) * r, long * value)
+{
+    GET_STRUCT_NAME(Number) n;
+    ASSERT_RETURN(0 == reader_number_ex(r, &n), -1);
+    int64_t v = number_to_int64(&n);
+    *value = v < LONG_MIN ? LONG_MIN : (v > LONG_MAX ? LONG_MAX : (long) v);
+    return 0;
+}
+
+/**
+ * @brief Read a number, @p true and @p false are read as @p 1 and @p 0, values of other types are skipped
+ * 
+ * @return int @p 1 for a number is read, @p 0 for the value is skipped, @p -1 for failure
+ */
+static int reader_scalar(GET_STRUCT_NAME(Reader) * r, GET_STRUCT_NAME(Number) * n)
+{
+    int c = json_wrapper_reader_peek(r);
+    if ('-' == c || (c >= '0' && c <= '9')) return 0 == reader_number_ex(r, n) ? 1 : -1;
+    n->is_double = false;
+    n->negative = false;
+    if ('t' == c && reader_literal(r, "true", 4))
+    {
+        n->u = 1;
+        return 1;
+    }
+    if ('f' == c && reader_literal(r, "false", 5))
+    {
+        n->u = 0;
+        return 1;
+    }
+    return 0 == json_wrapper_reader_skip(r) ? 0 : -1;
+}
+
+/**
+ * @brief Read a boolean, a number is read as @p true if it's not zero
+ * 
+ * @note Values of other types are skipped and @p value is left unchanged, the same for the other readers
+ * 
+ * @param r The reader
+ * @param value The value
+ * @return int @p 0 for success, @p -1 for failure
+ */
+int json_wrapper_reader_bool(GET_STRUCT_NAME(Reader) * r, bool * value)
+{
+    int c = json_wrapper_reader_peek(r);
+    if ('t' == c && reader_literal(r, "true", 4))
+    {
+        *value = true;
+        return 0;
+    }
+    if ('f' == c && reader_literal(r, "false", 5))
+    {
+        *value = false;
+        return 0;
+    }
+    if ('-' == c || (c >= '0' && c <= '9'))
+    {
+        long number = 0;
+        ASSERT_RETURN(0 == reader_number(r, &number), -1);
+        *value = 0 != number;
+        return 0;
+    }
+    return json_wrapper_reader_skip(r);
+}
+
+/**
+ * @brief Read an integer, fractions are truncated and out of range values are saturated,
+ *        @p true and @p false are read as @p 1 and @p 0
+ * 
+ * @param r The reader
+ * @param value The value
+ * @return int @p 0 for success, @p -1 for failure
+ */
+int json_wrapper_reader_int(GET_STRUCT_NAME(Reader) * r, long * value)
+{
+    int c = json_wrapper_reader_peek(r);
+    if ('-' == c || (c >= '0' && c <= '9')) return reader_number(r, value);
+    if ('t' == c && reader_literal(r, "true", 4))
+    {
+        *value = 1;
+        return 0;
+    }
+    if ('f' == c && reader_literal(r, "false", 5))
+    {
+        *value = 0;
+        return 0;
+    }
+    return json_wrapper_reader_skip(r);
+}
+
+/**
+ * @brief Read a 64 bits integer exactly, fractions are truncated and out of range values are saturated,
+ *        @p true and @p false are read as @p 1 and @p 0
+ * 
+ * @param r The reader
+ * @param value The value
+ * @return int @p 0 for success, @p -1 for failure
+ */
+int json_wrapper_reader_int64(GET_STRUCT_NAME(Reader) * r, int64_t * value)
+{
+    GET_STRUCT_NAME(Number) n;
+    int rc = reader_scalar(r, &n);
+    ASSERT_RETURN(rc >= 0, -1);
+    if (rc > 0) *value = number_to_int64(&n);
+    return 0;
+}
+
+/**
+ * @brief Read an unsigned 64 bits integer exactly, fractions are truncated and out of range values,
+ *        the negative ones included, are saturated, @p true and @p false are read as @p 1 and @p 0
+ * 
+ * @param r The reader
+ * @param value The value
+ * @return int @p 0 for success, @p -1 for failure
+ */
+int json_wrapper_reader_uint64(GET_STRUCT_NAME(Reader) * r, uint64_t * value)
+{
+    GET_STRUCT_NAME(Number) n;
+    int rc = reader_scalar(r, &n);
+    ASSERT_RETURN(rc >= 0, -1);
+    if (rc > 0) *value = number_to_uint64(&n);
+    return 0;
+}
+
+/**
+ * @brief Read a double, @p true and @p false are read as @p 1 and @p 0
+ * 
+ * @param r The reader
+ * @param value The value
+ * @return int @p 0 for success, @p -1 for failure
+ */
+int json_wrapper_reader_double(GET_STRUCT_NAME(Reader) * r, double * value)
+{
+    GET_STRUCT_NAME(Number) n;
+    int rc = reader_scalar(r, &n);
+    ASSERT_RETURN(rc >= 0, -1);
+    if (rc > 0) *value = number_to_double(&n);
+    return 0;
+}
+
+/**
+ * @brief Read and unescape a string into memory alloced for the reader, the old @p *value is freed
+ * 
+ * @param r The reader
+ * @param value The value
+ * @return int @p 0 for success, @p -1 for failure
+ */
+int json_wrapper_reader_string(GET_STRUCT_NAME(Reader) * r, char ** value)
+{
+    ASSERT_RETURN('"' == json_wrapper_reader_peek(r), json_wrapper_reader_skip(r));
+    bool escaped = false;
+    const char * begin = r->cur + 1;
+    const char * quote = reader_string_end(begin, r->end, &escaped);
+    ASSERT_RETURN(quote, -1);
+    char * str = json_wrapper_alloc_from(r->arena, quote - begin + 1);
+    ASSERT_RETURN(str, -1);
+    long len = quote - begin;
+    if (escaped)
+    {
+        len = reader_unescape(begin, quote, str, len);
+        if (len < 0)
+        {
+            if (NULL == r->arena) json_wrapper_free(str);
+            return -1;
+        }
+    } else
+    {
+        memcpy(str, begin, len);
+    }
+    str[len] = '\0';
+    if (NULL != *value && NULL == r->arena) json_wrapper_free(*value);
+    *value = str;
+    r->cur = quote + 1;
+    return 0;
+}
+
+/**
+ * @brief Read a string as a view into the text, nothing is copied unless the string is escaped
+ * 
+ * @note An escaped string is unescaped in place if the reader is writable, or else into its arena,
+ *       it's a failure if the reader has neither
+ * 
+ * @param r The reader
+ * @param value The value
+ * @return int @p 0 for success, @p -1 for failure
+ */
+int json_wrapper_reader_view(GET_STRUCT_NAME(Reader) * r, GET_STRUCT_NAME(STRING_VIEW) * value)
+{
+    ASSERT_RETURN('"' == json_wrapper_reader_peek(r), json_wrapper_reader_skip(r));
+    bool escaped = false;
+    const char * begin = r->cur + 1;
+    const char * quote = reader_string_end(begin, r->end, &escaped);
+    ASSERT_RETURN(quote, -1);
+    long len = quote - begin;
+    if (escaped)
+    {
+        char * out = r->writable ? (char *) begin : NULL;
+        if (NULL == out && NULL != r->arena) out = json_wrapper_alloc_from(r->arena, len);
+        ASSERT_RETURN(out, -1);
+        len = reader_unescape(begin, quote, out, len);
+        ASSERT_RETURN(len >= 0, -1);
+        begin = out;
+    }
+    value->ptr = begin;
+    value->len = len;
+    r->cur = quote + 1;
+    return 0;
+}
+
+/**
+ * @brief Read a string into a fixed-capacity buffer, nothing is alloced
+ * 
+ * @note A string longer than @p cap - 1 bytes is truncated on a UTF-8 character boundary,
+ *       the result is always '\0' terminated
+ * 
+ * @param r The reader
+ * @param value The buffer
+ * @param cap The capacity of the buffer, at least @p 1
+ * @return int @p 0 for success, @p -1 for failure
+ */
+int json_wrapper_reader_fixed(GET_STRUCT_NAME(Reader) * r, char * value, size_t cap)
+{
+    ASSERT_RETURN(value && cap > 0, -1);
+    ASSERT_RETURN('"' == json_wrapper_reader_peek(r), json_wrapper_reader_skip(r));
+    bool escaped = false;
+    const char * begin = r->cur + 1;
+    const char * quote = reader_string_end(begin, r->end, &escaped);
+    ASSERT_RETURN(quote, -1);
+    if (escaped)
+    {
+        long len = reader_unescape(begin, quote, value, cap);
+        ASSERT_RETURN(len >= 0, -1);
+        json_wrapper_fixed_string_set(value, cap, value, len < (long) cap ? (size_t) len : cap);
+    } else
+    {
+        json_wrapper_fixed_string_set(value, cap, begin, quote - begin);
+    }
+    r->cur = quote + 1;
+    return 0;
+}
+
+
+/**
+ * @brief The kinds of MessagePack values told by their headers
+ */
+enum
+{
+    MSGPACK_NIL,
+    MSGPACK_BOOL,
+    MSGPACK_UINT,
+    MSGPACK_INT,
+    MSGPACK_FLOAT32,
+    MSGPACK_FLOAT64,
+    MSGPACK_STR,
+    MSGPACK_BIN,
+    MSGPACK_EXT,
+    MSGPACK_ARRAY,
+    MSGPACK_MAP,
+};
+
+/**
+ * @brief Append a MessagePack header of the format byte @p tag followed by @p bytes bytes of @p value in big endian
+ * 
+ * @param buf The buffer
+ * @param tag The format byte
+ * @param value The value
+ * @param bytes The number of bytes of @p value, up to 8
+ * @return int @p 0 for success, @p -1 for failure
+ */
+static int msgpack_put(GET_STRUCT_NAME(Buffer) * buf, unsigned char tag, uint64_t value, size_t bytes)
+{
+    char header[9];
+    size_t i = 0;
+    header[0] = (char) tag;
+    for (i = 0; i < bytes; ++i)
+    {
+        header[bytes - i] = (char) (value >> (8 * i));
+    }
+    return json_wrapper_buffer_append(buf, header, 1 + bytes);
+}
+
+/**
+ * @brief Append the header of a str, array or map whose format bytes are @p fix, @p tag8 or the 2 following ones
+ * 
+ * @param buf The buffer
+ * @param count The length or the number of items
+ * @param fix The fixed format byte, @p 0 for none
+ * @param fix_max The max @p count of the fixed format
+ * @param tag8 The format byte of 8 bits, @p 0 for none, the one of 16 bits and 32 bits follow it
+ * @param tag16 The format byte of 16 bits, the one of 32 bits follows it
+ * @return int @p 0 for success, @p -1 for failure
+ */
+static int msgpack_put_count(GET_STRUCT_NAME(Buffer) * buf, size_t count,
+    unsigned char fix, size_t fix_max, unsigned char tag8, unsigned char tag16)
+{
+    if (count <= fix_max) return msgpack_put(buf, fix | (unsigned char) count, 0, 0);
+    if (tag8 && count <= 0xFF) return msgpack_put(buf, tag8, count, 1);
+    if (count <= 0xFFFF) return msgpack_put(buf, tag16, count, 2);
+    ASSERT_RETURN(count <= 0xFFFFFFFFu, -1);
+    return msgpack_put(buf, tag16 + 1, count, 4);
+}
+
+/**
+ * @brief Append a nil into @p buf
+ * 
+ * @param buf The buffer
+ * @return int @p 0 for success, @p -1 for failure
+ */
+int json_wrapper_msgpack_write_nil(GET_STRUCT_NAME(Buffer) * buf)
+{
+    return msgpack_put(buf, 0xC0, 0, 0);
+}
+
+/**
+ * @brief Append a boolean into @p buf
+ * 
+ * @param buf The buffer
+ * @param value The boolean
+ * @return int @p 0 for success, @p -1 for failure
+ */
+int json_wrapper_msgpack_write_bool(GET_STRUCT_NAME(Buffer) * buf, bool value)
+{
+    return msgpack_put(buf, value ? 0xC3 : 0xC2, 0, 0);
+}
+
+/**
+ * @brief Append an integer into @p buf
+ * 
+ * @param buf The buffer
+ * @param value The integer
+ * @return int @p 0 for success, @p -1 for failure
+ */
+int json_wrapper_msgpack_write_int(GET_STRUCT_NAME(Buffer) * buf, long value)
+{
+    return json_wrapper_msgpack_write_int64(buf, value);
+}
+
+/**
+ * @brief Append a 64 bits integer into @p buf
+ * 
+ * @param buf The buffer
+ * @param value The integer
+ * @return int @p 0 for success, @p -1 for failure
+ */
+int json_wrapper_msgpack_write_int64(GET_STRUCT_NAME(Buffer) * buf, int64_t value)
+{
+    if (value >= 0) return json_wrapper_msgpack_write_uint64(buf, (uint64_t) value);
+    if (value >= -32) return msgpack_put(buf, (unsigned char) value, 0, 0);
+    if (value >= INT8_MIN) return msgpack_put(buf, 0xD0, (uint64_t) value, 1);
+    if (value >= INT16_MIN) return msgpack_put(buf, 0xD1, (uint64_t) value, 2);
+    if (value >= INT32_MIN) return msgpack_put(buf, 0xD2, (uint64_t) value, 4);
+    return msgpack_put(buf, 0xD3, (uint64_t) value, 8);
+}
+
+/**
+ * @brief Append an unsigned 64 bits integer into @p buf
+ * 
+ * @param buf The buffer
+ * @param value The integer
+ * @return int @p 0 for success, @p -1 for failure
+ */
+int json_wrapper_msgpack_write_uint64(GET_STRUCT_NAME(Buffer) * buf, uint64_t value)
+{
+    if (value <= 0x7F) return msgpack_put(buf, (unsigned char) value, 0, 0);
+    if (value <= 0xFF) return msgpack_put(buf, 0xCC, value, 1);
+    if (value <= 0xFFFF) return msgpack_put(buf, 0xCD, value, 2);
+    if (value <= 0xFFFFFFFFu) return msgpack_put(buf, 0xCE, value, 4);
+    return msgpack_put(buf, 0xCF, value, 8);
+}
+
+/**
+ * @brief Append a float as a float 32 into @p buf
+ * 
+ * @param buf The buffer
+ * @param value The float
+ * @return int @p 0 for success, @p -1 for failure
+ */
+int json_wrapper_msgpack_write_float(GET_STRUCT_NAME(Buffer) * buf, float value)
+{
+    uint32_t bits = 0;
+    memcpy(&bits, &value, sizeof(bits));
+    return msgpack_put(buf, 0xCA, bits, 4);
+}
+
+/**
+ * @brief Append a double as a float 64 into @p buf
+ * 
+ * @param buf The buffer
+ * @param value The double
+ * @return int @p 0 for success, @p -1 for failure
+ */
+int json_wrapper_msgpack_write_double(GET_STRUCT_NAME(Buffer) * buf, double value)
+{
+    uint64_t bits = 0;
+    memcpy(&bits, &value, sizeof(bits));
+    return msgpack_put(buf, 0xCB, bits, 8);
+}
+
+/**
+ * @brief Append @p len bytes of @p str as a string into @p buf
+ * 
+ * @param buf The buffer
+ * @param str The string, which doesn't need to be '\0' terminated
+ * @param len The length of the string
+ * @return int @p 0 for success, @p -1 for failure
+ */
+int json_wrapper_msgpack_write_str(GET_STRUCT_NAME(Buffer) * buf, const char * str, size_t len)
+{
+    ASSERT_RETURN(0 == msgpack_put_count(buf, len, 0xA0, 31, 0xD9, 0xDA), -1);
+    return json_wrapper_buffer_append(buf, str, len);
+}
+
+/**
+ * @brief Append a '\0' terminated string into @p buf, @p NULL is appended as nil
+ * 
+ * @param buf The buffer
+ * @param str The string
+ * @return int @p 0 for success, @p -1 for failure
+ */
+int json_wrapper_msgpack_write_string(GET_STRUCT_NAME(Buffer) * buf, const char * str)
+{
+    ASSERT_RETURN(str, json_wrapper_msgpack_write_nil(buf));
+    return json_wrapper_msgpack_write_str(buf, str, strlen(str));
+}
+
+/**
+ * @brief Append the header of an array of @p count items into @p buf
+ * 
+ * @param buf The buffer
+ * @param count The number of items
+ * @return int @p 0 for success, @p -1 for failure
+ */
+int json_wrapper_msgpack_write_array(GET_STRUCT_NAME(Buffer) * buf, size_t count)
+{
+    return msgpack_put_count(buf, count, 0x90, 15, 0, 0xDC);
+}
+
+/**
+ * @brief Append the header of a map of @p count pairs into @p buf
+ * 
+ * @param buf The buffer
+ * @param count The number of pairs
+ * @return int @p 0 for success, @p -1 for failure
+ */
+int json_wrapper_msgpack_write_map(GET_STRUCT_NAME(Buffer) * buf, size_t count)
+{
+    return msgpack_put_count(buf, count, 0x80, 15, 0, 0xDE);
+}
+
+/**
+ * @brief Read @p bytes bytes in big endian
+ * 
+ * @param r The reader
+ * @param bytes The number of bytes, up to 8
+ * @param value The value
+ * @return int @p 0 for success, @p -1 for the data is truncated
+ */
+static int msgpack_get(GET_STRUCT_NAME(Reader) * r, size_t bytes, uint64_t * value)
+{
+    ASSERT_RETURN((size_t) (r->end - r->cur) >= bytes, -1);
+    const unsigned char * p = (const unsigned char *) r->cur;
+    uint64_t v = 0;
+    size_t i = 0;
+    for (i = 0; i < bytes; ++i) v = (v << 8) | p[i];
+    r->cur += bytes;
+    *value = v;
+    return 0;
+}
+
+/**
+ * @brief Read the header of the next value, the payload of str, bin and ext is not consumed
+ * 
+ * @param r The reader
+ * @param kind The kind of the value
+ * @param arg The value of nil, bool, integers and floats in bits, or the length of str, bin and ext
+ *            including the type byte, or the number of items of array and map
+ * @return int @p 0 for success, @p -1 for failure
+ */
+static int msgpack_header(GET_STRUCT_NAME(Reader) * r, int * kind, uint64_t * arg)
+{
+    ASSERT_RETURN(r->cur < r->end, -1);
+    unsigned char c = (unsigned char) *r->cur++;
+    *arg = 0;
+    if (c <= 0x7F) { *kind = MSGPACK_UINT; *arg = c; return 0; }
+    if (c >= 0xE0) { *kind = MSGPACK_INT; *arg = (uint64_t) (int64_t) (int8_t) c; return 0; }
+    if (c <= 0x8F) { *kind = MSGPACK_MAP; *arg = c & 0x0F; return 0; }
+    if (c <= 0x9F) { *kind = MSGPACK_ARRAY; *arg = c & 0x0F; return 0; }
+    if (c <= 0xBF) { *kind = MSGPACK_STR; *arg = c & 0x1F; return 0; }
+    switch (c)
+    {
+        case 0xC0: *kind = MSGPACK_NIL; return 0;
+        case 0xC2: *kind = MSGPACK_BOOL; *arg = 0; return 0;
+        case 0xC3: *kind = MSGPACK_BOOL; *arg = 1; return 0;
+        case 0xC4: *kind = MSGPACK_BIN; return msgpack_get(r, 1, arg);
+        case 0xC5: *kind = MSGPACK_BIN; return msgpack_get(r, 2, arg);
+        case 0xC6: *kind = MSGPACK_BIN; return msgpack_get(r, 4, arg);
+        case 0xC7: case 0xC8: case 0xC9:
+            *kind = MSGPACK_EXT;
+            ASSERT_RETURN(0 == msgpack_get(r, (size_t) 1 << (c - 0xC7), arg), -1);
+            ++*arg;
+            return 0;
+        case 0xCA: *kind = MSGPACK_FLOAT32; return msgpack_get(r, 4, arg);
+        case 0xCB: *kind = MSGPACK_FLOAT64; return msgpack_get(r, 8, arg);
+        case 0xCC: case 0xCD: case 0xCE: case 0xCF:
+            *kind = MSGPACK_UINT;
+            return msgpack_get(r, (size_t) 1 << (c - 0xCC), arg);
+        case 0xD0: case 0xD1: case 0xD2: case 0xD3:
+        {
+            size_t bytes = (size_t) 1 << (c - 0xD0);
+            *kind = MSGPACK_INT;
+            ASSERT_RETURN(0 == msgpack_get(r, bytes, arg), -1);
+            if (bytes < 8 && (*arg >> (8 * bytes - 1)) & 1) *arg |= ~(uint64_t) 0 << (8 * bytes);
+            return 0;
+        }
+        case 0xD4: case 0xD5: case 0xD6: case 0xD7: case 0xD8:
+            *kind = MSGPACK_EXT;
+            *arg = 1 + ((uint64_t) 1 << (c - 0xD4));
+            return 0;
+        case 0xD9: *kind = MSGPACK_STR; return msgpack_get(r, 1, arg);
+        case 0xDA: *kind = MSGPACK_STR; return msgpack_get(r, 2, arg);
+        case 0xDB: *kind = MSGPACK_STR; return msgpack_get(r, 4, arg);
+        case 0xDC: *kind = MSGPACK_ARRAY; return msgpack_get(r, 2, arg);
+        case 0xDD: *kind = MSGPACK_ARRAY; return msgpack_get(r, 4, arg);
+        case 0xDE: *kind = MSGPACK_MAP; return msgpack_get(r, 2, arg);
+        case 0xDF: *kind = MSGPACK_MAP; return msgpack_get(r, 4, arg);
+        default: return -1;
+    }
+}
+
+/**
+ * @brief Read the header of an array or a map, the count is checked against the bytes left
+ * 
+ * @param r The reader
+ * @param kind The expected kind
+ * @param count The number of items or pairs
+ * @return int @p 0 for success, @p -1 for failure
+ */
+static int msgpack_read_container(GET_STRUCT_NAME(Reader) * r, int kind, size_t * count)
+{
+    int got = 0;
+    uint64_t arg = 0;
+    ASSERT_RETURN(0 == msgpack_header(r, &got, &arg), -1);
+    ASSERT_RETURN(kind == got && arg <= (uint64_t) (r->end - r->cur), -1);
+    *count = (size_t) arg;
+    return 0;
+}
+
+/**
+ * @brief Read the header of an array
+ * 
+ * @param r The reader
+ * @param count The number of items
+ * @return int @p 0 for success, @p -1 for the next value is not an array or the data is truncated
+ */
+int json_wrapper_msgpack_read_array(GET_STRUCT_NAME(Reader) * r, size_t * count)
+{
+    ASSERT_RETURN(r && count, -1);
+    return msgpack_read_container(r, MSGPACK_ARRAY, count);
+}
+
+/**
+ * @brief Read the header of a map
+ * 
+ * @param r The reader
+ * @param count The number of pairs
+ * @return int @p 0 for success, @p -1 for the next value is not a map or the data is truncated
+ */
+int json_wrapper_msgpack_read_map(GET_STRUCT_NAME(Reader) * r, size_t * count)
+{
+    ASSERT_RETURN(r && count, -1);
+    return msgpack_read_container(r, MSGPACK_MAP, count);
+}
+
+/**
+ * @brief Skip a value of any type without allocating
+ * 
+ * @param r The reader
+ * @return int @p 0 for success, @p -1 for failure
+ */
+int json_wrapper_msgpack_skip(GET_STRUCT_NAME(Reader) * r)
+{
+    ASSERT_RETURN(r, -1);
+    uint64_t pending = 1;
+    while (pending > 0)
+    {
+        int kind = 0;
+        uint64_t arg = 0;
+        ASSERT_RETURN(0 == msgpack_header(r, &kind, &arg), -1);
+        --pending;
+        switch (kind)
+        {
+            case MSGPACK_STR:
+            case MSGPACK_BIN:
+            case MSGPACK_EXT:
+                ASSERT_RETURN(arg <= (uint64_t) (r->end - r->cur), -1);
+                r->cur += arg;
+                break;
+            case MSGPACK_ARRAY:
+            case MSGPACK_MAP:
+                ASSERT_RETURN(arg <= (uint64_t) (r->end - r->cur), -1);
+                pending += MSGPACK_MAP == kind ? 2 * arg : arg;
+                break;
+            default:
+                break;
+        }
+    }
+    return 0;
+}
+
+/**
+ * @brief Read a map key without copying it, a key which is not a string is skipped and returned with length @p 0
+ * 
+ * @param r The reader
+ * @param key The key, which points into the data, it's not '\0' terminated
+ * @param len The length of the key
+ * @return int @p 0 for success, @p -1 for failure
+ */
+int json_wrapper_msgpack_read_key(GET_STRUCT_NAME(Reader) * r, const char ** key, size_t * len)
+{
+    ASSERT_RETURN(r && key && len, -1);
+    const char * begin = r->cur;
+    int kind = 0;
+    uint64_t arg = 0;
+    ASSERT_RETURN(0 == msgpack_header(r, &kind, &arg), -1);
+    if (MSGPACK_STR != kind)
+    {
+        r->cur = begin;
+        *key = begin;
+        *len = 0;
+        return json_wrapper_msgpack_skip(r);
+    }
+    ASSERT_RETURN(arg <= (uint64_t) (r->end - r->cur), -1);
+    *key = r->cur;
+    *len = (size_t) arg;
+    r->cur += arg;
+    return 0;
+}
+
+/**
+ * @brief Read a number or a boolean
+ * 
+ * @param r The reader
+ * @param n The number
+ * @return int @p 1 for success, @p 0 for the value is of other types and the cursor is not moved, @p -1 for failure
+ */
+static int msgpack_read_number_ex(GET_STRUCT_NAME(Reader) * r, GET_STRUCT_NAME(Number) * n)
+{
+    const char * begin = r->cur;
+    int kind = 0;
+    uint64_t arg = 0;
+    ASSERT_RETURN(0 == msgpack_header(r, &kind, &arg), -1);
+    n->is_double = false;
+    n->negative = false;
+    switch (kind)
+    {
+        case MSGPACK_BOOL:
+        case MSGPACK_UINT:
+            n->u = arg;
+            return 1;
+        case MSGPACK_INT:
+            n->negative = (int64_t) arg < 0;
+            n->u = n->negative ? 0 - arg : arg;
+            return 1;
+        case MSGPACK_FLOAT32:
+        {
+            uint32_t bits = (uint32_t) arg;
+            float f = 0;
+            memcpy(&f, &bits, sizeof(f));
+            n->is_double = true;
+            n->d = f;
+            return 1;
+        }
+        case MSGPACK_FLOAT64:
+            n->is_double = true;
+            memcpy(&n->d, &arg, sizeof(n->d));
+            return 1;
+        default:
+            r->cur = begin;
+            return 0;
+    }
+}
+
+/**
+ * @brief Read a number or a boolean as a saturated long
+ * 
+ * @param r The reader
+ * @param value The value as a long
+ * @return int @p 1 for success, @p 0 for the value is of other types and the cursor is not moved, @p -1 for failure
+ */
+static int msgpack_read_number(GET_STRUCT_NAME(Reader) * r, long * value)
+{
+    GET_STRUCT_NAME(Number) n;
+    int rc = msgpack_read_number_ex(r, &n);
+    ASSERT_RETURN(rc > 0, rc);
+    int64_t v = number_to_int64(&n);
+    *value = v < LONG_MIN ? LONG_MIN : (v > LONG_MAX ? LONG_MAX : (long) v);
+    return 1;
+}
+
+/**
+ * @brief Read a boolean, a number is read as @p true if it's not zero
+ * 
+ * @note Values of other types are skipped and @p value is left unchanged, the same for the other readers
+ * 
+ * @param r The reader
+ * @param value The value
+ * @return int @p 0 for success, @p -1 for failure
+ */
+int json_wrapper_msgpack_read_bool(GET_STRUCT_NAME(Reader) * r, bool * value)
+{
+    ASSERT_RETURN(r && value, -1);
+    long number = 0;
+    int rc = msgpack_read_number(r, &number);
+    ASSERT_RETURN(rc >= 0, -1);
+    ASSERT_RETURN(rc > 0, json_wrapper_msgpack_skip(r));
+    *value = 0 != number;
+    return 0;
+}
+
+/**
+ * @brief Read an integer, floats are truncated and out of range values are saturated,
+ *        booleans are read as @p 1 and @p 0
+ * 
+ * @param r The reader
+ * @param value The value
+ * @return int @p 0 for success, @p -1 for failure
+ */
+int json_wrapper_msgpack_read_int(GET_STRUCT_NAME(Reader) * r, long * value)
+{
+    ASSERT_RETURN(r && value, -1);
+    long number = 0;
+    int rc = msgpack_read_number(r, &number);
+    ASSERT_RETURN(rc >= 0, -1);
+    ASSERT_RETURN(rc > 0, json_wrapper_msgpack_skip(r));
+    *value = number;
+    return 0;
+}
+
+/**
+ * @brief Read a 64 bits integer exactly, floats are truncated and out of range values are saturated,
+ *        booleans are read as @p 1 and @p 0
+ * 
+ * @param r The reader
+ * @param value The value
+ * @return int @p 0 for success, @p -1 for failure
+ */
+int json_wrapper_msgpack_read_int64(GET_STRUCT_NAME(Reader) * r, int64_t * value)
+{
+    ASSERT_RETURN(r && value, -1);
+    GET_STRUCT_NAME(Number) n;
+    int rc = msgpack_read_number_ex(r, &n);
+    ASSERT_RETURN(rc >= 0, -1);
+    ASSERT_RETURN(rc > 0, json_wrapper_msgpack_skip(r));
+    *value = number_to_int64(&n);
+    return 0;
+}
+
+/**
+ * @brief Read an unsigned 64 bits integer exactly, floats are truncated and out of range values,
+ *        the negative ones included, are saturated, booleans are read as @p 1 and @p 0
+ * 
+ * @param r The reader
+ * @param value The value
+ * @return int @p 0 for success, @p -1 for failure
+ */
+int json_wrapper_msgpack_read_uint64(GET_STRUCT_NAME(Reader) * r, uint64_t * value)
+{
+    ASSERT_RETURN(r && value, -1);
+    GET_STRUCT_NAME(Number) n;
+    int rc = msgpack_read_number_ex(r, &n);
+    ASSERT_RETURN(rc >= 0, -1);
+    ASSERT_RETURN(rc > 0, json_wrapper_msgpack_skip(r));
+    *value = number_to_uint64(&n);
+    return 0;
+}
+
+/**
+ * @brief Read a double, integers are converted and booleans are read as @p 1 and @p 0
+ * 
+ * @param r The reader
+ * @param value The value
+ * @return int @p 0 for success, @p -1 for failure
+ */
+int json_wrapper_msgpack_read_double(GET_STRUCT_NAME(Reader) * r, double * value)
+{
+    ASSERT_RETURN(r && value, -1);
+    GET_STRUCT_NAME(Number) n;
+    int rc = msgpack_read_number_ex(r, &n);
+    ASSERT_RETURN(rc >= 0, -1);
+    ASSERT_RETURN(rc > 0, json_wrapper_msgpack_skip(r));
+    *value = number_to_double(&n);
+    return 0;
+}
+
+/**
+ * @brief Read a string into memory alloced for the reader, the old @p *value is freed
+ * 
+ * @param r The reader
+ * @param value The value
+ * @return int @p 0 for success, @p -1 for failure
+ */
+int json_wrapper_msgpack_read_string(GET_STRUCT_NAME(Reader) * r, char ** value)
+{
+    ASSERT_RETURN(r && value, -1);
+    const char * begin = r->cur;
+    int kind = 0;
+    uint64_t arg = 0;
+    ASSERT_RETURN(0 == msgpack_header(r, &kind, &arg), -1);
+    if (MSGPACK_STR != kind)
+    {
+        r->cur = begin;
+        return json_wrapper_msgpack_skip(r);
+    }
+    ASSERT_RETURN(arg <= (uint64_t) (r->end - r->cur), -1);
+    char * str = json_wrapper_alloc_from(r->arena, arg + 1);
+    ASSERT_RETURN(str, -1);
+    memcpy(str, r->cur, arg);
+    str[arg] = '\0';
+    if (NULL != *value && NULL == r->arena) json_wrapper_free(*value);
+    *value = str;
+    r->cur += arg;
+    return 0;
+}
+
+/**
+ * @brief Read a string as a view into the data, nothing is copied
+ * 
+ * @param r The reader
+ * @param value The value
+ * @return int @p 0 for success, @p -1 for failure
+ */
+int json_wrapper_msgpack_read_view(GET_STRUCT_NAME(Reader) * r, GET_STRUCT_NAME(STRING_VIEW) * value)
+{
+    ASSERT_RETURN(r && value, -1);
+    const char * begin = r->cur;
+    int kind = 0;
+    uint64_t arg = 0;
+    ASSERT_RETURN(0 == msgpack_header(r, &kind, &arg), -1);
+    if (MSGPACK_STR != kind)
+    {
+        r->cur = begin;
+        return json_wrapper_msgpack_skip(r);
+    }
+    ASSERT_RETURN(arg <= (uint64_t) (r->end - r->cur), -1);
+    value->ptr = r->cur;
+    value->len = arg;
+    r->cur += arg;
+    return 0;
+}
+
+/**
+ * @brief Read a string into a fixed-capacity buffer, nothing is alloced
+ * 
+ * @note A string longer than @p cap - 1 bytes is truncated on a UTF-8 character boundary,
+ *       the result is always '\0' terminated
+ * 
+ * @param r The reader
+ * @param value The buffer
+ * @param cap The capacity of the buffer, at least @p 1
+ * @return int @p 0 for success, @p -1 for failure
+ */
+int json_wrapper_msgpack_read_fixed(GET_STRUCT_NAME(Reader) * r, char * value, size_t cap)
+{
+    ASSERT_RETURN(r && value && cap > 0, -1);
+    const char * begin = r->cur;
+    int kind = 0;
+    uint64_t arg = 0;
+    ASSERT_RETURN(0 == msgpack_header(r, &kind, &arg), -1);
+    if (MSGPACK_STR != kind)
+    {
+        r->cur = begin;
+        return json_wrapper_msgpack_skip(r);
+    }
+    ASSERT_RETURN(arg <= (uint64_t) (r->end - r->cur), -1);
+    json_wrapper_fixed_string_set(value, cap, r->cur, arg);
+    r->cur += arg;
+    return 0;
+}
+
+
+void JSON_2_FUNCTION_NAME(STRING)(cJSON * obj, STANDARD_TYPE(STRING) * dst)
+{
+    STANDARD_TYPE(STRING) src = (obj)->valuestring;
+    // STANDARD_TYPE(STRING) src = CONCAT(PRE_CONCAT(cJSON_Get, TYPE_2_CJSON_TYPE(STRING)), Value)(obj);
+    ASSERT_RETURN_VOID(src);
+    if (NULL != *dst) json_wrapper_free(*dst);
+    size_t len = strlen(src);
+    *dst = json_wrapper_alloc(1 + len);
+    ASSERT_RETURN_VOID(*dst);
+    memcpy(*dst, src, len);
+    (*dst)[len] = '\0';
+}
+
+
+/**
+ * @brief Store @p len bytes of @p src into a fixed-capacity buffer, @p src may be the buffer itself
+ * 
+ * @note A string longer than @p cap - 1 bytes is truncated on a UTF-8 character boundary,
+ *       the result is always '\0' terminated
+ * 
+ * @param dst The buffer
+ * @param cap The capacity of the buffer, at least @p 1
+ * @param src The string
+ * @param len The length of the string
+ * @return size_t The length stored
+ */
+size_t json_wrapper_fixed_string_set(char * dst, size_t cap, const char * src, size_t len)
+{
+    ASSERT_RETURN(dst && cap > 0 && (src || 0 == len), 0);
+    if (len >= cap)
+    {
+        size_t cut = cap - 1;
+        while (cut > 0 && cap - 1 - cut < 3 && 0x80 == ((unsigned char) src[cut] & 0xC0)) --cut;
+        len = 0x80 == ((unsigned char) src[cut] & 0xC0) ? cap - 1 : cut;
+    }
+    memmove(dst, src, len);
+    dst[len] = '\0';
+    return len;
+}
+
+/**
+ * @brief Convert a fixed-capacity string to json object
+ * 
+ * @param str The buffer
+ * @param cap The capacity of the buffer
+ * @return cJSON* The json object, @p NULL for failure
+ */
+cJSON * json_wrapper_fixed_string_to_json(const char * str, size_t cap)
+{
+    ASSERT_RETURN(str, NULL);
+    size_t len = json_wrapper_fixed_string_len(str, cap);
+    ASSERT_RETURN(len == cap, cJSON_CreateString(str));
+    char * copy = json_wrapper_alloc(len + 1);
+    ASSERT_RETURN(copy, NULL);
+    memcpy(copy, str, len);
+    copy[len] = '\0';
+    cJSON * obj = cJSON_CreateString(copy);
+    json_wrapper_free(copy);
+    return obj;
+}
+
+
+cJSON * STRUCT_2_FUNCTION_NAME(STRING_VIEW)(STANDARD_TYPE(STRING_VIEW) * value)
+{
+    ASSERT_RETURN(value->ptr, cJSON_CreateNull());
+    char * str = json_wrapper_alloc(value->len + 1);
+    ASSERT_RETURN(str, NULL);
+    memcpy(str, value->ptr, value->len);
+    str[value->len] = '\0';
+    cJSON * obj = PRE_CONCAT(cJSON_Create, TYPE_2_CJSON_TYPE(STRING_VIEW))(str);
+    json_wrapper_free(str);
+    return obj;
+}
+
+
+cJSON * STRUCT_2_FUNCTION_NAME(INT64)(STANDARD_TYPE(INT64) * value)
+{
+    ASSERT_RETURN(*value > (int64_t) 1 << 53 || *value < -((int64_t) 1 << 53), cJSON_CreateNumber((double) *value));
+    char digits[24];
+    char * end = digits + sizeof(digits) - 1;
+    *end = '\0';
+    char * p = format_uint64(end, *value < 0 ? 0 - (uint64_t) *value : (uint64_t) *value);
+    if (*value < 0) *--p = '-';
+    return cJSON_CreateRaw(p);
+}
+
+
+cJSON * STRUCT_2_FUNCTION_NAME(UINT64)(STANDARD_TYPE(UINT64) * value)
+{
+    ASSERT_RETURN(*value > (uint64_t) 1 << 53, cJSON_CreateNumber((double) *value));
+    char digits[24];
+    char * end = digits + sizeof(digits) - 1;
+    *end = '\0';
+    return cJSON_CreateRaw(format_uint64(end, *value));
+}
+
+
+void COPY_FUNCTION_NAME(STRING)(GET_STRUCT_NAME(STRING) * src, GET_STRUCT_NAME(STRING) * dst)
+{
+    COPY_ARENA_FUNCTION_NAME(STRING)(src, dst, NULL);
+}
+
+
+void COPY_ARENA_FUNCTION_NAME(STRING)(GET_STRUCT_NAME(STRING) * src, GET_STRUCT_NAME(STRING) * dst, GET_STRUCT_NAME(Arena) * arena)
+{
+    ASSERT_RETURN_VOID(src && dst);
+    char * copy = NULL;
+    if (NULL != *src)
+    {
+        size_t len = strlen(*src);
+        copy = json_wrapper_alloc_from(arena, len + 1);
+        ASSERT_RETURN_VOID(copy);
+        memcpy(copy, *src, len + 1);
+    }
+    if (NULL != *dst && NULL == arena) json_wrapper_free(*dst);
+    *dst = copy;
 }
 
 
@@ -119,7 +2648,7 @@ void RECYCLE_FUNCTION_NAME(STRING)(GET_STRUCT_NAME(STRING) * ptr)
     ASSERT_RETURN_VOID(ptr);
     if (*ptr)
     {
-        g_hook.free_(*ptr);
+        json_wrapper_free(*ptr);
         *ptr = NULL;
     }
 }
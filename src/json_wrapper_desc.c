@@ -0,0 +1,744 @@
+/**
+ * @file json_wrapper_desc.c
+ * @brief The table-driven engine which walks the descriptors of the wrapper types
+ *
+ */
+
+
+#include <stddef.h>
+#include <json_wrapper/json_wrapper.h>
+
+
+const GET_STRUCT_NAME(Desc) GET_DESC(BOOL) = { "BOOL", sizeof(GET_STRUCT_NAME(BOOL)), BOOL, NULL, 0, NULL, NULL };
+const GET_STRUCT_NAME(Desc) GET_DESC(CHAR) = { "CHAR", sizeof(GET_STRUCT_NAME(CHAR)), CHAR, NULL, 0, NULL, NULL };
+const GET_STRUCT_NAME(Desc) GET_DESC(INT) = { "INT", sizeof(GET_STRUCT_NAME(INT)), INT, NULL, 0, NULL, NULL };
+const GET_STRUCT_NAME(Desc) GET_DESC(INT64) = { "INT64", sizeof(GET_STRUCT_NAME(INT64)), INT64, NULL, 0, NULL, NULL };
+const GET_STRUCT_NAME(Desc) GET_DESC(UINT32) = { "UINT32", sizeof(GET_STRUCT_NAME(UINT32)), UINT32, NULL, 0, NULL, NULL };
+const GET_STRUCT_NAME(Desc) GET_DESC(UINT64) = { "UINT64", sizeof(GET_STRUCT_NAME(UINT64)), UINT64, NULL, 0, NULL, NULL };
+const GET_STRUCT_NAME(Desc) GET_DESC(FLOAT) = { "FLOAT", sizeof(GET_STRUCT_NAME(FLOAT)), FLOAT, NULL, 0, NULL, NULL };
+const GET_STRUCT_NAME(Desc) GET_DESC(DOUBLE) = { "DOUBLE", sizeof(GET_STRUCT_NAME(DOUBLE)), DOUBLE, NULL, 0, NULL, NULL };
+const GET_STRUCT_NAME(Desc) GET_DESC(STRING) = { "STRING", sizeof(GET_STRUCT_NAME(STRING)), STRING, NULL, 0, NULL, NULL };
+const GET_STRUCT_NAME(Desc) GET_DESC(STRING_VIEW) = { "STRING_VIEW", sizeof(GET_STRUCT_NAME(STRING_VIEW)), STRING_VIEW, NULL, 0, NULL, NULL };
+
+
+/**
+ * @brief The layout shared by all the VA_ARRAY types
+ */
+typedef struct GET_STRUCT_NAME(VaArray)
+{
+    void * data;
+    size_t size;
+} GET_STRUCT_NAME(VaArray);
+
+
+/**
+ * @brief Get the address of a field, or of an element of a field
+ */
+#define DESC_FIELD(value, field) ((char *) (value) + (field)->offset)
+#define DESC_ELEM(data, desc, i) ((char *) (data) + (desc)->size * (i))
+
+
+/**
+ * @brief Recycle the elements of a VA_ARRAY and free its buffer
+ *
+ * @param desc The descriptor of the elements
+ * @param array The VA_ARRAY
+ */
+static void desc_recycle_va_array(const GET_STRUCT_NAME(Desc) * desc, GET_STRUCT_NAME(VaArray) * array)
+{
+    size_t i = 0;
+    for (i = 0; NULL != array->data && i < array->size; ++i)
+    {
+        json_wrapper_desc_recycle(desc, DESC_ELEM(array->data, desc, i));
+    }
+    json_wrapper_free(array->data);
+    array->data = NULL;
+    array->size = 0;
+}
+
+/**
+ * @brief Prepare a VA_ARRAY for @p count zeroed elements, the old elements are recycled if there's no arena
+ *
+ * @param desc The descriptor of the elements
+ * @param array The VA_ARRAY
+ * @param count The number of elements
+ * @param arena The arena to alloc the buffer from, @p NULL for the hook in json wrapper
+ * @return int @p 0 for success, @p -1 for failure
+ */
+static int desc_alloc_va_array(const GET_STRUCT_NAME(Desc) * desc, GET_STRUCT_NAME(VaArray) * array,
+    size_t count, GET_STRUCT_NAME(Arena) * arena)
+{
+    if (NULL == arena) desc_recycle_va_array(desc, array);
+    array->data = NULL;
+    array->size = 0;
+    ASSERT_RETURN(count > 0, 0);
+    array->data = json_wrapper_alloc_from(arena, desc->size * count);
+    ASSERT_RETURN(array->data, -1);
+    memset(array->data, 0, desc->size * count);
+    array->size = count;
+    return 0;
+}
+
+
+/**
+ * @brief Get the elements of an ARRAY or a VA_ARRAY field
+ *
+ * @param field The descriptor of the field
+ * @param at The address of the field
+ * @param count The number of elements
+ * @return const char* The first element
+ */
+static const char * desc_array_data(const GET_STRUCT_NAME(FieldDesc) * field, const char * at, size_t * count)
+{
+    *count = field->count;
+    if (VA_ARRAY_ != field->kind) return at;
+    const GET_STRUCT_NAME(VaArray) * array = (const GET_STRUCT_NAME(VaArray) *) at;
+    *count = NULL != array->data ? array->size : 0;
+    return array->data;
+}
+
+/**
+ * @brief Write the value of a field as json text into @p buf
+ *
+ * @param field The descriptor of the field
+ * @param at The address of the field
+ * @param buf The buffer
+ * @return int @p 0 for success, @p -1 for failure
+ */
+static int desc_field_to_buffer(const GET_STRUCT_NAME(FieldDesc) * field, const char * at, GET_STRUCT_NAME(Buffer) * buf)
+{
+    switch (field->kind)
+    {
+        case OBJ_:
+            return json_wrapper_desc_to_buffer(field->desc, at, buf);
+        case FIXED_STRING_:
+            return json_wrapper_buffer_append_str(buf, at, json_wrapper_fixed_string_len(at, field->count));
+        default:
+            break;
+    }
+    size_t count = 0;
+    const char * data = desc_array_data(field, at, &count);
+    size_t i = 0;
+    ASSERT_RETURN(0 == json_wrapper_buffer_append(buf, "[", 1), -1);
+    for (i = 0; i < count; ++i)
+    {
+        if (i > 0) ASSERT_RETURN(0 == json_wrapper_buffer_append(buf, ",", 1), -1);
+        ASSERT_RETURN(0 == json_wrapper_desc_to_buffer(field->desc, DESC_ELEM(data, field->desc, i), buf), -1);
+    }
+    return json_wrapper_buffer_append(buf, "]", 1);
+}
+
+
+int json_wrapper_desc_to_buffer(const GET_STRUCT_NAME(Desc) * desc, const void * value, GET_STRUCT_NAME(Buffer) * buf)
+{
+    void * ptr = (void *) value;
+    switch (desc->type)
+    {
+        case BOOL: return STRUCT_2_BUFFER_FUNCTION_NAME(BOOL)(ptr, buf);
+        case CHAR: return STRUCT_2_BUFFER_FUNCTION_NAME(CHAR)(ptr, buf);
+        case INT: return STRUCT_2_BUFFER_FUNCTION_NAME(INT)(ptr, buf);
+        case INT64: return STRUCT_2_BUFFER_FUNCTION_NAME(INT64)(ptr, buf);
+        case UINT32: return STRUCT_2_BUFFER_FUNCTION_NAME(UINT32)(ptr, buf);
+        case UINT64: return STRUCT_2_BUFFER_FUNCTION_NAME(UINT64)(ptr, buf);
+        case FLOAT: return STRUCT_2_BUFFER_FUNCTION_NAME(FLOAT)(ptr, buf);
+        case DOUBLE: return STRUCT_2_BUFFER_FUNCTION_NAME(DOUBLE)(ptr, buf);
+        case STRING: return STRUCT_2_BUFFER_FUNCTION_NAME(STRING)(ptr, buf);
+        case STRING_VIEW: return STRUCT_2_BUFFER_FUNCTION_NAME(STRING_VIEW)(ptr, buf);
+        default: break;
+    }
+    size_t start = buf->len;
+    const GET_STRUCT_NAME(FieldDesc) * field = desc->fields;
+    const GET_STRUCT_NAME(FieldDesc) * end = desc->fields + desc->count;
+    for (; field < end; ++field)
+    {
+        ASSERT_RETURN(0 == json_wrapper_buffer_append(buf, field->member, field->member_len), -1);
+        ASSERT_RETURN(0 == desc_field_to_buffer(field, DESC_FIELD(value, field), buf), -1);
+    }
+    return json_wrapper_buffer_close_object(buf, start);
+}
+
+/**
+ * @brief Read a json array into an ARRAY or a VA_ARRAY field
+ *
+ * @param field The descriptor of the field
+ * @param r The reader
+ * @param at The address of the field
+ * @param mask The mask of the elements
+ * @return int @p 0 for success, @p -1 for failure
+ */
+static int desc_array_from_reader(const GET_STRUCT_NAME(FieldDesc) * field, GET_STRUCT_NAME(Reader) * r, char * at,
+    const GET_STRUCT_NAME(Mask) * mask)
+{
+    ASSERT_RETURN('[' == json_wrapper_reader_peek(r), json_wrapper_reader_skip(r));
+    char * data = at;
+    size_t count = field->count;
+    if (VA_ARRAY_ == field->kind)
+    {
+        GET_STRUCT_NAME(VaArray) * array = (GET_STRUCT_NAME(VaArray) *) at;
+        ASSERT_RETURN(0 == json_wrapper_reader_count(r, &count), -1);
+        ASSERT_RETURN(0 == desc_alloc_va_array(field->desc, array, count, r->arena), -1);
+        data = array->data;
+    }
+    ASSERT_RETURN(0 == json_wrapper_reader_expect(r, '['), -1);
+    size_t index = 0;
+    int rc = 0;
+    for (; 1 == (rc = json_wrapper_reader_next(r, ']', index)); ++index)
+    {
+        if (index < count)
+        {
+            ASSERT_RETURN(0 == json_wrapper_desc_from_reader_mask(field->desc, r, DESC_ELEM(data, field->desc, index), mask), -1);
+        } else
+        {
+            ASSERT_RETURN(VA_ARRAY_ != field->kind && 0 == json_wrapper_reader_skip(r), -1);
+        }
+    }
+    return rc;
+}
+
+int json_wrapper_desc_from_reader(const GET_STRUCT_NAME(Desc) * desc, GET_STRUCT_NAME(Reader) * r, void * value)
+{
+    return json_wrapper_desc_from_reader_mask(desc, r, value, NULL);
+}
+
+int json_wrapper_desc_from_reader_mask(const GET_STRUCT_NAME(Desc) * desc, GET_STRUCT_NAME(Reader) * r, void * value,
+    const GET_STRUCT_NAME(Mask) * mask)
+{
+    switch (desc->type)
+    {
+        case BOOL: return READER_2_FUNCTION_NAME(BOOL)(r, value);
+        case CHAR: return READER_2_FUNCTION_NAME(CHAR)(r, value);
+        case INT: return READER_2_FUNCTION_NAME(INT)(r, value);
+        case INT64: return READER_2_FUNCTION_NAME(INT64)(r, value);
+        case UINT32: return READER_2_FUNCTION_NAME(UINT32)(r, value);
+        case UINT64: return READER_2_FUNCTION_NAME(UINT64)(r, value);
+        case FLOAT: return READER_2_FUNCTION_NAME(FLOAT)(r, value);
+        case DOUBLE: return READER_2_FUNCTION_NAME(DOUBLE)(r, value);
+        case STRING: return READER_2_FUNCTION_NAME(STRING)(r, value);
+        case STRING_VIEW: return READER_2_FUNCTION_NAME(STRING_VIEW)(r, value);
+        default: break;
+    }
+    ASSERT_RETURN('{' == json_wrapper_reader_peek(r), json_wrapper_reader_skip(r));
+    ASSERT_RETURN(0 == json_wrapper_reader_expect(r, '{'), -1);
+    size_t index = 0;
+    size_t hint = 0;
+    int rc = 0;
+    for (; 1 == (rc = json_wrapper_reader_next(r, '}', index)); ++index)
+    {
+        const char * key = NULL;
+        size_t len = 0;
+        ASSERT_RETURN(0 == json_wrapper_reader_key(r, &key, &len), -1);
+        int i = json_wrapper_key_index(desc->keys, desc->count, desc->hash, key, len, hint);
+        if (i >= 0) hint = i + 1;
+        if (i < 0 || !json_wrapper_mask_has(mask, i))
+        {
+            ASSERT_RETURN(0 == json_wrapper_reader_skip(r), -1);
+            continue;
+        }
+        if (r->patch && 'n' == json_wrapper_reader_peek(r))
+        {
+            json_wrapper_desc_reset_field(desc, value, i, NULL == r->arena);
+            ASSERT_RETURN(0 == json_wrapper_reader_skip(r), -1);
+            continue;
+        }
+        const GET_STRUCT_NAME(FieldDesc) * field = &desc->fields[i];
+        const GET_STRUCT_NAME(Mask) * sub = json_wrapper_mask_sub(mask, i);
+        char * at = DESC_FIELD(value, field);
+        if (OBJ_ == field->kind)
+        {
+            ASSERT_RETURN(0 == json_wrapper_desc_from_reader_mask(field->desc, r, at, sub), -1);
+        } else if (FIXED_STRING_ == field->kind)
+        {
+            ASSERT_RETURN(0 == json_wrapper_reader_fixed(r, at, field->count), -1);
+        } else
+        {
+            ASSERT_RETURN(0 == desc_array_from_reader(field, r, at, sub), -1);
+        }
+    }
+    return rc;
+}
+
+
+int json_wrapper_desc_to_msgpack(const GET_STRUCT_NAME(Desc) * desc, const void * value, GET_STRUCT_NAME(Buffer) * buf)
+{
+    void * ptr = (void *) value;
+    switch (desc->type)
+    {
+        case BOOL: return STRUCT_2_MSGPACK_BUFFER_FUNCTION_NAME(BOOL)(ptr, buf);
+        case CHAR: return STRUCT_2_MSGPACK_BUFFER_FUNCTION_NAME(CHAR)(ptr, buf);
+        case INT: return STRUCT_2_MSGPACK_BUFFER_FUNCTION_NAME(INT)(ptr, buf);
+        case INT64: return STRUCT_2_MSGPACK_BUFFER_FUNCTION_NAME(INT64)(ptr, buf);
+        case UINT32: return STRUCT_2_MSGPACK_BUFFER_FUNCTION_NAME(UINT32)(ptr, buf);
+        case UINT64: return STRUCT_2_MSGPACK_BUFFER_FUNCTION_NAME(UINT64)(ptr, buf);
+        case FLOAT: return STRUCT_2_MSGPACK_BUFFER_FUNCTION_NAME(FLOAT)(ptr, buf);
+        case DOUBLE: return STRUCT_2_MSGPACK_BUFFER_FUNCTION_NAME(DOUBLE)(ptr, buf);
+        case STRING: return STRUCT_2_MSGPACK_BUFFER_FUNCTION_NAME(STRING)(ptr, buf);
+        case STRING_VIEW: return STRUCT_2_MSGPACK_BUFFER_FUNCTION_NAME(STRING_VIEW)(ptr, buf);
+        default: break;
+    }
+    ASSERT_RETURN(0 == json_wrapper_msgpack_write_map(buf, desc->count), -1);
+    const GET_STRUCT_NAME(FieldDesc) * field = desc->fields;
+    const GET_STRUCT_NAME(FieldDesc) * end = desc->fields + desc->count;
+    for (; field < end; ++field)
+    {
+        ASSERT_RETURN(0 == json_wrapper_msgpack_write_key(buf, field->name, field->len), -1);
+        char * at = DESC_FIELD(value, field);
+        const char * data = at;
+        size_t count = field->count;
+        size_t i = 0;
+        switch (field->kind)
+        {
+            case OBJ_:
+                ASSERT_RETURN(0 == json_wrapper_desc_to_msgpack(field->desc, at, buf), -1);
+                continue;
+            case FIXED_STRING_:
+                ASSERT_RETURN(0 == json_wrapper_msgpack_write_str(buf, at, json_wrapper_fixed_string_len(at, count)), -1);
+                continue;
+            case VA_ARRAY_:
+                data = ((GET_STRUCT_NAME(VaArray) *) at)->data;
+                count = NULL != data ? ((GET_STRUCT_NAME(VaArray) *) at)->size : 0;
+                break;
+            default:
+                break;
+        }
+        ASSERT_RETURN(0 == json_wrapper_msgpack_write_array(buf, count), -1);
+        for (i = 0; i < count; ++i)
+        {
+            ASSERT_RETURN(0 == json_wrapper_desc_to_msgpack(field->desc, DESC_ELEM(data, field->desc, i), buf), -1);
+        }
+    }
+    return 0;
+}
+
+/**
+ * @brief Read a MessagePack array into an ARRAY or a VA_ARRAY field
+ *
+ * @param field The descriptor of the field
+ * @param r The reader
+ * @param at The address of the field
+ * @return int @p 0 for success, @p -1 for failure
+ */
+static int desc_array_from_msgpack(const GET_STRUCT_NAME(FieldDesc) * field, GET_STRUCT_NAME(Reader) * r, char * at)
+{
+    int c = json_wrapper_msgpack_peek(r);
+    ASSERT_RETURN(JSON_WRAPPER_MSGPACK_IS_ARRAY(c), json_wrapper_msgpack_skip(r));
+    char * data = at;
+    size_t count = 0;
+    ASSERT_RETURN(0 == json_wrapper_msgpack_read_array(r, &count), -1);
+    size_t keep = count < field->count ? count : field->count;
+    if (VA_ARRAY_ == field->kind)
+    {
+        GET_STRUCT_NAME(VaArray) * array = (GET_STRUCT_NAME(VaArray) *) at;
+        ASSERT_RETURN(0 == desc_alloc_va_array(field->desc, array, count, r->arena), -1);
+        data = array->data;
+        keep = count;
+    }
+    size_t index = 0;
+    for (; index < count; ++index)
+    {
+        if (index < keep)
+        {
+            ASSERT_RETURN(0 == json_wrapper_desc_from_msgpack(field->desc, r, DESC_ELEM(data, field->desc, index)), -1);
+        } else
+        {
+            ASSERT_RETURN(0 == json_wrapper_msgpack_skip(r), -1);
+        }
+    }
+    return 0;
+}
+
+int json_wrapper_desc_from_msgpack(const GET_STRUCT_NAME(Desc) * desc, GET_STRUCT_NAME(Reader) * r, void * value)
+{
+    switch (desc->type)
+    {
+        case BOOL: return MSGPACK_READER_2_FUNCTION_NAME(BOOL)(r, value);
+        case CHAR: return MSGPACK_READER_2_FUNCTION_NAME(CHAR)(r, value);
+        case INT: return MSGPACK_READER_2_FUNCTION_NAME(INT)(r, value);
+        case INT64: return MSGPACK_READER_2_FUNCTION_NAME(INT64)(r, value);
+        case UINT32: return MSGPACK_READER_2_FUNCTION_NAME(UINT32)(r, value);
+        case UINT64: return MSGPACK_READER_2_FUNCTION_NAME(UINT64)(r, value);
+        case FLOAT: return MSGPACK_READER_2_FUNCTION_NAME(FLOAT)(r, value);
+        case DOUBLE: return MSGPACK_READER_2_FUNCTION_NAME(DOUBLE)(r, value);
+        case STRING: return MSGPACK_READER_2_FUNCTION_NAME(STRING)(r, value);
+        case STRING_VIEW: return MSGPACK_READER_2_FUNCTION_NAME(STRING_VIEW)(r, value);
+        default: break;
+    }
+    int c = json_wrapper_msgpack_peek(r);
+    ASSERT_RETURN(JSON_WRAPPER_MSGPACK_IS_MAP(c), json_wrapper_msgpack_skip(r));
+    size_t count = 0;
+    ASSERT_RETURN(0 == json_wrapper_msgpack_read_map(r, &count), -1);
+    size_t index = 0;
+    size_t hint = 0;
+    for (; index < count; ++index)
+    {
+        const char * key = NULL;
+        size_t len = 0;
+        ASSERT_RETURN(0 == json_wrapper_msgpack_read_key(r, &key, &len), -1);
+        int i = json_wrapper_key_index(desc->keys, desc->count, desc->hash, key, len, hint);
+        if (i < 0)
+        {
+            ASSERT_RETURN(0 == json_wrapper_msgpack_skip(r), -1);
+            continue;
+        }
+        const GET_STRUCT_NAME(FieldDesc) * field = &desc->fields[i];
+        char * at = DESC_FIELD(value, field);
+        if (OBJ_ == field->kind)
+        {
+            ASSERT_RETURN(0 == json_wrapper_desc_from_msgpack(field->desc, r, at), -1);
+        } else if (FIXED_STRING_ == field->kind)
+        {
+            ASSERT_RETURN(0 == json_wrapper_msgpack_read_fixed(r, at, field->count), -1);
+        } else
+        {
+            ASSERT_RETURN(0 == desc_array_from_msgpack(field, r, at), -1);
+        }
+        hint = i + 1;
+    }
+    return 0;
+}
+
+
+cJSON * json_wrapper_desc_to_json(const GET_STRUCT_NAME(Desc) * desc, const void * value)
+{
+    void * ptr = (void *) value;
+    switch (desc->type)
+    {
+        case BOOL: return STRUCT_2_FUNCTION_NAME(BOOL)(ptr);
+        case CHAR: return STRUCT_2_FUNCTION_NAME(CHAR)(ptr);
+        case INT: return STRUCT_2_FUNCTION_NAME(INT)(ptr);
+        case INT64: return STRUCT_2_FUNCTION_NAME(INT64)(ptr);
+        case UINT32: return STRUCT_2_FUNCTION_NAME(UINT32)(ptr);
+        case UINT64: return STRUCT_2_FUNCTION_NAME(UINT64)(ptr);
+        case FLOAT: return STRUCT_2_FUNCTION_NAME(FLOAT)(ptr);
+        case DOUBLE: return STRUCT_2_FUNCTION_NAME(DOUBLE)(ptr);
+        case STRING: return STRUCT_2_FUNCTION_NAME(STRING)(ptr);
+        case STRING_VIEW: return STRUCT_2_FUNCTION_NAME(STRING_VIEW)(ptr);
+        default: break;
+    }
+    cJSON * json = cJSON_CreateObject();
+    ASSERT_RETURN(json, NULL);
+    const GET_STRUCT_NAME(FieldDesc) * field = desc->fields;
+    const GET_STRUCT_NAME(FieldDesc) * end = desc->fields + desc->count;
+    for (; field < end; ++field)
+    {
+        char * at = DESC_FIELD(value, field);
+        const char * data = at;
+        size_t count = field->count;
+        size_t i = 0;
+        switch (field->kind)
+        {
+            case OBJ_:
+            {
+                cJSON * obj = json_wrapper_desc_to_json(field->desc, at);
+                ASSERT_RETURN(obj, json);
+                cJSON_AddItemToObject(json, field->name, obj);
+                continue;
+            }
+            case FIXED_STRING_:
+            {
+                cJSON * obj = json_wrapper_fixed_string_to_json(at, count);
+                ASSERT_RETURN(obj, json);
+                cJSON_AddItemToObject(json, field->name, obj);
+                continue;
+            }
+            case VA_ARRAY_:
+                data = ((GET_STRUCT_NAME(VaArray) *) at)->data;
+                count = NULL != data ? ((GET_STRUCT_NAME(VaArray) *) at)->size : 0;
+                break;
+            default:
+                break;
+        }
+        cJSON * array = cJSON_CreateArray();
+        ASSERT_RETURN(array, json);
+        for (i = 0; i < count; ++i)
+        {
+            cJSON * obj = json_wrapper_desc_to_json(field->desc, DESC_ELEM(data, field->desc, i));
+            ASSERT_BREAK(obj);
+            cJSON_AddItemToArray(array, obj);
+        }
+        cJSON_AddItemToObject(json, field->name, array);
+    }
+    return json;
+}
+
+int json_wrapper_desc_from_json(const GET_STRUCT_NAME(Desc) * desc, cJSON * json, void * value)
+{
+    switch (desc->type)
+    {
+        case BOOL: JSON_2_FUNCTION_NAME(BOOL)(json, value); return 0;
+        case CHAR: JSON_2_FUNCTION_NAME(CHAR)(json, value); return 0;
+        case INT: JSON_2_FUNCTION_NAME(INT)(json, value); return 0;
+        case INT64: JSON_2_FUNCTION_NAME(INT64)(json, value); return 0;
+        case UINT32: JSON_2_FUNCTION_NAME(UINT32)(json, value); return 0;
+        case UINT64: JSON_2_FUNCTION_NAME(UINT64)(json, value); return 0;
+        case FLOAT: JSON_2_FUNCTION_NAME(FLOAT)(json, value); return 0;
+        case DOUBLE: JSON_2_FUNCTION_NAME(DOUBLE)(json, value); return 0;
+        case STRING: JSON_2_FUNCTION_NAME(STRING)(json, value); return 0;
+        case STRING_VIEW: JSON_2_FUNCTION_NAME(STRING_VIEW)(json, value); return 0;
+        default: break;
+    }
+    size_t hint = 0;
+    cJSON * obj = NULL;
+    cJSON_ArrayForEach(obj, json)
+    {
+        if (NULL == obj->string) continue;
+        int i = json_wrapper_key_index(desc->keys, desc->count, desc->hash, obj->string, strlen(obj->string), hint);
+        if (i < 0) continue;
+        hint = i + 1;
+        const GET_STRUCT_NAME(FieldDesc) * field = &desc->fields[i];
+        char * at = DESC_FIELD(value, field);
+        if (OBJ_ == field->kind)
+        {
+            json_wrapper_desc_from_json(field->desc, obj, at);
+            continue;
+        }
+        if (FIXED_STRING_ == field->kind)
+        {
+            if (cJSON_IsString(obj) && NULL != obj->valuestring)
+            {
+                json_wrapper_fixed_string_set(at, field->count, obj->valuestring, strlen(obj->valuestring));
+            }
+            continue;
+        }
+        if (!cJSON_IsArray(obj)) continue;
+        char * data = at;
+        size_t count = field->count;
+        if (VA_ARRAY_ == field->kind)
+        {
+            GET_STRUCT_NAME(VaArray) * array = (GET_STRUCT_NAME(VaArray) *) at;
+            count = cJSON_GetArraySize(obj);
+            if (0 != desc_alloc_va_array(field->desc, array, count, NULL)) continue;
+            data = array->data;
+        }
+        cJSON * elem = NULL;
+        size_t index = 0;
+        cJSON_ArrayForEach(elem, obj)
+        {
+            ASSERT_BREAK(index < count);
+            json_wrapper_desc_from_json(field->desc, elem, DESC_ELEM(data, field->desc, index));
+            ++index;
+        }
+    }
+    return 0;
+}
+
+
+void json_wrapper_desc_copy(const GET_STRUCT_NAME(Desc) * desc, const void * src, void * dst, GET_STRUCT_NAME(Arena) * arena)
+{
+    ASSERT_RETURN_VOID(src != dst);
+    void * from = (void *) src;
+    switch (desc->type)
+    {
+        case BOOL: COPY_ARENA_FUNCTION_NAME(BOOL)(from, dst, arena); return;
+        case CHAR: COPY_ARENA_FUNCTION_NAME(CHAR)(from, dst, arena); return;
+        case INT: COPY_ARENA_FUNCTION_NAME(INT)(from, dst, arena); return;
+        case INT64: COPY_ARENA_FUNCTION_NAME(INT64)(from, dst, arena); return;
+        case UINT32: COPY_ARENA_FUNCTION_NAME(UINT32)(from, dst, arena); return;
+        case UINT64: COPY_ARENA_FUNCTION_NAME(UINT64)(from, dst, arena); return;
+        case FLOAT: COPY_ARENA_FUNCTION_NAME(FLOAT)(from, dst, arena); return;
+        case DOUBLE: COPY_ARENA_FUNCTION_NAME(DOUBLE)(from, dst, arena); return;
+        case STRING: COPY_ARENA_FUNCTION_NAME(STRING)(from, dst, arena); return;
+        case STRING_VIEW: COPY_ARENA_FUNCTION_NAME(STRING_VIEW)(from, dst, arena); return;
+        default: break;
+    }
+    const GET_STRUCT_NAME(FieldDesc) * field = desc->fields;
+    const GET_STRUCT_NAME(FieldDesc) * end = desc->fields + desc->count;
+    for (; field < end; ++field)
+    {
+        char * from_at = DESC_FIELD(src, field);
+        char * to_at = DESC_FIELD(dst, field);
+        const char * from_data = from_at;
+        char * to_data = to_at;
+        size_t count = field->count;
+        size_t i = 0;
+        switch (field->kind)
+        {
+            case OBJ_:
+                json_wrapper_desc_copy(field->desc, from_at, to_at, arena);
+                continue;
+            case FIXED_STRING_:
+                memcpy(to_at, from_at, count);
+                continue;
+            case VA_ARRAY_:
+            {
+                GET_STRUCT_NAME(VaArray) * from_array = (GET_STRUCT_NAME(VaArray) *) from_at;
+                GET_STRUCT_NAME(VaArray) * to_array = (GET_STRUCT_NAME(VaArray) *) to_at;
+                count = NULL != from_array->data ? from_array->size : 0;
+                if (0 != desc_alloc_va_array(field->desc, to_array, count, arena)) continue;
+                from_data = from_array->data;
+                to_data = to_array->data;
+                break;
+            }
+            default:
+                break;
+        }
+        for (i = 0; i < count; ++i)
+        {
+            json_wrapper_desc_copy(field->desc, DESC_ELEM(from_data, field->desc, i), DESC_ELEM(to_data, field->desc, i), arena);
+        }
+    }
+}
+
+/**
+ * @brief Recycle the value of a field
+ *
+ * @param field The descriptor of the field
+ * @param at The address of the field
+ */
+static void desc_field_recycle(const GET_STRUCT_NAME(FieldDesc) * field, char * at)
+{
+    size_t i = 0;
+    switch (field->kind)
+    {
+        case OBJ_:
+            json_wrapper_desc_recycle(field->desc, at);
+            break;
+        case ARRAY_:
+            for (i = 0; i < field->count; ++i)
+            {
+                json_wrapper_desc_recycle(field->desc, DESC_ELEM(at, field->desc, i));
+            }
+            break;
+        case VA_ARRAY_:
+            desc_recycle_va_array(field->desc, (GET_STRUCT_NAME(VaArray) *) at);
+            break;
+        default:
+            break;
+    }
+}
+
+
+void json_wrapper_desc_recycle(const GET_STRUCT_NAME(Desc) * desc, void * value)
+{
+    switch (desc->type)
+    {
+        case STRING: RECYCLE_FUNCTION_NAME(STRING)(value); return;
+        case STRING_VIEW: return;
+        case STRUCT_: break;
+        default: return;
+    }
+    const GET_STRUCT_NAME(FieldDesc) * field = desc->fields;
+    const GET_STRUCT_NAME(FieldDesc) * end = desc->fields + desc->count;
+    for (; field < end; ++field)
+    {
+        desc_field_recycle(field, DESC_FIELD(value, field));
+    }
+}
+
+void json_wrapper_desc_reset_field(const GET_STRUCT_NAME(Desc) * desc, void * value, size_t index, bool recycle)
+{
+    ASSERT_RETURN_VOID(desc && value && index < desc->count);
+    const GET_STRUCT_NAME(FieldDesc) * field = &desc->fields[index];
+    char * at = DESC_FIELD(value, field);
+    size_t size = field->desc->size;
+    switch (field->kind)
+    {
+        case ARRAY_: size *= field->count; break;
+        case VA_ARRAY_: size = sizeof(GET_STRUCT_NAME(VaArray)); break;
+        case FIXED_STRING_: size = field->count; break;
+        default: break;
+    }
+    if (recycle) desc_field_recycle(field, at);
+    memset(at, 0, size);
+}
+
+
+/**
+ * @brief Compare the values of a field in two structs deeply
+ *
+ * @param field The descriptor of the field
+ * @param a The address of the field in a struct
+ * @param b The address of the field in the other struct
+ * @return bool @p true for they are equal
+ */
+static bool desc_field_equal(const GET_STRUCT_NAME(FieldDesc) * field, const char * a, const char * b)
+{
+    switch (field->kind)
+    {
+        case OBJ_:
+            return json_wrapper_desc_equal(field->desc, a, b);
+        case FIXED_STRING_:
+            return 0 == strncmp(a, b, field->count);
+        default:
+            break;
+    }
+    size_t count = 0;
+    size_t other = 0;
+    const char * a_data = desc_array_data(field, a, &count);
+    const char * b_data = desc_array_data(field, b, &other);
+    ASSERT_RETURN(count == other, false);
+    size_t i = 0;
+    for (i = 0; i < count; ++i)
+    {
+        ASSERT_RETURN(json_wrapper_desc_equal(field->desc, DESC_ELEM(a_data, field->desc, i), DESC_ELEM(b_data, field->desc, i)), false);
+    }
+    return true;
+}
+
+bool json_wrapper_desc_equal(const GET_STRUCT_NAME(Desc) * desc, const void * a, const void * b)
+{
+    void * x = (void *) a;
+    void * y = (void *) b;
+    switch (desc->type)
+    {
+        case BOOL: return EQUAL_FUNCTION_NAME(BOOL)(x, y);
+        case CHAR: return EQUAL_FUNCTION_NAME(CHAR)(x, y);
+        case INT: return EQUAL_FUNCTION_NAME(INT)(x, y);
+        case INT64: return EQUAL_FUNCTION_NAME(INT64)(x, y);
+        case UINT32: return EQUAL_FUNCTION_NAME(UINT32)(x, y);
+        case UINT64: return EQUAL_FUNCTION_NAME(UINT64)(x, y);
+        case FLOAT: return EQUAL_FUNCTION_NAME(FLOAT)(x, y);
+        case DOUBLE: return EQUAL_FUNCTION_NAME(DOUBLE)(x, y);
+        case STRING: return EQUAL_FUNCTION_NAME(STRING)(x, y);
+        case STRING_VIEW: return EQUAL_FUNCTION_NAME(STRING_VIEW)(x, y);
+        default: break;
+    }
+    const GET_STRUCT_NAME(FieldDesc) * field = desc->fields;
+    const GET_STRUCT_NAME(FieldDesc) * end = desc->fields + desc->count;
+    for (; field < end; ++field)
+    {
+        ASSERT_RETURN(desc_field_equal(field, DESC_FIELD(a, field), DESC_FIELD(b, field)), false);
+    }
+    return true;
+}
+
+int json_wrapper_desc_diff(const GET_STRUCT_NAME(Desc) * desc, const void * old, const void * value, GET_STRUCT_NAME(Buffer) * buf)
+{
+    void * x = (void *) old;
+    void * y = (void *) value;
+    switch (desc->type)
+    {
+        case BOOL: return DIFF_BUFFER_FUNCTION_NAME(BOOL)(x, y, buf);
+        case CHAR: return DIFF_BUFFER_FUNCTION_NAME(CHAR)(x, y, buf);
+        case INT: return DIFF_BUFFER_FUNCTION_NAME(INT)(x, y, buf);
+        case INT64: return DIFF_BUFFER_FUNCTION_NAME(INT64)(x, y, buf);
+        case UINT32: return DIFF_BUFFER_FUNCTION_NAME(UINT32)(x, y, buf);
+        case UINT64: return DIFF_BUFFER_FUNCTION_NAME(UINT64)(x, y, buf);
+        case FLOAT: return DIFF_BUFFER_FUNCTION_NAME(FLOAT)(x, y, buf);
+        case DOUBLE: return DIFF_BUFFER_FUNCTION_NAME(DOUBLE)(x, y, buf);
+        case STRING: return DIFF_BUFFER_FUNCTION_NAME(STRING)(x, y, buf);
+        case STRING_VIEW: return DIFF_BUFFER_FUNCTION_NAME(STRING_VIEW)(x, y, buf);
+        default: break;
+    }
+    size_t start = buf->len;
+    const GET_STRUCT_NAME(FieldDesc) * field = desc->fields;
+    const GET_STRUCT_NAME(FieldDesc) * end = desc->fields + desc->count;
+    for (; field < end; ++field)
+    {
+        const char * from = DESC_FIELD(old, field);
+        const char * at = DESC_FIELD(value, field);
+        if (OBJ_ == field->kind)
+        {
+            size_t key = buf->len;
+            ASSERT_RETURN(0 == json_wrapper_buffer_append(buf, field->member, field->member_len), -1);
+            int rc = json_wrapper_desc_diff(field->desc, from, at, buf);
+            ASSERT_RETURN(rc >= 0, -1);
+            if (0 == rc) buf->len = key;
+        } else if (!desc_field_equal(field, from, at))
+        {
+            ASSERT_RETURN(0 == json_wrapper_buffer_append(buf, field->member, field->member_len), -1);
+            ASSERT_RETURN(0 == desc_field_to_buffer(field, at, buf), -1);
+        }
+    }
+    ASSERT_RETURN(buf->len != start, 0);
+    return 0 == json_wrapper_buffer_close_object(buf, start) ? 1 : -1;
+}
@@ -0,0 +1,462 @@
+/**
+ * @file json_wrapper_instrument.c
+ * @brief The per-type call counters, latency histograms and allocation accounting of the generated functions,
+ *        kept per thread without locks when json wrapper is built with JSON_WRAPPER_INSTRUMENT defined
+ * 
+ */
+
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <json_wrapper/json_wrapper.h>
+
+
+#if defined(JSON_WRAPPER_INSTRUMENT)
+
+#if defined(_WIN32)
+#include <windows.h>
+#else
+#include <time.h>
+#endif
+
+
+#if defined(__STDC_VERSION__) && __STDC_VERSION__ >= 201112L && !defined(__STDC_NO_THREADS__)
+#define THREAD_LOCAL _Thread_local
+#elif defined(_MSC_VER)
+#define THREAD_LOCAL __declspec(thread)
+#else
+#define THREAD_LOCAL __thread
+#endif
+
+/**
+ * @brief Add to a counter which only its thread writes, and read it from any thread
+ */
+#if defined(_MSC_VER) && !defined(__clang__)
+#define COUNTER_ADD(counter, n) (*(volatile uint64_t *) &(counter) = (counter) + (n))
+#define COUNTER_GET(counter) (*(volatile uint64_t *) &(counter))
+#define COUNTER_SET(counter, n) (*(volatile uint64_t *) &(counter) = (n))
+#define GENERATION_GET(generation) (*(volatile uint64_t *) &(generation))
+#define GENERATION_SET(generation, n) (*(volatile uint64_t *) &(generation) = (n))
+#define GENERATION_NEXT(generation) InterlockedIncrement64((volatile LONG64 *) &(generation))
+#define PTR_GET(ptr) (*(ptr))
+#define ID_GET(id) (*(volatile int *) &(id))
+#define ID_SET(id, n) (*(volatile int *) &(id) = (n))
+#define CAS_PTR(ptr, old, new) \
+    ((void *) (old) == InterlockedCompareExchangePointer((void * volatile *) (ptr), (void *) (new), (void *) (old)))
+#else
+#define COUNTER_ADD(counter, n) __atomic_store_n(&(counter), __atomic_load_n(&(counter), __ATOMIC_RELAXED) + (n), __ATOMIC_RELAXED)
+#define COUNTER_GET(counter) __atomic_load_n(&(counter), __ATOMIC_RELAXED)
+#define COUNTER_SET(counter, n) __atomic_store_n(&(counter), (n), __ATOMIC_RELAXED)
+#define GENERATION_GET(generation) __atomic_load_n(&(generation), __ATOMIC_ACQUIRE)
+#define GENERATION_SET(generation, n) __atomic_store_n(&(generation), (n), __ATOMIC_RELEASE)
+#define GENERATION_NEXT(generation) __atomic_add_fetch(&(generation), 1, __ATOMIC_ACQ_REL)
+#define PTR_GET(ptr) __atomic_load_n(ptr, __ATOMIC_ACQUIRE)
+#define ID_GET(id) __atomic_load_n(&(id), __ATOMIC_RELAXED)
+#define ID_SET(id, n) __atomic_store_n(&(id), (n), __ATOMIC_RELAXED)
+#define CAS_PTR(ptr, old, new) __sync_bool_compare_and_swap(ptr, old, new)
+#endif
+
+
+/**
+ * @brief The counters of an operation on a type in a thread
+ */
+typedef struct GET_STRUCT_NAME(OpStats)
+{
+    uint64_t calls;
+    uint64_t bytes_in;
+    uint64_t bytes_out;
+    uint64_t allocs;
+    uint64_t alloc_bytes;
+    uint64_t ns;
+    uint64_t histogram[INSTRUMENT_BUCKETS];
+} GET_STRUCT_NAME(OpStats);
+
+/**
+ * @brief The counters of a thread, a row of @link INSTRUMENT_OPS counters per type alloced on its first call
+ * 
+ * @note The counters outlive their thread, so that the dumps keep the calls of the threads which have exited.
+ *       Only the thread writes its counters, a reset bumps @link g_generation and the thread zeros its counters
+ *       on its next call, the dumps skip the counters of the threads left in an older generation
+ */
+typedef struct GET_STRUCT_NAME(ThreadStats)
+{
+    struct GET_STRUCT_NAME(ThreadStats) * next;
+    uint64_t generation;                    // The generation the counters belong to
+    GET_STRUCT_NAME(OpStats) * volatile types[INSTRUMENT_TYPES_MAX];
+} GET_STRUCT_NAME(ThreadStats);
+
+static const char * const g_op_names[INSTRUMENT_OPS] = { "s2j", "j2s", "copy", "recycle" };
+
+/**
+ * @brief The registered type names, an open addressing table which only grows
+ */
+static const char * volatile g_names[INSTRUMENT_TYPES_MAX];
+
+/**
+ * @brief The counters of all the threads which have recorded a call, pushed to the front without locks
+ */
+static GET_STRUCT_NAME(ThreadStats) * volatile g_threads = NULL;
+
+/**
+ * @brief The generation of the counters, bumped by @link json_wrapper_instrument_reset
+ */
+static uint64_t g_generation = 0;
+
+/**
+ * @brief The counters of the current thread
+ */
+static THREAD_LOCAL GET_STRUCT_NAME(ThreadStats) * t_stats = NULL;
+
+/**
+ * @brief The counters of the call being recorded in the current thread, @p NULL for none
+ */
+static THREAD_LOCAL GET_STRUCT_NAME(OpStats) * t_current = NULL;
+
+
+/**
+ * @brief Get the monotonic time in nanoseconds
+ */
+static uint64_t instrument_now(void)
+{
+#if defined(_WIN32)
+    static LARGE_INTEGER frequency;
+    LARGE_INTEGER counter;
+    if (0 == frequency.QuadPart) QueryPerformanceFrequency(&frequency);
+    QueryPerformanceCounter(&counter);
+    return (uint64_t) ((double) counter.QuadPart * 1e9 / frequency.QuadPart);
+#else
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t) ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+#endif
+}
+
+/**
+ * @brief Get the histogram bucket of a latency, the floor of its log2
+ */
+static int instrument_bucket(uint64_t ns)
+{
+    int bucket = 0;
+#if defined(__GNUC__) || defined(__clang__)
+    bucket = ns > 1 ? 63 - __builtin_clzll(ns) : 0;
+#else
+    for (; ns > 1; ns >>= 1) ++bucket;
+#endif
+    return bucket < INSTRUMENT_BUCKETS ? bucket : INSTRUMENT_BUCKETS - 1;
+}
+
+/**
+ * @brief Register a type name, the threads racing on the same name get the same id
+ * 
+ * @return int The id, @p -1 for the table is full
+ */
+static int instrument_register(const char * name)
+{
+    uint32_t hash = 2166136261u;
+    const char * p = name;
+    for (; *p; ++p) hash = (hash ^ (unsigned char) *p) * 16777619u;
+    int i = 0;
+    for (i = 0; i < INSTRUMENT_TYPES_MAX; ++i)
+    {
+        int id = (int) ((hash + i) % INSTRUMENT_TYPES_MAX);
+        if (NULL == PTR_GET(&g_names[id]) && CAS_PTR(&g_names[id], NULL, name)) return id;
+        if (0 == strcmp(PTR_GET(&g_names[id]), name)) return id;
+    }
+    return -1;
+}
+
+/**
+ * @brief Get the counters of the type @p id in the current thread, which are alloced on the first call
+ *        and zeroed on the first call after a reset
+ * 
+ * @note The counters are alloced by malloc instead of the hook, so they are neither counted nor
+ *       freed by an arena or a pool behind the hook
+ */
+static GET_STRUCT_NAME(OpStats) * instrument_row(int id)
+{
+    GET_STRUCT_NAME(ThreadStats) * stats = t_stats;
+    if (NULL == stats)
+    {
+        stats = calloc(1, sizeof(GET_STRUCT_NAME(ThreadStats)));
+        ASSERT_RETURN(stats, NULL);
+        stats->generation = GENERATION_GET(g_generation);
+        do {
+            stats->next = PTR_GET(&g_threads);
+        } while (!CAS_PTR(&g_threads, stats->next, stats));
+        t_stats = stats;
+    }
+    uint64_t generation = GENERATION_GET(g_generation);
+    if (stats->generation != generation)
+    {
+        int i = 0;
+        for (i = 0; i < INSTRUMENT_TYPES_MAX; ++i)
+        {
+            uint64_t * counters = (uint64_t *) stats->types[i];
+            size_t n = NULL != counters ? INSTRUMENT_OPS * sizeof(GET_STRUCT_NAME(OpStats)) / sizeof(uint64_t) : 0;
+            size_t k = 0;
+            for (k = 0; k < n; ++k) COUNTER_SET(counters[k], 0);
+        }
+        GENERATION_SET(stats->generation, generation);
+    }
+    GET_STRUCT_NAME(OpStats) * row = stats->types[id];
+    if (NULL == row)
+    {
+        row = calloc(INSTRUMENT_OPS, sizeof(GET_STRUCT_NAME(OpStats)));
+        ASSERT_RETURN(row, NULL);
+        CAS_PTR(&stats->types[id], NULL, row);
+    }
+    return row;
+}
+
+/**
+ * @brief Start recording a call of the operation @p op on the type @p name
+ * 
+ * @note Only the outermost call of a thread is recorded, the nested calls such as copying the struct fields
+ *       and the allocations they make are accounted to it
+ * 
+ * @param probe The call
+ * @param id The cached id of the type name, @p -1 until the name is registered on the first call
+ * @param name The type name
+ * @param op The operation
+ */
+void json_wrapper_instrument_enter(GET_STRUCT_NAME(Probe) * probe, int * id, const char * name,
+    GET_STRUCT_NAME(InstrumentOp) op)
+{
+    probe->stats = NULL;
+    ASSERT_RETURN_VOID(NULL == t_current);
+    int type = ID_GET(*id);
+    if (type < 0)
+    {
+        type = instrument_register(name);
+        ID_SET(*id, type);
+    }
+    ASSERT_RETURN_VOID(type >= 0);
+    GET_STRUCT_NAME(OpStats) * row = instrument_row(type);
+    ASSERT_RETURN_VOID(row);
+    t_current = &row[op];
+    probe->stats = t_current;
+    probe->begin = instrument_now();
+}
+
+/**
+ * @brief Stop recording a call and count its latency and bytes into the counters of the thread
+ * 
+ * @param probe The call
+ * @param bytes_in The bytes of text read
+ * @param bytes_out The bytes of text written
+ */
+void json_wrapper_instrument_leave(GET_STRUCT_NAME(Probe) * probe, size_t bytes_in, size_t bytes_out)
+{
+    GET_STRUCT_NAME(OpStats) * stats = probe->stats;
+    ASSERT_RETURN_VOID(stats);
+    uint64_t ns = instrument_now() - probe->begin;
+    t_current = NULL;
+    COUNTER_ADD(stats->calls, 1);
+    COUNTER_ADD(stats->bytes_in, bytes_in);
+    COUNTER_ADD(stats->bytes_out, bytes_out);
+    COUNTER_ADD(stats->ns, ns);
+    COUNTER_ADD(stats->histogram[instrument_bucket(ns)], 1);
+}
+
+/**
+ * @brief Count an allocation of @p size bytes into the call being recorded in the current thread,
+ *        it's called by @link json_wrapper_alloc
+ * 
+ * @param size The memory size
+ */
+void json_wrapper_instrument_alloc(size_t size)
+{
+    GET_STRUCT_NAME(OpStats) * stats = t_current;
+    ASSERT_RETURN_VOID(stats);
+    COUNTER_ADD(stats->allocs, 1);
+    COUNTER_ADD(stats->alloc_bytes, size);
+}
+
+/**
+ * @brief Sum the counters of an operation on a type over all the threads
+ */
+static void instrument_sum(int id, int op, GET_STRUCT_NAME(OpStats) * sum)
+{
+    GET_STRUCT_NAME(ThreadStats) * stats = PTR_GET(&g_threads);
+    uint64_t generation = GENERATION_GET(g_generation);
+    memset(sum, 0, sizeof(GET_STRUCT_NAME(OpStats)));
+    for (; NULL != stats; stats = stats->next)
+    {
+        if (GENERATION_GET(stats->generation) != generation) continue;
+        GET_STRUCT_NAME(OpStats) * row = PTR_GET(&stats->types[id]);
+        if (NULL == row) continue;
+        sum->calls += COUNTER_GET(row[op].calls);
+        sum->bytes_in += COUNTER_GET(row[op].bytes_in);
+        sum->bytes_out += COUNTER_GET(row[op].bytes_out);
+        sum->allocs += COUNTER_GET(row[op].allocs);
+        sum->alloc_bytes += COUNTER_GET(row[op].alloc_bytes);
+        sum->ns += COUNTER_GET(row[op].ns);
+        int i = 0;
+        for (i = 0; i < INSTRUMENT_BUCKETS; ++i) sum->histogram[i] += COUNTER_GET(row[op].histogram[i]);
+    }
+}
+
+/**
+ * @brief Get the upper bound of the latency of the fraction @p q of the calls by the histogram
+ */
+static uint64_t instrument_percentile(const GET_STRUCT_NAME(OpStats) * sum, double q)
+{
+    uint64_t seen = 0;
+    int i = 0;
+    for (i = 0; i < INSTRUMENT_BUCKETS - 1; ++i)
+    {
+        seen += sum->histogram[i];
+        if (seen >= q * sum->calls) break;
+    }
+    return 2ULL << i;
+}
+
+/**
+ * @brief Write the counters of all the threads summed per type and operation as a text table into @p buf
+ * 
+ * @note Nothing is written unless json wrapper is built with @p JSON_WRAPPER_INSTRUMENT defined.
+ *       The counters are read while other threads may be updating them, so a dump taken under load is
+ *       consistent per counter but not across them
+ * 
+ * @param buf The buffer
+ * @return int @p 0 for success, @p -1 for failure or the instrumentation is compiled out
+ */
+int json_wrapper_instrument_dump_text(GET_STRUCT_NAME(Buffer) * buf)
+{
+    ASSERT_RETURN(buf, -1);
+    char line[256];
+    int n = snprintf(line, sizeof(line), "%-24s %-8s %10s %14s %14s %10s %14s %12s %10s %10s\n", "type", "op",
+        "calls", "bytes_in", "bytes_out", "allocs", "alloc_bytes", "mean_ns", "p50_ns", "p99_ns");
+    ASSERT_RETURN(0 == json_wrapper_buffer_append(buf, line, n), -1);
+    int id = 0;
+    int op = 0;
+    for (id = 0; id < INSTRUMENT_TYPES_MAX; ++id)
+    {
+        if (NULL == PTR_GET(&g_names[id])) continue;
+        for (op = 0; op < INSTRUMENT_OPS; ++op)
+        {
+            GET_STRUCT_NAME(OpStats) sum;
+            instrument_sum(id, op, &sum);
+            if (0 == sum.calls) continue;
+            n = snprintf(line, sizeof(line), "%-24s %-8s %10llu %14llu %14llu %10llu %14llu %12.1f %10llu %10llu\n",
+                g_names[id], g_op_names[op], (unsigned long long) sum.calls, (unsigned long long) sum.bytes_in,
+                (unsigned long long) sum.bytes_out, (unsigned long long) sum.allocs,
+                (unsigned long long) sum.alloc_bytes, (double) sum.ns / sum.calls,
+                (unsigned long long) instrument_percentile(&sum, 0.5),
+                (unsigned long long) instrument_percentile(&sum, 0.99));
+            ASSERT_RETURN(n > 0 && (size_t) n < sizeof(line), -1);
+            ASSERT_RETURN(0 == json_wrapper_buffer_append(buf, line, n), -1);
+        }
+    }
+    return 0;
+}
+
+/**
+ * @brief Append @p ,"key":value into @p buf
+ */
+static int instrument_append_member(GET_STRUCT_NAME(Buffer) * buf, const char * key, uint64_t value)
+{
+    ASSERT_RETURN(0 == json_wrapper_buffer_append(buf, ",\"", 2), -1);
+    ASSERT_RETURN(0 == json_wrapper_buffer_append(buf, key, strlen(key)), -1);
+    ASSERT_RETURN(0 == json_wrapper_buffer_append(buf, "\":", 2), -1);
+    return json_wrapper_buffer_append_uint64(buf, value);
+}
+
+/**
+ * @brief Write the counters the same as @link json_wrapper_instrument_dump_text but as a json array
+ *        of an object per type and operation, with the latency histogram in @p histogram
+ * 
+ * @param buf The buffer
+ * @return int @p 0 for success, @p -1 for failure or the instrumentation is compiled out
+ */
+int json_wrapper_instrument_dump_json(GET_STRUCT_NAME(Buffer) * buf)
+{
+    ASSERT_RETURN(buf, -1);
+    ASSERT_RETURN(0 == json_wrapper_buffer_append(buf, "[", 1), -1);
+    bool first = true;
+    int id = 0;
+    int op = 0;
+    for (id = 0; id < INSTRUMENT_TYPES_MAX; ++id)
+    {
+        if (NULL == PTR_GET(&g_names[id])) continue;
+        for (op = 0; op < INSTRUMENT_OPS; ++op)
+        {
+            GET_STRUCT_NAME(OpStats) sum;
+            instrument_sum(id, op, &sum);
+            if (0 == sum.calls) continue;
+            ASSERT_RETURN(0 == json_wrapper_buffer_append(buf, first ? "{\"type\":" : ",{\"type\":", first ? 8 : 9), -1);
+            first = false;
+            ASSERT_RETURN(0 == json_wrapper_buffer_append_string(buf, g_names[id]), -1);
+            ASSERT_RETURN(0 == json_wrapper_buffer_append(buf, ",\"op\":", 6), -1);
+            ASSERT_RETURN(0 == json_wrapper_buffer_append_string(buf, g_op_names[op]), -1);
+            ASSERT_RETURN(0 == instrument_append_member(buf, "calls", sum.calls), -1);
+            ASSERT_RETURN(0 == instrument_append_member(buf, "bytes_in", sum.bytes_in), -1);
+            ASSERT_RETURN(0 == instrument_append_member(buf, "bytes_out", sum.bytes_out), -1);
+            ASSERT_RETURN(0 == instrument_append_member(buf, "allocs", sum.allocs), -1);
+            ASSERT_RETURN(0 == instrument_append_member(buf, "alloc_bytes", sum.alloc_bytes), -1);
+            ASSERT_RETURN(0 == instrument_append_member(buf, "ns", sum.ns), -1);
+            ASSERT_RETURN(0 == json_wrapper_buffer_append(buf, ",\"histogram\":[", 14), -1);
+            int i = 0;
+            for (i = 0; i < INSTRUMENT_BUCKETS; ++i)
+            {
+                if (i > 0) ASSERT_RETURN(0 == json_wrapper_buffer_append(buf, ",", 1), -1);
+                ASSERT_RETURN(0 == json_wrapper_buffer_append_uint64(buf, sum.histogram[i]), -1);
+            }
+            ASSERT_RETURN(0 == json_wrapper_buffer_append(buf, "]}", 2), -1);
+        }
+    }
+    return json_wrapper_buffer_append(buf, "]", 1);
+}
+
+/**
+ * @brief Zero the counters of all the threads, the type names stay registered
+ * 
+ * @note The counters are not written here, each thread zeros its own on its next call,
+ *       so a call in flight across the reset is dropped
+ */
+void json_wrapper_instrument_reset(void)
+{
+    GENERATION_NEXT(g_generation);
+}
+
+#else
+
+void json_wrapper_instrument_enter(GET_STRUCT_NAME(Probe) * probe, int * id, const char * name,
+    GET_STRUCT_NAME(InstrumentOp) op)
+{
+    (void) id;
+    (void) name;
+    (void) op;
+    probe->stats = NULL;
+}
+
+void json_wrapper_instrument_leave(GET_STRUCT_NAME(Probe) * probe, size_t bytes_in, size_t bytes_out)
+{
+    (void) probe;
+    (void) bytes_in;
+    (void) bytes_out;
+}
+
+void json_wrapper_instrument_alloc(size_t size)
+{
+    (void) size;
+}
+
+int json_wrapper_instrument_dump_text(GET_STRUCT_NAME(Buffer) * buf)
+{
+    (void) buf;
+    return -1;
+}
+
+int json_wrapper_instrument_dump_json(GET_STRUCT_NAME(Buffer) * buf)
+{
+    (void) buf;
+    return -1;
+}
+
+void json_wrapper_instrument_reset(void)
+{
+}
+
+#endif
@@ -0,0 +1,254 @@
+/**
+ * @file json_wrapper_lines.c
+ * @brief The line sources which NDJSON records are decoded from
+ *
+ */
+
+
+#include <stddef.h>
+#include <errno.h>
+#include <json_wrapper/json_wrapper.h>
+
+#ifdef _WIN32
+#include <io.h>
+#define LINES_READ(fd, buf, len) _read(fd, buf, (unsigned int) (len))
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#define LINES_READ(fd, buf, len) read(fd, buf, len)
+#endif
+
+
+/**
+ * @brief The bytes of a mapped file consumed before their pages are dropped, which keeps the resident memory bounded
+ */
+#define LINES_MAP_RELEASE (64 << 20)
+
+
+/**
+ * @brief Init a line source which reads @p fd through a refill buffer, the descriptor is not closed by the source
+ *
+ * @param lines The line source
+ * @param fd The file descriptor
+ * @param max The length limit of a line, @p 0 for @link LINES_MAX_LINE, longer lines are reported as failures
+ * @return int @p 0 for success, @p -1 for failure
+ */
+int json_wrapper_lines_init_fd(GET_STRUCT_NAME(Lines) * lines, int fd, size_t max)
+{
+    ASSERT_RETURN(lines && fd >= 0, -1);
+    memset(lines, 0, sizeof(GET_STRUCT_NAME(Lines)));
+    lines->fd = fd;
+    lines->max = max ? max : LINES_MAX_LINE;
+    lines->cap = LINES_BUFFER_SIZE < lines->max ? LINES_BUFFER_SIZE : lines->max;
+    lines->data = json_wrapper_alloc(lines->cap);
+    ASSERT_RETURN(lines->data, -1);
+    return 0;
+}
+
+/**
+ * @brief Init a line source over a file mapped into memory, the pages are read ahead and cached by the system
+ *
+ * @note Only available on POSIX systems. The mapping is private, the changes made to it are never written back
+ *
+ * @param lines The line source
+ * @param path The path of the file
+ * @return int @p 0 for success, @p -1 for failure
+ */
+int json_wrapper_lines_init_map(GET_STRUCT_NAME(Lines) * lines, const char * path)
+{
+    ASSERT_RETURN(lines && path, -1);
+    memset(lines, 0, sizeof(GET_STRUCT_NAME(Lines)));
+    lines->fd = -1;
+#ifdef _WIN32
+    return -1;
+#else
+    int fd = open(path, O_RDONLY);
+    ASSERT_RETURN(fd >= 0, -1);
+    struct stat st;
+    if (0 != fstat(fd, &st))
+    {
+        close(fd);
+        return -1;
+    }
+    if (st.st_size > 0)
+    {
+        void * data = mmap(NULL, st.st_size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+        if (MAP_FAILED == data)
+        {
+            close(fd);
+            return -1;
+        }
+        madvise(data, st.st_size, MADV_SEQUENTIAL);
+        lines->data = data;
+        lines->len = st.st_size;
+        lines->mapped = true;
+    }
+    close(fd);
+    lines->eof = true;
+    return 0;
+#endif
+}
+
+/**
+ * @brief Init a line source over @p len bytes of @p data of the caller
+ *
+ * @param lines The line source
+ * @param data The text
+ * @param len The length of text
+ */
+void json_wrapper_lines_init_memory(GET_STRUCT_NAME(Lines) * lines, const char * data, size_t len)
+{
+    ASSERT_RETURN_VOID(lines);
+    memset(lines, 0, sizeof(GET_STRUCT_NAME(Lines)));
+    lines->fd = -1;
+    lines->data = data;
+    lines->len = NULL != data ? len : 0;
+    lines->eof = true;
+}
+
+/**
+ * @brief Drop the pages of a mapped file before @p offset, which have been consumed
+ *
+ * @note @p cap of a mapped source is the number of bytes dropped so far
+ *
+ * @param lines The line source
+ * @param offset The start of the line being handed out
+ */
+static void lines_release_map(GET_STRUCT_NAME(Lines) * lines, size_t offset)
+{
+#ifndef _WIN32
+    if (!lines->mapped || offset - lines->cap < LINES_MAP_RELEASE) return;
+    size_t page = (size_t) sysconf(_SC_PAGESIZE);
+    size_t end = offset / page * page;
+    madvise((char *) lines->data + lines->cap, end - lines->cap, MADV_DONTNEED);
+    lines->cap = end;
+#endif
+}
+
+/**
+ * @brief Read more bytes from the descriptor of @p lines, the consumed bytes are moved out first
+ *
+ * @param lines The line source
+ * @return int @p 1 for some bytes are read or the end is reached, @p 0 for the line is too long, @p -1 for failure
+ */
+static int lines_refill(GET_STRUCT_NAME(Lines) * lines)
+{
+    char * data = (char *) lines->data;
+    if (lines->pos > 0)
+    {
+        memmove(data, data + lines->pos, lines->len - lines->pos);
+        lines->len -= lines->pos;
+        lines->pos = 0;
+    }
+    if (lines->len == lines->cap)
+    {
+        if (lines->skip)
+        {
+            lines->len = 0;
+        } else if (lines->cap >= lines->max)
+        {
+            return 0;
+        } else
+        {
+            size_t cap = lines->cap * 2 < lines->max ? lines->cap * 2 : lines->max;
+            char * grown = json_wrapper_alloc(cap);
+            ASSERT_RETURN(grown, -1);
+            memcpy(grown, data, lines->len);
+            json_wrapper_free(data);
+            lines->data = data = grown;
+            lines->cap = cap;
+        }
+    }
+    for (;;)
+    {
+        long n = (long) LINES_READ(lines->fd, data + lines->len, lines->cap - lines->len);
+        if (n < 0 && EINTR == errno) continue;
+        if (n <= 0) lines->eof = true;
+        ASSERT_RETURN(n >= 0, -1);
+        lines->len += n;
+        return 1;
+    }
+}
+
+/**
+ * @brief Get the next line, without the '\n' nor the '\r' before it
+ *
+ * @note The line stays valid until the next call. A line which is too long or an error of reading
+ *       is reported once by @p -1, the next call goes on with the line after it
+ *
+ * @param lines The line source
+ * @param line The line
+ * @param len The length of the line
+ * @return int @p 1 for there's a line, @p 0 for the end, @p -1 for failure
+ */
+int json_wrapper_lines_next(GET_STRUCT_NAME(Lines) * lines, const char ** line, size_t * len)
+{
+    ASSERT_RETURN(lines && line && len, -1);
+    size_t scan = lines->pos;
+    for (;;)
+    {
+        const char * begin = lines->data + lines->pos;
+        const char * end = lines->data + lines->len;
+        const char * nl = scan < lines->len ? memchr(lines->data + scan, '\n', lines->len - scan) : NULL;
+        if (NULL == nl && lines->eof)
+        {
+            if (begin == end || lines->skip)
+            {
+                lines->pos = lines->len;
+                lines->skip = false;
+                return 0;
+            }
+            nl = end;
+        }
+        if (NULL != nl)
+        {
+            lines->pos = nl - lines->data + (nl < end);
+            if (lines->skip)
+            {
+                lines->skip = false;
+                scan = lines->pos;
+                continue;
+            }
+            if (nl > begin && '\r' == nl[-1]) --nl;
+            *line = begin;
+            *len = nl - begin;
+            ++lines->line;
+            lines_release_map(lines, begin - lines->data);
+            return 1;
+        }
+        size_t pending = lines->len - lines->pos;
+        int rc = lines_refill(lines);
+        if (rc <= 0)
+        {
+            ++lines->line;
+            lines->skip = 0 == rc;
+            lines->len = lines->pos = 0;
+            return -1;
+        }
+        scan = lines->skip ? 0 : pending;
+    }
+}
+
+/**
+ * @brief Release the refill buffer or unmap the file of @p lines
+ *
+ * @param lines The line source
+ */
+void json_wrapper_lines_release(GET_STRUCT_NAME(Lines) * lines)
+{
+    ASSERT_RETURN_VOID(lines);
+    if (lines->fd >= 0)
+    {
+        json_wrapper_free((void *) lines->data);
+    }
+#ifndef _WIN32
+    else if (lines->mapped)
+    {
+        munmap((void *) lines->data, lines->len);
+    }
+#endif
+    memset(lines, 0, sizeof(GET_STRUCT_NAME(Lines)));
+    lines->fd = -1;
+}
@@ -0,0 +1,337 @@
+/**
+ * @file json_wrapper_parallel.c
+ * @brief Decode NDJSON text into an array of structs on a pool of worker threads with work stealing
+ *
+ */
+
+
+#include <stddef.h>
+#include <json_wrapper/json_wrapper.h>
+
+#ifndef _WIN32
+#include <pthread.h>
+#include <unistd.h>
+#define PARALLEL_THREADS 1
+#else
+#define PARALLEL_THREADS 0
+#endif
+
+
+/**
+ * @brief A piece of work: the records in [begin, end) of the text, whose first one goes to slot @p first
+ */
+typedef struct GET_STRUCT_NAME(Piece)
+{
+    size_t begin;
+    size_t end;
+    size_t first;
+} GET_STRUCT_NAME(Piece);
+
+struct GET_STRUCT_NAME(Job);
+
+/**
+ * @brief A worker and the range of pieces it owns, the range is shared with the thieves under @p lock
+ */
+typedef struct GET_STRUCT_NAME(Worker)
+{
+#if PARALLEL_THREADS
+    pthread_mutex_t lock;
+    pthread_t thread;
+#endif
+    size_t lo;
+    size_t hi;
+    int id;
+    int rc;
+    bool started;
+    struct GET_STRUCT_NAME(Job) * job;
+} GET_STRUCT_NAME(Worker);
+
+/**
+ * @brief A parallel decode shared by all its workers
+ */
+typedef struct GET_STRUCT_NAME(Job)
+{
+    const char * data;
+    char * array;
+    size_t size;
+    size_t count;
+    GET_STRUCT_NAME(Decode) decode;
+    void * (* alloc_)(size_t size);         // The hook in effect on the calling thread, bound to the workers
+    void (* free_)(void * ptr);
+    GET_STRUCT_NAME(Arena) * arenas;
+    GET_STRUCT_NAME(Piece) * pieces;
+    size_t npieces;
+    GET_STRUCT_NAME(Worker) * workers;
+    int nworkers;
+    bool counting;                          // counting the records of the pieces, or decoding them
+} GET_STRUCT_NAME(Job);
+
+
+/**
+ * @brief Count the non-empty lines of a piece, or decode them into their slots
+ *
+ * @param job The job
+ * @param worker The worker
+ * @param piece The piece
+ * @return size_t The number of non-empty lines
+ */
+static size_t parallel_piece(GET_STRUCT_NAME(Job) * job, GET_STRUCT_NAME(Worker) * worker, GET_STRUCT_NAME(Piece) * piece)
+{
+    const char * p = job->data + piece->begin;
+    const char * end = job->data + piece->end;
+    size_t index = piece->first;
+    size_t lines = 0;
+    GET_STRUCT_NAME(Reader) r;
+    while (p < end)
+    {
+        const char * nl = memchr(p, '\n', end - p);
+        const char * line_end = NULL != nl ? nl : end;
+        json_wrapper_reader_init(&r, p, line_end - p);
+        p = line_end + 1;
+        if (-1 == json_wrapper_reader_peek(&r)) continue;
+        ++lines;
+        if (job->counting) continue;
+        if (index >= job->count) break;
+        r.arena = NULL != job->arenas ? &job->arenas[worker->id] : NULL;
+        if (0 != job->decode(&r, job->array + job->size * index)) worker->rc = -1;
+        ++index;
+    }
+    return lines;
+}
+
+/**
+ * @brief Take the next piece of @p worker, or steal the upper half of the range of another worker
+ *
+ * @param worker The worker
+ * @param piece The index of the piece taken
+ * @return bool @p false for no piece is left
+ */
+static bool parallel_take(GET_STRUCT_NAME(Worker) * worker, size_t * piece)
+{
+    GET_STRUCT_NAME(Job) * job = worker->job;
+    bool taken = false;
+#if PARALLEL_THREADS
+    pthread_mutex_lock(&worker->lock);
+#endif
+    if (worker->lo < worker->hi)
+    {
+        *piece = worker->lo++;
+        taken = true;
+    }
+#if PARALLEL_THREADS
+    pthread_mutex_unlock(&worker->lock);
+    int i = 1;
+    for (; !taken && i < job->nworkers; ++i)
+    {
+        GET_STRUCT_NAME(Worker) * victim = &job->workers[(worker->id + i) % job->nworkers];
+        size_t lo = 0;
+        size_t hi = 0;
+        pthread_mutex_lock(&victim->lock);
+        if (victim->lo < victim->hi)
+        {
+            hi = victim->hi;
+            lo = hi - (hi - victim->lo + 1) / 2;
+            victim->hi = lo;
+        }
+        pthread_mutex_unlock(&victim->lock);
+        if (lo == hi) continue;
+        pthread_mutex_lock(&worker->lock);
+        worker->lo = lo + 1;
+        worker->hi = hi;
+        pthread_mutex_unlock(&worker->lock);
+        *piece = lo;
+        taken = true;
+    }
+#endif
+    return taken;
+}
+
+/**
+ * @brief Run a worker: count the records of its fixed share of the pieces, or decode pieces until none is left
+ *
+ * @param arg The worker
+ * @return void* @p NULL
+ */
+static void * parallel_work(void * arg)
+{
+    GET_STRUCT_NAME(Worker) * worker = arg;
+    GET_STRUCT_NAME(Job) * job = worker->job;
+    size_t i = 0;
+    if (job->counting)
+    {
+        for (i = worker->lo; i < worker->hi; ++i)
+        {
+            job->pieces[i].first = parallel_piece(job, worker, &job->pieces[i]);
+        }
+        return NULL;
+    }
+    while (parallel_take(worker, &i))
+    {
+        if (job->pieces[i].first < job->count) parallel_piece(job, worker, &job->pieces[i]);
+    }
+    return NULL;
+}
+
+#if PARALLEL_THREADS
+/**
+ * @brief Run a worker on its own thread bound to the hook of the calling thread, so that the records
+ *        and arena chunks it allocs are freed the same as the ones of worker 0
+ *
+ * @param arg The worker
+ * @return void* @p NULL
+ */
+static void * parallel_thread(void * arg)
+{
+    GET_STRUCT_NAME(Worker) * worker = arg;
+    json_wrapper_hook_thread(worker->job->alloc_, worker->job->free_);
+    parallel_work(worker);
+    json_wrapper_hook_thread(NULL, NULL);
+    return NULL;
+}
+#endif
+
+/**
+ * @brief Give each worker an even share of the pieces and run them all, the calling thread is worker 0
+ *
+ * @param job The job
+ */
+static void parallel_run(GET_STRUCT_NAME(Job) * job)
+{
+    int i = 0;
+    for (i = 0; i < job->nworkers; ++i)
+    {
+        job->workers[i].lo = job->npieces * i / job->nworkers;
+        job->workers[i].hi = job->npieces * (i + 1) / job->nworkers;
+    }
+#if PARALLEL_THREADS
+    for (i = 1; i < job->nworkers; ++i)
+    {
+        job->workers[i].started = 0 == pthread_create(&job->workers[i].thread, NULL, parallel_thread, &job->workers[i]);
+    }
+#endif
+    parallel_work(&job->workers[0]);
+#if PARALLEL_THREADS
+    for (i = 1; i < job->nworkers; ++i)
+    {
+        if (job->workers[i].started)
+        {
+            pthread_join(job->workers[i].thread, NULL);
+        } else if (job->counting)
+        {
+            parallel_work(&job->workers[i]);
+        }
+    }
+#endif
+}
+
+/**
+ * @brief Decode the non-empty lines of NDJSON text into an array on a pool of worker threads
+ *
+ * @note The text is split into pieces of about @p chunk bytes on line ends, the records of each piece
+ *       are counted first so that every record knows its slot in @p array, then the workers decode their
+ *       own ranges of pieces and steal half of the rest of another worker when they run out.
+ *       The workers are bound to the hook in effect on the calling thread, the thread hook if it's bound,
+ *       so the records are freed by RECYCLE_ST on the calling thread the same as if it decoded them all,
+ *       and the hook is called from all the workers, it must be thread safe.
+ *       With arenas, the records decoded by worker @p i live in @p arenas[i], grown by the same hook
+ *
+ * @param data The NDJSON text
+ * @param len The length of text
+ * @param array The array of structs, the records decode into it the same as @link J2S does
+ * @param size The size of a struct
+ * @param count The number of structs in @p array, the records after them are ignored
+ * @param decode The decode function of the struct
+ * @param options The options, @p NULL for the defaults
+ * @param records The number of records decoded into @p array
+ * @return int @p 0 for success, @p -1 for any record or the pool failed
+ */
+int json_wrapper_parallel_decode(const char * data, size_t len, void * array, size_t size, size_t count,
+    GET_STRUCT_NAME(Decode) decode, const GET_STRUCT_NAME(Parallel) * options, size_t * records)
+{
+    ASSERT_RETURN((data || 0 == len) && (array || 0 == count) && decode && records, -1);
+    *records = 0;
+    ASSERT_RETURN(len > 0 && count > 0, 0);
+    GET_STRUCT_NAME(Parallel) defaults;
+    memset(&defaults, 0, sizeof(GET_STRUCT_NAME(Parallel)));
+    if (NULL == options) options = &defaults;
+    size_t chunk = options->chunk ? options->chunk : PARALLEL_CHUNK_SIZE;
+    int threads = options->threads;
+#if PARALLEL_THREADS
+    if (threads <= 0) threads = (int) sysconf(_SC_NPROCESSORS_ONLN);
+#else
+    threads = 1;
+#endif
+    if (threads <= 0) threads = 1;
+
+    GET_STRUCT_NAME(Job) job;
+    memset(&job, 0, sizeof(GET_STRUCT_NAME(Job)));
+    job.data = data;
+    job.array = array;
+    job.size = size;
+    job.count = count;
+    job.decode = decode;
+    json_wrapper_hook_current(&job.alloc_, &job.free_);
+    job.arenas = options->arenas;
+    job.pieces = json_wrapper_alloc(sizeof(GET_STRUCT_NAME(Piece)) * (len / chunk + 1));
+    ASSERT_RETURN(job.pieces, -1);
+    size_t pos = 0;
+    while (pos < len)
+    {
+        size_t end = pos + chunk;
+        if (end < len)
+        {
+            const char * nl = memchr(data + end, '\n', len - end);
+            end = NULL != nl ? (size_t) (nl - data) + 1 : len;
+        } else
+        {
+            end = len;
+        }
+        job.pieces[job.npieces].begin = pos;
+        job.pieces[job.npieces].end = end;
+        ++job.npieces;
+        pos = end;
+    }
+    job.nworkers = (size_t) threads < job.npieces ? threads : (int) job.npieces;
+    job.workers = json_wrapper_alloc(sizeof(GET_STRUCT_NAME(Worker)) * job.nworkers);
+    if (NULL == job.workers)
+    {
+        json_wrapper_free(job.pieces);
+        return -1;
+    }
+    memset(job.workers, 0, sizeof(GET_STRUCT_NAME(Worker)) * job.nworkers);
+    int i = 0;
+    for (i = 0; i < job.nworkers; ++i)
+    {
+        job.workers[i].id = i;
+        job.workers[i].job = &job;
+#if PARALLEL_THREADS
+        pthread_mutex_init(&job.workers[i].lock, NULL);
+#endif
+    }
+
+    job.counting = true;
+    parallel_run(&job);
+    size_t total = 0;
+    size_t k = 0;
+    for (k = 0; k < job.npieces; ++k)
+    {
+        size_t lines = job.pieces[k].first;
+        job.pieces[k].first = total;
+        total += lines;
+    }
+    job.counting = false;
+    parallel_run(&job);
+
+    int rc = 0;
+    for (i = 0; i < job.nworkers; ++i)
+    {
+        if (0 != job.workers[i].rc) rc = -1;
+#if PARALLEL_THREADS
+        pthread_mutex_destroy(&job.workers[i].lock);
+#endif
+    }
+    json_wrapper_free(job.workers);
+    json_wrapper_free(job.pieces);
+    *records = total < count ? total : count;
+    return rc;
+}
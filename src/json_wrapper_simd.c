@@ -0,0 +1,547 @@
+/**
+ * @file json_wrapper_simd.c
+ * @brief The text scanners with SSE2 and AVX2 versions picked by the CPU at runtime, and the plain C fallback
+ *
+ */
+
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+#include <json_wrapper/json_wrapper.h>
+
+#if defined(__x86_64__) || defined(_M_X64) || (defined(__i386__) && defined(__SSE2__))
+#include <emmintrin.h>
+#define HAS_SSE2 1
+#else
+#define HAS_SSE2 0
+#endif
+
+#if HAS_SSE2 && (defined(__GNUC__) || defined(__clang__))
+#include <immintrin.h>
+#define HAS_AVX2 1
+#define TARGET_AVX2 __attribute__((target("avx2")))
+#else
+#define HAS_AVX2 0
+#endif
+
+#if defined(_MSC_VER) && !defined(__clang__)
+#include <intrin.h>
+#endif
+
+
+/**
+ * @brief Get the index of the lowest set bit of @p mask, which is not 0
+ */
+static inline int first_bit(uint32_t mask)
+{
+#if defined(_MSC_VER) && !defined(__clang__)
+    unsigned long index = 0;
+    _BitScanForward(&index, mask);
+    return (int) index;
+#else
+    return __builtin_ctz(mask);
+#endif
+}
+
+/**
+ * @brief Count the set bits of @p mask
+ */
+static inline size_t popcount64(uint64_t mask)
+{
+#if defined(_MSC_VER) && !defined(__clang__)
+    mask -= (mask >> 1) & 0x5555555555555555ULL;
+    mask = (mask & 0x3333333333333333ULL) + ((mask >> 2) & 0x3333333333333333ULL);
+    return (size_t) ((((mask + (mask >> 4)) & 0x0F0F0F0F0F0F0F0FULL) * 0x0101010101010101ULL) >> 56);
+#else
+    return (size_t) __builtin_popcountll(mask);
+#endif
+}
+
+/**
+ * @brief Get the index of the lowest set bit of the 64 bits @p mask, which is not 0
+ */
+static inline int first_bit64(uint64_t mask)
+{
+#if defined(_MSC_VER) && !defined(__clang__) && defined(_M_X64)
+    unsigned long index = 0;
+    _BitScanForward64(&index, mask);
+    return (int) index;
+#elif defined(_MSC_VER) && !defined(__clang__)
+    return (uint32_t) mask ? first_bit((uint32_t) mask) : 32 + first_bit((uint32_t) (mask >> 32));
+#else
+    return __builtin_ctzll(mask);
+#endif
+}
+
+
+/**
+ * @brief Repeat a byte in all the 8 bytes of a word
+ */
+#define SWAR_REPEAT(c) (0x0101010101010101ULL * (uint8_t) (c))
+
+/**
+ * @brief Whether a byte of the word @p x is less than @p n, which is at most 128
+ */
+#define SWAR_HAS_LESS(x, n) (((x) - SWAR_REPEAT(n)) & ~(x) & SWAR_REPEAT(0x80))
+
+/**
+ * @brief Whether a byte needs to be escaped in a json string
+ */
+#define NEED_ESCAPE(c) ((unsigned char) (c) < 0x20 || '"' == (c) || '\\' == (c))
+
+/**
+ * @brief Find the first byte which needs to be escaped, testing 8 bytes at a time in a word
+ */
+static const char * scan_escape_scalar(const char * p, const char * end)
+{
+    for (; end - p >= 8; p += 8)
+    {
+        uint64_t x = 0;
+        memcpy(&x, p, sizeof(x));
+        if (0 == (SWAR_HAS_LESS(x, 0x20) | SWAR_HAS_LESS(x ^ SWAR_REPEAT('"'), 1)
+            | SWAR_HAS_LESS(x ^ SWAR_REPEAT('\\'), 1))) continue;
+        break;
+    }
+    for (; p < end && !NEED_ESCAPE(*p); ++p);
+    return p;
+}
+
+#if HAS_SSE2
+/**
+ * @brief Find the first byte which needs to be escaped, testing 16 bytes at a time,
+ *        a control byte is one which is not above 0x1F as unsigned
+ */
+static const char * scan_escape_sse2(const char * p, const char * end)
+{
+    const __m128i quote = _mm_set1_epi8('"');
+    const __m128i slash = _mm_set1_epi8('\\');
+    const __m128i control = _mm_set1_epi8(0x1F);
+    for (; end - p >= 16; p += 16)
+    {
+        __m128i x = _mm_loadu_si128((const __m128i *) p);
+        __m128i hit = _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(x, quote), _mm_cmpeq_epi8(x, slash)),
+            _mm_cmpeq_epi8(_mm_min_epu8(x, control), x));
+        uint32_t mask = (uint32_t) _mm_movemask_epi8(hit);
+        if (mask) return p + first_bit(mask);
+    }
+    return scan_escape_scalar(p, end);
+}
+#endif
+
+#if HAS_AVX2
+/**
+ * @brief Find the first byte which needs to be escaped, testing 32 bytes at a time
+ */
+static TARGET_AVX2 const char * scan_escape_avx2(const char * p, const char * end)
+{
+    const __m256i quote = _mm256_set1_epi8('"');
+    const __m256i slash = _mm256_set1_epi8('\\');
+    const __m256i control = _mm256_set1_epi8(0x1F);
+    for (; end - p >= 32; p += 32)
+    {
+        __m256i x = _mm256_loadu_si256((const __m256i *) p);
+        __m256i hit = _mm256_or_si256(_mm256_or_si256(_mm256_cmpeq_epi8(x, quote), _mm256_cmpeq_epi8(x, slash)),
+            _mm256_cmpeq_epi8(_mm256_min_epu8(x, control), x));
+        uint32_t mask = (uint32_t) _mm256_movemask_epi8(hit);
+        if (mask) return p + first_bit(mask);
+    }
+    return scan_escape_sse2(p, end);
+}
+#endif
+
+
+/**
+ * @brief The bits of a 64 bytes block of text which are quotes, backslashes, braces and brackets,
+ *        and all the structural characters '{', '}', '[', ']', ':' and ','
+ */
+typedef struct GET_STRUCT_NAME(Block)
+{
+    uint64_t quote;
+    uint64_t backslash;
+    uint64_t bracket;
+    uint64_t op;
+} GET_STRUCT_NAME(Block);
+
+/**
+ * @brief The classes of the bytes for @link classify_scalar, 1 for a quote, 2 for a backslash,
+ *        4 for an op and 8 for a brace or bracket
+ */
+static const uint8_t g_classes[256] = {
+    ['"'] = 1, ['\\'] = 2, ['{'] = 12, ['}'] = 12, ['['] = 12, [']'] = 12, [':'] = 4, [','] = 4,
+};
+
+/**
+ * @brief Classify the 64 bytes of a block one at a time
+ */
+static void classify_scalar(const char * p, GET_STRUCT_NAME(Block) * block)
+{
+    uint64_t quote = 0;
+    uint64_t backslash = 0;
+    uint64_t bracket = 0;
+    uint64_t op = 0;
+    int i = 0;
+    for (i = 0; i < 64; ++i)
+    {
+        uint8_t c = g_classes[(unsigned char) p[i]];
+        quote |= (uint64_t) (c & 1) << i;
+        backslash |= (uint64_t) ((c >> 1) & 1) << i;
+        op |= (uint64_t) ((c >> 2) & 1) << i;
+        bracket |= (uint64_t) ((c >> 3) & 1) << i;
+    }
+    block->quote = quote;
+    block->backslash = backslash;
+    block->bracket = bracket;
+    block->op = op;
+}
+
+#if HAS_SSE2
+/**
+ * @brief Classify a block 16 bytes at a time
+ */
+static void classify_sse2(const char * p, GET_STRUCT_NAME(Block) * block)
+{
+    const __m128i quote = _mm_set1_epi8('"');
+    const __m128i slash = _mm_set1_epi8('\\');
+    const __m128i colon = _mm_set1_epi8(':');
+    const __m128i comma = _mm_set1_epi8(',');
+    const __m128i brace = _mm_set1_epi8('{');
+    const __m128i bracket = _mm_set1_epi8('[');
+    const __m128i two = _mm_set1_epi8(2);
+    int i = 0;
+    block->quote = 0;
+    block->backslash = 0;
+    block->bracket = 0;
+    block->op = 0;
+    for (i = 0; i < 4; ++i)
+    {
+        __m128i x = _mm_loadu_si128((const __m128i *) (p + 16 * i));
+        // '{' + 2 is '}', '[' + 2 is ']', so the closing ones are found by comparing x - 2 with the opening ones
+        __m128i y = _mm_sub_epi8(x, two);
+        __m128i brackets = _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(x, brace), _mm_cmpeq_epi8(x, bracket)),
+            _mm_or_si128(_mm_cmpeq_epi8(y, brace), _mm_cmpeq_epi8(y, bracket)));
+        __m128i op = _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(x, colon), _mm_cmpeq_epi8(x, comma)), brackets);
+        block->quote |= (uint64_t) (uint32_t) _mm_movemask_epi8(_mm_cmpeq_epi8(x, quote)) << (16 * i);
+        block->backslash |= (uint64_t) (uint32_t) _mm_movemask_epi8(_mm_cmpeq_epi8(x, slash)) << (16 * i);
+        block->bracket |= (uint64_t) (uint32_t) _mm_movemask_epi8(brackets) << (16 * i);
+        block->op |= (uint64_t) (uint32_t) _mm_movemask_epi8(op) << (16 * i);
+    }
+}
+#endif
+
+#if HAS_AVX2
+/**
+ * @brief Classify a block 32 bytes at a time
+ */
+static TARGET_AVX2 void classify_avx2(const char * p, GET_STRUCT_NAME(Block) * block)
+{
+    const __m256i quote = _mm256_set1_epi8('"');
+    const __m256i slash = _mm256_set1_epi8('\\');
+    const __m256i colon = _mm256_set1_epi8(':');
+    const __m256i comma = _mm256_set1_epi8(',');
+    const __m256i brace = _mm256_set1_epi8('{');
+    const __m256i bracket = _mm256_set1_epi8('[');
+    const __m256i two = _mm256_set1_epi8(2);
+    int i = 0;
+    block->quote = 0;
+    block->backslash = 0;
+    block->bracket = 0;
+    block->op = 0;
+    for (i = 0; i < 2; ++i)
+    {
+        __m256i x = _mm256_loadu_si256((const __m256i *) (p + 32 * i));
+        __m256i y = _mm256_sub_epi8(x, two);
+        __m256i brackets = _mm256_or_si256(_mm256_or_si256(_mm256_cmpeq_epi8(x, brace), _mm256_cmpeq_epi8(x, bracket)),
+            _mm256_or_si256(_mm256_cmpeq_epi8(y, brace), _mm256_cmpeq_epi8(y, bracket)));
+        __m256i op = _mm256_or_si256(_mm256_or_si256(_mm256_cmpeq_epi8(x, colon), _mm256_cmpeq_epi8(x, comma)), brackets);
+        block->quote |= (uint64_t) (uint32_t) _mm256_movemask_epi8(_mm256_cmpeq_epi8(x, quote)) << (32 * i);
+        block->backslash |= (uint64_t) (uint32_t) _mm256_movemask_epi8(_mm256_cmpeq_epi8(x, slash)) << (32 * i);
+        block->bracket |= (uint64_t) (uint32_t) _mm256_movemask_epi8(brackets) << (32 * i);
+        block->op |= (uint64_t) (uint32_t) _mm256_movemask_epi8(op) << (32 * i);
+    }
+}
+#endif
+
+
+/**
+ * @brief The scanners of an instruction set
+ */
+typedef struct GET_STRUCT_NAME(Scanners)
+{
+    GET_STRUCT_NAME(Simd) level;
+    const char * (* scan_escape)(const char * p, const char * end);
+    void (* classify)(const char * p, GET_STRUCT_NAME(Block) * block);
+} GET_STRUCT_NAME(Scanners);
+
+static const GET_STRUCT_NAME(Scanners) g_scanners[] = {
+    { SIMD_SCALAR, scan_escape_scalar, classify_scalar },
+#if HAS_SSE2
+    { SIMD_SSE2, scan_escape_sse2, classify_sse2 },
+#endif
+#if HAS_AVX2
+    { SIMD_AVX2, scan_escape_avx2, classify_avx2 },
+#endif
+};
+
+/**
+ * @brief Load and store the scanners in use across threads
+ */
+#if defined(_MSC_VER) && !defined(__clang__)
+#define SCANNERS_GET(ptr) (*(const GET_STRUCT_NAME(Scanners) * volatile *) (ptr))
+#define SCANNERS_SET(ptr, use) _InterlockedExchangePointer((void * volatile *) (ptr), (void *) (use))
+#else
+#define SCANNERS_GET(ptr) __atomic_load_n(ptr, __ATOMIC_ACQUIRE)
+#define SCANNERS_SET(ptr, use) __atomic_store_n(ptr, use, __ATOMIC_RELEASE)
+#endif
+
+/**
+ * @brief The scanners in use, @p NULL until they're picked by the first call
+ *
+ * @note The threads racing on the first call pick and store the same scanners
+ */
+static const GET_STRUCT_NAME(Scanners) * g_use = NULL;
+
+/**
+ * @brief Get the best instruction set the CPU supports
+ */
+static GET_STRUCT_NAME(Simd) simd_detect(void)
+{
+#if HAS_AVX2
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2")) return SIMD_AVX2;
+#endif
+#if HAS_SSE2
+    return SIMD_SSE2;
+#else
+    return SIMD_SCALAR;
+#endif
+}
+
+/**
+ * @brief Get the scanners of the best instruction set up to @p level
+ */
+static const GET_STRUCT_NAME(Scanners) * simd_pick(GET_STRUCT_NAME(Simd) level)
+{
+    GET_STRUCT_NAME(Simd) best = simd_detect();
+    size_t i = sizeof(g_scanners) / sizeof(g_scanners[0]);
+    while (--i > 0 && (g_scanners[i].level > level || g_scanners[i].level > best));
+    return &g_scanners[i];
+}
+
+/**
+ * @brief Get the scanners in use, which are picked on the first call
+ */
+static inline const GET_STRUCT_NAME(Scanners) * simd_use(void)
+{
+    const GET_STRUCT_NAME(Scanners) * use = SCANNERS_GET(&g_use);
+    if (NULL == use)
+    {
+        use = simd_pick(SIMD_AVX2);
+        SCANNERS_SET(&g_use, use);
+    }
+    return use;
+}
+
+/**
+ * @brief Get the instruction set in use by the text scanners
+ * 
+ * @return GET_STRUCT_NAME(Simd) The instruction set
+ */
+GET_STRUCT_NAME(Simd) json_wrapper_simd_level(void)
+{
+    return simd_use()->level;
+}
+
+/**
+ * @brief Limit the text scanners to the instruction set @p level, mostly for benchmarks and tests
+ * 
+ * @note The level is lowered to the best one the CPU supports, the scans already running on other threads
+ *       finish with the scanners they started with
+ * 
+ * @param level The instruction set
+ * @return GET_STRUCT_NAME(Simd) The instruction set in use
+ */
+GET_STRUCT_NAME(Simd) json_wrapper_simd_limit(GET_STRUCT_NAME(Simd) level)
+{
+    const GET_STRUCT_NAME(Scanners) * use = simd_pick(level);
+    SCANNERS_SET(&g_use, use);
+    return use->level;
+}
+
+/**
+ * @brief Find the first byte in [@p p, @p end) which needs to be escaped in a json string,
+ *        that is '"', '\\' or a control character
+ * 
+ * @param p The begin of the bytes
+ * @param end The end of the bytes
+ * @return const char* The byte found, @p end for none
+ */
+const char * json_wrapper_scan_escape(const char * p, const char * end)
+{
+    return simd_use()->scan_escape(p, end);
+}
+
+
+/**
+ * @brief Get the bits of a block which are escaped by a backslash
+ * 
+ * @param backslash The backslashes of the block
+ * @param carry Whether the first byte is escaped by the last backslash of the previous block,
+ *              updated for the next block
+ */
+static uint64_t index_escaped(uint64_t backslash, uint64_t * carry)
+{
+    uint64_t escaped = *carry;
+    backslash &= ~escaped;
+    *carry = 0;
+    while (backslash)
+    {
+        int i = first_bit64(backslash);
+        if (63 == i)
+        {
+            *carry = 1;
+            break;
+        }
+        escaped |= 2ULL << i;
+        backslash &= ~(3ULL << i);
+    }
+    return escaped;
+}
+
+/**
+ * @brief Get the bits from each opening quote up to the byte before its closing quote
+ */
+static inline uint64_t index_prefix_xor(uint64_t x)
+{
+    x ^= x << 1;
+    x ^= x << 2;
+    x ^= x << 4;
+    x ^= x << 8;
+    x ^= x << 16;
+    x ^= x << 32;
+    return x;
+}
+
+/**
+ * @brief Make room for @p more entries in an index
+ */
+static int index_reserve(GET_STRUCT_NAME(Index) * index, size_t more)
+{
+    ASSERT_RETURN(index->count + more > index->cap, 0);
+    size_t cap = index->cap ? index->cap : 256;
+    while (cap < index->count + more) cap <<= 1;
+    uint32_t * positions = json_wrapper_alloc(cap * sizeof(uint32_t));
+    uint32_t * jumps = json_wrapper_alloc(cap * sizeof(uint32_t));
+    if (NULL == positions || NULL == jumps)
+    {
+        json_wrapper_free(positions);
+        json_wrapper_free(jumps);
+        return -1;
+    }
+    if (index->count)
+    {
+        memcpy(positions, index->positions, index->count * sizeof(uint32_t));
+        memcpy(jumps, index->jumps, index->count * sizeof(uint32_t));
+    }
+    json_wrapper_free(index->positions);
+    json_wrapper_free(index->jumps);
+    index->positions = positions;
+    index->jumps = jumps;
+    index->cap = cap;
+    return 0;
+}
+
+/**
+ * @brief Match the braces and brackets of a block, the open ones are chained by their @p jumps
+ *        until they're closed
+ * 
+ * @param index The index, whose entries of the block are from @p base on
+ * @param data The json text
+ * @param bits The structural bits of the block
+ * @param brackets The bits of the braces and brackets out of strings
+ * @param top The entry of the innermost open one plus 1, @p 0 for none
+ */
+static int index_match(GET_STRUCT_NAME(Index) * index, size_t base, const char * data, uint64_t bits,
+    uint64_t brackets, size_t * top)
+{
+    for (; brackets; brackets &= brackets - 1)
+    {
+        size_t k = base + popcount64(bits & ((1ULL << first_bit64(brackets)) - 1));
+        char c = data[index->positions[k]];
+        if ('{' == c || '[' == c)
+        {
+            index->jumps[k] = (uint32_t) *top;
+            *top = k + 1;
+        } else
+        {
+            ASSERT_RETURN(*top > 0, -1);
+            size_t open = *top - 1;
+            ASSERT_RETURN(c == data[index->positions[open]] + 2, -1);
+            *top = index->jumps[open];
+            index->jumps[open] = (uint32_t) k;
+        }
+    }
+    return 0;
+}
+
+/**
+ * @brief Build the structural index of @p len bytes of @p data, the memory of the index is reused
+ * 
+ * @note The text is classified by 64 bytes blocks with the instruction set of @link json_wrapper_simd_level,
+ *       it's a failure if the text is longer than 4GB, a string is not closed or the braces and brackets
+ *       are not matched. Nothing else is validated, that's left to the reader
+ * 
+ * @param index The index, zeroed before the first build
+ * @param data The json text
+ * @param len The length of json text
+ * @return int @p 0 for success, @p -1 for failure
+ */
+int json_wrapper_index_build(GET_STRUCT_NAME(Index) * index, const char * data, size_t len)
+{
+    ASSERT_RETURN(index && (data || 0 == len) && len < UINT32_MAX, -1);
+    const GET_STRUCT_NAME(Scanners) * use = simd_use();
+    uint64_t escaped = 0;
+    uint64_t in_string = 0;
+    size_t top = 0;
+    size_t offset = 0;
+    char tail[64];
+    index->count = 0;
+    for (offset = 0; offset < len; offset += 64)
+    {
+        const char * p = data + offset;
+        if (len - offset < 64)
+        {
+            memset(tail, ' ', sizeof(tail));
+            memcpy(tail, p, len - offset);
+            p = tail;
+        }
+        GET_STRUCT_NAME(Block) block;
+        use->classify(p, &block);
+        uint64_t quote = block.quote & ~index_escaped(block.backslash, &escaped);
+        uint64_t string = index_prefix_xor(quote) ^ in_string;
+        in_string = 0 - (string >> 63);
+        uint64_t bits = (block.op & ~string) | quote;
+        ASSERT_RETURN(0 == index_reserve(index, 64), -1);
+        size_t base = index->count;
+        uint32_t * out = index->positions + base;
+        uint64_t left = bits;
+        for (; left; left &= left - 1) *out++ = (uint32_t) (offset + first_bit64(left));
+        index->count = out - index->positions;
+        ASSERT_RETURN(0 == index_match(index, base, data, bits, block.bracket & ~string, &top), -1);
+    }
+    ASSERT_RETURN(0 == in_string && 0 == top, -1);
+    return 0;
+}
+
+/**
+ * @brief Free the memory of an index, the index is reset to empty
+ * 
+ * @param index The index
+ */
+void json_wrapper_index_release(GET_STRUCT_NAME(Index) * index)
+{
+    ASSERT_RETURN_VOID(index);
+    json_wrapper_free(index->positions);
+    json_wrapper_free(index->jumps);
+    memset(index, 0, sizeof(*index));
+}
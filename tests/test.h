@@ -0,0 +1,55 @@
+/**
+ * @file test.h
+ * @brief The checks and the runner shared by the tests
+ *
+ * @note Every test is a target of the CMake build registered with ctest, or build one with the wrapper source
+ *       and cJSON, for example:
+ *           cc -Iinclude tests/test_json.c src/json_wrapper*.c -lcjson -lm -lpthread -o test_json
+ */
+
+
+#include <stdio.h>
+#include <stdint.h>
+#include <json_wrapper/json_wrapper.h>
+
+
+static int g_failures = 0;
+
+/**
+ * @brief Report the failure of @p exp without stopping the test
+ */
+#define EXPECT(exp) do { \
+    if (!(exp)) \
+    { \
+        ++g_failures; \
+        fprintf(stderr, "%s:%d: EXPECT(%s) failed\n", __FILE__, __LINE__, #exp); \
+    } \
+} while (0)
+
+/**
+ * @brief Check two '\0' terminated strings are equal, @p NULL only equals @p NULL
+ */
+#define EXPECT_STR(a, b) do { \
+    const char * a_ = (a); \
+    const char * b_ = (b); \
+    if (!(a_ == b_ || (NULL != a_ && NULL != b_ && 0 == strcmp(a_, b_)))) \
+    { \
+        ++g_failures; \
+        fprintf(stderr, "%s:%d: EXPECT_STR(%s, %s) failed: \"%s\" != \"%s\"\n", __FILE__, __LINE__, #a, #b, \
+            a_ ? a_ : "(null)", b_ ? b_ : "(null)"); \
+    } \
+} while (0)
+
+/**
+ * @brief Run a test function and print its result
+ */
+#define RUN(test) do { \
+    int failures_ = g_failures; \
+    test(); \
+    printf("%-40s %s\n", #test, failures_ == g_failures ? "ok" : "FAILED"); \
+} while (0)
+
+/**
+ * @brief The exit code of the test program
+ */
+#define TEST_RESULT() (0 == g_failures ? 0 : 1)
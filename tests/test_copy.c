@@ -0,0 +1,121 @@
+/**
+ * @file test_copy.c
+ * @brief Check COPY_ST, MOVE_ST and RECYCLE_ST of unrolled and compact structs,
+ *        the compact codec against the unrolled one and the truncation of FIXED_STRING fields
+ */
+
+
+#include "test.h"
+
+
+DEFINE_STRUCT(Leaf,
+    (OBJ(STRING), name)
+    (OBJ(INT), id)
+)
+
+DEFINE_STRUCT(Tree,
+    (OBJ(STRING), name)
+    (OBJ(Leaf), leaf)
+    (ARRAY(Leaf, 2), pair)
+    (VA_ARRAY(Leaf), leaves)
+    (FIXED_STRING(5), code)
+)
+
+DEFINE_STRUCT_COMPACT(CompactLeaf,
+    (OBJ(STRING), name)
+    (OBJ(INT), id)
+)
+
+DEFINE_STRUCT_COMPACT(CompactTree,
+    (OBJ(STRING), name)
+    (OBJ(CompactLeaf), leaf)
+    (ARRAY(CompactLeaf, 2), pair)
+    (VA_ARRAY(CompactLeaf), leaves)
+    (FIXED_STRING(5), code)
+)
+
+
+static const char * const g_tree = "{\"name\":\"root\",\"leaf\":{\"name\":\"l\",\"id\":1},"
+    "\"pair\":[{\"name\":\"p0\",\"id\":2},{\"name\":null,\"id\":3}],"
+    "\"leaves\":[{\"name\":\"v0\",\"id\":4},{\"name\":\"v1\",\"id\":5}],\"code\":\"abcd\"}";
+
+
+static void test_copy_move(void)
+{
+    DECLARE_STRUCT(Tree, tree);
+    EXPECT(0 == J2S((char *) g_tree, Tree, &tree));
+    DECLARE_STRUCT(Tree, copy);
+    EXPECT(0 == J2S("{\"name\":\"old\",\"leaves\":[{\"name\":\"gone\"}]}", Tree, &copy));
+    COPY_ST(Tree, &tree, &copy);
+    EXPECT(EQUAL_ST(Tree, &tree, &copy));
+    EXPECT(copy.name != tree.name && copy.leaves.leaves != tree.leaves.leaves);
+    char * json = S2J(Tree, &copy);
+    EXPECT_STR(json, g_tree);
+    json_wrapper_free(json);
+
+    DECLARE_STRUCT(Tree, moved);
+    MOVE_ST(Tree, &copy, &moved);
+    EXPECT(EQUAL_ST(Tree, &tree, &moved));
+    EXPECT(NULL == copy.name && NULL == copy.leaves.leaves && 0 == copy.leaves.size);
+    RECYCLE_ST(Tree, &moved);
+    EXPECT(NULL == moved.name && 0 == moved.leaves.size);
+
+    GET_STRUCT_NAME(Arena) arena;
+    json_wrapper_arena_init(&arena, 0);
+    DECLARE_STRUCT(Tree, in_arena);
+    COPY_ST_ARENA(Tree, &tree, &in_arena, &arena);
+    EXPECT(EQUAL_ST(Tree, &tree, &in_arena));
+    json_wrapper_arena_release(&arena);
+
+    COPY_ST(Tree, &tree, &tree);
+    char * self = S2J(Tree, &tree);
+    EXPECT_STR(self, g_tree);
+    json_wrapper_free(self);
+    RECYCLE_ST(Tree, &tree);
+}
+
+static void test_compact(void)
+{
+    DECLARE_STRUCT(CompactTree, tree);
+    EXPECT(0 == J2S((char *) g_tree, CompactTree, &tree));
+    char * json = S2J(CompactTree, &tree);
+    EXPECT_STR(json, g_tree);
+    json_wrapper_free(json);
+    DECLARE_STRUCT(CompactTree, copy);
+    COPY_ST(CompactTree, &tree, &copy);
+    EXPECT(EQUAL_ST(CompactTree, &tree, &copy));
+    COPY_ST(CompactTree, &copy, &copy);
+    EXPECT(EQUAL_ST(CompactTree, &tree, &copy));
+    size_t len = 0;
+    char * data = S2M(CompactTree, &copy, &len);
+    RECYCLE_ST(CompactTree, &copy);
+    EXPECT(0 == M2S(data, len, CompactTree, &copy));
+    EXPECT(EQUAL_ST(CompactTree, &tree, &copy));
+    json_wrapper_free(data);
+    RECYCLE_ST(CompactTree, &copy);
+    RECYCLE_ST(CompactTree, &tree);
+}
+
+static void test_fixed_string(void)
+{
+    DECLARE_STRUCT(Tree, tree);
+    EXPECT(0 == J2S("{\"code\":\"toolong\"}", Tree, &tree));
+    EXPECT_STR(tree.code, "tool");
+    EXPECT(0 == J2S("{\"code\":\"ab\\u20ac\"}", Tree, &tree));
+    EXPECT_STR(tree.code, "ab");
+    EXPECT(0 == J2S("{\"code\":null}", Tree, &tree));
+    EXPECT_STR(tree.code, "ab");
+    memcpy(tree.code, "12345", 5);
+    char * json = S2J(Tree, &tree);
+    EXPECT(NULL != strstr(json, "\"code\":\"12345\""));
+    json_wrapper_free(json);
+    RECYCLE_ST(Tree, &tree);
+}
+
+int main(int argc, char * argv[])
+{
+    RUN(test_copy_move);
+    RUN(test_compact);
+    RUN(test_fixed_string);
+    return TEST_RESULT();
+}
@@ -0,0 +1,161 @@
+/**
+ * @file test_hooks.c
+ * @brief Check the global and thread memory hooks, and the cJSON tree path with cJSON routed through the hooks,
+ *        with the pooled items freed on other threads and outliving the thread they were alloced on
+ */
+
+
+#include "test.h"
+#if !defined(_WIN32)
+#include <pthread.h>
+#endif
+
+
+DEFINE_STRUCT(Node,
+    (OBJ(STRING), name)
+    (OBJ(INT), value)
+    (VA_ARRAY(INT), values)
+)
+
+
+static int g_allocs = 0;
+static int g_frees = 0;
+
+static void * counting_alloc(size_t size)
+{
+    ++g_allocs;
+    return malloc(size);
+}
+
+static void counting_free(void * ptr)
+{
+    if (NULL != ptr) ++g_frees;
+    free(ptr);
+}
+
+static void test_thread_hook(void)
+{
+    g_allocs = 0;
+    g_frees = 0;
+    EXPECT(0 == json_wrapper_hook_thread(counting_alloc, counting_free));
+    DECLARE_STRUCT(Node, node);
+    EXPECT(0 == J2S("{\"name\":\"n\",\"value\":1,\"values\":[1,2,3]}", Node, &node));
+    char * json = S2J(Node, &node);
+    EXPECT_STR(json, "{\"name\":\"n\",\"value\":1,\"values\":[1,2,3]}");
+    json_wrapper_free(json);
+    RECYCLE_ST(Node, &node);
+    EXPECT(g_allocs > 0 && g_allocs == g_frees);
+    EXPECT(0 == json_wrapper_hook_thread(NULL, NULL));
+    int allocs = g_allocs;
+    json_wrapper_free(json_wrapper_alloc(16));
+    EXPECT(allocs == g_allocs);
+}
+
+/**
+ * @brief Round trip @p node through a cJSON tree
+ */
+static void round_trip_tree(void)
+{
+    GET_STRUCT_NAME(Node) node = { "tree", 7, { NULL, 0 } };
+    int values[2] = { 4, 5 };
+    node.values.values = values;
+    node.values.size = 2;
+    cJSON * tree = STRUCT_2_FUNCTION_NAME(Node)(&node);
+    EXPECT(NULL != tree);
+    char * text = cJSON_PrintUnformatted(tree);
+    EXPECT_STR(text, "{\"name\":\"tree\",\"value\":7,\"values\":[4,5]}");
+    cJSON_free(text);
+    DECLARE_STRUCT(Node, decoded);
+    EXPECT(0 == JSON_2_FUNCTION_NAME(Node)(tree, &decoded));
+    cJSON_Delete(tree);
+    EXPECT(EQUAL_ST(Node, &node, &decoded));
+    RECYCLE_ST(Node, &decoded);
+}
+
+static void test_cjson_hooks(void)
+{
+    g_allocs = 0;
+    g_frees = 0;
+    json_wrapper_hook_alloc(counting_alloc);
+    json_wrapper_hook_free(counting_free);
+    json_wrapper_hook_cjson(false);
+    round_trip_tree();
+    EXPECT(g_allocs > 0 && g_allocs == g_frees);
+    json_wrapper_hook_cjson(true);
+    int i = 0;
+    for (i = 0; i < 100; ++i) round_trip_tree();
+    json_wrapper_cjson_pool_release();
+    EXPECT(g_allocs == g_frees);
+    json_wrapper_hook_alloc(malloc);
+    json_wrapper_hook_free(free);
+}
+
+#if !defined(_WIN32)
+#define TREES 8
+
+/**
+ * @brief Alloc the trees on a thread which exits before they are freed
+ */
+static void * alloc_trees(void * arg)
+{
+    cJSON ** trees = arg;
+    GET_STRUCT_NAME(Node) node = { "far", 1, { NULL, 0 } };
+    int i = 0;
+    for (i = 0; i < TREES; ++i) trees[i] = STRUCT_2_FUNCTION_NAME(Node)(&node);
+    return NULL;
+}
+
+/**
+ * @brief Free the trees alloced on another thread
+ */
+static void * free_trees(void * arg)
+{
+    cJSON ** trees = arg;
+    int i = 0;
+    for (i = 0; i < TREES; ++i) cJSON_Delete(trees[i]);
+    return NULL;
+}
+
+static void test_cjson_pool_threads(void)
+{
+    g_allocs = 0;
+    g_frees = 0;
+    json_wrapper_hook_alloc(counting_alloc);
+    json_wrapper_hook_free(counting_free);
+    json_wrapper_hook_cjson(true);
+    cJSON * trees[TREES];
+    pthread_t thread;
+    EXPECT(0 == pthread_create(&thread, NULL, alloc_trees, trees));
+    pthread_join(thread, NULL);
+    EXPECT(NULL != trees[0] && NULL != trees[TREES - 1]);
+    EXPECT(g_allocs > g_frees);
+    free_trees(trees);
+    EXPECT(g_allocs == g_frees);
+
+    int round = 0;
+    int held = 0;
+    for (round = 0; round < 100; ++round)
+    {
+        alloc_trees(trees);
+        EXPECT(0 == pthread_create(&thread, NULL, free_trees, trees));
+        pthread_join(thread, NULL);
+        if (0 == round) held = g_allocs - g_frees;
+    }
+    EXPECT(held > 0 && held == g_allocs - g_frees);
+    json_wrapper_cjson_pool_release();
+    EXPECT(g_allocs == g_frees);
+    json_wrapper_hook_cjson(false);
+    json_wrapper_hook_alloc(malloc);
+    json_wrapper_hook_free(free);
+}
+#endif
+
+int main(int argc, char * argv[])
+{
+    RUN(test_thread_hook);
+    RUN(test_cjson_hooks);
+#if !defined(_WIN32)
+    RUN(test_cjson_pool_threads);
+#endif
+    return TEST_RESULT();
+}
@@ -0,0 +1,337 @@
+/**
+ * @file test_json.c
+ * @brief Round trip every field type through S2J and J2S, and the sized, view, mask, index, arena and batch variants
+ */
+
+
+#include <math.h>
+#include <float.h>
+#include "test.h"
+
+
+DEFINE_STRUCT(Item,
+    (OBJ(STRING), name)
+    (OBJ(INT), qty)
+)
+
+DEFINE_STRUCT(Record,
+    (OBJ(BOOL), flag)
+    (OBJ(CHAR), c)
+    (OBJ(INT), i)
+    (OBJ(INT64), i64)
+    (OBJ(UINT32), u32)
+    (OBJ(UINT64), u64)
+    (OBJ(FLOAT), f)
+    (OBJ(DOUBLE), d)
+    (OBJ(STRING), s)
+    (FIXED_STRING(8), fixed)
+    (OBJ(Item), item)
+    (ARRAY(Item, 2), pair)
+    (ARRAY(INT, 3), ints)
+    (VA_ARRAY(Item), items)
+)
+
+DEFINE_STRUCT(Point,
+    (OBJ(INT), x)
+    (OBJ(INT), y)
+    (OBJ(DOUBLE), z)
+)
+
+DEFINE_STRUCT(Empty,
+    (ARRAY(INT, 0), none)
+    (OBJ(BOOL), ok)
+)
+
+DEFINE_STRUCT(Viewed,
+    (OBJ(STRING_VIEW), name)
+    (OBJ(STRING), copy)
+)
+
+
+static void fill_record(GET_STRUCT_NAME(Record) * r)
+{
+    static GET_STRUCT_NAME(Item) items[3] = { { "a", 1 }, { "b \"quoted\"", 2 }, { NULL, 3 } };
+    memset(r, 0, sizeof(GET_STRUCT_NAME(Record)));
+    r->flag = true;
+    r->c = 'x';
+    r->i = -123456;
+    r->i64 = INT64_MIN;
+    r->u32 = UINT32_MAX;
+    r->u64 = UINT64_MAX;
+    r->f = 3.14f;
+    r->d = 0.1;
+    r->s = "line\nbreak \\ tab\t \xE2\x82\xAC \x01";
+    strcpy(r->fixed, "fixed");
+    r->item.name = "item";
+    r->item.qty = 7;
+    r->pair[0].name = "first";
+    r->pair[1].qty = -1;
+    r->ints[0] = 1;
+    r->ints[2] = INT32_MAX;
+    r->items.items = items;
+    r->items.size = 3;
+}
+
+static void test_round_trip(void)
+{
+    GET_STRUCT_NAME(Record) record;
+    fill_record(&record);
+    char * json = S2J(Record, &record);
+    EXPECT(NULL != json);
+    DECLARE_STRUCT(Record, decoded);
+    EXPECT(0 == J2S(json, Record, &decoded));
+    EXPECT(EQUAL_ST(Record, &record, &decoded));
+    EXPECT_STR(decoded.s, record.s);
+    EXPECT(INT64_MIN == decoded.i64 && UINT64_MAX == decoded.u64 && UINT32_MAX == decoded.u32);
+    EXPECT(3 == decoded.items.size && NULL == decoded.items.items[2].name);
+    char * again = S2J(Record, &decoded);
+    EXPECT_STR(again, json);
+    json_wrapper_free(again);
+    json_wrapper_free(json);
+    RECYCLE_ST(Record, &decoded);
+}
+
+static void test_decode(void)
+{
+    DECLARE_STRUCT(Point, point);
+    EXPECT(0 == J2S("{\"x\":1,\"unknown\":[{\"a\":[true,false,null]},-1.5e3,\"}\"],\"y\":2}", Point, &point));
+    EXPECT(1 == point.x && 2 == point.y);
+    EXPECT(0 == J2S(" {\"y\" : 3 , \"x\" : 4 } ", Point, &point));
+    EXPECT(4 == point.x && 3 == point.y);
+    EXPECT(0 == J2S("{\"x\":\"text\",\"y\":null}", Point, &point));
+    EXPECT(4 == point.x && 3 == point.y);
+    EXPECT(0 == J2S("{\"x\":true,\"y\":1e2,\"z\":-2.5E-1}", Point, &point));
+    EXPECT(1 == point.x && 100 == point.y && -0.25 == point.z);
+    EXPECT(0 == J2S("{\"z\":7,\"xx\":1,\"X\":1,\"y\":6,\"\":1,\"x\":5}", Point, &point));
+    EXPECT(5 == point.x && 6 == point.y && 7 == point.z);
+    cJSON * tree = cJSON_Parse("{\"z\":1,\"Y\":9,\"y\":2,\"x\":3}");
+    EXPECT(0 == JSON_2_FUNCTION_NAME(Point)(tree, &point));
+    EXPECT(3 == point.x && 2 == point.y && 1 == point.z);
+    cJSON_Delete(tree);
+}
+
+static void test_invalid(void)
+{
+    DECLARE_STRUCT(Point, point);
+    EXPECT(0 == J2S("{\"x\":1,\"skipped\":{\"a\":[1,{}],\"b\":[]}}", Point, &point));
+    EXPECT(-1 == J2S("hello", Point, &point));
+    EXPECT(-1 == J2S("", Point, &point));
+    EXPECT(-1 == J2S("   ", Point, &point));
+    EXPECT(-1 == J2S("{\"x\":1", Point, &point));
+    EXPECT(-1 == J2S("{\"x\":1,\"skipped\":{\"a\":[1,2", Point, &point));
+    EXPECT(-1 == J2S("{\"x\":1,}", Point, &point));
+    EXPECT(-1 == J2S("{\"skipped\":[1,],\"x\":1}", Point, &point));
+    EXPECT(-1 == J2S("{\"skipped\":{\"a\":1,},\"x\":1}", Point, &point));
+    EXPECT(-1 == J2S("{\"skipped\":{\"a\" 1},\"x\":1}", Point, &point));
+    EXPECT(-1 == J2S("{\"skipped\":[1 2],\"x\":1}", Point, &point));
+    EXPECT(-1 == J2S("{\"skipped\":nul,\"x\":1}", Point, &point));
+    EXPECT(-1 == J2S("{\"skipped\":xxxx,\"x\":1}", Point, &point));
+    EXPECT(-1 == J2S("{\"skipped\":01,\"x\":1}", Point, &point));
+    EXPECT(-1 == J2S("{\"skipped\":1.,\"x\":1}", Point, &point));
+    EXPECT(-1 == J2S("{\"skipped\":-,\"x\":1}", Point, &point));
+    EXPECT(-1 == J2S("{\"skipped\":1e+,\"x\":1}", Point, &point));
+    EXPECT(-1 == J2S("{\"skipped\":[1}],\"x\":1}", Point, &point));
+}
+
+static void test_sized(void)
+{
+    GET_STRUCT_NAME(Record) record;
+    fill_record(&record);
+    char * json = S2J(Record, &record);
+    size_t len = strlen(json);
+    EXPECT(len == S2J_SIZE(Record, &record));
+    char exact[1024];
+    EXPECT(len < sizeof(exact));
+    EXPECT(len == S2J_INTO(Record, &record, exact, len + 1));
+    EXPECT_STR(exact, json);
+    char small[16];
+    EXPECT(len == S2J_INTO(Record, &record, small, sizeof(small)));
+    EXPECT('\0' == small[sizeof(small) - 1] && 0 == memcmp(small, json, sizeof(small) - 1));
+    json_wrapper_free(json);
+
+    EXPECT(S2J_IS_BOUNDED(Point));
+    EXPECT(!S2J_IS_BOUNDED(Record));
+    GET_STRUCT_NAME(Point) point = { INT_MIN, INT_MIN, -DBL_MAX };
+    char bounded[S2J_MAX_SIZE(Point) + 1];
+    len = S2J_INTO(Point, &point, bounded, sizeof(bounded));
+    EXPECT(len > 0 && len < sizeof(bounded));
+    point.z = -DBL_MIN / 3;
+    len = S2J_INTO(Point, &point, bounded, sizeof(bounded));
+    EXPECT(len > 0 && len < sizeof(bounded));
+
+    GET_STRUCT_NAME(Empty) empty = { .ok = false };
+    char tight[S2J_MAX_SIZE(Empty) + 1];
+    EXPECT(S2J_MAX_SIZE(Empty) == S2J_INTO(Empty, &empty, tight, sizeof(tight)));
+    EXPECT_STR(tight, "{\"none\":[],\"ok\":false}");
+}
+
+/**
+ * @brief Check @p value is written as @p text and reads back exactly
+ */
+static void check_double(double value, const char * text)
+{
+    GET_STRUCT_NAME(Buffer) buf;
+    memset(&buf, 0, sizeof(GET_STRUCT_NAME(Buffer)));
+    EXPECT(0 == json_wrapper_buffer_append_double(&buf, value));
+    EXPECT(0 == json_wrapper_buffer_append(&buf, "", 1));
+    if (NULL != text) EXPECT_STR(buf.data, text);
+    GET_STRUCT_NAME(Reader) r;
+    json_wrapper_reader_init(&r, buf.data, buf.len - 1);
+    double decoded = 0;
+    EXPECT(0 == json_wrapper_reader_double(&r, &decoded));
+    EXPECT(0 == memcmp(&decoded, &value, sizeof(double)) || (0 == value && 0 == decoded));
+    json_wrapper_buffer_release(&buf);
+}
+
+static void check_float(float value, const char * text)
+{
+    GET_STRUCT_NAME(Buffer) buf;
+    memset(&buf, 0, sizeof(GET_STRUCT_NAME(Buffer)));
+    EXPECT(0 == json_wrapper_buffer_append_float(&buf, value));
+    EXPECT(0 == json_wrapper_buffer_append(&buf, "", 1));
+    if (NULL != text) EXPECT_STR(buf.data, text);
+    EXPECT(value == strtof(buf.data, NULL));
+    json_wrapper_buffer_release(&buf);
+}
+
+static void test_numbers(void)
+{
+    check_double(0.1, "0.1");
+    check_double(1.0 / 3, "0.3333333333333333");
+    check_double(-2.5, "-2.5");
+    check_double(100, "100");
+    check_double(1e300, "1e+300");
+    check_double(5e-324, "5e-324");
+    check_double(DBL_MAX, "1.7976931348623157e+308");
+    check_double(123456789.125, "123456789.125");
+    check_float(0.1f, "0.1");
+    check_float(3.14f, "3.14");
+    check_float(FLT_MAX, "3.4028235e+38");
+    check_float(1e-45f, "1e-45");
+    uint64_t bits = 0x9E3779B97F4A7C15ULL;
+    int i = 0;
+    for (i = 0; i < 2000; ++i)
+    {
+        bits ^= bits << 13;
+        bits ^= bits >> 7;
+        bits ^= bits << 17;
+        double d = 0;
+        memcpy(&d, &bits, sizeof(double));
+        if (isfinite(d)) check_double(d, NULL);
+        float f = 0;
+        uint32_t half = (uint32_t) bits;
+        memcpy(&f, &half, sizeof(float));
+        if (isfinite(f)) check_float(f, NULL);
+    }
+
+    GET_STRUCT_NAME(Point) point = { 0, 0, NAN };
+    char * json = S2J(Point, &point);
+    EXPECT_STR(json, "{\"x\":0,\"y\":0,\"z\":null}");
+    json_wrapper_free(json);
+}
+
+static void test_view(void)
+{
+    char text[] = "{\"name\":\"esc\\\"aped\",\"copy\":\"plain\"}";
+    DECLARE_STRUCT(Viewed, viewed);
+    EXPECT(0 == J2S_VIEW(text, strlen(text), Viewed, &viewed));
+    EXPECT(8 == viewed.name.len && 0 == memcmp(viewed.name.ptr, "esc\"aped", 8));
+    EXPECT(viewed.name.ptr >= text && viewed.name.ptr < text + sizeof(text));
+    EXPECT_STR(viewed.copy, "plain");
+    char * json = S2J(Viewed, &viewed);
+    EXPECT_STR(json, "{\"name\":\"esc\\\"aped\",\"copy\":\"plain\"}");
+    json_wrapper_free(json);
+    RECYCLE_ST(Viewed, &viewed);
+}
+
+static void test_mask_index_arena(void)
+{
+    GET_STRUCT_NAME(Record) record;
+    fill_record(&record);
+    char * json = S2J(Record, &record);
+    size_t len = strlen(json);
+
+    static const GET_STRUCT_NAME(Mask) item_qty = { GET_FIELD_BIT(Item, qty), NULL };
+    static const GET_STRUCT_NAME(Mask) * const subs[GET_FIELD_COUNT(Record)] = {
+        [GET_FIELD_INDEX(Record, items)] = &item_qty,
+    };
+    static const GET_STRUCT_NAME(Mask) mask = { GET_FIELD_BIT(Record, i) | GET_FIELD_BIT(Record, items), subs };
+    DECLARE_STRUCT(Record, masked);
+    EXPECT(0 == J2S_MASK(json, Record, &masked, &mask));
+    EXPECT(record.i == masked.i && NULL == masked.s && 0 == masked.u64);
+    EXPECT(3 == masked.items.size && 2 == masked.items.items[1].qty && NULL == masked.items.items[1].name);
+    RECYCLE_ST(Record, &masked);
+
+    GET_STRUCT_NAME(Index) index;
+    memset(&index, 0, sizeof(GET_STRUCT_NAME(Index)));
+    DECLARE_STRUCT(Record, indexed);
+    EXPECT(0 == J2S_INDEX(json, len, Record, &indexed, NULL, &index));
+    EXPECT(EQUAL_ST(Record, &record, &indexed));
+    RECYCLE_ST(Record, &indexed);
+    EXPECT(0 == J2S_INDEX(json, len, Record, &indexed, &mask, &index));
+    EXPECT(record.i == indexed.i && NULL == indexed.s && 3 == indexed.items.size);
+    RECYCLE_ST(Record, &indexed);
+    json_wrapper_index_release(&index);
+
+    GET_STRUCT_NAME(Arena) arena;
+    json_wrapper_arena_init(&arena, 64);
+    DECLARE_STRUCT(Record, in_arena);
+    EXPECT(0 == J2S_ARENA(json, Record, &in_arena, &arena));
+    EXPECT(EQUAL_ST(Record, &record, &in_arena));
+    json_wrapper_arena_release(&arena);
+    json_wrapper_free(json);
+}
+
+static void test_batch(void)
+{
+    GET_STRUCT_NAME(Point) points[3] = { { 1, 2, 0.5 }, { 3, 4, 0 }, { 5, 6, -1 } };
+    GET_STRUCT_NAME(Buffer) buf;
+    memset(&buf, 0, sizeof(GET_STRUCT_NAME(Buffer)));
+    GET_STRUCT_NAME(Sink) sink;
+    json_wrapper_sink_init_buffer(&sink, &buf, BATCH_ARRAY);
+    EXPECT(0 == S2J_BATCH(Point, points, 3, &sink));
+    json_wrapper_sink_release(&sink);
+    EXPECT(0 == json_wrapper_buffer_append(&buf, "", 1));
+    EXPECT_STR(buf.data, "[{\"x\":1,\"y\":2,\"z\":0.5},{\"x\":3,\"y\":4,\"z\":0},{\"x\":5,\"y\":6,\"z\":-1}]");
+    buf.len = 0;
+    json_wrapper_sink_init_buffer(&sink, &buf, BATCH_NDJSON);
+    EXPECT(0 == S2J_BATCH(Point, points, 2, &sink));
+    json_wrapper_sink_release(&sink);
+    EXPECT(0 == json_wrapper_buffer_append(&buf, "", 1));
+    EXPECT_STR(buf.data, "{\"x\":1,\"y\":2,\"z\":0.5}\n{\"x\":3,\"y\":4,\"z\":0}\n");
+    json_wrapper_buffer_release(&buf);
+}
+
+static void test_batch_overflow(void)
+{
+    GET_STRUCT_NAME(Point) points[2] = { { 1, 2, 0.5 }, { 3, 4, 0 } };
+    char data[64];
+    GET_STRUCT_NAME(Buffer) buf;
+    GET_STRUCT_NAME(Sink) sink;
+    json_wrapper_buffer_init_fixed(&buf, data, 16);
+    json_wrapper_sink_init_buffer(&sink, &buf, BATCH_ARRAY);
+    EXPECT(-1 == S2J_BATCH(Point, points, 2, &sink));
+    EXPECT(0 == buf.len);
+    json_wrapper_buffer_init_fixed(&buf, data, sizeof(data));
+    json_wrapper_sink_init_buffer(&sink, &buf, BATCH_ARRAY);
+    EXPECT(0 == S2J_BATCH(Point, points, 2, &sink));
+    EXPECT(0 == json_wrapper_buffer_append(&buf, "", 1));
+    EXPECT_STR(buf.data, "[{\"x\":1,\"y\":2,\"z\":0.5},{\"x\":3,\"y\":4,\"z\":0}]");
+    json_wrapper_buffer_init_fixed(&buf, data, strlen("[{\"x\":1,\"y\":2,\"z\":0.5}]"));
+    json_wrapper_sink_init_buffer(&sink, &buf, BATCH_ARRAY);
+    EXPECT(-1 == S2J_BATCH(Point, points, 1, &sink));
+}
+
+int main(int argc, char * argv[])
+{
+    RUN(test_round_trip);
+    RUN(test_decode);
+    RUN(test_invalid);
+    RUN(test_sized);
+    RUN(test_numbers);
+    RUN(test_view);
+    RUN(test_mask_index_arena);
+    RUN(test_batch);
+    RUN(test_batch_overflow);
+    return TEST_RESULT();
+}
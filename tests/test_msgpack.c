@@ -0,0 +1,102 @@
+/**
+ * @file test_msgpack.c
+ * @brief Round trip every field type through S2M and M2S, and check the encoding of the integers and strings
+ */
+
+
+#include "test.h"
+
+
+DEFINE_STRUCT(Tag,
+    (OBJ(STRING), key)
+    (OBJ(STRING_VIEW), value)
+)
+
+DEFINE_STRUCT(Sample,
+    (OBJ(BOOL), ok)
+    (OBJ(CHAR), c)
+    (OBJ(INT), i)
+    (OBJ(INT64), i64)
+    (OBJ(UINT32), u32)
+    (OBJ(UINT64), u64)
+    (OBJ(FLOAT), f)
+    (OBJ(DOUBLE), d)
+    (OBJ(STRING), s)
+    (FIXED_STRING(6), fixed)
+    (OBJ(Tag), tag)
+    (ARRAY(INT, 2), pair)
+    (VA_ARRAY(Tag), tags)
+)
+
+DEFINE_STRUCT(Small,
+    (OBJ(INT), a)
+    (OBJ(STRING), b)
+)
+
+
+static void test_round_trip(void)
+{
+    GET_STRUCT_NAME(Tag) tags[2] = { { "k1", { "v1", 2 } }, { NULL, { NULL, 0 } } };
+    GET_STRUCT_NAME(Sample) sample;
+    memset(&sample, 0, sizeof(GET_STRUCT_NAME(Sample)));
+    sample.ok = true;
+    sample.c = -5;
+    sample.i = 1 << 20;
+    sample.i64 = INT64_MIN;
+    sample.u32 = UINT32_MAX;
+    sample.u64 = UINT64_MAX;
+    sample.f = 0.1f;
+    sample.d = -1e-300;
+    sample.s = "text with \"quotes\"";
+    strcpy(sample.fixed, "fixed");
+    sample.tag.key = "key";
+    sample.tag.value.ptr = "value";
+    sample.tag.value.len = 5;
+    sample.pair[0] = -1;
+    sample.pair[1] = 127;
+    sample.tags.tags = tags;
+    sample.tags.size = 2;
+
+    size_t len = 0;
+    char * data = S2M(Sample, &sample, &len);
+    EXPECT(NULL != data && len > 0);
+    DECLARE_STRUCT(Sample, decoded);
+    EXPECT(0 == M2S(data, len, Sample, &decoded));
+    EXPECT(EQUAL_ST(Sample, &sample, &decoded));
+    EXPECT(5 == decoded.tag.value.len && decoded.tag.value.ptr >= data && decoded.tag.value.ptr < data + len);
+    RECYCLE_ST(Sample, &decoded);
+
+    GET_STRUCT_NAME(Arena) arena;
+    json_wrapper_arena_init(&arena, 0);
+    DECLARE_STRUCT(Sample, in_arena);
+    EXPECT(0 == M2S_ARENA(data, len, Sample, &in_arena, &arena));
+    EXPECT(EQUAL_ST(Sample, &sample, &in_arena));
+    json_wrapper_arena_release(&arena);
+    DECLARE_STRUCT(Sample, truncated);
+    EXPECT(0 != M2S(data, len - 1, Sample, &truncated));
+    RECYCLE_ST(Sample, &truncated);
+    json_wrapper_free(data);
+}
+
+static void test_encoding(void)
+{
+    GET_STRUCT_NAME(Small) small = { 1, "x" };
+    size_t len = 0;
+    char * data = S2M(Small, &small, &len);
+    static const unsigned char expected[] = { 0x82, 0xA1, 'a', 0x01, 0xA1, 'b', 0xA1, 'x' };
+    EXPECT(sizeof(expected) == len && 0 == memcmp(data, expected, len));
+    json_wrapper_free(data);
+    small.a = -33;
+    small.b = NULL;
+    data = S2M(Small, &small, &len);
+    static const unsigned char negative[] = { 0x82, 0xA1, 'a', 0xD0, 0xDF, 0xA1, 'b', 0xC0 };
+    EXPECT(sizeof(negative) == len && 0 == memcmp(data, negative, len));
+    json_wrapper_free(data);
+}
+
+int main(int argc, char * argv[])
+{
+    RUN(test_round_trip);
+    RUN(test_encoding);
+    return TEST_RESULT();
+}
@@ -0,0 +1,214 @@
+/**
+ * @file test_ndjson.c
+ * @brief Decode NDJSON by J2S_NEXT from memory, a file descriptor and a mapped file, and by J2S_PARALLEL
+ */
+
+
+#include "test.h"
+#if !defined(_WIN32)
+#include <unistd.h>
+#include <fcntl.h>
+#endif
+
+
+DEFINE_STRUCT(Event,
+    (OBJ(INT), id)
+    (OBJ(STRING), name)
+    (OBJ(STRING_VIEW), tag)
+)
+
+
+static const char g_text[] = "{\"id\":1,\"name\":\"a\",\"tag\":\"x\\ty\"}\n"
+    "\r\n"
+    "{\"id\":2,\"name\":\"b\"}\r\n"
+    "\n"
+    "{\"id\":3,\"name\":\"c\"}";
+
+
+/**
+ * @brief Decode all the records of @p lines, the ids are summed into @p sum
+ *
+ * @note The lines in memory are not writable, so the escaped views are unescaped into the arena of @p lines
+ *
+ * @return int The number of good records, @p -1 for any bad record
+ */
+static int decode_all(GET_STRUCT_NAME(Lines) * lines, int * sum)
+{
+    DECLARE_STRUCT(Event, event);
+    int records = 0;
+    bool bad = false;
+    int rc = 0;
+    *sum = 0;
+    while (0 != (rc = J2S_NEXT(lines, Event, &event)))
+    {
+        if (1 == rc)
+        {
+            ++records;
+            *sum += event.id;
+        } else bad = true;
+        if (1 == event.id && 1 == rc) EXPECT(3 == event.tag.len && 0 == memcmp(event.tag.ptr, "x\ty", 3));
+    }
+    if (NULL == lines->arena) RECYCLE_ST(Event, &event);
+    return bad ? -1 : records;
+}
+
+static void test_memory(void)
+{
+    GET_STRUCT_NAME(Lines) lines;
+    GET_STRUCT_NAME(Arena) arena;
+    json_wrapper_arena_init(&arena, 0);
+    json_wrapper_lines_init_memory(&lines, g_text, strlen(g_text));
+    lines.arena = &arena;
+    int sum = 0;
+    EXPECT(3 == decode_all(&lines, &sum));
+    EXPECT(6 == sum);
+    json_wrapper_lines_release(&lines);
+    json_wrapper_arena_release(&arena);
+}
+
+#if !defined(_WIN32)
+static void test_file(void)
+{
+    char path[] = "/tmp/json_wrapper_test_XXXXXX";
+    int fd = mkstemp(path);
+    EXPECT(fd >= 0);
+    if (fd < 0) return;
+    EXPECT((ssize_t) strlen(g_text) == write(fd, g_text, strlen(g_text)));
+    lseek(fd, 0, SEEK_SET);
+    GET_STRUCT_NAME(Lines) lines;
+    EXPECT(0 == json_wrapper_lines_init_fd(&lines, fd, 0));
+    int sum = 0;
+    EXPECT(3 == decode_all(&lines, &sum));
+    EXPECT(6 == sum);
+    json_wrapper_lines_release(&lines);
+    close(fd);
+
+    EXPECT(0 == json_wrapper_lines_init_map(&lines, path));
+    EXPECT(3 == decode_all(&lines, &sum));
+    EXPECT(6 == sum);
+    json_wrapper_lines_release(&lines);
+    unlink(path);
+}
+#endif
+
+static void test_garbage(void)
+{
+    static const char text[] = "{\"id\":1,\"name\":\"a\"}\nhello\nxxxx\n42\n{\"id\":2} x\n{\"id\":3} \t\n";
+    static const int expected[] = { 1, -1, -1, -1, -1, 1, 0 };
+    GET_STRUCT_NAME(Lines) lines;
+    json_wrapper_lines_init_memory(&lines, text, strlen(text));
+    DECLARE_STRUCT(Event, event);
+    size_t i = 0;
+    for (i = 0; i < sizeof(expected) / sizeof(expected[0]); ++i) EXPECT(expected[i] == J2S_NEXT(&lines, Event, &event));
+    EXPECT(3 == event.id);
+    RECYCLE_ST(Event, &event);
+    json_wrapper_lines_release(&lines);
+
+    GET_STRUCT_NAME(Event) events[8];
+    memset(events, 0, sizeof(events));
+    size_t records = 0;
+    EXPECT(-1 == J2S_PARALLEL(text, strlen(text), Event, events, 8, NULL, &records));
+    for (i = 0; i < 8; ++i) RECYCLE_ST(Event, &events[i]);
+    static const char good[] = "{\"id\":1}\n\n{\"id\":2}  \r\n";
+    EXPECT(0 == J2S_PARALLEL(good, strlen(good), Event, events, 8, NULL, &records));
+    EXPECT(2 == records && 1 == events[0].id && 2 == events[1].id);
+}
+
+static void test_parallel(void)
+{
+    GET_STRUCT_NAME(Buffer) buf;
+    memset(&buf, 0, sizeof(GET_STRUCT_NAME(Buffer)));
+    GET_STRUCT_NAME(Sink) sink;
+    json_wrapper_sink_init_buffer(&sink, &buf, BATCH_NDJSON);
+    GET_STRUCT_NAME(Event) event = { 0, "name", { NULL, 0 } };
+    int i = 0;
+    for (i = 0; i < 1000; ++i)
+    {
+        event.id = i;
+        EXPECT(0 == S2J_BATCH(Event, &event, 1, &sink));
+    }
+    json_wrapper_sink_release(&sink);
+
+    static GET_STRUCT_NAME(Event) events[1000];
+    memset(events, 0, sizeof(events));
+    GET_STRUCT_NAME(Parallel) options;
+    memset(&options, 0, sizeof(GET_STRUCT_NAME(Parallel)));
+    options.threads = 4;
+    options.chunk = 256;
+    size_t records = 0;
+    EXPECT(0 == J2S_PARALLEL(buf.data, buf.len, Event, events, 1000, &options, &records));
+    EXPECT(1000 == records);
+    bool ordered = true;
+    for (i = 0; i < 1000; ++i)
+    {
+        ordered = ordered && i == events[i].id && NULL != events[i].name && 0 == strcmp(events[i].name, "name");
+        RECYCLE_ST(Event, &events[i]);
+    }
+    EXPECT(ordered);
+    json_wrapper_buffer_release(&buf);
+}
+
+static long g_hook_allocs = 0;
+static long g_hook_frees = 0;
+
+static void * tagged_alloc(size_t size)
+{
+    __atomic_add_fetch(&g_hook_allocs, 1, __ATOMIC_RELAXED);
+    return malloc(size);
+}
+
+static void tagged_free(void * ptr)
+{
+    if (NULL != ptr) __atomic_add_fetch(&g_hook_frees, 1, __ATOMIC_RELAXED);
+    free(ptr);
+}
+
+/**
+ * @brief Enough records that the workers started after the calling thread get some of them
+ */
+#define PARALLEL_RECORDS 50000
+
+static void test_parallel_hook(void)
+{
+    GET_STRUCT_NAME(Buffer) buf;
+    memset(&buf, 0, sizeof(GET_STRUCT_NAME(Buffer)));
+    GET_STRUCT_NAME(Sink) sink;
+    json_wrapper_sink_init_buffer(&sink, &buf, BATCH_NDJSON);
+    GET_STRUCT_NAME(Event) event = { 0, "name", { NULL, 0 } };
+    int i = 0;
+    for (i = 0; i < PARALLEL_RECORDS; ++i)
+    {
+        event.id = i;
+        EXPECT(0 == S2J_BATCH(Event, &event, 1, &sink));
+    }
+    json_wrapper_sink_release(&sink);
+
+    static GET_STRUCT_NAME(Event) events[PARALLEL_RECORDS];
+    memset(events, 0, sizeof(events));
+    GET_STRUCT_NAME(Parallel) options;
+    memset(&options, 0, sizeof(GET_STRUCT_NAME(Parallel)));
+    options.threads = 4;
+    options.chunk = 256;
+    size_t records = 0;
+    g_hook_allocs = 0;
+    g_hook_frees = 0;
+    EXPECT(0 == json_wrapper_hook_thread(tagged_alloc, tagged_free));
+    EXPECT(0 == J2S_PARALLEL(buf.data, buf.len, Event, events, PARALLEL_RECORDS, &options, &records));
+    EXPECT(PARALLEL_RECORDS == records);
+    for (i = 0; i < PARALLEL_RECORDS; ++i) RECYCLE_ST(Event, &events[i]);
+    EXPECT(0 == json_wrapper_hook_thread(NULL, NULL));
+    EXPECT(g_hook_allocs >= PARALLEL_RECORDS && g_hook_allocs == g_hook_frees);
+    json_wrapper_buffer_release(&buf);
+}
+
+int main(int argc, char * argv[])
+{
+    RUN(test_memory);
+#if !defined(_WIN32)
+    RUN(test_file);
+#endif
+    RUN(test_garbage);
+    RUN(test_parallel);
+    RUN(test_parallel_hook);
+    return TEST_RESULT();
+}
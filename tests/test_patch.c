@@ -0,0 +1,106 @@
+/**
+ * @file test_patch.c
+ * @brief Check DIFF_ST against PATCH_ST as json merge patches, and S2J_TRACKED against S2J after the changes
+ */
+
+
+#include "test.h"
+
+
+DEFINE_STRUCT(Address,
+    (OBJ(STRING), city)
+    (OBJ(INT), zip)
+)
+
+DEFINE_STRUCT(Customer,
+    (OBJ(STRING), name)
+    (OBJ(INT), age)
+    (OBJ(DOUBLE), score)
+    (OBJ(Address), address)
+    (ARRAY(INT, 2), pair)
+    (VA_ARRAY(Address), others)
+)
+
+DEFINE_STRUCT(Transfer,
+    (OBJ(STRING), to)
+    (OBJ(INT64), amount)
+)
+
+DEFINE_STRUCT_TRACKED(Account,
+    (OBJ(STRING), owner)
+    (OBJ(INT64), balance)
+    (FIXED_STRING(4), currency)
+    (OBJ(Address), address)
+    (VA_ARRAY(Transfer), history)
+)
+
+
+static void test_diff_patch(void)
+{
+    DECLARE_STRUCT(Customer, old);
+    EXPECT(0 == J2S("{\"name\":\"Ann\",\"age\":30,\"score\":1.5,\"address\":{\"city\":\"Oslo\",\"zip\":1},"
+        "\"pair\":[1,2],\"others\":[{\"city\":\"Rome\",\"zip\":2}]}", Customer, &old));
+    DECLARE_STRUCT(Customer, value);
+    COPY_ST(Customer, &old, &value);
+
+    char * patch = DIFF_ST(Customer, &old, &value);
+    EXPECT_STR(patch, "{}");
+    json_wrapper_free(patch);
+
+    value.age = 31;
+    value.address.zip = 9;
+    value.pair[1] = 3;
+    json_wrapper_free(value.name);
+    value.name = NULL;
+    patch = DIFF_ST(Customer, &old, &value);
+    EXPECT_STR(patch, "{\"name\":null,\"age\":31,\"address\":{\"zip\":9},\"pair\":[1,3]}");
+
+    EXPECT(0 == PATCH_ST(Customer, patch, &old));
+    EXPECT(EQUAL_ST(Customer, &old, &value));
+    json_wrapper_free(patch);
+
+    GET_STRUCT_NAME(Buffer) buf;
+    memset(&buf, 0, sizeof(GET_STRUCT_NAME(Buffer)));
+    EXPECT(0 == DIFF_ST_BUFFER(Customer, &old, &value, &buf));
+    EXPECT(0 == buf.len);
+    json_wrapper_buffer_release(&buf);
+
+    EXPECT(0 == PATCH_ST(Customer, "{\"address\":null,\"others\":[]}", &old));
+    EXPECT(NULL == old.address.city && 0 == old.address.zip && 0 == old.others.size && 31 == old.age);
+    RECYCLE_ST(Customer, &old);
+    RECYCLE_ST(Customer, &value);
+}
+
+static void test_tracked(void)
+{
+    GET_STRUCT_NAME(Transfer) history[2] = { { "Bob", 10 }, { "Eve", -3 } };
+    DECLARE_TRACKED(Account, account);
+    SET_ST(Account, &account, owner, "Ann");
+    SET_ST(Account, &account, balance, -5);
+    SET_ST(Account, &account, currency, "EUR");
+    SET_ST(Account, &account, history, history, 2);
+    size_t len = 0;
+    const char * text = S2J_TRACKED(Account, &account, &len);
+    char * plain = S2J(Account, &account.value);
+    EXPECT_STR(text, plain);
+    EXPECT(strlen(plain) == len);
+    json_wrapper_free(plain);
+
+    SET_ST(Account, &account, balance, 100);
+    account.value.address.zip = 7;
+    TOUCH_ST(Account, &account, address);
+    text = S2J_TRACKED(Account, &account, &len);
+    plain = S2J(Account, &account.value);
+    EXPECT_STR(text, plain);
+    EXPECT(NULL != strstr(text, "\"balance\":100") && NULL != strstr(text, "\"zip\":7"));
+    json_wrapper_free(plain);
+    EXPECT(text == S2J_TRACKED(Account, &account, &len));
+    RECYCLE_TRACKED(Account, &account);
+}
+
+int main(int argc, char * argv[])
+{
+    RUN(test_diff_patch);
+    RUN(test_tracked);
+    return TEST_RESULT();
+}